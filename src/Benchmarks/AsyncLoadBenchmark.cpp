@@ -0,0 +1,153 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/ObjParser.hpp>
+#include <ResourceManager/ResourceManager.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Request
+    {
+        LoadPriority priority{LoadPriority::Background};
+        bool isMesh{false};
+        bool isCancelled{false};
+        Clock::time_point queuedAt;
+        double latencyMs{0.0};
+        int callbackCount{0};
+        LoadState state{LoadState::Queued};
+        MeshHandle mesh;
+        ShapeHandle shape;
+    };
+
+    const char *PRIORITY_NAMES[LOAD_PRIORITY_COUNT] = {"visible now", "prefetch", "background"};
+}
+
+// Simulates a frame loop: queue a mix of loads, cancel some, promote one, and
+// keep dispatching completions until all of them reported back.
+int Bench::RunAsyncLoad(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int loadsPerClass = argc > 1 ? std::atoi(argv[1]) : 4;
+    const unsigned threadCount = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+
+    std::string cookedPath = path;
+    cookedPath = cookedPath.substr(0, cookedPath.rfind('.')) + ".cmesh";
+    const VertexLayout layout = VertexLayouts::DepthAndShading::Describe();
+    {
+        SponzaShape sponza;
+        Obj::LoadOptions options;
+        options.layout = &layout;
+        if (!Obj::LoadFile(path, sponza, options) || !WriteCookedMesh(cookedPath.c_str(), sponza)) {
+            std::printf("async: cannot cook %s\n", path);
+            return 1;
+        }
+    }
+
+    ResourceManager resources{threadCount};
+    std::vector<Request> requests(LOAD_PRIORITY_COUNT * loadsPerClass);
+    double maxCallMs = 0.0;
+
+    const Clock::time_point queueStart = Clock::now();
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Request &request = requests[i];
+        request.priority = static_cast<LoadPriority>(i % LOAD_PRIORITY_COUNT);
+        request.isMesh = (i / LOAD_PRIORITY_COUNT) % 2 == 0;
+        request.queuedAt = Clock::now();
+        auto callback = [&request](LoadState state) {
+            request.latencyMs = millisecondsSince(request.queuedAt);
+            request.state = state;
+            ++request.callbackCount;
+        };
+        if (request.isMesh) {
+            request.mesh = resources.LoadMesh(cookedPath, request.priority, callback);
+        } else {
+            request.shape = resources.LoadShape(path, request.priority, &layout, callback);
+        }
+    }
+    maxCallMs = std::max(maxCallMs, millisecondsSince(queueStart));
+
+    // The last background load became visible, the first one is not needed anymore.
+    Clock::time_point callStart = Clock::now();
+    Request &promoted = requests[requests.size() - 1];
+    if (promoted.isMesh) {
+        resources.SetPriority(promoted.mesh, LoadPriority::VisibleNow);
+    } else {
+        resources.SetPriority(promoted.shape, LoadPriority::VisibleNow);
+    }
+    Request &dropped = requests[LOAD_PRIORITY_COUNT - 1];
+    dropped.isCancelled = dropped.isMesh ? resources.Cancel(dropped.mesh) : resources.Cancel(dropped.shape);
+    maxCallMs = std::max(maxCallMs, millisecondsSince(callStart));
+
+    size_t frames = 0;
+    while (resources.PendingCount() > 0 || frames == 0) {
+        callStart = Clock::now();
+        resources.DispatchCompletions();
+        maxCallMs = std::max(maxCallMs, millisecondsSince(callStart));
+        ++frames;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    callStart = Clock::now();
+    resources.DispatchCompletions();
+    maxCallMs = std::max(maxCallMs, millisecondsSince(callStart));
+
+    bool isValid = true;
+    std::printf("%-12s %6s %10s %10s %10s\n", "priority", "loads", "ready", "mean ms", "max ms");
+    for (size_t p = 0; p < LOAD_PRIORITY_COUNT; ++p) {
+        size_t count = 0, ready = 0;
+        double total = 0.0, worst = 0.0;
+        for (const Request &request : requests) {
+            if (static_cast<size_t>(request.priority) != p || request.isCancelled || &request == &promoted) {
+                continue;
+            }
+            ++count;
+            ready += request.state == LoadState::Ready ? 1 : 0;
+            total += request.latencyMs;
+            worst = std::max(worst, request.latencyMs);
+        }
+        std::printf("%-12s %6zu %10zu %10.2f %10.2f\n", PRIORITY_NAMES[p], count, ready, count > 0 ? total / count : 0.0,
+                    worst);
+    }
+    std::printf("promoted     %6d %10s %10.2f\n", 1, promoted.state == LoadState::Ready ? "yes" : "no", promoted.latencyMs);
+
+    for (const Request &request : requests) {
+        const LoadState expected = request.isCancelled ? LoadState::Cancelled : LoadState::Ready;
+        const bool hasResource = request.isMesh ? resources.Get(request.mesh) != nullptr
+                                                : resources.Get(request.shape) != nullptr;
+        isValid &= request.callbackCount == 1 && request.state == expected && hasResource == !request.isCancelled;
+    }
+
+    // Hot reload keeps serving the old mesh until the new one is swapped in on this thread.
+    const MeshHandle reloaded = requests[0].mesh;
+    const CookedMesh *before = resources.Get(reloaded);
+    LoadState reloadState = LoadState::Queued;
+    const Clock::time_point reloadStart = Clock::now();
+    isValid &= resources.Reload(reloaded, LoadPriority::VisibleNow, [&reloadState](LoadState state) {
+        reloadState = state;
+    });
+    while (reloadState == LoadState::Queued) {
+        isValid &= resources.Get(reloaded) == before;
+        resources.DispatchCompletions();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double reloadMs = millisecondsSince(reloadStart);
+    isValid &= reloadState == LoadState::Ready && resources.Get(reloaded) != nullptr && resources.Get(reloaded) != before;
+
+    std::printf("%zu frames, longest main thread call %.3f ms, reload %.2f ms, callbacks %s\n", frames, maxCallMs,
+                reloadMs, isValid ? "ok" : "FAIL");
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Bench
+{
+    struct Timing
+    {
+        double minMs{0.0};
+        double medianMs{0.0};
+    };
+
+    // Runs fn the given number of times and returns wall-clock statistics.
+    template<typename Fn>
+    Timing Measure(int iterations, Fn &&fn)
+    {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Timing timing;
+        if (!samples.empty()) {
+            timing.minMs = samples.front();
+            timing.medianMs = samples[samples.size() / 2];
+        }
+        return timing;
+    }
+
+    inline double MegabytesPerSecond(size_t bytes, double ms)
+    {
+        return ms > 0.0 ? (bytes / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+    }
+
+    int RunObjLoad(int argc, char **argv);
+    int RunWeld(int argc, char **argv);
+    int RunTriangulate(int argc, char **argv);
+    int RunLayout(int argc, char **argv);
+    int RunCookedMesh(int argc, char **argv);
+    int RunAsyncLoad(int argc, char **argv);
+    int RunTga(int argc, char **argv);
+    int RunMips(int argc, char **argv);
+    int RunBlockCompression(int argc, char **argv);
+    int RunCookedTexture(int argc, char **argv);
+    int RunResidency(int argc, char **argv);
+    int RunVirtualTexture(int argc, char **argv);
+    int RunPipeline(int argc, char **argv);
+    int RunVertexCache(int argc, char **argv);
+    int RunMeshlets(int argc, char **argv);
+    int RunLod(int argc, char **argv);
+    int RunTangents(int argc, char **argv);
+}
@@ -0,0 +1,223 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/BlockCompressor.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Texture
+    {
+        std::string name;
+        Image image;
+        Bc::BlockFormat format{Bc::BlockFormat::BC7};
+    };
+
+    Image makeImage(uint32_t width, uint32_t height)
+    {
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.format = PixelFormat::RGBA8;
+        image.pixels.Allocate(image.RowPitch() * height);
+        return image;
+    }
+
+    // Gradients, hard edges and some grain, roughly what a diffuse map holds.
+    Image makeAlbedo(uint32_t size)
+    {
+        Image image = makeImage(size, size);
+        uint32_t seed = 99;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                const int grain = static_cast<int>(seed >> 28) - 8;
+                const bool brick = ((y / 24) % 2 == 0 ? x : x + 32) % 64 < 60 && y % 24 < 21;
+                uint8_t *texel = image.pixels.Data.get() + (size_t(y) * size + x) * 4;
+                const int r = brick ? 150 + static_cast<int>(40 * std::sin(x * 0.02f)) : 90;
+                const int g = brick ? 80 + static_cast<int>(30 * std::cos(y * 0.03f)) : 85;
+                const int b = brick ? 60 : 80;
+                texel[0] = static_cast<uint8_t>(std::clamp(r + grain, 0, 255));
+                texel[1] = static_cast<uint8_t>(std::clamp(g + grain, 0, 255));
+                texel[2] = static_cast<uint8_t>(std::clamp(b + grain, 0, 255));
+                texel[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    // Tangent space normals of a bumpy height field, XY in RG.
+    Image makeNormalMap(uint32_t size)
+    {
+        Image image = makeImage(size, size);
+        auto height = [](float x, float y) { return 4.0f * std::sin(x * 0.15f) * std::cos(y * 0.11f); };
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const float dx = height(x + 1.0f, float(y)) - height(x - 1.0f, float(y));
+                const float dy = height(float(x), y + 1.0f) - height(float(x), y - 1.0f);
+                const float length = std::sqrt(dx * dx + dy * dy + 4.0f);
+                uint8_t *texel = image.pixels.Data.get() + (size_t(y) * size + x) * 4;
+                texel[0] = static_cast<uint8_t>((-dx / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+                texel[1] = static_cast<uint8_t>((-dy / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+                texel[2] = static_cast<uint8_t>((2.0f / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+                texel[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    uint32_t comparedChannels(Bc::BlockFormat format)
+    {
+        switch (format) {
+        case Bc::BlockFormat::BC1: return 3;
+        case Bc::BlockFormat::BC4: return 1;
+        case Bc::BlockFormat::BC5: return 2;
+        case Bc::BlockFormat::BC7: return 4;
+        }
+        return 0;
+    }
+
+    // Squared error over the channels the format stores.
+    double squaredError(const Image &source, const Image &decoded, uint32_t channels, size_t &samples)
+    {
+        const uint32_t sourceStride = BytesPerPixel(source.format);
+        const uint32_t decodedStride = BytesPerPixel(decoded.format);
+        double error = 0.0;
+        const size_t count = size_t(source.width) * source.height;
+        for (size_t i = 0; i < count; ++i) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                const uint8_t expected = c < sourceStride ? source.pixels.Data[i * sourceStride + c] : (c == 3 ? 255 : 0);
+                const double difference = double(expected) - decoded.pixels.Data[i * decodedStride + c];
+                error += difference * difference;
+            }
+        }
+        samples += count * channels;
+        return error;
+    }
+
+    double psnr(double error, size_t samples)
+    {
+        const double mse = samples > 0 ? error / samples : 0.0;
+        return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+    }
+}
+
+// Compresses the textures of a directory plus synthetic albedo and normal
+// maps in the format each one is assigned, per quality preset, and reports
+// throughput and PSNR against the source.
+int Bench::RunBlockCompression(int argc, char **argv)
+{
+    const char *directory = argc > 0 ? argv[0] : "assets/sponza/textures_pbr";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 1;
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Texture> textures;
+    std::error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error)) {
+        const std::string extension = Text::ToLower(entry.path().extension().string());
+        Texture texture;
+        texture.name = entry.path().filename().string();
+        if (extension == ".tga" && Tga::LoadFile(entry.path().string().c_str(), texture.image)) {
+            textures.push_back(std::move(texture));
+        }
+    }
+    textures.push_back({"synthetic_diffuse.tga", makeAlbedo(512)});
+    textures.push_back({"synthetic_normal.tga", makeNormalMap(512)});
+    for (Texture &texture : textures) {
+        texture.format = Bc::FormatForTexture(texture.name, texture.image.format);
+    }
+
+    // BC1 is the fast alternative for every texture that would go to BC7.
+    std::vector<const Texture *> colorTextures;
+    for (const Texture &texture : textures) {
+        if (texture.format == Bc::BlockFormat::BC7) {
+            colorTextures.push_back(&texture);
+        }
+    }
+
+    const Bc::Quality QUALITIES[] = {Bc::Quality::Fast, Bc::Quality::Normal, Bc::Quality::High};
+    const char *QUALITY_NAMES[] = {"fast", "normal", "high"};
+    bool isValid = true;
+    double previousPsnr[4] = {0.0, 0.0, 0.0, 0.0};
+
+    std::printf("%zu textures, %u threads\n", textures.size(), cores);
+    std::printf("%-6s %-8s %8s %12s %10s %10s %8s\n", "format", "preset", "count", "ms", "MPix/s", "ratio", "PSNR");
+    for (Bc::BlockFormat format : {Bc::BlockFormat::BC1, Bc::BlockFormat::BC4, Bc::BlockFormat::BC5,
+                                   Bc::BlockFormat::BC7}) {
+        std::vector<const Texture *> selected;
+        for (const Texture &texture : textures) {
+            if (texture.format == format) {
+                selected.push_back(&texture);
+            }
+        }
+        if (format == Bc::BlockFormat::BC1) {
+            selected = colorTextures;
+        }
+        if (selected.empty()) {
+            continue;
+        }
+
+        for (size_t q = 0; q < 3; ++q) {
+            Bc::CompressOptions options;
+            options.format = format;
+            options.quality = QUALITIES[q];
+            options.threadCount = cores;
+
+            std::vector<RawData> blocks(selected.size());
+            size_t pixels = 0;
+            size_t sourceBytes = 0;
+            size_t compressedBytes = 0;
+            const Timing timing = Measure(iterations, [&]() {
+                pixels = sourceBytes = compressedBytes = 0;
+                for (size_t i = 0; i < selected.size(); ++i) {
+                    const Image &image = selected[i]->image;
+                    isValid &= Bc::Compress(image, options, blocks[i]);
+                    pixels += size_t(image.width) * image.height;
+                    sourceBytes += image.pixels.Size;
+                    compressedBytes += blocks[i].Size;
+                }
+            });
+
+            double totalError = 0.0;
+            size_t samples = 0;
+            for (size_t i = 0; i < selected.size(); ++i) {
+                const Image &image = selected[i]->image;
+                Image decoded;
+                isValid &= Bc::Decompress(format, blocks[i].Data.get(), image.width, image.height, decoded);
+                totalError += squaredError(image, decoded, comparedChannels(format), samples);
+            }
+            const double quality = psnr(totalError, samples);
+            // Presets have to be ordered by quality; allow noise from local minima.
+            isValid &= quality + 0.05 >= previousPsnr[static_cast<size_t>(format)];
+            previousPsnr[static_cast<size_t>(format)] = quality;
+
+            // The block split must not change the output.
+            if (q == 1) {
+                Bc::CompressOptions single = options;
+                single.threadCount = 1;
+                RawData serial;
+                isValid &= Bc::Compress(selected.front()->image, single, serial) && serial.Size == blocks[0].Size &&
+                           std::memcmp(serial.Data.get(), blocks[0].Data.get(), serial.Size) == 0;
+            }
+
+            std::printf("%-6s %-8s %8zu %12.2f %10.2f %9.1f:1 %8.2f\n", Bc::FormatName(format), QUALITY_NAMES[q],
+                        selected.size(), timing.minMs, timing.minMs > 0.0 ? pixels / (timing.minMs * 1000.0) : 0.0,
+                        compressedBytes > 0 ? double(sourceBytes) / compressedBytes : 0.0, quality);
+        }
+    }
+    std::printf("round trip and preset ordering: %s\n", isValid ? "ok" : "FAIL");
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Drops the file from the page cache so the next open reads from disk.
+    bool evict(const char *path)
+    {
+#if defined(__linux__)
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        ::fdatasync(fd);
+        const bool evicted = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        ::close(fd);
+        return evicted;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // Reads one byte per page, what a renderer uploading the mesh would pay at least.
+    uint64_t touch(std::string_view bytes)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < bytes.size(); i += 4096) {
+            sum += static_cast<uint8_t>(bytes[i]);
+        }
+        return sum;
+    }
+
+    struct StartupTiming
+    {
+        double coldMs{0.0};
+        double warmMs{0.0};
+        bool cold{false};
+    };
+
+    template<typename Fn>
+    StartupTiming measureStartup(const char *path, int iterations, Fn &&fn)
+    {
+        StartupTiming timing;
+        timing.cold = evict(path);
+        timing.coldMs = Bench::Measure(1, fn).minMs;
+        timing.warmMs = Bench::Measure(iterations, fn).minMs;
+        return timing;
+    }
+
+    void printStartup(const char *name, const StartupTiming &timing)
+    {
+        if (timing.cold) {
+            std::printf("%-24s %12.2f %12.2f\n", name, timing.coldMs, timing.warmMs);
+        } else {
+            std::printf("%-24s %12s %12.2f\n", name, "n/a", timing.warmMs);
+        }
+    }
+}
+
+int Bench::RunCookedMesh(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    std::string cookedPath = path;
+    const size_t extension = cookedPath.rfind('.');
+    cookedPath = cookedPath.substr(0, extension) + ".cmesh";
+
+    const VertexLayout layout = VertexLayouts::DepthAndShading::Describe();
+    Obj::LoadOptions options;
+    options.layout = &layout;
+
+    SponzaShape sponza;
+    if (!Obj::LoadFile(path, sponza, options)) {
+        std::printf("cmesh: cannot load %s\n", path);
+        return 1;
+    }
+    if (!WriteCookedMesh(cookedPath.c_str(), sponza)) {
+        std::printf("cmesh: cannot write %s\n", cookedPath.c_str());
+        return 1;
+    }
+
+    CookedMesh mesh;
+    if (!mesh.Open(cookedPath.c_str())) {
+        std::printf("cmesh: %s does not validate\n", cookedPath.c_str());
+        return 1;
+    }
+    const CookedMeshHeader &header = mesh.Header();
+    std::printf("%s: %u submeshes, %u vertices, %u indices, %u materials, %.1f KB\n", cookedPath.c_str(),
+                header.submeshCount, header.vertexCount, header.indexCount, header.materialCount,
+                header.fileSize / 1024.0);
+
+    // The mapped data must be exactly what was cooked.
+    bool same = mesh.SubmeshCount() == sponza.shapes.size();
+    for (uint32_t i = 0; same && i < mesh.SubmeshCount(); ++i) {
+        const CookedSubmesh &submesh = mesh.Submesh(i);
+        const SponzaShape::Shape &shape = sponza.shapes[i];
+        same = mesh.SubmeshName(i) == shape.name && submesh.material == shape.material &&
+               std::equal(shape.indicies.begin(), shape.indicies.end(), mesh.Indices() + submesh.firstIndex);
+        for (uint32_t s = 0; same && s < layout.streamCount; ++s) {
+            const uint8_t *stream = mesh.Stream(s) + size_t(submesh.firstVertex) * layout.strides[s];
+            same = std::equal(shape.streams[s].begin(), shape.streams[s].end(), stream);
+        }
+    }
+    mesh.Close();
+    sponza = SponzaShape{};
+
+    uint64_t checksum = 0;
+    std::printf("%-24s %12s %12s\n", "startup", "cold ms", "warm ms");
+    printStartup("obj parse + build", measureStartup(path, iterations, [&]() {
+        Obj::LoadFile(path, sponza, options);
+    }));
+    printStartup("cmesh open", measureStartup(cookedPath.c_str(), iterations, [&]() {
+        mesh.Open(cookedPath.c_str());
+        checksum += mesh.SubmeshCount();
+    }));
+    printStartup("cmesh open + touch", measureStartup(cookedPath.c_str(), iterations, [&]() {
+        mesh.Open(cookedPath.c_str());
+        checksum += touch(mesh.View());
+    }));
+    std::printf("round trip: %s (checksum %llu)\n", same ? "ok" : "FAIL", static_cast<unsigned long long>(checksum));
+    return same ? 0 : 1;
+}
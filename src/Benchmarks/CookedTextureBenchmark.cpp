@@ -0,0 +1,239 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedTexture.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Odd sizes so levels end in partial blocks and rows that need padding.
+    Image makeGradient(uint32_t width, uint32_t height, PixelFormat format)
+    {
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.format = format;
+        image.pixels.Allocate(image.RowPitch() * height);
+        const uint32_t channels = BytesPerPixel(format);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                uint8_t *texel = image.pixels.Data.get() + (size_t(y) * width + x) * channels;
+                for (uint32_t c = 0; c < channels; ++c) {
+                    texel[c] = static_cast<uint8_t>((x * (c + 1) + y * (3 - c % 4) + (x ^ y)) & 0xff);
+                }
+            }
+        }
+        return image;
+    }
+
+    Bc::BlockFormat blockFormat(TextureFormat format)
+    {
+        switch (format) {
+        case TextureFormat::BC1: return Bc::BlockFormat::BC1;
+        case TextureFormat::BC4: return Bc::BlockFormat::BC4;
+        case TextureFormat::BC5: return Bc::BlockFormat::BC5;
+        default: return Bc::BlockFormat::BC7;
+        }
+    }
+
+    // Levels as the cooker produces them: raw pixels, or blocks for BC formats.
+    bool buildLevels(const Image &image, TextureFormat format, Bc::Quality quality, TextureLevels &texture)
+    {
+        MipChain chain;
+        if (!GenerateMips(image, MipOptions{}, chain)) {
+            return false;
+        }
+        texture.format = format;
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.levels.clear();
+        texture.levels.resize(std::min<size_t>(chain.levels.size(), MAX_TEXTURE_MIPS));
+        for (size_t level = 0; level < texture.levels.size(); ++level) {
+            const Image &source = chain.levels[level];
+            if (!IsBlockCompressed(format)) {
+                texture.levels[level].Allocate(source.pixels.Size);
+                std::memcpy(texture.levels[level].Data.get(), source.pixels.Data.get(), source.pixels.Size);
+                continue;
+            }
+            Bc::CompressOptions options;
+            options.format = blockFormat(format);
+            options.quality = quality;
+            if (!Bc::Compress(source, options, texture.levels[level])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Header rules plus the data of every level, row by row.
+    bool matches(const CookedTexture &cooked, const TextureLevels &texture)
+    {
+        if (cooked.MipCount() != texture.levels.size() || cooked.Format() != texture.format ||
+            cooked.Width() != texture.width || cooked.Height() != texture.height) {
+            return false;
+        }
+        for (uint32_t level = 0; level < cooked.MipCount(); ++level) {
+            const CookedMip &mip = cooked.Mip(level);
+            if (mip.offset % TEXTURE_PLACEMENT_ALIGNMENT != 0 || mip.rowPitch % TEXTURE_PITCH_ALIGNMENT != 0 ||
+                (level + 1 < cooked.MipCount() && mip.offset <= cooked.Mip(level + 1).offset)) {
+                return false;
+            }
+            const size_t rowBytes = TextureRowBytes(texture.format, mip.width);
+            for (uint32_t row = 0; row < mip.rowCount; ++row) {
+                if (std::memcmp(cooked.MipData(level) + size_t(row) * mip.rowPitch,
+                                texture.levels[level].Data.get() + row * rowBytes, rowBytes) != 0) {
+                    return false;
+                }
+            }
+        }
+        // A single level range is the level itself, the full range ends the file.
+        const uint32_t last = cooked.MipCount() - 1;
+        const std::string_view top = cooked.MipRange(0, 0);
+        const std::string_view all = cooked.MipRange(0, last);
+        return top.data() == reinterpret_cast<const char *>(cooked.MipData(0)) && top.size() == cooked.Mip(0).size &&
+               all.data() == reinterpret_cast<const char *>(cooked.MipData(last)) &&
+               all.data() + all.size() == cooked.View().data() + cooked.View().size();
+    }
+
+    // First level no larger than size texels, what a streamer maps in before anything else.
+    uint32_t tailLevel(const CookedTexture &cooked, uint32_t size)
+    {
+        uint32_t level = 0;
+        while (level + 1 < cooked.MipCount() && std::max(cooked.Mip(level).width, cooked.Mip(level).height) > size) {
+            ++level;
+        }
+        return level;
+    }
+
+    // Reads one byte per page, what copying the range into upload memory would pay at least.
+    uint64_t touch(std::string_view bytes)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < bytes.size(); i += 4096) {
+            sum += static_cast<uint8_t>(bytes[i]);
+        }
+        return sum;
+    }
+}
+
+// Round trips every format through a .ctex and checks the layout rules, then
+// cooks the textures of a directory and times mapping a file and touching
+// its low mip tail against touching all of it.
+int Bench::RunCookedTexture(int argc, char **argv)
+{
+    const char *directory = argc > 0 ? argv[0] : "assets/sponza/textures_pbr";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+    const fs::path temporary = fs::temp_directory_path() / "chelson-ctex";
+    std::error_code error;
+    fs::create_directories(temporary, error);
+
+    bool isValid = true;
+    const std::string roundTripPath = (temporary / "round_trip.ctex").string();
+    for (uint32_t f = 0; f < static_cast<uint32_t>(TextureFormat::Count); ++f) {
+        const TextureFormat format = static_cast<TextureFormat>(f);
+        const PixelFormat pixels = format == TextureFormat::R8 ? PixelFormat::R8 : PixelFormat::RGBA8;
+        TextureLevels texture;
+        CookedTexture cooked;
+        const bool same = buildLevels(makeGradient(301, 77, pixels), format, Bc::Quality::Fast, texture) &&
+                          WriteCookedTexture(roundTripPath.c_str(), texture) &&
+                          cooked.Open(roundTripPath.c_str()) && matches(cooked, texture);
+        std::printf("round trip %-6s %2u mips %8.1f KB: %s\n", TextureFormatName(format),
+                    cooked.IsOpen() ? cooked.MipCount() : 0, cooked.IsOpen() ? cooked.Header().fileSize / 1024.0 : 0.0,
+                    same ? "ok" : "FAIL");
+        isValid &= same;
+    }
+
+    // A cut off file must not open.
+    {
+        CookedTexture cooked;
+        const uintmax_t size = fs::file_size(roundTripPath, error);
+        fs::resize_file(roundTripPath, size - 1, error);
+        isValid &= !error && !cooked.Open(roundTripPath.c_str());
+    }
+
+    struct Cooked
+    {
+        std::string path;
+        uint64_t sourceBytes{0};
+    };
+    std::vector<Cooked> files;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error)) {
+        const std::string extension = Text::ToLower(entry.path().extension().string());
+        Image image;
+        if (extension != ".tga" || !Tga::LoadFile(entry.path().string().c_str(), image)) {
+            continue;
+        }
+        const std::string name = entry.path().filename().string();
+        TextureLevels texture;
+        Cooked file{(temporary / entry.path().stem()).string() + ".ctex", image.pixels.Size};
+        const TextureFormat format = TextureFormatOf(Bc::FormatForTexture(name, image.format));
+        if (buildLevels(image, format, Bc::Quality::Fast, texture) && WriteCookedTexture(file.path.c_str(), texture)) {
+            files.push_back(std::move(file));
+        }
+    }
+    if (files.empty()) {
+        std::printf("ctex: no textures in %s\n", directory);
+        return isValid ? 0 : 1;
+    }
+
+    const uint32_t TAIL_SIZE = 128;
+    uint64_t sourceBytes = 0;
+    uint64_t cookedBytes = 0;
+    uint64_t tailBytes = 0;
+    uint64_t checksum = 0;
+    CookedTexture cooked;
+    for (const Cooked &file : files) {
+        isValid &= cooked.Open(file.path.c_str());
+        if (!cooked.IsOpen()) {
+            continue;
+        }
+        const uint32_t first = tailLevel(cooked, TAIL_SIZE);
+        sourceBytes += file.sourceBytes;
+        cookedBytes += cooked.Header().fileSize;
+        tailBytes += cooked.MipRange(first, cooked.MipCount() - 1).size();
+    }
+
+    const Timing open = Measure(iterations, [&]() {
+        for (const Cooked &file : files) {
+            cooked.Open(file.path.c_str());
+            checksum += cooked.MipCount();
+        }
+    });
+    const Timing tail = Measure(iterations, [&]() {
+        for (const Cooked &file : files) {
+            cooked.Open(file.path.c_str());
+            checksum += touch(cooked.MipRange(tailLevel(cooked, TAIL_SIZE), cooked.MipCount() - 1));
+        }
+    });
+    const Timing all = Measure(iterations, [&]() {
+        for (const Cooked &file : files) {
+            cooked.Open(file.path.c_str());
+            checksum += touch(cooked.MipRange(0, cooked.MipCount() - 1));
+        }
+    });
+    cooked.Close();
+
+    std::printf("%zu textures: %.1f MB decoded, %.1f MB cooked with mips, %.1f KB mip tails (<= %u texels)\n",
+                files.size(), sourceBytes / (1024.0 * 1024.0), cookedBytes / (1024.0 * 1024.0), tailBytes / 1024.0,
+                TAIL_SIZE);
+    std::printf("%-24s %12s\n", "warm", "ms");
+    std::printf("%-24s %12.2f\n", "open", open.minMs);
+    std::printf("%-24s %12.2f\n", "open + touch tail", tail.minMs);
+    std::printf("%-24s %12.2f\n", "open + touch all", all.minMs);
+    std::printf("round trip and layout: %s (checksum %llu)\n", isValid ? "ok" : "FAIL",
+                static_cast<unsigned long long>(checksum));
+    fs::remove_all(temporary, error);
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CpuFeatures.hpp>
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/ObjParser.hpp>
+#include <ResourceManager/ResourceManager.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    struct NamedLayout
+    {
+        const char *name;
+        VertexLayout layout;
+    };
+
+    const NamedLayout LAYOUTS[] = {
+        {"interleaved float", VertexLayouts::InterleavedFloat::Describe()},
+        {"depth + shading", VertexLayouts::DepthAndShading::Describe()},
+        {"depth + shading + tangent", VertexLayouts::DepthAndShadingTangent::Describe()},
+        {"quantized", VertexLayouts::Quantized::Describe()},
+        {"quantized + tangent", VertexLayouts::QuantizedTangent::Describe()},
+    };
+
+    // Largest decode error of a layout against the float build: positions
+    // as a share of the quantization step bound, normals in radians and
+    // texcoords relative to their magnitude.
+    struct DecodeError
+    {
+        double position{0.0};
+        double normal{0.0};
+        double texcoord{0.0};
+    };
+
+    DecodeError measureError(const SponzaShape &encoded, const SponzaShape &floats)
+    {
+        DecodeError error;
+        for (size_t i = 0; i < floats.shapes.size(); ++i) {
+            const SponzaShape::Shape &shape = encoded.shapes[i];
+            const SponzaShape::Shape &source = floats.shapes[i];
+            const uint8_t *streams[MAX_VERTEX_STREAMS];
+            for (uint32_t s = 0; s < MAX_VERTEX_STREAMS; ++s) {
+                streams[s] = shape.streams[s].data();
+            }
+            const bool quantized = IsQuantized(shape.layout);
+            for (uint32_t v = 0; v < shape.vertexCount; ++v) {
+                float value[4];
+                DecodeAttribute(shape.layout, streams, v, VertexAttribute::Position, value, shape.quantization);
+                for (int c = 0; c < 3; ++c) {
+                    const float expected = source.positions[size_t(v) * 3 + c];
+                    // Half a step of the 16-bit grid, plus float rounding of the decode itself.
+                    const double bound = quantized ? shape.quantization.scale[c] / 131070.0 : 0.0;
+                    const double slack = 1e-6 * (std::fabs(expected) + shape.quantization.scale[c]) + 1e-30;
+                    error.position = std::max(error.position, std::fabs(value[c] - expected) / (bound + slack));
+                }
+
+                DecodeAttribute(shape.layout, streams, v, VertexAttribute::Normal, value, shape.quantization);
+                // Angle between the two, whatever their lengths: flat shaded faces keep unnormalized normals.
+                const double a[3] = {value[0], value[1], value[2]};
+                const float *normal = &source.normals[size_t(v) * 3];
+                const double b[3] = {normal[0], normal[1], normal[2]};
+                const double cross[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+                const double sine = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                error.normal = std::max(error.normal, std::atan2(sine, a[0] * b[0] + a[1] * b[1] + a[2] * b[2]));
+
+                DecodeAttribute(shape.layout, streams, v, VertexAttribute::Texcoord, value, shape.quantization);
+                for (int c = 0; c < 2; ++c) {
+                    const float expected = source.texcoords[size_t(v) * 2 + c];
+                    error.texcoord = std::max(error.texcoord,
+                                              double(std::fabs(value[c] - expected)) / std::max(std::fabs(expected), 1e-4f));
+                }
+            }
+        }
+        return error;
+    }
+
+    // Every half and a sweep of floats through the batch conversions, which
+    // take the F16C path at Avx2, against the scalar ones.
+    bool sameHalfConversions()
+    {
+        std::vector<uint16_t> halves(65536);
+        for (size_t i = 0; i < halves.size(); ++i) {
+            halves[i] = static_cast<uint16_t>(i);
+        }
+        std::vector<float> floats(halves.size());
+        HalfToFloat(halves.data(), floats.data(), halves.size());
+        for (size_t i = 0; i < halves.size(); ++i) {
+            const float expected = HalfToFloat(halves[i]);
+            if (std::memcmp(&floats[i], &expected, sizeof(float)) != 0 && !std::isnan(expected)) {
+                return false;
+            }
+        }
+
+        uint32_t seed = 7;
+        for (float &value : floats) {
+            seed = seed * 1664525u + 1013904223u;
+            uint32_t bits = seed;
+            std::memcpy(&value, &bits, sizeof(value));
+        }
+        FloatToHalf(floats.data(), halves.data(), floats.size());
+        for (size_t i = 0; i < floats.size(); ++i) {
+            if (halves[i] != FloatToHalf(floats[i]) && !std::isnan(floats[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Encoding at weld time must produce exactly what encoding the float build afterwards does.
+    bool sameStreams(const SponzaShape &encoded, SponzaShape floats, const VertexLayout &layout)
+    {
+        if (encoded.shapes.size() != floats.shapes.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < floats.shapes.size(); ++i) {
+            EncodeStreams(floats.shapes[i], layout);
+            for (uint32_t s = 0; s < MAX_VERTEX_STREAMS; ++s) {
+                if (encoded.shapes[i].streams[s] != floats.shapes[i].streams[s]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Tangents through Snorm16x2OctSign: direction within 0.0002 rad, twice
+    // the normal bound for the bit x gives up, and the bitangent sign exact,
+    // for random directions with either sign.
+    bool signedOctahedralRoundTrip()
+    {
+        const VertexLayout layout = VertexLayouts::QuantizedTangent::Describe();
+        std::vector<uint8_t> streams[MAX_VERTEX_STREAMS];
+        uint8_t *pointers[MAX_VERTEX_STREAMS] = {};
+        for (uint32_t s = 0; s < layout.streamCount; ++s) {
+            streams[s].resize(layout.strides[s]);
+            pointers[s] = streams[s].data();
+        }
+
+        uint32_t seed = 11;
+        auto next = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+        };
+        for (int i = 0; i < 100000; ++i) {
+            float tangent[4] = {next(), next(), next(), next() < 0.0f ? -1.0f : 1.0f};
+            if (std::fabs(tangent[0]) + std::fabs(tangent[1]) + std::fabs(tangent[2]) < 1e-3f) {
+                continue;
+            }
+            VertexAttributes attributes;
+            attributes.tangent = tangent;
+            EncodeVertex(layout, attributes, pointers, 0);
+            float decoded[4];
+            const uint8_t *const *readers = pointers;
+            DecodeAttribute(layout, readers, 0, VertexAttribute::Tangent, decoded);
+            const double cross[3] = {double(decoded[1]) * tangent[2] - double(decoded[2]) * tangent[1],
+                                     double(decoded[2]) * tangent[0] - double(decoded[0]) * tangent[2],
+                                     double(decoded[0]) * tangent[1] - double(decoded[1]) * tangent[0]};
+            const double sine = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            const double cosine = double(decoded[0]) * tangent[0] + double(decoded[1]) * tangent[1] +
+                                  double(decoded[2]) * tangent[2];
+            if (decoded[3] != tangent[3] || std::atan2(sine, cosine) > 2e-4) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Unorm16x2 texcoords take [0, 1] and nothing else: tiling ones have to
+    // fail the encode instead of coming back clamped.
+    bool unormTexcoordsChecked()
+    {
+        using Layout = VertexLayouts::Layout<
+            VertexLayouts::Stream<VertexLayouts::Element<VertexAttribute::Position, VertexLayouts::Float3>,
+                                  VertexLayouts::Element<VertexAttribute::Texcoord, VertexLayouts::Unorm16x2>>>;
+        const VertexLayout layout = Layout::Describe();
+        std::vector<uint8_t> stream(layout.strides[0]);
+        uint8_t *streams[MAX_VERTEX_STREAMS] = {stream.data()};
+        const float position[3] = {0.0f, 0.0f, 0.0f};
+        const float inside[2] = {0.0f, 1.0f};
+        const float tiled[2] = {2.5f, 0.5f};
+        const float negative[2] = {0.5f, -0.25f};
+        VertexAttributes attributes;
+        attributes.position = position;
+        attributes.texcoord = inside;
+        const bool accepted = EncodeVertex(layout, attributes, streams, 0);
+        attributes.texcoord = tiled;
+        const bool tiledRejected = !EncodeVertex(layout, attributes, streams, 0);
+        attributes.texcoord = negative;
+        const bool negativeRejected = !EncodeVertex(layout, attributes, streams, 0);
+        return accepted && tiledRejected && negativeRejected;
+    }
+}
+
+int Bench::RunLayout(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    MappedFile file;
+    Obj::Data data;
+    if (!file.Open(path) || !Obj::Parse(file.View(), data)) {
+        std::printf("layout: cannot load %s\n", path);
+        return 1;
+    }
+
+    SponzaShape floats;
+    Obj::BuildOptions options;
+    Timing timing = Measure(iterations, [&]() {
+        Obj::BuildShape(data, options, floats);
+    });
+    size_t floatBytes = 0;
+    for (const SponzaShape::Shape &shape : floats.shapes) {
+        floatBytes += (shape.positions.size() + shape.normals.size() + shape.texcoords.size()) * sizeof(float);
+    }
+    std::printf("%-28s %10s %10s %10s %10s %8s %10s %10s %10s %8s\n", "layout", "ms", "stride", "pos KB",
+                "total KB", "saved", "pos step", "normal rad", "uv rel", "check");
+    std::printf("%-28s %10.2f %10zu %10s %10.1f %8s %10s %10s %10s %8s\n", "float arrays", timing.minMs,
+                8 * sizeof(float), "-", floatBytes / 1024.0, "-", "-", "-", "-", "-");
+
+    int failures = 0;
+    for (const NamedLayout &named : LAYOUTS) {
+        SponzaShape encoded;
+        options.layout = &named.layout;
+        timing = Measure(iterations, [&]() {
+            Obj::BuildShape(data, options, encoded);
+        });
+
+        size_t stride = 0, positionBytes = 0, totalBytes = 0;
+        for (uint32_t s = 0; s < named.layout.streamCount; ++s) {
+            stride += named.layout.strides[s];
+        }
+        for (const SponzaShape::Shape &shape : encoded.shapes) {
+            positionBytes += shape.streams[0].size();
+            for (const std::vector<uint8_t> &stream : shape.streams) {
+                totalBytes += stream.size();
+            }
+        }
+
+        // Positions within half a step of the grid (1 = exactly half a step),
+        // oct16 normals within 0.0001 rad, halves within their 11-bit mantissa.
+        const DecodeError error = measureError(encoded, floats);
+        const bool bounded = error.position <= 1.0 && error.normal <= 1e-4 && error.texcoord <= 1.0 / 2048.0;
+        const bool same = sameStreams(encoded, floats, named.layout);
+        failures += same && bounded ? 0 : 1;
+        std::printf("%-28s %10.2f %10zu %10.1f %10.1f %7.1f%% %10.3f %10.2e %10.2e %8s\n", named.name, timing.minMs,
+                    stride, positionBytes / 1024.0, totalBytes / 1024.0,
+                    floatBytes > 0 ? 100.0 * (1.0 - double(totalBytes) / floatBytes) : 0.0, error.position,
+                    error.normal, error.texcoord, same && bounded ? "ok" : "FAIL");
+    }
+
+    const bool halves = sameHalfConversions();
+    failures += halves ? 0 : 1;
+    const bool tangents = signedOctahedralRoundTrip();
+    failures += tangents ? 0 : 1;
+    const bool unorm = unormTexcoordsChecked();
+    failures += unorm ? 0 : 1;
+    std::printf("half conversion at %s: %s, signed octahedral tangents: %s, unorm16 texcoord range: %s\n",
+                SimdLevelName(ActiveSimdLevel()), halves ? "ok" : "FAIL", tangents ? "ok" : "FAIL",
+                unorm ? "ok" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/MeshOptimizer.hpp>
+#include <ResourceManager/MeshSimplifier.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    using Edge = std::pair<uint32_t, uint32_t>;
+
+    // Every vertex numbered by the first vertex at its position.
+    std::vector<uint32_t> positionIds(const std::vector<float> &positions)
+    {
+        std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> first;
+        std::vector<uint32_t> ids(positions.size() / 3);
+        for (uint32_t v = 0; v < ids.size(); ++v) {
+            uint32_t bits[3];
+            std::memcpy(bits, &positions[size_t(v) * 3], sizeof(bits));
+            ids[v] = first.emplace(std::make_tuple(bits[0], bits[1], bits[2]), v).first->second;
+        }
+        return ids;
+    }
+
+    // Edges between positions that no triangle walks back: the holes and
+    // borders of the surface, UV seams do not count.
+    std::vector<Edge> openEdges(const std::vector<unsigned int> &indices, const std::vector<uint32_t> &ids)
+    {
+        std::map<Edge, int> edges;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (size_t c = 0; c < 3; ++c) {
+                const uint32_t a = ids[indices[i + c]];
+                const uint32_t b = ids[indices[i + (c + 1) % 3]];
+                if (a != b) {
+                    ++edges[{a, b}];
+                }
+            }
+        }
+        std::vector<Edge> open;
+        for (const auto &[edge, count] : edges) {
+            const auto back = edges.find({edge.second, edge.first});
+            const int backCount = back != edges.end() ? back->second : 0;
+            for (int i = backCount; i < count; ++i) {
+                open.push_back(edge);
+            }
+        }
+        return open;
+    }
+
+    float diagonal(const Bounds &bounds)
+    {
+        const float extent[3] = {bounds.max[0] - bounds.min[0], bounds.max[1] - bounds.min[1],
+                                 bounds.max[2] - bounds.min[2]};
+        return std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]);
+    }
+
+    // Indices in range, levels shrinking, errors within the limit and the
+    // borders and seams of the full shape still there at every level.
+    bool checkLods(const SponzaShape::Shape &shape, const LodOptions &options)
+    {
+        std::vector<float> positions;
+        if (!ShapePositions(shape, positions)) {
+            return shape.lods.empty();
+        }
+        const std::vector<uint32_t> ids = positionIds(positions);
+        const std::vector<Edge> borders = openEdges(shape.indicies, ids);
+        const float limit = options.simplify.maxError * diagonal(shape.bounds) * 1.001f;
+
+        size_t previous = shape.indicies.size();
+        for (const MeshLod &lod : shape.lods) {
+            if (lod.indices.empty() || lod.indices.size() % 3 != 0 || lod.indices.size() >= previous ||
+                lod.error > limit) {
+                return false;
+            }
+            for (unsigned int index : lod.indices) {
+                if (index >= shape.vertexCount) {
+                    return false;
+                }
+            }
+            if (options.simplify.lockBorders && openEdges(lod.indices, ids) != borders) {
+                return false;
+            }
+            previous = lod.indices.size();
+        }
+        return true;
+    }
+
+    // Every level read back from the cooked file, and SelectLod going from
+    // the last level without error up close (full detail unless simplifying
+    // lost nothing, as on planar shapes) to the coarsest level far away.
+    bool sameLods(const SponzaShape &sponza, const CookedMesh &mesh)
+    {
+        for (uint32_t i = 0; i < mesh.SubmeshCount(); ++i) {
+            const SponzaShape::Shape &shape = sponza.shapes[i];
+            const CookedSubmesh &submesh = mesh.Submesh(i);
+            uint32_t exact = 0;
+            while (exact < shape.lods.size() && shape.lods[exact].error == 0.0f) {
+                ++exact;
+            }
+            if (submesh.lodCount != shape.lods.size() + 1 || mesh.SelectLod(i, 0.0f, 1000.0f, 1.0f) != exact ||
+                mesh.SelectLod(i, 1e30f, 1000.0f, 1.0f) != submesh.lodCount - 1) {
+                return false;
+            }
+            for (uint32_t l = 1; l < submesh.lodCount; ++l) {
+                const CookedLod &lod = submesh.lods[l];
+                const MeshLod &source = shape.lods[l - 1];
+                if (lod.indexCount != source.indices.size() || lod.error != source.error ||
+                    !std::equal(mesh.Indices() + lod.firstIndex, mesh.Indices() + lod.firstIndex + lod.indexCount,
+                                source.indices.begin())) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int Bench::RunLod(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+
+    const VertexLayout layout = VertexLayouts::DepthAndShading::Describe();
+    Obj::LoadOptions loadOptions;
+    loadOptions.layout = &layout;
+    loadOptions.optimize = true;
+    SponzaShape sponza;
+    if (!Obj::LoadFile(path, sponza, loadOptions)) {
+        std::printf("lod: cannot load %s\n", path);
+        return 1;
+    }
+
+    const LodOptions options;
+    std::vector<LodStats> stats;
+    GenerateLods(sponza, options, 1, &stats);
+
+    std::printf("targets: %u levels, %.0f%% of the level before, error limit %.1f%% of the shape diagonal\n",
+                options.levelCount, options.reduction * 100.0, options.simplify.maxError * 100.0);
+    std::printf("%-28s %9s %27s %33s %9s %9s %s\n", "shape", "triangles", "LOD 1..3 triangles",
+                "LOD 1..3 error (% diagonal)", "ms", "Mtri/s", "check");
+    size_t triangles = 0, failures = 0;
+    size_t levelTriangles[MAX_MESH_LODS] = {};
+    double milliseconds = 0.0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const LodStats &shape = stats[i];
+        const bool ok = checkLods(sponza.shapes[i], options);
+        const float scale = 100.0f / std::max(diagonal(sponza.shapes[i].bounds), 1e-30f);
+        char counts[64] = "";
+        char errors[64] = "";
+        for (size_t level = 1; level < MAX_MESH_LODS; ++level) {
+            char count[16] = "-", error[16] = "-";
+            if (level < shape.triangleCounts.size()) {
+                std::snprintf(count, sizeof(count), "%zu", shape.triangleCounts[level]);
+                std::snprintf(error, sizeof(error), "%.3f", shape.errors[level] * scale);
+            }
+            std::snprintf(counts + std::strlen(counts), sizeof(counts) - std::strlen(counts), " %8s", count);
+            std::snprintf(errors + std::strlen(errors), sizeof(errors) - std::strlen(errors), " %10s", error);
+        }
+        const size_t full = shape.triangleCounts.front();
+        std::printf("%-28.28s %9zu %27s %33s %9.2f %9.2f %s\n", shape.name.c_str(), full, counts, errors,
+                    shape.milliseconds, shape.milliseconds > 0.0 ? full / (shape.milliseconds * 1000.0) : 0.0,
+                    ok ? "ok" : "FAIL");
+        triangles += full;
+        for (size_t level = 0; level < MAX_MESH_LODS; ++level) {
+            levelTriangles[level] += level < shape.triangleCounts.size() ? shape.triangleCounts[level] : 0;
+        }
+        milliseconds += shape.milliseconds;
+        failures += ok ? 0 : 1;
+    }
+    std::printf("total: %zu triangles, LOD 1..3 %zu / %zu / %zu (shapes that stop early count as 0), %.2f ms\n",
+                triangles, levelTriangles[1], levelTriangles[2], levelTriangles[3], milliseconds);
+
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%-8s %12s %12s %12s\n", "threads", "min ms", "median ms", "Mtri/s");
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        const Timing timing = Measure(iterations, [&]() { GenerateLods(sponza, options, threads); });
+        std::printf("%-8u %12.2f %12.2f %12.2f\n", threads, timing.minMs, timing.medianMs,
+                    timing.minMs > 0.0 ? triangles / (timing.minMs * 1000.0) : 0.0);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    std::string cookedPath = path;
+    cookedPath = cookedPath.substr(0, cookedPath.rfind('.')) + ".lod.cmesh";
+    CookedMesh cooked;
+    const bool roundTrip = WriteCookedMesh(cookedPath.c_str(), sponza) && cooked.Open(cookedPath.c_str()) &&
+                           sameLods(sponza, cooked);
+    cooked.Close();
+    std::remove(cookedPath.c_str());
+
+    std::printf("lod chains: %s, cooked round trip: %s\n", failures == 0 ? "ok" : "FAIL", roundTrip ? "ok" : "FAIL");
+    return failures == 0 && roundTrip ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#include "Benchmarks.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    struct Entry
+    {
+        const char *name;
+        int (*run)(int argc, char **argv);
+        const char *usage;
+    };
+
+    const Entry BENCHMARKS[] = {
+        {"obj", &Bench::RunObjLoad, "obj [path.obj] [iterations]  - mapped OBJ reader vs objl::Loader"},
+        {"weld", &Bench::RunWeld, "weld [path.obj] [iterations] - per-shape vertex welding stats"},
+        {"triangulate", &Bench::RunTriangulate, "triangulate [iterations]    - convex/concave faces with 3..16 corners"},
+        {"layout", &Bench::RunLayout, "layout [path.obj] [iterations] - vertex stream layouts, sizes and encode cost"},
+        {"cmesh", &Bench::RunCookedMesh, "cmesh [path.obj] [iterations]  - cook to .cmesh, cold/warm startup vs OBJ"},
+        {"async", &Bench::RunAsyncLoad, "async [path.obj] [loads] [threads] - prioritized background loads in a frame loop"},
+        {"tga", &Bench::RunTga, "tga [directory] [iterations]   - TGA decode throughput per SIMD level"},
+        {"mips", &Bench::RunMips, "mips [directory] [iterations]  - mip chains per filter, SIMD level and thread count"},
+        {"bc", &Bench::RunBlockCompression, "bc [directory] [iterations]    - BC1/BC4/BC5/BC7 presets, throughput and PSNR"},
+        {"ctex", &Bench::RunCookedTexture, "ctex [directory] [iterations]  - .ctex round trip, layout and mip tail streaming"},
+        {"residency", &Bench::RunResidency, "residency [cooked dir] [budget MB] [frames] - mip streaming under a VRAM budget"},
+        {"vt", &Bench::RunVirtualTexture, "vt [frames] [cache tiles]      - virtual texture page table and tile cache"},
+        {"pipeline", &Bench::RunPipeline, "pipeline [directory] [json] [iterations] - texture pipeline stages, thread scaling, JSON results"},
+        {"vcache", &Bench::RunVertexCache, "vcache [path.obj] [iterations] - vertex cache/overdraw/fetch reordering, ACMR/ATVR per shape"},
+        {"meshlets", &Bench::RunMeshlets, "meshlets [path.obj] [views] [iterations] - meshlet build, cooked round trip, cluster vs per-shape culling"},
+        {"lod", &Bench::RunLod, "lod [path.obj] [iterations]    - quadric LOD chains per shape, error and throughput"},
+        {"tangents", &Bench::RunTangents, "tangents [path.obj] [iterations] - tangent frames per shape against a MikkTSpace reference, octahedral round trip"},
+    };
+
+    void printUsage()
+    {
+        std::printf("usage: chelson-bench <benchmark> [args]\n");
+        for (const Entry &entry : BENCHMARKS) {
+            std::printf("  %s\n", entry.usage);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    for (const Entry &entry : BENCHMARKS) {
+        if (std::strcmp(argv[1], entry.name) == 0) {
+            return entry.run(argc - 2, argv + 2);
+        }
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,276 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/MeshOptimizer.hpp>
+#include <ResourceManager/Meshlets.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Meshlets of one shape with the positions they index, for the checks.
+    struct ShapeMeshlets
+    {
+        const SponzaShape::Shape *shape;
+        std::vector<float> positions;
+    };
+
+    const float *corner(const ShapeMeshlets &mesh, const Meshlet &meshlet, uint32_t triangle, uint32_t c)
+    {
+        const uint32_t packed = mesh.shape->meshletTriangles[meshlet.firstTriangle + triangle];
+        const uint32_t vertex = mesh.shape->meshletVertices[meshlet.firstVertex + ((packed >> (c * 8)) & 0xff)];
+        return &mesh.positions[size_t(vertex) * 3];
+    }
+
+    void triangleNormal(const float *p0, const float *p1, const float *p2, float *normal)
+    {
+        const float a[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const float b[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        normal[0] = a[1] * b[2] - a[2] * b[1];
+        normal[1] = a[2] * b[0] - a[0] * b[2];
+        normal[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // Limits, triangle order, spheres and cones of every meshlet of a shape.
+    bool checkMeshlets(const ShapeMeshlets &mesh)
+    {
+        const SponzaShape::Shape &shape = *mesh.shape;
+        if (shape.meshlets.size() != shape.meshletBounds.size()) {
+            return false;
+        }
+        size_t index = 0;
+        for (size_t m = 0; m < shape.meshlets.size(); ++m) {
+            const Meshlet &meshlet = shape.meshlets[m];
+            const MeshletBounds &bounds = shape.meshletBounds[m];
+            if (meshlet.vertexCount == 0 || meshlet.vertexCount > MAX_MESHLET_VERTICES || meshlet.triangleCount == 0 ||
+                meshlet.triangleCount > MAX_MESHLET_TRIANGLES) {
+                return false;
+            }
+
+            for (uint32_t v = 0; v < meshlet.vertexCount; ++v) {
+                const float *p = &mesh.positions[size_t(shape.meshletVertices[meshlet.firstVertex + v]) * 3];
+                const float d[3] = {p[0] - bounds.center[0], p[1] - bounds.center[1], p[2] - bounds.center[2]};
+                if (std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) > bounds.radius) {
+                    return false;
+                }
+            }
+
+            const float minimum = bounds.cutoff < 1.0f ? std::sqrt(1.0f - bounds.cutoff * bounds.cutoff) : -1.0f;
+            for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+                const uint32_t packed = shape.meshletTriangles[meshlet.firstTriangle + t];
+                for (uint32_t c = 0; c < 3; ++c) {
+                    const uint32_t local = (packed >> (c * 8)) & 0xff;
+                    if (local >= meshlet.vertexCount ||
+                        shape.meshletVertices[meshlet.firstVertex + local] != shape.indicies[index++]) {
+                        return false;
+                    }
+                }
+                float normal[3];
+                triangleNormal(corner(mesh, meshlet, t, 0), corner(mesh, meshlet, t, 1), corner(mesh, meshlet, t, 2),
+                               normal);
+                const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                if (length > 0.0f && (normal[0] * bounds.axis[0] + normal[1] * bounds.axis[1] +
+                                      normal[2] * bounds.axis[2]) < (minimum - 1e-4f) * length) {
+                    return false;
+                }
+            }
+        }
+        return index == shape.indicies.size();
+    }
+
+    // A meshlet the cone test dropped must have no triangle facing the eye.
+    bool isBackfacing(const ShapeMeshlets &mesh, const Meshlet &meshlet, const float *eye)
+    {
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+            const float *p0 = corner(mesh, meshlet, t, 0);
+            float normal[3];
+            triangleNormal(p0, corner(mesh, meshlet, t, 1), corner(mesh, meshlet, t, 2), normal);
+            const float toTriangle[3] = {p0[0] - eye[0], p0[1] - eye[1], p0[2] - eye[2]};
+            if (normal[0] * toTriangle[0] + normal[1] * toTriangle[1] + normal[2] * toTriangle[2] < -1e-5f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Cameras spread through the scene, looking around at eye height.
+    std::vector<CullView> makeViews(const Bounds &scene, int count)
+    {
+        std::vector<CullView> views;
+        uint32_t seed = 2024;
+        auto next = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+        const float extent[3] = {scene.max[0] - scene.min[0], scene.max[1] - scene.min[1], scene.max[2] - scene.min[2]};
+        const float farZ = std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]);
+        const float up[3] = {0.0f, 1.0f, 0.0f};
+        for (int i = 0; i < count; ++i) {
+            float eye[3];
+            for (int a = 0; a < 3; ++a) {
+                eye[a] = scene.min[a] + extent[a] * (0.1f + 0.8f * next());
+            }
+            eye[1] = scene.min[1] + extent[1] * (0.05f + 0.3f * next());
+            const float yaw = 6.2831853f * next();
+            const float pitch = 0.6f * (next() - 0.5f);
+            const float forward[3] = {std::cos(yaw) * std::cos(pitch), std::sin(pitch), std::sin(yaw) * std::cos(pitch)};
+            views.push_back(MakeCullView(eye, forward, up, 1.0471976f, 16.0f / 9.0f, 0.01f * farZ, farZ));
+        }
+        return views;
+    }
+
+    bool sameMeshlets(const SponzaShape &sponza, const CookedMesh &mesh)
+    {
+        size_t total = 0;
+        for (uint32_t i = 0; i < mesh.SubmeshCount(); ++i) {
+            const SponzaShape::Shape &shape = sponza.shapes[i];
+            const CookedSubmesh &submesh = mesh.Submesh(i);
+            if (submesh.meshletCount != shape.meshlets.size()) {
+                return false;
+            }
+            for (uint32_t m = 0; m < submesh.meshletCount; ++m) {
+                const Meshlet &cooked = mesh.Meshlets()[submesh.firstMeshlet + m];
+                const Meshlet &source = shape.meshlets[m];
+                if (cooked.vertexCount != source.vertexCount || cooked.triangleCount != source.triangleCount ||
+                    std::memcmp(&mesh.GetMeshletBounds()[submesh.firstMeshlet + m], &shape.meshletBounds[m],
+                                sizeof(MeshletBounds)) != 0 ||
+                    !std::equal(mesh.MeshletVertices() + cooked.firstVertex,
+                                mesh.MeshletVertices() + cooked.firstVertex + cooked.vertexCount,
+                                shape.meshletVertices.begin() + source.firstVertex) ||
+                    !std::equal(mesh.MeshletTriangles() + cooked.firstTriangle,
+                                mesh.MeshletTriangles() + cooked.firstTriangle + cooked.triangleCount,
+                                shape.meshletTriangles.begin() + source.firstTriangle)) {
+                    return false;
+                }
+            }
+            total += submesh.meshletCount;
+        }
+        return total == mesh.MeshletCount();
+    }
+}
+
+int Bench::RunMeshlets(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int viewCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    const VertexLayout layout = VertexLayouts::DepthAndShading::Describe();
+    Obj::LoadOptions options;
+    options.layout = &layout;
+    options.optimize = true;
+    SponzaShape sponza;
+    if (!Obj::LoadFile(path, sponza, options)) {
+        std::printf("meshlets: cannot load %s\n", path);
+        return 1;
+    }
+
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    const Timing build = Measure(iterations, [&]() { BuildMeshlets(sponza, maxThreads); });
+
+    // Everything culling needs, flattened across shapes the way the cooked file has it.
+    std::vector<ShapeMeshlets> meshes;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> meshletShape;
+    std::vector<uint32_t> meshletIndex;
+    Bounds scene;
+    size_t triangleCount = 0;
+    bool valid = true;
+    for (const SponzaShape::Shape &shape : sponza.shapes) {
+        ShapeMeshlets mesh{&shape, {}};
+        valid &= ShapePositions(shape, mesh.positions) && checkMeshlets(mesh);
+        for (size_t m = 0; m < shape.meshlets.size(); ++m) {
+            bounds.push_back(shape.meshletBounds[m]);
+            meshletShape.push_back(static_cast<uint32_t>(meshes.size()));
+            meshletIndex.push_back(static_cast<uint32_t>(m));
+        }
+        scene.Extend(shape.bounds);
+        triangleCount += shape.indicies.size() / 3;
+        meshes.push_back(std::move(mesh));
+    }
+
+    size_t coneless = 0;
+    for (const MeshletBounds &meshlet : bounds) {
+        coneless += meshlet.cutoff >= 1.0f ? 1 : 0;
+    }
+    std::printf("%s: %zu shapes, %zu triangles, %zu meshlets (%.1f triangles each, %zu without a cone)\n", path,
+                sponza.shapes.size(), triangleCount, bounds.size(),
+                bounds.empty() ? 0.0 : double(triangleCount) / bounds.size(), coneless);
+    std::printf("build: %.2f ms min, %.2f ms median on %u threads\n", build.minMs, build.medianMs, maxThreads);
+
+    std::string cookedPath = path;
+    cookedPath = cookedPath.substr(0, cookedPath.rfind('.')) + ".meshlets.cmesh";
+    CookedMesh cooked;
+    const bool roundTrip = WriteCookedMesh(cookedPath.c_str(), sponza) && cooked.Open(cookedPath.c_str()) &&
+                           sameMeshlets(sponza, cooked);
+    cooked.Close();
+    std::remove(cookedPath.c_str());
+
+    // Frustum only: the same spheres with cones that never cull.
+    std::vector<MeshletBounds> spheres = bounds;
+    for (MeshletBounds &sphere : spheres) {
+        sphere.cutoff = 1.0f;
+    }
+
+    const std::vector<CullView> views = makeViews(scene, viewCount);
+    std::vector<uint32_t> visible(bounds.size());
+    size_t shapeTriangles = 0, sphereTriangles = 0, coneTriangles = 0;
+    bool conservative = true;
+    for (const CullView &view : views) {
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            shapeTriangles += IsVisible(view, shape.bounds) ? shape.indicies.size() / 3 : 0;
+        }
+        const size_t sphereCount = CullMeshlets(view, spheres.data(), spheres.size(), visible.data());
+        for (size_t i = 0; i < sphereCount; ++i) {
+            sphereTriangles += meshes[meshletShape[visible[i]]].shape->meshlets[meshletIndex[visible[i]]].triangleCount;
+        }
+
+        const size_t coneCount = CullMeshlets(view, bounds.data(), bounds.size(), visible.data());
+        size_t kept = 0;
+        for (size_t m = 0; m < bounds.size(); ++m) {
+            const ShapeMeshlets &mesh = meshes[meshletShape[m]];
+            const Meshlet &meshlet = mesh.shape->meshlets[meshletIndex[m]];
+            if (kept < coneCount && visible[kept] == m) {
+                coneTriangles += meshlet.triangleCount;
+                ++kept;
+            } else if (IsVisible(view, spheres[m])) {
+                conservative &= isBackfacing(mesh, meshlet, view.eye);
+            }
+        }
+    }
+
+    uint64_t checksum = 0;
+    const Timing shapeTiming = Measure(iterations, [&]() {
+        for (const CullView &view : views) {
+            for (const SponzaShape::Shape &shape : sponza.shapes) {
+                checksum += IsVisible(view, shape.bounds) ? 1 : 0;
+            }
+        }
+    });
+    const Timing meshletTiming = Measure(iterations, [&]() {
+        for (const CullView &view : views) {
+            checksum += CullMeshlets(view, bounds.data(), bounds.size(), visible.data());
+        }
+    });
+
+    const double perView = 1.0 / views.size();
+    auto share = [triangleCount](double triangles) { return triangleCount > 0 ? 100.0 * triangles / triangleCount : 0.0; };
+    std::printf("%-24s %14s %8s %14s\n", "culling", "triangles/view", "kept", "us/view");
+    std::printf("%-24s %14.0f %7.1f%% %14.2f\n", "per shape (box)", shapeTriangles * perView,
+                share(shapeTriangles * perView), shapeTiming.minMs * 1000.0 * perView);
+    std::printf("%-24s %14.0f %7.1f%% %14s\n", "meshlet sphere", sphereTriangles * perView,
+                share(sphereTriangles * perView), "");
+    std::printf("%-24s %14.0f %7.1f%% %14.2f\n", "meshlet sphere + cone", coneTriangles * perView,
+                share(coneTriangles * perView), meshletTiming.minMs * 1000.0 * perView);
+    std::printf("meshlets: %s, cooked round trip: %s, cone culling: %s (checksum %llu)\n", valid ? "ok" : "FAIL",
+                roundTrip ? "ok" : "FAIL", conservative ? "ok" : "FAIL", static_cast<unsigned long long>(checksum));
+    return valid && roundTrip && conservative ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CpuFeatures.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    Image makeImage(uint32_t width, uint32_t height, PixelFormat format)
+    {
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.format = format;
+        image.pixels.Allocate(image.RowPitch() * height);
+        return image;
+    }
+
+    // Black and white texels: filtered in linear space the first mip is 50%
+    // linear grey, which is sRGB 188, not the 128 a gamma-space average gives.
+    Image makeCheckerboard(uint32_t size)
+    {
+        Image image = makeImage(size, size, PixelFormat::RGBA8);
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const uint8_t value = (x + y) % 2 == 0 ? 255 : 0;
+                uint8_t *texel = image.pixels.Data.get() + (size_t(y) * size + x) * 4;
+                texel[0] = texel[1] = texel[2] = value;
+                texel[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    // Thin noisy branches on transparent ground, like a foliage alpha mask.
+    Image makeMask(uint32_t size)
+    {
+        Image image = makeImage(size, size, PixelFormat::RGBA8);
+        uint32_t seed = 12345;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                // Distance to the nearest of two sets of diagonal strokes, with soft edges.
+                const int first = static_cast<int>((x * 7 + y * 3) % 23);
+                const int second = static_cast<int>((x * 5 + y * 11) % 31);
+                const int edge = std::max(255 - first * 80, 230 - second * 90);
+                uint8_t *texel = image.pixels.Data.get() + (size_t(y) * size + x) * 4;
+                texel[0] = static_cast<uint8_t>(seed >> 24);
+                texel[1] = static_cast<uint8_t>(seed >> 16);
+                texel[2] = 40;
+                texel[3] = static_cast<uint8_t>(std::clamp(edge + static_cast<int>(seed >> 27) - 16, 0, 255));
+            }
+        }
+        return image;
+    }
+
+    float alphaCoverage(const Image &image, float cutoff)
+    {
+        const uint32_t channels = BytesPerPixel(image.format);
+        const size_t count = size_t(image.width) * image.height;
+        size_t passing = 0;
+        for (size_t i = 0; i < count; ++i) {
+            passing += image.pixels.Data[i * channels + channels - 1] > cutoff * 255.0f ? 1 : 0;
+        }
+        return float(passing) / count;
+    }
+
+    bool sameChain(const MipChain &a, const MipChain &b)
+    {
+        if (a.levels.size() != b.levels.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.levels.size(); ++i) {
+            const Image &x = a.levels[i];
+            const Image &y = b.levels[i];
+            if (x.width != y.width || x.height != y.height || x.pixels.Size != y.pixels.Size ||
+                std::memcmp(x.pixels.Data.get(), y.pixels.Data.get(), x.pixels.Size) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t sourceBytes(const std::vector<const Image *> &images)
+    {
+        size_t bytes = 0;
+        for (const Image *image : images) {
+            bytes += image->pixels.Size;
+        }
+        return bytes;
+    }
+}
+
+// Builds mip chains for the textures in a directory and for synthetic sRGB
+// and alpha-mask images, per filter, SIMD level and thread count.
+int Bench::RunMips(int argc, char **argv)
+{
+    const char *directory = argc > 0 ? argv[0] : "assets/sponza/textures_pbr";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 3;
+
+    std::vector<Image> decoded;
+    std::vector<std::string> names;
+    std::error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error)) {
+        const std::string extension = Text::ToLower(entry.path().extension().string());
+        Image image;
+        if (extension == ".tga" && Tga::LoadFile(entry.path().string().c_str(), image)) {
+            decoded.push_back(std::move(image));
+            names.push_back(entry.path().filename().string());
+        }
+    }
+    decoded.push_back(makeCheckerboard(1024));
+    names.push_back("checker_diffuse.tga");
+    decoded.push_back(makeMask(1024));
+    names.push_back("thorn_mask.tga");
+
+    std::vector<const Image *> sources;
+    std::vector<MipOptions> options;
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        sources.push_back(&decoded[i]);
+        options.push_back(MipOptionsForTexture(names[i]));
+    }
+    const size_t bytes = sourceBytes(sources);
+    std::printf("%zu textures, %.1f MB\n", sources.size(), bytes / (1024.0 * 1024.0));
+
+    const SimdLevel best = ActiveSimdLevel();
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    bool isValid = true;
+    std::printf("%-8s %-8s %8s %12s %10s\n", "filter", "simd", "threads", "ms", "MB/s");
+    for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser}) {
+        for (MipOptions &option : options) {
+            option.filter = filter;
+        }
+        std::vector<MipChain> reference;
+        for (int level = 0; level <= static_cast<int>(best); ++level) {
+            LimitSimdLevel(static_cast<SimdLevel>(level));
+            for (unsigned threads : {1u, cores}) {
+                std::vector<MipChain> chains;
+                const Timing timing = Measure(iterations, [&]() {
+                    isValid &= GenerateMips(sources, options, chains, threads);
+                });
+                if (reference.empty()) {
+                    reference = std::move(chains);
+                } else {
+                    for (size_t i = 0; i < chains.size(); ++i) {
+                        isValid &= sameChain(chains[i], reference[i]);
+                    }
+                }
+                std::printf("%-8s %-8s %8u %12.2f %10.1f\n", filter == MipFilter::Box ? "box" : "kaiser",
+                            SimdLevelName(static_cast<SimdLevel>(level)), threads, timing.minMs,
+                            MegabytesPerSecond(bytes, timing.minMs));
+                if (cores == 1) {
+                    break;
+                }
+            }
+        }
+        LimitSimdLevel(best);
+
+        // Same chain when one texture's rows are split across threads instead.
+        MipOptions rowSplit = options.back();
+        rowSplit.threadCount = std::max(cores, 4u);
+        MipChain split;
+        isValid &= GenerateMips(*sources.back(), rowSplit, split) && sameChain(split, reference.back());
+    }
+
+    // Box filtered checkerboard: every texel of mip 1 is linear 0.5.
+    MipOptions srgb = MipOptionsForTexture("checker_diffuse.tga");
+    MipOptions gamma = srgb;
+    gamma.srgb = false;
+    MipChain linearChain;
+    MipChain gammaChain;
+    const Image &checker = decoded[decoded.size() - 2];
+    isValid &= GenerateMips(checker, srgb, linearChain) && GenerateMips(checker, gamma, gammaChain);
+    const uint8_t linearGrey = linearChain.levels[1].pixels.Data[0];
+    const uint8_t gammaGrey = gammaChain.levels[1].pixels.Data[0];
+    isValid &= linearGrey == 188 && linearChain.levels[1].pixels.Data[3] == 255;
+    std::printf("checker mip 1: %u in linear space, %u in gamma space\n", linearGrey, gammaGrey);
+
+    // Alpha coverage per level with and without preservation.
+    const Image &mask = decoded.back();
+    MipOptions preserved = MipOptionsForTexture("thorn_mask.tga");
+    MipOptions plain = preserved;
+    plain.preserveAlphaCoverage = false;
+    MipChain preservedChain;
+    MipChain plainChain;
+    isValid &= preserved.preserveAlphaCoverage && GenerateMips(mask, preserved, preservedChain) &&
+               GenerateMips(mask, plain, plainChain);
+    const float target = alphaCoverage(mask, preserved.alphaCutoff);
+    std::printf("%-6s %10s %10s %10s\n", "level", "size", "plain", "preserved");
+    float worst = 0.0f;
+    for (size_t level = 0; level < preservedChain.levels.size(); ++level) {
+        const Image &image = preservedChain.levels[level];
+        const float kept = alphaCoverage(image, preserved.alphaCutoff);
+        if (image.width >= 32) {
+            worst = std::max(worst, std::abs(kept - target));
+        }
+        std::printf("%-6zu %4ux%-5u %10.3f %10.3f\n", level, image.width, image.height,
+                    alphaCoverage(plainChain.levels[level], plain.alphaCutoff), kept);
+    }
+    isValid &= worst < 0.02f;
+
+    std::printf("simd, threads and filtering checks: %s\n", isValid ? "ok" : "FAIL");
+    return isValid ? 0 : 1;
+}
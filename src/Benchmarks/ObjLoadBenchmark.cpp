@@ -0,0 +1,153 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <external/ObjLoader/ObjLoader.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // The loading path LoadSponzaShape used before the mapped reader.
+    bool loadWithObjl(const char *path, SponzaShape &sponza)
+    {
+        sponza = SponzaShape{};
+        objl::Loader objLoader;
+
+        if (!objLoader.LoadFile(path)) {
+            return false;
+        }
+
+        for (const objl::Mesh &curMesh : objLoader.LoadedMeshes) {
+            SponzaShape::Shape curShape;
+            curShape.name = curMesh.MeshName;
+            for (const objl::Vertex &vertex : curMesh.Vertices) {
+                curShape.positions.push_back(vertex.Position.X);
+                curShape.positions.push_back(vertex.Position.Y);
+                curShape.positions.push_back(vertex.Position.Z);
+
+                curShape.normals.push_back(vertex.Normal.X);
+                curShape.normals.push_back(vertex.Normal.Y);
+                curShape.normals.push_back(vertex.Normal.Z);
+            }
+            for (unsigned int index : curMesh.Indices) {
+                curShape.indicies.push_back(index);
+            }
+            sponza.shapes.push_back(std::move(curShape));
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool sameBits(const std::vector<T> &a, const std::vector<T> &b)
+    {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    bool sameData(const Obj::Data &a, const Obj::Data &b)
+    {
+        if (!sameBits(a.positions, b.positions) || !sameBits(a.texcoords, b.texcoords)
+            || !sameBits(a.normals, b.normals) || a.groups.size() != b.groups.size()
+            || a.corners.size() != b.corners.size() || a.faces.size() != b.faces.size()
+            || a.materialLibraries != b.materialLibraries) {
+            return false;
+        }
+        for (size_t i = 0; i < a.corners.size(); ++i) {
+            const Obj::Corner &ca = a.corners[i];
+            const Obj::Corner &cb = b.corners[i];
+            if (ca.position != cb.position || ca.texcoord != cb.texcoord || ca.normal != cb.normal) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < a.faces.size(); ++i) {
+            if (a.faces[i].firstCorner != b.faces[i].firstCorner || a.faces[i].cornerCount != b.faces[i].cornerCount) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < a.groups.size(); ++i) {
+            const Obj::Group &ga = a.groups[i];
+            const Obj::Group &gb = b.groups[i];
+            if (ga.name != gb.name || ga.material != gb.material
+                || ga.firstFace != gb.firstFace || ga.faceCount != gb.faceCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void countShape(const SponzaShape &sponza, size_t &vertices, size_t &indices)
+    {
+        vertices = 0;
+        indices = 0;
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            vertices += shape.positions.size() / 3;
+            indices += shape.indicies.size();
+        }
+    }
+}
+
+int Bench::RunObjLoad(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        std::printf("obj: cannot open %s\n", path);
+        return 1;
+    }
+    const size_t bytes = file.Size();
+
+    // Thread scaling of the parse step over the already mapped file.
+    Obj::Data single;
+    Obj::Parse(file.View(), single, 1);
+
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("\n%-8s %10s %10s %10s %10s\n", "threads", "min ms", "MB/s", "scaling", "identical");
+    double singleMs = 0.0;
+    for (unsigned threads = 1; threads <= std::max(maxThreads, 16u); threads *= 2) {
+        Obj::Data data;
+        Timing timing = Measure(iterations, [&]() {
+            Obj::Parse(file.View(), data, threads);
+        });
+        if (threads == 1) {
+            singleMs = timing.minMs;
+        }
+        std::printf("%-8u %10.2f %10.1f %9.2fx %10s\n", threads, timing.minMs, MegabytesPerSecond(bytes, timing.minMs),
+                    timing.minMs > 0.0 ? singleMs / timing.minMs : 0.0, sameData(single, data) ? "yes" : "NO");
+    }
+    file.Close();
+
+    SponzaShape mapped;
+    Timing mappedTiming = Measure(iterations, [&]() {
+        Obj::LoadFile(path, mapped);
+    });
+
+    SponzaShape reference;
+    Timing objlTiming = Measure(iterations, [&]() {
+        loadWithObjl(path, reference);
+    });
+
+    size_t mappedVertices, mappedIndices, objlVertices, objlIndices;
+    countShape(mapped, mappedVertices, mappedIndices);
+    countShape(reference, objlVertices, objlIndices);
+
+    std::printf("\n%s: %.1f MB, %d iterations\n", path, bytes / (1024.0 * 1024.0), iterations);
+    std::printf("%-12s %10s %10s %10s %8s %12s %12s\n", "loader", "min ms", "median ms", "MB/s", "shapes", "vertices", "indices");
+    std::printf("%-12s %10.2f %10.2f %10.1f %8zu %12zu %12zu\n", "mapped",
+                mappedTiming.minMs, mappedTiming.medianMs, MegabytesPerSecond(bytes, mappedTiming.minMs),
+                mapped.shapes.size(), mappedVertices, mappedIndices);
+    std::printf("%-12s %10.2f %10.2f %10.1f %8zu %12zu %12zu\n", "objl",
+                objlTiming.minMs, objlTiming.medianMs, MegabytesPerSecond(bytes, objlTiming.minMs),
+                reference.shapes.size(), objlVertices, objlIndices);
+    if (mappedTiming.minMs > 0.0) {
+        std::printf("speedup: %.1fx\n", objlTiming.minMs / mappedTiming.minMs);
+    }
+    return 0;
+}
@@ -0,0 +1,306 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/BlockCompressor.hpp>
+#include <ResourceManager/ChannelPacker.hpp>
+#include <ResourceManager/CpuFeatures.hpp>
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/Parallel.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct StageResult
+    {
+        std::string stage;
+        unsigned threads{1};
+        size_t textures{0};
+        uint64_t bytes{0};
+        Bench::Timing timing;
+        double speedup{1.0};
+    };
+
+    // 1, 2, 4, ... up to the core count, which is always included.
+    std::vector<unsigned> threadCounts(unsigned cores)
+    {
+        std::vector<unsigned> counts;
+        for (unsigned threads = 1; threads < cores; threads *= 2) {
+            counts.push_back(threads);
+        }
+        counts.push_back(cores);
+        return counts;
+    }
+
+    bool sameImage(const Image &a, const Image &b)
+    {
+        return a.width == b.width && a.height == b.height && a.format == b.format && a.pixels.Size == b.pixels.Size &&
+               std::memcmp(a.pixels.Data.get(), b.pixels.Data.get(), a.pixels.Size) == 0;
+    }
+
+    bool sameData(const RawData &a, const RawData &b)
+    {
+        return a.Size == b.Size && std::memcmp(a.Data.get(), b.Data.get(), a.Size) == 0;
+    }
+
+    void writeJsonString(std::FILE *file, const std::string &text)
+    {
+        std::fputc('"', file);
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                std::fprintf(file, "\\%c", c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                std::fprintf(file, "\\u%04x", static_cast<unsigned>(c));
+            } else {
+                std::fputc(c, file);
+            }
+        }
+        std::fputc('"', file);
+    }
+
+    // One object per stage and thread count; flat so a script can diff two
+    // runs by (stage, threads) without knowing the stages.
+    bool writeJson(const char *path, const std::string &directory, int iterations, size_t textureCount,
+                   uint64_t sourceBytes, bool isValid, const std::vector<StageResult> &results)
+    {
+        std::FILE *file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fprintf(file, "{\n  \"benchmark\": \"pipeline\",\n  \"directory\": ");
+        writeJsonString(file, directory);
+        std::fprintf(file,
+                     ",\n  \"simd\": \"%s\",\n  \"hardwareThreads\": %u,\n  \"iterations\": %d,\n"
+                     "  \"textures\": %zu,\n  \"sourceBytes\": %llu,\n  \"valid\": %s,\n  \"stages\": [\n",
+                     SimdLevelName(ActiveSimdLevel()), std::max(1u, std::thread::hardware_concurrency()), iterations,
+                     textureCount, static_cast<unsigned long long>(sourceBytes), isValid ? "true" : "false");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const StageResult &result = results[i];
+            std::fprintf(file,
+                         "    {\"stage\": \"%s\", \"threads\": %u, \"textures\": %zu, \"bytes\": %llu, "
+                         "\"minMs\": %.3f, \"medianMs\": %.3f, \"mbPerSecond\": %.1f, \"texturesPerSecond\": %.1f, "
+                         "\"speedup\": %.2f}%s\n",
+                         result.stage.c_str(), result.threads, result.textures,
+                         static_cast<unsigned long long>(result.bytes), result.timing.minMs, result.timing.medianMs,
+                         Bench::MegabytesPerSecond(result.bytes, result.timing.minMs),
+                         result.timing.minMs > 0.0 ? result.textures * 1000.0 / result.timing.minMs : 0.0,
+                         result.speedup, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+}
+
+// The cooker's texture pipeline stage by stage over a texture directory:
+// decode (file to pixels), decode-mem (the same Tga::Decode from files
+// already mapped and paged in, so without the file system), mip
+// generation, ORM channel packing of roughness/metallic pairs and block
+// compression of every level. Each stage runs at 1, 2, 4 ... N
+// threads, one texture per thread as chelson-cook does, and must give the
+// same output at every thread count. Results also go to a JSON file, to be
+// compared across commits.
+int Bench::RunPipeline(int argc, char **argv)
+{
+    const std::string directory = argc > 0 ? argv[0] : "assets/sponza/textures_pbr";
+    const char *jsonPath = argc > 1 ? argv[1] : "pipeline.json";
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error)) {
+        if (Text::ToLower(entry.path().extension().string()) == ".tga") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<MappedFile> files(paths.size());
+    uint64_t sourceBytes = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!files[i].Open(paths[i].c_str())) {
+            std::printf("pipeline: cannot read %s\n", paths[i].c_str());
+            return 1;
+        }
+        sourceBytes += files[i].Size();
+    }
+    if (paths.empty()) {
+        std::printf("pipeline: no .tga files in %s\n", directory.c_str());
+        return 1;
+    }
+
+    // Reference outputs, single threaded; every other run is compared against them.
+    std::vector<Image> images(paths.size());
+    std::vector<MipOptions> mipOptions;
+    std::vector<Bc::CompressOptions> compressOptions;
+    uint64_t pixelBytes = 0;
+    bool isValid = true;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        isValid &= Tga::LoadFile(paths[i].c_str(), images[i]);
+        pixelBytes += images[i].pixels.Size;
+        mipOptions.push_back(MipOptionsForTexture(paths[i]));
+        Bc::CompressOptions options;
+        options.format = Bc::FormatForTexture(paths[i], images[i].format);
+        options.threadCount = 1;
+        compressOptions.push_back(options);
+    }
+    std::vector<const Image *> sources;
+    for (const Image &image : images) {
+        sources.push_back(&image);
+    }
+    std::vector<MipChain> chains;
+    isValid &= GenerateMips(sources, mipOptions, chains, 1);
+    uint64_t chainBytes = 0;
+    for (const MipChain &chain : chains) {
+        for (const Image &level : chain.levels) {
+            chainBytes += level.pixels.Size;
+        }
+    }
+
+    // Roughness and metallic maps with the same prefix, as the materials pair them.
+    std::vector<std::pair<size_t, size_t>> pairs;
+    uint64_t pairBytes = 0;
+    for (size_t r = 0; r < paths.size(); ++r) {
+        const std::string name = Text::ToLower(fs::path{paths[r]}.stem().string());
+        const size_t split = name.rfind("_roughness");
+        if (split == std::string::npos || split + 10 != name.size()) {
+            continue;
+        }
+        for (size_t m = 0; m < paths.size(); ++m) {
+            if (Text::ToLower(fs::path{paths[m]}.stem().string()) == name.substr(0, split) + "_metallic") {
+                pairs.emplace_back(r, m);
+                pairBytes += images[r].pixels.Size + images[m].pixels.Size;
+            }
+        }
+    }
+    std::vector<Image> packed(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        PackOrm(images[pairs[i].first], images[pairs[i].second], packed[i]);
+    }
+
+    std::vector<std::vector<RawData>> compressed(chains.size());
+    for (size_t i = 0; i < chains.size(); ++i) {
+        compressed[i].resize(chains[i].levels.size());
+        for (size_t level = 0; level < chains[i].levels.size(); ++level) {
+            isValid &= Bc::Compress(chains[i].levels[level], compressOptions[i], compressed[i][level]);
+        }
+    }
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%zu textures (%.1f MB in files, %.1f MB decoded), %zu roughness/metallic pairs, %s, %u threads\n",
+                paths.size(), sourceBytes / (1024.0 * 1024.0), pixelBytes / (1024.0 * 1024.0), pairs.size(),
+                SimdLevelName(ActiveSimdLevel()), cores);
+    std::printf("%-10s %8s %12s %10s %12s %9s\n", "stage", "threads", "ms", "MB/s", "textures/s", "speedup");
+
+    std::vector<StageResult> results;
+    auto run = [&](const char *stage, size_t count, uint64_t bytes, auto &&work, auto &&check) {
+        double singleMs = 0.0;
+        for (unsigned threads : threadCounts(cores)) {
+            StageResult result;
+            result.stage = stage;
+            result.threads = threads;
+            result.textures = count;
+            result.bytes = bytes;
+            result.timing = Measure(iterations, [&]() { work(threads); });
+            singleMs = threads == 1 ? result.timing.minMs : singleMs;
+            result.speedup = result.timing.minMs > 0.0 ? singleMs / result.timing.minMs : 0.0;
+            isValid &= check();
+            std::printf("%-10s %8u %12.2f %10.1f %12.1f %8.2fx\n", stage, threads, result.timing.minMs,
+                        MegabytesPerSecond(bytes, result.timing.minMs),
+                        result.timing.minMs > 0.0 ? count * 1000.0 / result.timing.minMs : 0.0, result.speedup);
+            results.push_back(result);
+        }
+    };
+
+    std::vector<Image> decoded(paths.size());
+    auto sameDecoded = [&]() {
+        bool same = true;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            same &= sameImage(decoded[i], images[i]);
+        }
+        return same;
+    };
+    std::vector<uint8_t> loaded(paths.size(), 0);
+    run("decode", paths.size(), sourceBytes,
+        [&](unsigned threads) {
+            ParallelFor(paths.size(), threads,
+                        [&](size_t i) { loaded[i] = Tga::LoadFile(paths[i].c_str(), decoded[i]) ? 1 : 0; });
+        },
+        [&]() { return sameDecoded() && std::count(loaded.begin(), loaded.end(), 0) == 0; });
+    run("decode-mem", paths.size(), pixelBytes,
+        [&](unsigned threads) {
+            ParallelFor(paths.size(), threads,
+                        [&](size_t i) { loaded[i] = Tga::Decode(files[i].View(), decoded[i]) ? 1 : 0; });
+        },
+        [&]() { return sameDecoded() && std::count(loaded.begin(), loaded.end(), 0) == 0; });
+
+    std::vector<MipChain> generated;
+    run("mips", paths.size(), pixelBytes,
+        [&](unsigned threads) { loaded[0] = GenerateMips(sources, mipOptions, generated, threads) ? 1 : 0; },
+        [&]() {
+            bool same = loaded[0] != 0 && generated.size() == chains.size();
+            for (size_t i = 0; same && i < chains.size(); ++i) {
+                same &= generated[i].levels.size() == chains[i].levels.size();
+                for (size_t level = 0; same && level < chains[i].levels.size(); ++level) {
+                    same &= sameImage(generated[i].levels[level], chains[i].levels[level]);
+                }
+            }
+            return same;
+        });
+
+    if (!pairs.empty()) {
+        std::vector<Image> orm(pairs.size());
+        run("pack", pairs.size(), pairBytes,
+            [&](unsigned threads) {
+                ParallelFor(pairs.size(), threads,
+                            [&](size_t i) { PackOrm(images[pairs[i].first], images[pairs[i].second], orm[i]); });
+            },
+            [&]() {
+                bool same = true;
+                for (size_t i = 0; i < pairs.size(); ++i) {
+                    same &= sameImage(orm[i], packed[i]);
+                }
+                return same;
+            });
+    }
+
+    std::vector<std::vector<RawData>> blocks(chains.size());
+    run("compress", chains.size(), chainBytes,
+        [&](unsigned threads) {
+            ParallelFor(chains.size(), threads, [&](size_t i) {
+                blocks[i].resize(chains[i].levels.size());
+                for (size_t level = 0; level < chains[i].levels.size(); ++level) {
+                    Bc::Compress(chains[i].levels[level], compressOptions[i], blocks[i][level]);
+                }
+            });
+        },
+        [&]() {
+            bool same = true;
+            for (size_t i = 0; i < chains.size(); ++i) {
+                for (size_t level = 0; level < chains[i].levels.size(); ++level) {
+                    same &= sameData(blocks[i][level], compressed[i][level]);
+                }
+            }
+            return same;
+        });
+
+    if (!writeJson(jsonPath, directory, iterations, paths.size(), sourceBytes, isValid, results)) {
+        std::printf("pipeline: cannot write %s\n", jsonPath);
+        return 1;
+    }
+    std::printf("results written to %s\n", jsonPath);
+    std::printf("same output at every thread count: %s\n", isValid ? "ok" : "FAIL");
+    return isValid ? 0 : 1;
+}
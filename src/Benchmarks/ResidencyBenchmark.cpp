@@ -0,0 +1,320 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/CookedTexture.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/TextureResidency.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64_t MB = 1024 * 1024;
+
+    // Level contents do not matter to residency, only their sizes do.
+    bool writeTexture(const std::string &path, uint32_t size, uint64_t contentHash = 0, bool srgb = false)
+    {
+        TextureLevels texture;
+        texture.format = TextureFormat::BC7;
+        texture.srgb = srgb;
+        texture.width = size;
+        texture.height = size;
+        texture.contentHash[0] = contentHash;
+        for (uint32_t level = 0; level < MipLevelCount(size, size); ++level) {
+            const uint32_t levelSize = std::max(1u, size >> level);
+            RawData data;
+            data.Allocate(size_t(TextureRowBytes(texture.format, levelSize)) * TextureRowCount(texture.format, levelSize));
+            std::fill(data.Data.get(), data.Data.get() + data.Size, uint8_t(level));
+            texture.levels.push_back(std::move(data));
+        }
+        return WriteCookedTexture(path.c_str(), texture);
+    }
+
+    // What the manager believes has to be what the backend holds.
+    bool agrees(const TextureResidency &residency, const SimulatedUploadBackend &backend)
+    {
+        const ResidencyStats &stats = residency.Stats();
+        if (stats.residentBytes + stats.inFlightBytes != backend.AllocatedBytes() || backend.ErrorCount() != 0) {
+            return false;
+        }
+        for (TextureId texture = 0; texture < residency.TextureCount(); ++texture) {
+            const uint32_t mipCount = residency.Texture(texture).MipCount();
+            const uint32_t resident = residency.ResidentMip(texture);
+            const uint32_t expected = resident < mipCount ? ((1u << mipCount) - 1) & ~((1u << resident) - 1) : 0;
+            if (!residency.IsUploading(texture) && backend.ResidentLevels(texture) != expected) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void runFrame(TextureResidency &residency, SimulatedUploadBackend &backend)
+    {
+        residency.Update();
+        backend.AdvanceFrame();
+    }
+
+    // Wanting fewer levels must not drop them before hysteresisFrames
+    // frames, and wanting them back streams them in again.
+    bool checkHysteresis(const std::vector<std::string> &paths)
+    {
+        SimulatedUploadBackend backend{2};
+        ResidencyOptions options;
+        options.hysteresisFrames = 10;
+        TextureResidency residency{backend, options};
+        const TextureId texture = residency.Add(paths[0].c_str());
+        for (int frame = 0; frame < 40; ++frame) {
+            residency.RequestMip(texture, 0);
+            runFrame(residency, backend);
+        }
+        bool isValid = residency.ResidentMip(texture) == 0;
+        for (uint32_t frame = 1; frame <= options.hysteresisFrames; ++frame) {
+            residency.RequestMip(texture, 3);
+            runFrame(residency, backend);
+            isValid &= residency.ResidentMip(texture) == (frame < options.hysteresisFrames ? 0u : 3u);
+        }
+        for (int frame = 0; frame < 40; ++frame) {
+            residency.RequestMip(texture, 1);
+            runFrame(residency, backend);
+        }
+        return isValid && residency.ResidentMip(texture) == 1 && agrees(residency, backend);
+    }
+
+    // With room for two full textures, a third one takes the levels of the
+    // one used longest ago and leaves the other alone.
+    bool checkLru(const std::vector<std::string> &paths)
+    {
+        SimulatedUploadBackend backend{1};
+        ResidencyOptions options;
+        CookedTexture probe;
+        probe.Open(paths[1].c_str());
+        options.budgetBytes = 2 * probe.Header().fileSize + probe.Header().fileSize / 2;
+        TextureResidency residency{backend, options};
+        // Equally sized textures, every fourth synthetic one is larger.
+        const TextureId first = residency.Add(paths[1].c_str());
+        const TextureId second = residency.Add(paths[2].c_str());
+        const TextureId third = residency.Add(paths[3].c_str());
+
+        auto stream = [&](TextureId texture) {
+            for (int frame = 0; frame < 40; ++frame) {
+                residency.RequestMip(texture, 0);
+                runFrame(residency, backend);
+            }
+        };
+        stream(first);
+        stream(second);
+        const bool bothResident = residency.ResidentMip(first) == 0 && residency.ResidentMip(second) == 0;
+        stream(third);
+        return bothResident && residency.ResidentMip(third) == 0 && residency.ResidentMip(second) == 0 &&
+               residency.ResidentMip(first) > 0 && backend.PeakBytes() <= options.budgetBytes &&
+               agrees(residency, backend);
+    }
+
+    // Two files with the same content hash are one texture, a third one is
+    // not, nor is a fourth with the same hash cooked as sRGB.
+    bool checkSharing(const fs::path &directory)
+    {
+        const std::string paths[4] = {(directory / "same_a.ctex").string(), (directory / "same_b.ctex").string(),
+                                      (directory / "other.ctex").string(), (directory / "same_srgb.ctex").string()};
+        if (!writeTexture(paths[0], 256, 7) || !writeTexture(paths[1], 256, 7) || !writeTexture(paths[2], 256, 8) ||
+            !writeTexture(paths[3], 256, 7, true)) {
+            return false;
+        }
+        SimulatedUploadBackend backend;
+        TextureResidency residency{backend};
+        const TextureId first = residency.Add(paths[0].c_str());
+        const TextureId second = residency.Add(paths[1].c_str());
+        const TextureId other = residency.Add(paths[2].c_str());
+        const TextureId srgb = residency.Add(paths[3].c_str());
+        return first != INVALID_TEXTURE && first == second && other != first && srgb != first &&
+               residency.TextureCount() == 3 && residency.Stats().sharedCount == 1;
+    }
+
+    struct FlightResult
+    {
+        bool isValid{true};
+        uint64_t allBytes{0};
+        uint64_t peakBytes{0};
+        double updateMs{0.0};
+    };
+
+    // Flies the camera past every object and checks the invariants each frame.
+    FlightResult fly(TextureResidency &residency, SimulatedUploadBackend &backend, const std::vector<Bounds> &objects,
+                     const std::vector<TextureId> &textures, const float (&from)[3], const float (&to)[3], int frames)
+    {
+        FlightResult result;
+        for (TextureId texture = 0; texture < residency.TextureCount(); ++texture) {
+            result.allBytes += residency.Texture(texture).Header().fileSize;
+        }
+        uint64_t tailBytes = 0;
+        CameraView camera;
+        for (int frame = 0; frame < frames; ++frame) {
+            const float t = frames > 1 ? float(frame) / (frames - 1) : 0.0f;
+            for (int i = 0; i < 3; ++i) {
+                camera.position[i] = from[i] + (to[i] - from[i]) * t;
+            }
+            const Bench::Timing timing = Bench::Measure(1, [&]() {
+                for (size_t i = 0; i < objects.size(); ++i) {
+                    residency.RequestFootprint(textures[i], objects[i], camera);
+                }
+                residency.Update();
+            });
+            backend.AdvanceFrame();
+            result.updateMs += timing.minMs;
+            result.isValid &= agrees(residency, backend);
+
+            // Only tails may push memory past the budget.
+            tailBytes = 0;
+            for (TextureId texture = 0; texture < residency.TextureCount(); ++texture) {
+                const uint32_t tail = residency.TailMip(texture);
+                const CookedTexture &file = residency.Texture(texture);
+                tailBytes += file.MipRange(tail, file.MipCount() - 1).size();
+            }
+            result.isValid &= backend.AllocatedBytes() <= std::max(residency.Options().budgetBytes, tailBytes);
+        }
+        result.peakBytes = backend.PeakBytes();
+        return result;
+    }
+
+    void printFlight(const char *name, const TextureResidency &residency, const FlightResult &result, int frames)
+    {
+        const ResidencyStats &stats = residency.Stats();
+        std::printf("%s: %zu textures, %.1f MB with all mips, budget %.1f MB, peak %.1f MB\n", name,
+                    residency.TextureCount(), result.allBytes / double(MB),
+                    residency.Options().budgetBytes / double(MB), result.peakBytes / double(MB));
+        std::printf("  %zu uploads (%.1f MB), %zu levels evicted for the budget, %zu dropped, %zu deferred; "
+                    "%.3f ms per update\n",
+                    stats.uploadCount, stats.uploadedBytes / double(MB), stats.evictionCount, stats.droppedCount,
+                    stats.deferredCount, frames > 0 ? result.updateMs / frames : 0.0);
+        if (stats.sharedCount > 0) {
+            std::printf("  %zu textures shared with identical content (%.1f MB)\n", stats.sharedCount,
+                        stats.sharedBytes / double(MB));
+        }
+    }
+}
+
+// Drives the texture residency manager against the simulated upload backend:
+// hysteresis and LRU order on a few textures, then a camera flight past a row
+// of synthetic objects and, when chelson-cook has run, through Sponza.
+int Bench::RunResidency(int argc, char **argv)
+{
+    const char *cookedRoot = argc > 0 ? argv[0] : "cooked";
+    const uint64_t budgetMb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 600;
+
+    const fs::path temporary = fs::temp_directory_path() / "chelson-residency";
+    std::error_code error;
+    fs::create_directories(temporary, error);
+    const uint32_t OBJECT_COUNT = 48;
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < OBJECT_COUNT; ++i) {
+        paths.push_back((temporary / ("object_" + std::to_string(i) + ".ctex")).string());
+        if (!writeTexture(paths.back(), i % 4 == 0 ? 2048 : 1024)) {
+            std::printf("residency: cannot write %s\n", paths.back().c_str());
+            return 1;
+        }
+    }
+
+    const bool hysteresis = checkHysteresis(paths);
+    const bool lru = checkLru(paths);
+    const bool sharing = checkSharing(temporary);
+    std::printf("hysteresis: %s, lru eviction: %s, content sharing: %s\n", hysteresis ? "ok" : "FAIL",
+                lru ? "ok" : "FAIL", sharing ? "ok" : "FAIL");
+    bool isValid = hysteresis && lru && sharing;
+
+    // Two meter boxes ten meters apart along x, camera passing at two meters.
+    {
+        SimulatedUploadBackend backend{2, 32 * MB};
+        ResidencyOptions options;
+        options.budgetBytes = budgetMb * MB;
+        TextureResidency residency{backend, options};
+        std::vector<Bounds> objects;
+        std::vector<TextureId> textures;
+        for (uint32_t i = 0; i < OBJECT_COUNT; ++i) {
+            Bounds bounds;
+            const float low[3] = {i * 10.0f - 1.0f, -1.0f, -1.0f};
+            const float high[3] = {i * 10.0f + 1.0f, 1.0f, 1.0f};
+            bounds.Extend(low);
+            bounds.Extend(high);
+            objects.push_back(bounds);
+            textures.push_back(residency.Add(paths[i].c_str()));
+        }
+        const float from[3] = {-20.0f, 0.0f, 2.0f};
+        const float to[3] = {OBJECT_COUNT * 10.0f + 20.0f, 0.0f, 2.0f};
+        const FlightResult result = fly(residency, backend, objects, textures, from, to, frames);
+        printFlight("synthetic", residency, result, frames);
+        isValid &= result.isValid;
+    }
+
+    CookedMesh mesh;
+    const std::string meshPath = (fs::path{cookedRoot} / "sponza" / "sponza.cmesh").string();
+    if (mesh.Open(meshPath.c_str())) {
+        SimulatedUploadBackend backend{2, 32 * MB};
+        ResidencyOptions options;
+        options.budgetBytes = budgetMb * MB;
+        TextureResidency residency{backend, options};
+
+        // Materials live in the .cmat of each library, texture paths relative to it.
+        const fs::path meshDirectory = fs::path{meshPath}.parent_path();
+        std::vector<CookedMaterials> libraries(mesh.MaterialLibraryCount());
+        std::vector<std::vector<TextureId>> cookedIds(libraries.size());
+        for (uint32_t l = 0; l < libraries.size(); ++l) {
+            const fs::path libraryPath = meshDirectory / std::string(mesh.MaterialLibrary(l));
+            if (!libraries[l].Open(libraryPath.string().c_str())) {
+                continue;
+            }
+            for (TextureId texture = 0; texture < libraries[l].TextureCount(); ++texture) {
+                const fs::path path = libraryPath.parent_path() / std::string(libraries[l].TexturePath(texture));
+                cookedIds[l].push_back(residency.Add(path.string().c_str()));
+            }
+        }
+
+        std::vector<Bounds> objects;
+        std::vector<TextureId> textures;
+        for (uint32_t s = 0; s < mesh.SubmeshCount(); ++s) {
+            const uint32_t material = mesh.Submesh(s).material;
+            if (material == INVALID_MATERIAL) {
+                continue;
+            }
+            // The first library defining the name wins, like the importer.
+            for (uint32_t l = 0; l < libraries.size(); ++l) {
+                const uint32_t found = libraries[l].IsOpen() ? libraries[l].FindMaterial(mesh.MaterialName(material))
+                                                             : INVALID_MATERIAL;
+                if (found == INVALID_MATERIAL) {
+                    continue;
+                }
+                for (TextureId texture : libraries[l].GetMaterial(found).textures) {
+                    if (texture != INVALID_TEXTURE && cookedIds[l][texture] != INVALID_TEXTURE) {
+                        objects.push_back(mesh.SubmeshBounds(s));
+                        textures.push_back(cookedIds[l][texture]);
+                    }
+                }
+                break;
+            }
+        }
+
+        // Down the middle of the atrium at head height.
+        const Bounds &bounds = mesh.Header().bounds;
+        const float y = bounds.min[1] + 0.1f * (bounds.max[1] - bounds.min[1]);
+        const float z = 0.5f * (bounds.min[2] + bounds.max[2]);
+        const float from[3] = {bounds.min[0] * 0.8f, y, z};
+        const float to[3] = {bounds.max[0] * 0.8f, y, z};
+        const FlightResult result = fly(residency, backend, objects, textures, from, to, frames);
+        printFlight("sponza", residency, result, frames);
+        isValid &= result.isValid;
+    } else {
+        std::printf("sponza: %s not found, run chelson-cook first\n", meshPath.c_str());
+    }
+
+    std::printf("budget and residency checks: %s\n", isValid ? "ok" : "FAIL");
+    fs::remove_all(temporary, error);
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/ObjParser.hpp>
+#include <ResourceManager/ResourceManager.hpp>
+#include <ResourceManager/TangentSpace.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    double dot(const double *a, const double *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    void load(const float *v, double *out)
+    {
+        out[0] = v[0];
+        out[1] = v[1];
+        out[2] = v[2];
+    }
+
+    bool normalize(double *v)
+    {
+        const double length = std::sqrt(dot(v, v));
+        if (!(length > 0.0)) {
+            return false;
+        }
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+        return true;
+    }
+
+    double angle(const double *a, const double *b)
+    {
+        const double cross[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        return std::atan2(std::sqrt(dot(cross, cross)), dot(a, b));
+    }
+
+    // Worst agreement between the tangent of a corner and the direction of
+    // increasing u on its triangle, as a cosine. 1 for shapes whose vertices
+    // each see one triangle, lower where smooth vertices average several.
+    struct TangentCheck
+    {
+        bool ok{true};
+        double alignment{1.0};
+    };
+
+    // Unit tangents in the normal plane, the sign of every corner matching
+    // its triangle's UV orientation, the triangles still on the same
+    // positions and texcoords as before and only the reported splits added.
+    TangentCheck checkTangents(const SponzaShape::Shape &shape, const SponzaShape::Shape &source,
+                               const TangentStats &stats)
+    {
+        TangentCheck check;
+        const size_t vertexCount = shape.vertexCount;
+        if (vertexCount != source.vertexCount + stats.splitCount || shape.tangents.size() != vertexCount * 4 ||
+            shape.indicies.size() != source.indicies.size() || shape.positions.size() != vertexCount * 3) {
+            check.ok = false;
+            return check;
+        }
+        const bool hasTexcoords = shape.texcoords.size() == vertexCount * 2;
+
+        for (size_t v = 0; v < vertexCount; ++v) {
+            const float *tangent = &shape.tangents[v * 4];
+            double t[3], n[3];
+            load(tangent, t);
+            load(&shape.normals[v * 3], n);
+            if (std::fabs(dot(t, t) - 1.0) > 1e-4 || std::fabs(std::fabs(tangent[3]) - 1.0f) != 0.0f ||
+                (normalize(n) && std::fabs(dot(t, n)) > 1e-4)) {
+                check.ok = false;
+            }
+        }
+
+        size_t degenerate = 0;
+        for (size_t i = 0; i + 2 < shape.indicies.size(); i += 3) {
+            for (size_t c = 0; c < 3; ++c) {
+                const unsigned int a = shape.indicies[i + c];
+                const unsigned int b = source.indicies[i + c];
+                if (!std::equal(&shape.positions[size_t(a) * 3], &shape.positions[size_t(a) * 3] + 3,
+                                &source.positions[size_t(b) * 3]) ||
+                    (hasTexcoords && !std::equal(&shape.texcoords[size_t(a) * 2], &shape.texcoords[size_t(a) * 2] + 2,
+                                                 &source.texcoords[size_t(b) * 2]))) {
+                    check.ok = false;
+                }
+            }
+            if (!hasTexcoords) {
+                ++degenerate;
+                continue;
+            }
+
+            const unsigned int *triangle = &shape.indicies[i];
+            double p[3][3];
+            for (int c = 0; c < 3; ++c) {
+                load(&shape.positions[size_t(triangle[c]) * 3], p[c]);
+            }
+            const float *uv0 = &shape.texcoords[size_t(triangle[0]) * 2];
+            const float *uv1 = &shape.texcoords[size_t(triangle[1]) * 2];
+            const float *uv2 = &shape.texcoords[size_t(triangle[2]) * 2];
+            const float t21[2] = {uv1[0] - uv0[0], uv1[1] - uv0[1]};
+            const float t31[2] = {uv2[0] - uv0[0], uv2[1] - uv0[1]};
+            const float area = t21[0] * t31[1] - t21[1] * t31[0];
+            // Degenerate as GenerateTangents sees it, in float: no UV area, or
+            // no direction of increasing u, as where positions collapse at a pole.
+            const float *p0 = &shape.positions[size_t(triangle[0]) * 3];
+            const float *p1 = &shape.positions[size_t(triangle[1]) * 3];
+            const float *p2 = &shape.positions[size_t(triangle[2]) * 3];
+            float u[3];
+            for (int k = 0; k < 3; ++k) {
+                u[k] = t31[1] * (p1[k] - p0[k]) - t21[1] * (p2[k] - p0[k]);
+            }
+            if (area == 0.0f || !(std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]) > 0.0f)) {
+                ++degenerate;
+                continue;
+            }
+            double s[3];
+            for (int k = 0; k < 3; ++k) {
+                s[k] = (t31[1] * (p[1][k] - p[0][k]) - t21[1] * (p[2][k] - p[0][k])) / area;
+            }
+            for (int c = 0; c < 3; ++c) {
+                const float *tangent = &shape.tangents[size_t(triangle[c]) * 4];
+                if ((tangent[3] < 0.0f) != (area < 0.0f)) {
+                    check.ok = false;
+                }
+                double n[3], t[3], projected[3];
+                load(&shape.normals[size_t(triangle[c]) * 3], n);
+                load(tangent, t);
+                if (!normalize(n)) {
+                    continue;
+                }
+                const double along = dot(n, s);
+                for (int k = 0; k < 3; ++k) {
+                    projected[k] = s[k] - n[k] * along;
+                }
+                if (normalize(projected)) {
+                    check.alignment = std::min(check.alignment, dot(t, projected));
+                }
+            }
+        }
+        if (degenerate != stats.degenerateCount) {
+            check.ok = false;
+        }
+        return check;
+    }
+
+    int cornerOf(const unsigned int *triangle, unsigned int vertex)
+    {
+        return triangle[0] == vertex ? 0 : triangle[1] == vertex ? 1 : 2;
+    }
+
+    // Tangent of every corner computed on its own, in double, the way
+    // MikkTSpace defines it: the angle weighted directions of increasing u
+    // over the fan of triangles around the corner's vertex that are joined
+    // edge to edge and have its UV orientation, triangles without UV area
+    // joining any fan. Returns the worst angle to the generated tangent of
+    // the corner, negative when a sign differs.
+    double referenceError(const SponzaShape::Shape &shape, const SponzaShape::Shape &source)
+    {
+        const size_t triangleCount = source.indicies.size() / 3;
+        if (source.texcoords.size() < size_t(source.vertexCount) * 2 ||
+            source.normals.size() < size_t(source.vertexCount) * 3) {
+            return 0.0;
+        }
+        // 1 or -1 by UV orientation, 0 for triangles the generator skips, 2
+        // for those without UV area that still span positions.
+        std::vector<int> orientations(triangleCount, 0);
+        std::vector<double> directions(triangleCount * 3, 0.0);
+        std::vector<std::vector<uint32_t>> trianglesOf(source.vertexCount);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const unsigned int *triangle = &source.indicies[t * 3];
+            const float *p[3], *uv[3];
+            for (int c = 0; c < 3; ++c) {
+                p[c] = &source.positions[size_t(triangle[c]) * 3];
+                uv[c] = &source.texcoords[size_t(triangle[c]) * 2];
+                trianglesOf[triangle[c]].push_back(static_cast<uint32_t>(t));
+            }
+            const float t21[2] = {uv[1][0] - uv[0][0], uv[1][1] - uv[0][1]};
+            const float t31[2] = {uv[2][0] - uv[0][0], uv[2][1] - uv[0][1]};
+            const float area = t21[0] * t31[1] - t21[1] * t31[0];
+            float u[3], d1[3], d2[3];
+            for (int k = 0; k < 3; ++k) {
+                d1[k] = p[1][k] - p[0][k];
+                d2[k] = p[2][k] - p[0][k];
+                u[k] = t31[1] * d1[k] - t21[1] * d2[k];
+            }
+            const float face[3] = {d1[1] * d2[2] - d1[2] * d2[1], d1[2] * d2[0] - d1[0] * d2[2],
+                                   d1[0] * d2[1] - d1[1] * d2[0]};
+            const bool hasFace = std::sqrt(face[0] * face[0] + face[1] * face[1] + face[2] * face[2]) > 0.0f;
+            if (area == 0.0f || !(std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]) > 0.0f)) {
+                orientations[t] = area == 0.0f && hasFace ? 2 : 0;
+                continue;
+            }
+            orientations[t] = area < 0.0f ? -1 : 1;
+            for (int k = 0; k < 3; ++k) {
+                directions[t * 3 + k] = double(u[k]) / area;
+            }
+        }
+
+        double worst = 0.0;
+        std::vector<uint32_t> fan, pending;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const int orientation = orientations[t];
+            if (orientation != 1 && orientation != -1) {
+                continue;
+            }
+            for (uint32_t c = 0; c < 3; ++c) {
+                const unsigned int vertex = source.indicies[t * 3 + c];
+                fan.assign(1, static_cast<uint32_t>(t));
+                pending.assign(1, static_cast<uint32_t>(t));
+                while (!pending.empty()) {
+                    const unsigned int *triangle = &source.indicies[size_t(pending.back()) * 3];
+                    pending.pop_back();
+                    for (uint32_t other : trianglesOf[vertex]) {
+                        const unsigned int *adjacent = &source.indicies[size_t(other) * 3];
+                        if (std::find(fan.begin(), fan.end(), other) != fan.end() ||
+                            (orientations[other] != orientation && orientations[other] != 2)) {
+                            continue;
+                        }
+                        // Sharing an edge at vertex, walked the other way round.
+                        const int a = cornerOf(triangle, vertex);
+                        const int b = cornerOf(adjacent, vertex);
+                        if (triangle[(a + 1) % 3] == adjacent[(b + 2) % 3] ||
+                            triangle[(a + 2) % 3] == adjacent[(b + 1) % 3]) {
+                            fan.push_back(other);
+                            pending.push_back(other);
+                        }
+                    }
+                }
+
+                double n[3], sum[3] = {0.0, 0.0, 0.0};
+                load(&source.normals[size_t(vertex) * 3], n);
+                if (!normalize(n)) {
+                    continue;
+                }
+                for (uint32_t member : fan) {
+                    if (orientations[member] == 2) {
+                        continue;
+                    }
+                    const unsigned int *triangle = &source.indicies[size_t(member) * 3];
+                    const int corner = cornerOf(triangle, vertex);
+                    double here[3], edges[2][3], direction[3];
+                    load(&source.positions[size_t(vertex) * 3], here);
+                    for (int e = 0; e < 2; ++e) {
+                        load(&source.positions[size_t(triangle[(corner + 1 + e) % 3]) * 3], edges[e]);
+                        for (int k = 0; k < 3; ++k) {
+                            edges[e][k] -= here[k];
+                        }
+                    }
+                    double along[3] = {dot(n, edges[0]), dot(n, edges[1]), dot(n, &directions[size_t(member) * 3])};
+                    for (int k = 0; k < 3; ++k) {
+                        edges[0][k] -= n[k] * along[0];
+                        edges[1][k] -= n[k] * along[1];
+                        direction[k] = directions[size_t(member) * 3 + k] - n[k] * along[2];
+                    }
+                    if (!normalize(edges[0]) || !normalize(edges[1]) || !normalize(direction)) {
+                        continue;
+                    }
+                    const double weight = std::acos(std::clamp(dot(edges[0], edges[1]), -1.0, 1.0));
+                    for (int k = 0; k < 3; ++k) {
+                        sum[k] += direction[k] * weight;
+                    }
+                }
+                if (!normalize(sum)) {
+                    continue;
+                }
+                const float *tangent = &shape.tangents[size_t(shape.indicies[t * 3 + c]) * 4];
+                if ((tangent[3] < 0.0f) != (orientation < 0)) {
+                    return -1.0;
+                }
+                double generated[3];
+                load(tangent, generated);
+                worst = std::max(worst, angle(sum, generated));
+            }
+        }
+        return worst;
+    }
+
+    // Worst angle between the tangents and their QuantizedTangent decode,
+    // negative when a sign flipped.
+    double roundTripError(const SponzaShape::Shape &floats)
+    {
+        SponzaShape::Shape shape = floats;
+        const VertexLayout layout = VertexLayouts::QuantizedTangent::Describe();
+        EncodeStreams(shape, layout);
+        const uint8_t *streams[MAX_VERTEX_STREAMS];
+        for (uint32_t s = 0; s < MAX_VERTEX_STREAMS; ++s) {
+            streams[s] = shape.streams[s].data();
+        }
+        double error = 0.0;
+        for (uint32_t v = 0; v < shape.vertexCount; ++v) {
+            float value[4];
+            DecodeAttribute(layout, streams, v, VertexAttribute::Tangent, value, shape.quantization);
+            if (value[3] != floats.tangents[size_t(v) * 4 + 3]) {
+                return -1.0;
+            }
+            double a[3], b[3];
+            load(value, a);
+            load(&floats.tangents[size_t(v) * 4], b);
+            error = std::max(error, angle(a, b));
+        }
+        return error;
+    }
+}
+
+int Bench::RunTangents(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+    SponzaShape source;
+    if (!Obj::LoadFile(path, source)) {
+        std::printf("tangents: cannot load %s\n", path);
+        return 1;
+    }
+
+    SponzaShape sponza = source;
+    std::vector<TangentStats> stats;
+    GenerateTangents(sponza, 1, &stats);
+
+    std::printf("%-28s %9s %9s %9s %11s %10s %11s %11s %9s %s\n", "shape", "vertices", "splits", "split %",
+                "degenerate", "alignment", "ref error", "oct error", "ms", "check");
+    size_t vertices = 0, splits = 0, degenerates = 0, failures = 0;
+    double worstRoundTrip = 0.0, milliseconds = 0.0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const TangentStats &shape = stats[i];
+        const TangentCheck check = checkTangents(sponza.shapes[i], source.shapes[i], shape);
+        const double roundTrip = roundTripError(sponza.shapes[i]);
+        const double reference = referenceError(sponza.shapes[i], source.shapes[i]);
+        // The sign takes the lowest bit of x, so allow a little more than for normals. Float sums
+        // and welding frames closer than 1e-4 keep the generated tangents near the reference.
+        const bool ok = check.ok && roundTrip >= 0.0 && roundTrip <= 2e-4 && reference >= 0.0 && reference <= 1e-3;
+        std::printf("%-28.28s %9zu %9zu %8.2f%% %11zu %10.4f %11.2e %11.2e %9.3f %s\n", shape.name.c_str(),
+                    shape.vertexCount, shape.splitCount,
+                    shape.vertexCount > 0 ? 100.0 * shape.splitCount / shape.vertexCount : 0.0, shape.degenerateCount,
+                    check.alignment, reference, roundTrip, shape.milliseconds, ok ? "ok" : "FAIL");
+        vertices += shape.vertexCount;
+        splits += shape.splitCount;
+        degenerates += shape.degenerateCount;
+        worstRoundTrip = std::max(worstRoundTrip, roundTrip);
+        milliseconds += shape.milliseconds;
+        failures += ok ? 0 : 1;
+    }
+    std::printf("total: %zu vertices, %zu split for UV mirrors and separate fans, %zu degenerate triangles, worst oct "
+                "error %.2e rad, %.2f ms\n", vertices, splits, degenerates, worstRoundTrip, milliseconds);
+
+    // Every run needs the float shapes again, so the copies are made up front.
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%-8s %12s %12s %14s\n", "threads", "min ms", "median ms", "Mvertices/s");
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        std::vector<SponzaShape> copies(iterations, source);
+        size_t next = 0;
+        const Timing timing = Measure(iterations, [&]() { GenerateTangents(copies[next++], threads); });
+        std::printf("%-8u %12.2f %12.2f %14.2f\n", threads, timing.minMs, timing.medianMs,
+                    timing.minMs > 0.0 ? vertices / (timing.minMs * 1000.0) : 0.0);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    std::printf("tangent frames: %s\n", failures == 0 ? "ok" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/CpuFeatures.hpp>
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Source
+    {
+        std::string name;
+        std::string bytes;
+    };
+
+    void writeHeader(std::string &bytes, uint8_t imageType, uint32_t width, uint32_t height, uint8_t bitsPerPixel,
+                     uint8_t descriptor)
+    {
+        const uint8_t header[Tga::HEADER_SIZE] = {
+            0, 0, imageType, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            uint8_t(width), uint8_t(width >> 8), uint8_t(height), uint8_t(height >> 8), bitsPerPixel, descriptor,
+        };
+        bytes.assign(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+
+    // Smooth gradients with flat patches, so the RLE variant gets runs as well
+    // as raw packets and packets that cross row ends.
+    std::string makePixels(uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+    {
+        std::string pixels(size_t(width) * height * bytesPerPixel, '\0');
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const bool flat = ((x / 37) + (y / 23)) % 3 == 0;
+                for (uint32_t c = 0; c < bytesPerPixel; ++c) {
+                    const uint32_t value = flat ? 40 * c + 7 : x * (c + 1) + y * (3 - c) + c * 11;
+                    pixels[(size_t(y) * width + x) * bytesPerPixel + c] = static_cast<char>(value);
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // Encodes a whole image as one packet stream, the way most writers do.
+    std::string encodeRle(const std::string &pixels, uint32_t bytesPerPixel)
+    {
+        std::string packets;
+        const size_t count = pixels.size() / bytesPerPixel;
+        auto same = [&](size_t a, size_t b) {
+            return std::memcmp(&pixels[a * bytesPerPixel], &pixels[b * bytesPerPixel], bytesPerPixel) == 0;
+        };
+        size_t i = 0;
+        while (i < count) {
+            size_t run = 1;
+            while (i + run < count && run < 128 && same(i, i + run)) {
+                ++run;
+            }
+            if (run > 1) {
+                packets.push_back(static_cast<char>(0x80 | (run - 1)));
+                packets.append(pixels, i * bytesPerPixel, bytesPerPixel);
+                i += run;
+                continue;
+            }
+            size_t raw = 1;
+            while (i + raw < count && raw < 128 && !(i + raw + 1 < count && same(i + raw, i + raw + 1))) {
+                ++raw;
+            }
+            packets.push_back(static_cast<char>(raw - 1));
+            packets.append(pixels, i * bytesPerPixel, raw * bytesPerPixel);
+            i += raw;
+        }
+        return packets;
+    }
+
+    std::vector<Source> makeSynthetic(uint32_t width, uint32_t height)
+    {
+        struct Variant
+        {
+            uint8_t imageType;
+            uint8_t bitsPerPixel;
+            uint8_t descriptor;
+        };
+        const Variant VARIANTS[] = {
+            {2, 24, 0x00}, {2, 32, 0x28}, {3, 8, 0x00}, {10, 24, 0x00}, {10, 32, 0x28}, {11, 8, 0x00},
+        };
+
+        std::vector<Source> sources;
+        for (const Variant &variant : VARIANTS) {
+            const uint32_t bytesPerPixel = variant.bitsPerPixel / 8u;
+            const std::string pixels = makePixels(width, height, bytesPerPixel);
+            Source source;
+            source.name = "type " + std::to_string(variant.imageType) + ", " + std::to_string(variant.bitsPerPixel) +
+                          (variant.descriptor & 0x20 ? " bit, top-down" : " bit, bottom-up");
+            writeHeader(source.bytes, variant.imageType, width, height, variant.bitsPerPixel, variant.descriptor);
+            source.bytes += variant.imageType >= 9 ? encodeRle(pixels, bytesPerPixel) : pixels;
+            sources.push_back(std::move(source));
+        }
+        return sources;
+    }
+
+    bool samePixels(const Image &a, const Image &b)
+    {
+        return a.width == b.width && a.height == b.height && a.format == b.format && a.pixels.Size == b.pixels.Size &&
+               std::memcmp(a.pixels.Data.get(), b.pixels.Data.get(), a.pixels.Size) == 0;
+    }
+
+    size_t decodedBytes(const std::vector<Source> &sources, std::vector<Image> &images)
+    {
+        size_t bytes = 0;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (!Tga::Decode(sources[i].bytes, images[i])) {
+                return 0;
+            }
+            bytes += images[i].pixels.Size;
+        }
+        return bytes;
+    }
+}
+
+// Decodes every .tga in a directory plus synthetic images of each supported
+// type, once per SIMD level, and checks all levels and the RLE variants
+// against the scalar uncompressed result.
+int Bench::RunTga(int argc, char **argv)
+{
+    const char *directory = argc > 0 ? argv[0] : "assets/sponza/textures_pbr";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    std::vector<Source> files;
+    std::error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error)) {
+        const std::string extension = Text::ToLower(entry.path().extension().string());
+        MappedFile file;
+        if (extension != ".tga" || !file.Open(entry.path().string().c_str())) {
+            continue;
+        }
+        files.push_back({entry.path().filename().string(), std::string(file.View())});
+    }
+    const std::vector<Source> synthetic = makeSynthetic(1021, 509);
+
+    const SimdLevel best = ActiveSimdLevel();
+    bool isValid = true;
+    std::vector<Image> reference(synthetic.size());
+    std::vector<Image> fileReference(files.size());
+    LimitSimdLevel(SimdLevel::Scalar);
+    isValid &= decodedBytes(synthetic, reference) > 0 && (files.empty() || decodedBytes(files, fileReference) > 0);
+    // Bottom-up files land flipped, top-down ones as stored, channels as RGBA.
+    for (size_t i = 0; i < 2; ++i) {
+        const Image &image = reference[i];
+        const size_t bytesPerPixel = i == 0 ? 3 : 4;
+        const size_t row = i == 0 ? image.height - 1 : 0;
+        const uint8_t *stored = reinterpret_cast<const uint8_t *>(synthetic[i].bytes.data()) + Tga::HEADER_SIZE +
+                                row * image.width * bytesPerPixel;
+        const uint8_t *decoded = image.pixels.Data.get();
+        isValid &= decoded[0] == stored[2] && decoded[1] == stored[1] && decoded[2] == stored[0] &&
+                   decoded[3] == (i == 0 ? 0xff : stored[3]);
+    }
+    // RLE variants follow their uncompressed twins in the synthetic set.
+    for (size_t i = 0; i + 3 < synthetic.size(); ++i) {
+        isValid &= samePixels(reference[i], reference[i + 3]);
+    }
+
+    std::printf("%zu files in %s\n", files.size(), directory);
+    std::printf("%-8s %14s %10s %14s %10s\n", "simd", "files ms", "GB/s", "synthetic ms", "GB/s");
+    for (int level = 0; level <= static_cast<int>(best); ++level) {
+        LimitSimdLevel(static_cast<SimdLevel>(level));
+        std::vector<Image> images(synthetic.size());
+        std::vector<Image> fileImages(files.size());
+        size_t fileBytes = 0;
+        size_t syntheticBytes = 0;
+        const Timing fileTiming = Measure(iterations, [&]() { fileBytes = decodedBytes(files, fileImages); });
+        const Timing syntheticTiming = Measure(iterations, [&]() { syntheticBytes = decodedBytes(synthetic, images); });
+        for (size_t i = 0; i < synthetic.size(); ++i) {
+            isValid &= samePixels(images[i], reference[i]);
+        }
+        for (size_t i = 0; i < files.size(); ++i) {
+            isValid &= samePixels(fileImages[i], fileReference[i]);
+        }
+        std::printf("%-8s %14.2f %10.2f %14.2f %10.2f\n", SimdLevelName(static_cast<SimdLevel>(level)),
+                    fileTiming.minMs, MegabytesPerSecond(fileBytes, fileTiming.minMs) / 1024.0, syntheticTiming.minMs,
+                    MegabytesPerSecond(syntheticBytes, syntheticTiming.minMs) / 1024.0);
+    }
+    LimitSimdLevel(best);
+
+    std::printf("%-26s %12s\n", "synthetic", "GB/s");
+    for (size_t i = 0; i < synthetic.size(); ++i) {
+        Image image;
+        size_t bytes = 0;
+        const Timing timing = Measure(iterations, [&]() {
+            bytes = Tga::Decode(synthetic[i].bytes, image) ? image.pixels.Size : 0;
+        });
+        std::printf("%-26s %12.2f\n", synthetic[i].name.c_str(), MegabytesPerSecond(bytes, timing.minMs) / 1024.0);
+    }
+    std::printf("simd and rle match scalar: %s\n", isValid ? "ok" : "FAIL");
+    return isValid ? 0 : 1;
+}
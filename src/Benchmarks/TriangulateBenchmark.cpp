@@ -0,0 +1,144 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/Triangulator.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint32_t MIN_CORNERS = 3;
+    constexpr uint32_t MAX_CORNERS = 16;
+    constexpr int POLYGONS = 4096;
+
+    // Regular polygon, or a star when concave, tilted out of the axis planes
+    // and jittered so every face is different.
+    void makePolygon(uint32_t cornerCount, bool concave, int seed, float *positions)
+    {
+        const float tilt = 0.3f + 0.001f * seed;
+        for (uint32_t i = 0; i < cornerCount; ++i) {
+            const float angle = 6.2831853f * i / cornerCount;
+            const float radius = (concave && (i & 1)) ? 0.4f : 1.0f + 0.01f * ((seed + i) % 7);
+            const float x = radius * std::cos(angle);
+            const float y = radius * std::sin(angle);
+            positions[i * 3 + 0] = x;
+            positions[i * 3 + 1] = y * std::cos(tilt);
+            positions[i * 3 + 2] = y * std::sin(tilt);
+        }
+    }
+
+    void cross(const float *a, const float *b, const float *c, float *out)
+    {
+        const float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        const float e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        out[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        out[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        out[2] = e0[0] * e1[1] - e0[1] * e1[0];
+    }
+
+    // The triangles cover the polygon exactly once: every one winds like the
+    // Newell normal, and their areas add up to the polygon's.
+    bool covers(uint32_t cornerCount, const float *polygon, const uint32_t *triangles, uint32_t triangleCount)
+    {
+        double normal[3] = {0.0, 0.0, 0.0};
+        const float *prev = polygon + (cornerCount - 1) * 3;
+        for (uint32_t i = 0; i < cornerCount; ++i) {
+            const float *cur = polygon + i * 3;
+            normal[0] += (prev[1] - cur[1]) * (prev[2] + cur[2]);
+            normal[1] += (prev[2] - cur[2]) * (prev[0] + cur[0]);
+            normal[2] += (prev[0] - cur[0]) * (prev[1] + cur[1]);
+            prev = cur;
+        }
+        const double polygonArea = 0.5 * std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        double area = 0.0;
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            float n[3];
+            cross(polygon + triangles[t * 3] * 3, polygon + triangles[t * 3 + 1] * 3, polygon + triangles[t * 3 + 2] * 3, n);
+            if (n[0] * normal[0] + n[1] * normal[1] + n[2] * normal[2] <= 0.0) {
+                return false;
+            }
+            area += 0.5 * std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] + double(n[2]) * n[2]);
+        }
+        return std::fabs(area - polygonArea) <= 1e-5 * polygonArea;
+    }
+
+    template<typename TriangulateFn>
+    bool coversAll(uint32_t corners, const std::vector<float> &positions, std::vector<uint32_t> &triangles,
+                   TriangulateFn &&triangulate)
+    {
+        for (int p = 0; p < POLYGONS; ++p) {
+            const float *polygon = &positions[p * MAX_CORNERS * 3];
+            const uint32_t count = triangulate(polygon);
+            if (!covers(corners, polygon, triangles.data(), count)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int Bench::RunTriangulate(int argc, char **argv)
+{
+    const int iterations = argc > 0 ? std::atoi(argv[0]) : 20;
+
+    std::vector<float> positions(POLYGONS * MAX_CORNERS * 3);
+    std::vector<uint32_t> triangles((MAX_CORNERS - 2) * 3);
+    Triangulator triangulator;
+
+    std::printf("%-8s %-8s %14s %14s %10s\n", "corners", "shape", "fast ns/face", "clip ns/face", "concave");
+    for (uint32_t corners = MIN_CORNERS; corners <= MAX_CORNERS; ++corners) {
+        for (bool concave : {false, true}) {
+            // Stars need an even corner count, and below six corners they are convex.
+            if (concave && (corners < 6 || (corners & 1))) {
+                continue;
+            }
+            for (int p = 0; p < POLYGONS; ++p) {
+                makePolygon(corners, concave, p, &positions[p * MAX_CORNERS * 3]);
+            }
+
+            uint32_t checksum = 0;
+            const uint32_t concaveBefore = triangulator.ConcaveCount();
+            Timing fast = Measure(iterations, [&]() {
+                for (int p = 0; p < POLYGONS; ++p) {
+                    const float *polygon = &positions[p * MAX_CORNERS * 3];
+                    checksum += triangulator.Triangulate(corners, [polygon](uint32_t c) { return polygon + c * 3; },
+                                                         triangles.data());
+                }
+            });
+            const uint32_t concaveFaces = (triangulator.ConcaveCount() - concaveBefore) / iterations;
+
+            Timing clip = Measure(iterations, [&]() {
+                for (int p = 0; p < POLYGONS; ++p) {
+                    const float *polygon = &positions[p * MAX_CORNERS * 3];
+                    checksum += triangulator.ClipEars(corners, [polygon](uint32_t c) { return polygon + c * 3; },
+                                                      triangles.data());
+                }
+            });
+
+            if (checksum != 2u * iterations * POLYGONS * (corners - 2)) {
+                std::printf("triangulate: wrong triangle count for %u corners\n", corners);
+                return 1;
+            }
+            const bool fastCovers = coversAll(corners, positions, triangles, [&](const float *polygon) {
+                return triangulator.Triangulate(corners, [polygon](uint32_t c) { return polygon + c * 3; },
+                                                triangles.data());
+            });
+            const bool clipCovers = coversAll(corners, positions, triangles, [&](const float *polygon) {
+                return triangulator.ClipEars(corners, [polygon](uint32_t c) { return polygon + c * 3; },
+                                             triangles.data());
+            });
+            if (!fastCovers || !clipCovers) {
+                std::printf("triangulate: %s %u-gon triangles do not cover it with its winding\n",
+                            concave ? "concave" : "convex", corners);
+                return 1;
+            }
+            std::printf("%-8u %-8s %14.1f %14.1f %10u\n", corners, concave ? "concave" : "convex",
+                        fast.minMs * 1e6 / POLYGONS, clip.minMs * 1e6 / POLYGONS, concaveFaces);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/MeshOptimizer.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    using Corner = std::array<float, 8>;
+    using Triangle = std::array<Corner, 3>;
+
+    Corner corner(const SponzaShape::Shape &shape, unsigned int vertex)
+    {
+        Corner value{};
+        for (int i = 0; i < 3; ++i) {
+            value[i] = shape.positions[size_t(vertex) * 3 + i];
+            value[3 + i] = shape.normals[size_t(vertex) * 3 + i];
+        }
+        value[6] = shape.texcoords[size_t(vertex) * 2 + 0];
+        value[7] = shape.texcoords[size_t(vertex) * 2 + 1];
+        return value;
+    }
+
+    // Triangles by vertex content, each rotated to start at its smallest
+    // corner so winding is compared too, then sorted.
+    std::vector<Triangle> triangleSet(const SponzaShape::Shape &shape)
+    {
+        std::vector<Triangle> triangles(shape.indicies.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            Triangle triangle;
+            for (size_t c = 0; c < 3; ++c) {
+                triangle[c] = corner(shape, shape.indicies[t * 3 + c]);
+            }
+            while (triangle[1] < triangle[0] || triangle[2] < triangle[0]) {
+                std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+            }
+            triangles[t] = triangle;
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    bool sameMesh(const SponzaShape::Shape &before, const SponzaShape::Shape &after)
+    {
+        if (after.positions.size() != size_t(after.vertexCount) * 3 || after.indicies.size() != before.indicies.size()) {
+            return false;
+        }
+        for (unsigned int index : after.indicies) {
+            if (index >= after.vertexCount) {
+                return false;
+            }
+        }
+        return triangleSet(before) == triangleSet(after);
+    }
+
+    // Indices must touch vertices in order, no vertex may be skipped.
+    bool isFetchOrdered(const SponzaShape::Shape &shape)
+    {
+        unsigned int next = 0;
+        for (unsigned int index : shape.indicies) {
+            if (index > next) {
+                return false;
+            }
+            next += index == next ? 1 : 0;
+        }
+        return next == shape.vertexCount;
+    }
+
+    Bench::Timing measureOptimize(const SponzaShape &source, unsigned threadCount, int iterations)
+    {
+        std::vector<SponzaShape> copies(iterations, source);
+        size_t next = 0;
+        return Bench::Measure(iterations, [&]() {
+            OptimizeShapes(copies[next++], threadCount);
+        });
+    }
+}
+
+int Bench::RunVertexCache(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+    MappedFile file;
+    Obj::Data data;
+    if (!file.Open(path) || !Obj::Parse(file.View(), data)) {
+        std::printf("vcache: cannot load %s\n", path);
+        return 1;
+    }
+    SponzaShape source;
+    Obj::BuildShape(data, Obj::BuildOptions{}, source);
+
+    SponzaShape optimized = source;
+    std::vector<MeshOptimizeStats> stats;
+    OptimizeShapes(optimized, 0, &stats);
+
+    std::printf("cache: %u entry FIFO\n", VERTEX_CACHE_SIZE);
+    std::printf("%-32s %9s %9s %8s %8s %8s %8s %8s %s\n", "shape", "triangles", "vertices", "clusters", "ACMR in",
+                "ACMR out", "ATVR in", "ATVR out", "check");
+    size_t triangles = 0, vertices = 0, clusters = 0, failures = 0;
+    double missesBefore = 0.0, missesAfter = 0.0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const MeshOptimizeStats &shape = stats[i];
+        const bool ok = sameMesh(source.shapes[i], optimized.shapes[i]) && isFetchOrdered(optimized.shapes[i]);
+        std::printf("%-32.32s %9zu %9zu %8zu %8.3f %8.3f %8.3f %8.3f %s\n", shape.name.c_str(), shape.triangleCount,
+                    shape.vertexCount, shape.clusterCount, shape.before.acmr, shape.after.acmr, shape.before.atvr,
+                    shape.after.atvr, ok ? "ok" : "FAIL");
+        triangles += shape.triangleCount;
+        vertices += shape.vertexCount;
+        clusters += shape.clusterCount;
+        missesBefore += double(shape.before.acmr) * shape.triangleCount;
+        missesAfter += double(shape.after.acmr) * shape.triangleCount;
+        failures += ok ? 0 : 1;
+    }
+    if (triangles > 0 && vertices > 0) {
+        std::printf("%-32s %9zu %9zu %8zu %8.3f %8.3f %8.3f %8.3f\n", "total", triangles, vertices, clusters,
+                    missesBefore / triangles, missesAfter / triangles, missesBefore / vertices,
+                    missesAfter / vertices);
+    }
+
+    // Shapes are independent, so the pass scales with their count until the largest one dominates.
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%-8s %12s %12s\n", "threads", "min ms", "median ms");
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        const Timing timing = measureOptimize(source, threads, iterations);
+        std::printf("%-8u %12.2f %12.2f\n", threads, timing.minMs, timing.medianMs);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    std::printf("triangle sets: %s\n", failures == 0 ? "ok" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/TiledTexture.hpp>
+#include <ResourceManager/VirtualTexture.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr double MB = 1024.0 * 1024.0;
+
+    uint32_t unitBytes(TextureFormat format)
+    {
+        return IsBlockCompressed(format) ? TextureRowBytes(format, 4) : TextureRowBytes(format, 1);
+    }
+
+    uint32_t wrap(int64_t value, uint32_t count)
+    {
+        const int64_t remainder = value % int64_t(count);
+        return static_cast<uint32_t>(remainder < 0 ? remainder + count : remainder);
+    }
+
+    // Every level down to 1x1, filled with bytes that differ per level and position.
+    TextureLevels makeLevels(TextureFormat format, uint32_t width, uint32_t height)
+    {
+        TextureLevels texture;
+        texture.format = format;
+        texture.width = width;
+        texture.height = height;
+        for (uint32_t level = 0; std::max(width >> level, height >> level) > 0; ++level) {
+            const uint32_t levelWidth = std::max(1u, width >> level);
+            const uint32_t levelHeight = std::max(1u, height >> level);
+            RawData data;
+            data.Allocate(size_t(TextureRowBytes(format, levelWidth)) * TextureRowCount(format, levelHeight));
+            uint32_t state = 0x9e3779b9u * (level + 1) ^ width;
+            for (size_t i = 0; i < data.Size; ++i) {
+                state = state * 1664525u + 1013904223u;
+                data.Data[i] = static_cast<uint8_t>(state >> 24);
+            }
+            texture.levels.push_back(std::move(data));
+        }
+        return texture;
+    }
+
+    // Every tile holds the level's texels (or blocks) at its position and
+    // its border from the neighbouring tiles, wrapped around past the edges.
+    bool checkLayout(const fs::path &directory, TextureFormat format, uint32_t width, uint32_t height)
+    {
+        const std::string path = (directory / (std::string("layout_") + TextureFormatName(format) + ".cvt")).string();
+        const TextureLevels levels = makeLevels(format, width, height);
+        TiledTexture texture;
+        if (!WriteTiledTexture(path.c_str(), levels) || !texture.Open(path.c_str()) ||
+            texture.MipCount() != TiledMipCount(width, height)) {
+            return false;
+        }
+        const uint32_t unit = unitBytes(format);
+        const uint32_t units = TextureRowCount(format, VIRTUAL_TILE_SIZE);
+        const uint32_t border = TextureRowCount(format, VIRTUAL_TILE_BORDER);
+        const uint32_t content = units - 2 * border;
+        for (uint32_t level = 0; level < texture.MipCount(); ++level) {
+            const TiledMip &mip = texture.Mip(level);
+            const uint32_t columns = TextureRowBytes(format, mip.width) / unit;
+            const uint32_t rows = TextureRowCount(format, mip.height);
+            const uint8_t *source = levels.levels[level].Data.get();
+            for (uint32_t y = 0; y < mip.tilesY; ++y) {
+                for (uint32_t x = 0; x < mip.tilesX; ++x) {
+                    const std::string_view tile = texture.Tile(level, x, y);
+                    if (tile.size() != texture.Header().tileBytes || tile.data() - texture.View().data() <= 0 ||
+                        (tile.data() - texture.View().data()) % TEXTURE_PLACEMENT_ALIGNMENT != 0) {
+                        return false;
+                    }
+                    for (uint32_t row = 0; row < units; ++row) {
+                        for (uint32_t column = 0; column < units; ++column) {
+                            const uint32_t sourceRow = wrap(int64_t(y) * content + row - border, rows);
+                            const uint32_t sourceColumn = wrap(int64_t(x) * content + column - border, columns);
+                            const uint8_t *expected = source + (size_t(sourceRow) * columns + sourceColumn) * unit;
+                            const char *actual = tile.data() + size_t(row) * TiledRowPitch(format) + column * unit;
+                            if (std::memcmp(expected, actual, unit) != 0) {
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        // A file cut short must not open.
+        fs::resize_file(path, texture.Header().fileSize - 1);
+        texture.Close();
+        return !texture.Open(path.c_str());
+    }
+
+    void runFrame(VirtualTextureSystem &system, SimulatedTileBackend &backend, const std::vector<TileKey> &feedback)
+    {
+        system.AddFeedback(feedback.data(), feedback.size());
+        system.Update();
+        backend.AdvanceFrame();
+    }
+
+    // Five slots: the pinned coarsest tile and the four of level 1. A level
+    // 0 tile then takes the slot of the level 1 tile used longest ago, and
+    // what it covered falls back to the coarsest level.
+    bool checkLru(const fs::path &directory)
+    {
+        const std::string path = (directory / "lru.cvt").string();
+        const uint32_t size = 4 * VIRTUAL_TILE_CONTENT;
+        if (!WriteTiledTexture(path.c_str(), makeLevels(TextureFormat::BC1, size, size))) {
+            return false;
+        }
+        SimulatedTileBackend backend{5, 1};
+        VirtualTextureOptions options;
+        options.cacheSlots = 5;
+        VirtualTextureSystem system{backend, options};
+        const TextureId texture = system.Add(path.c_str());
+        if (texture == INVALID_TEXTURE || system.Texture(texture).MipCount() != 3) {
+            return false;
+        }
+
+        const std::vector<TileKey> levelOne = {PackTile(texture, 1, 0, 0), PackTile(texture, 1, 1, 0),
+                                               PackTile(texture, 1, 0, 1), PackTile(texture, 1, 1, 1)};
+        for (int frame = 0; frame < 5; ++frame) {
+            runFrame(system, backend, levelOne);
+        }
+        bool isValid = system.Cache().UsedCount() == 5;
+        for (TileKey tile : levelOne) {
+            isValid &= system.IsResident(tile);
+        }
+        runFrame(system, backend, {levelOne[1], levelOne[2], levelOne[3]});
+        runFrame(system, backend, {PackTile(texture, 0, 2, 2)});
+        const PageTable &pages = system.Pages();
+        isValid &= !system.IsResident(levelOne[0]) && system.IsResident(levelOne[3]) &&
+                   pages.Entry(texture, 1, 0, 0).level == 2 && pages.Entry(texture, 0, 1, 1).level == 2 &&
+                   pages.Entry(texture, 0, 2, 2).level == 1;
+        for (int frame = 0; frame < 3; ++frame) {
+            runFrame(system, backend, {PackTile(texture, 0, 2, 2)});
+        }
+        return isValid && system.IsResident(PackTile(texture, 0, 2, 2)) && pages.Entry(texture, 0, 2, 2).level == 0 &&
+               pages.Entry(texture, 0, 3, 3).level == 1 && system.Stats().evictionCount == 1 &&
+               backend.ErrorCount() == 0;
+    }
+
+    // Every entry names a resident tile covering it, the finest one there
+    // is, and the slot holds that tile's bytes.
+    bool consistent(const VirtualTextureSystem &system, const SimulatedTileBackend &backend,
+                    const std::vector<std::vector<uint64_t>> &checksums)
+    {
+        const PageTable &pages = system.Pages();
+        for (uint32_t texture = 0; texture < pages.TextureCount(); ++texture) {
+            const TiledTexture &file = system.Texture(texture);
+            for (uint32_t level = 0; level < pages.MipCount(texture); ++level) {
+                for (uint32_t y = 0; y < pages.TilesY(texture, level); ++y) {
+                    for (uint32_t x = 0; x < pages.TilesX(texture, level); ++x) {
+                        const PageEntry &entry = pages.Entry(texture, level, x, y);
+                        const bool isResident = system.IsResident(PackTile(texture, level, x, y));
+                        if (entry.slot == 0xffff) {
+                            if (isResident || system.IsResident(PackTile(texture, pages.MipCount(texture) - 1, 0, 0))) {
+                                return false;
+                            }
+                            continue;
+                        }
+                        const TileKey tile = system.Cache().Tile(entry.slot);
+                        uint32_t ancestorX, ancestorY;
+                        pages.Ancestor(texture, level, x, y, entry.level, ancestorX, ancestorY);
+                        if (tile != PackTile(texture, entry.level, ancestorX, ancestorY) || !system.IsResident(tile) ||
+                            isResident != (entry.level == level) ||
+                            backend.SlotChecksum(entry.slot) !=
+                                checksums[texture][file.TileIndex(entry.level, ancestorX, ancestorY)]) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return backend.ErrorCount() == 0;
+    }
+
+    // A wall of textures side by side seen at a slant: each feedback texel
+    // covers 8x8 screen pixels, rows further up see more texels per pixel.
+    void renderFeedback(const VirtualTextureSystem &system, double pan, double zoom, uint32_t width, uint32_t height,
+                        std::vector<TileKey> &feedback)
+    {
+        feedback.clear();
+        const TiledTexture &first = system.Texture(0);
+        const double textureWidth = first.Width();
+        const double wallWidth = textureWidth * system.TextureCount();
+        for (uint32_t y = 0; y < height; ++y) {
+            const double texelsPerPixel = zoom * (1.0 + 3.0 * (1.0 - double(y) / (height - 1)));
+            const uint32_t level = std::min(static_cast<uint32_t>(std::max(0.0, std::floor(std::log2(texelsPerPixel)))),
+                                            first.MipCount() - 1);
+            const double v = first.Height() * 0.5 + (double(y) - height * 0.5) * 8.0 * texelsPerPixel * 0.5;
+            for (uint32_t x = 0; x < width; ++x) {
+                const double u = pan + (double(x) - width * 0.5) * 8.0 * texelsPerPixel;
+                if (u < 0.0 || u >= wallWidth || v < 0.0 || v >= first.Height()) {
+                    feedback.push_back(INVALID_TILE);
+                    continue;
+                }
+                const uint32_t texture = static_cast<uint32_t>(u / textureWidth);
+                const uint32_t texelX = static_cast<uint32_t>(u - texture * textureWidth) >> level;
+                const uint32_t texelY = static_cast<uint32_t>(v) >> level;
+                feedback.push_back(
+                    PackTile(texture, level, texelX / VIRTUAL_TILE_CONTENT, texelY / VIRTUAL_TILE_CONTENT));
+            }
+        }
+    }
+}
+
+// Virtual texturing without a GPU: the .cvt tile layout, LRU replacement
+// and fallback in a five slot cache, then a camera panning along a wall of
+// 4096x4096 textures with the feedback buffer of a 1920x1080 view at 1/8
+// resolution, checking the page table against the simulated cache each
+// frame.
+int Bench::RunVirtualTexture(int argc, char **argv)
+{
+    const int frames = argc > 0 ? std::atoi(argv[0]) : 600;
+    const uint32_t cacheSlots = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 512;
+
+    const fs::path temporary = fs::temp_directory_path() / "chelson-vt";
+    std::error_code error;
+    fs::create_directories(temporary, error);
+
+    const bool layout = checkLayout(temporary, TextureFormat::RGBA8, 301, 77) &&
+                        checkLayout(temporary, TextureFormat::R8, 1000, 3) &&
+                        checkLayout(temporary, TextureFormat::BC1, 1030, 517) &&
+                        checkLayout(temporary, TextureFormat::BC7, 300, 300);
+    const bool lru = checkLru(temporary);
+    std::printf("tile layout: %s, lru and fallback: %s\n", layout ? "ok" : "FAIL", lru ? "ok" : "FAIL");
+    bool isValid = layout && lru;
+
+    const uint32_t TEXTURE_COUNT = 4;
+    const uint32_t TEXTURE_SIZE = 4096;
+    SimulatedTileBackend backend{cacheSlots, 2};
+    VirtualTextureOptions options;
+    options.cacheSlots = cacheSlots;
+    VirtualTextureSystem system{backend, options};
+    std::vector<std::vector<uint64_t>> checksums;
+    uint64_t allBytes = 0;
+    for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+        const std::string path = (temporary / ("wall_" + std::to_string(i) + ".cvt")).string();
+        TextureLevels levels = makeLevels(TextureFormat::BC1, TEXTURE_SIZE, TEXTURE_SIZE);
+        levels.levels[0].Data[0] = static_cast<uint8_t>(i);
+        const TextureId texture = WriteTiledTexture(path.c_str(), levels) ? system.Add(path.c_str()) : INVALID_TEXTURE;
+        if (texture == INVALID_TEXTURE) {
+            std::printf("vt: cannot write %s\n", path.c_str());
+            return 1;
+        }
+        const TiledTexture &file = system.Texture(texture);
+        checksums.emplace_back();
+        for (uint32_t tile = 0; tile < file.TileCount(); ++tile) {
+            checksums.back().push_back(SimulatedTileBackend::Checksum(file.Tile(tile)));
+        }
+        allBytes += uint64_t(file.TileCount()) * file.Header().tileBytes;
+    }
+
+    // Pan along the wall while zooming in and out, then hold still so the cache catches up.
+    const uint32_t FEEDBACK_WIDTH = 240;
+    const uint32_t FEEDBACK_HEIGHT = 135;
+    const int STILL_FRAMES = 60;
+    std::vector<TileKey> feedback;
+    double updateMs = 0.0;
+    size_t requests = 0;
+    size_t missing = 0;
+    bool isConsistent = true;
+    for (int frame = 0; frame < frames + STILL_FRAMES; ++frame) {
+        const double t = std::min(1.0, frames > 1 ? double(frame) / (frames - 1) : 1.0);
+        const double pan = 2000.0 + t * (TEXTURE_COUNT * TEXTURE_SIZE - 4000.0);
+        const double zoom = 0.75 + 0.5 * std::sin(std::min(frame, frames) * 0.02);
+        renderFeedback(system, pan, zoom, FEEDBACK_WIDTH, FEEDBACK_HEIGHT, feedback);
+        const Bench::Timing timing = Bench::Measure(1, [&]() {
+            system.AddFeedback(feedback.data(), feedback.size());
+            system.Update();
+        });
+        backend.AdvanceFrame();
+        updateMs += timing.minMs;
+        requests += system.Stats().requestCount;
+        missing += system.Stats().missingCount;
+        isConsistent &= consistent(system, backend, checksums);
+    }
+    size_t stillMissing = 0;
+    for (TileKey tile : feedback) {
+        stillMissing += tile != INVALID_TILE && !system.IsResident(tile) ? 1 : 0;
+    }
+
+    const VirtualTextureStats &stats = system.Stats();
+    const int total = frames + STILL_FRAMES;
+    const double tileBytes = system.Texture(0).Header().tileBytes;
+    std::printf("wall: %u textures of %ux%u BC1, %.1f MB of tiles, cache %u slots (%.1f MB)\n", TEXTURE_COUNT,
+                TEXTURE_SIZE, TEXTURE_SIZE, allBytes / MB, cacheSlots, cacheSlots * tileBytes / MB);
+    std::printf("  %d frames, %u feedback values each: %.1f distinct tiles, %.1f missing per frame\n", total,
+                FEEDBACK_WIDTH * FEEDBACK_HEIGHT, double(requests) / total, double(missing) / total);
+    std::printf("  %zu uploads (%.1f MB), %zu evictions; %.3f ms per frame for feedback and update\n",
+                stats.uploadCount, stats.uploadCount * tileBytes / MB, stats.evictionCount, updateMs / total);
+    // A cache smaller than the view cannot converge, it only has to stay consistent.
+    const bool fits = cacheSlots >= stats.requestCount + TEXTURE_COUNT;
+    std::printf("  page table %s, %zu feedback tiles missing after holding still%s\n",
+                isConsistent ? "consistent" : "INCONSISTENT", stillMissing, fits ? "" : " (view exceeds the cache)");
+    isValid &= isConsistent && (stillMissing == 0 || !fits);
+
+    std::printf("virtual texture checks: %s\n", isValid ? "ok" : "FAIL");
+    fs::remove_all(temporary, error);
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include "Benchmarks.hpp"
+
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/ObjParser.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Resources::CPU;
+
+int Bench::RunWeld(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : "assets/sponza/sponza.obj";
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    MappedFile file;
+    Obj::Data data;
+    if (!file.Open(path) || !Obj::Parse(file.View(), data)) {
+        std::printf("weld: cannot load %s\n", path);
+        return 1;
+    }
+
+    SponzaShape sponza;
+    std::vector<Obj::ShapeStats> stats;
+    Obj::BuildOptions options;
+    options.stats = &stats;
+    Timing timing = Measure(iterations, [&]() {
+        Obj::BuildShape(data, options, sponza);
+    });
+
+    std::printf("%-32s %10s %10s %7s %12s %12s\n", "shape", "corners", "vertices", "ratio", "KB before", "KB after");
+    size_t corners = 0, vertices = 0, before = 0, after = 0;
+    for (const Obj::ShapeStats &shape : stats) {
+        std::printf("%-32.32s %10zu %10zu %6.2fx %12.1f %12.1f\n", shape.name.c_str(), shape.cornerCount, shape.vertexCount,
+                    shape.vertexCount > 0 ? double(shape.cornerCount) / shape.vertexCount : 0.0,
+                    shape.bytesBefore / 1024.0, shape.bytesAfter / 1024.0);
+        corners += shape.cornerCount;
+        vertices += shape.vertexCount;
+        before += shape.bytesBefore;
+        after += shape.bytesAfter;
+    }
+    std::printf("%-32s %10zu %10zu %6.2fx %12.1f %12.1f\n", "total", corners, vertices,
+                vertices > 0 ? double(corners) / vertices : 0.0, before / 1024.0, after / 1024.0);
+    std::printf("build + weld: %.2f ms min, %.2f ms median\n", timing.minMs, timing.medianMs);
+    return 0;
+}
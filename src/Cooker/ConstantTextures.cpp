@@ -0,0 +1,125 @@
+#include "ConstantTextures.hpp"
+#include "CookUtil.hpp"
+
+#include <ResourceManager/ImageStats.hpp>
+#include <ResourceManager/MaterialCompiler.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Channels may differ by one step and still count as one value: that is
+    // below what any of the block formats keeps apart.
+    constexpr uint8_t UNIFORM_TOLERANCE = 1;
+    constexpr uint8_t FLAT_NORMAL = 128;
+
+    struct Scan
+    {
+        bool isScanned{false};
+        bool isUniform{false};
+        uint32_t channelCount{0};
+        uint8_t value[4]{0, 0, 0, 0};
+        uint64_t bytes{0};
+    };
+
+    float unorm(uint8_t value) { return value / 255.0f; }
+
+    float srgbToLinear(uint8_t value)
+    {
+        const float c = unorm(value);
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    const Scan &scanTexture(const std::string &path, Scan &scan, std::vector<std::string> &dependencies)
+    {
+        if (scan.isScanned) {
+            return scan;
+        }
+        scan.isScanned = true;
+        Cook::AddDependency(dependencies, path);
+
+        Image image;
+        if (!Tga::LoadFile(path.c_str(), image)) {
+            return scan;
+        }
+        const ChannelRange range = MeasureChannelRange(image, UNIFORM_TOLERANCE);
+        scan.isUniform = range.IsUniform(UNIFORM_TOLERANCE);
+        scan.channelCount = range.channelCount;
+        for (uint32_t c = 0; c < range.channelCount; ++c) {
+            scan.value[c] = static_cast<uint8_t>((range.minimum[c] + range.maximum[c] + 1) / 2);
+        }
+        scan.bytes = image.pixels.Size;
+        return scan;
+    }
+
+    bool isFlatNormal(const Scan &scan)
+    {
+        return scan.channelCount >= 2 && std::abs(scan.value[0] - FLAT_NORMAL) <= UNIFORM_TOLERANCE &&
+               std::abs(scan.value[1] - FLAT_NORMAL) <= UNIFORM_TOLERANCE;
+    }
+
+    // Moves the value into the material; false when the slot has no constant
+    // equivalent and has to keep its texture.
+    bool applyConstant(Material &material, MaterialSlot slot, const Scan &scan)
+    {
+        const bool isGrey = scan.channelCount == 1;
+        switch (slot) {
+        case MaterialSlot::Albedo:
+            for (uint32_t c = 0; c < 3; ++c) {
+                material.baseColor[c] *= srgbToLinear(scan.value[isGrey ? 0 : c]);
+            }
+            if (!isGrey) {
+                material.opacity *= unorm(scan.value[3]);
+            }
+            return true;
+        case MaterialSlot::Roughness: material.roughness = unorm(scan.value[0]); return true;
+        case MaterialSlot::Metallic: material.metallic = unorm(scan.value[0]); return true;
+        case MaterialSlot::Mask: material.opacity *= unorm(scan.value[isGrey ? 0 : 3]); return true;
+        case MaterialSlot::Normal: return isFlatNormal(scan);
+        default: return false;
+        }
+    }
+}
+
+void Cook::CollapseConstantTextures(MaterialTable &table, std::vector<std::string> &dependencies,
+                                    ConstantTextureStats &stats)
+{
+    std::vector<Scan> scans(table.texturePaths.size());
+    std::vector<bool> isCollapsed(table.texturePaths.size(), false);
+    for (Material &material : table.materials) {
+        for (size_t s = 0; s < MATERIAL_SLOT_COUNT; ++s) {
+            TextureId &texture = material.textures[s];
+            if (texture == INVALID_TEXTURE || texture >= scans.size()) {
+                continue;
+            }
+            const Scan &scan = scanTexture(table.texturePaths[texture], scans[texture], dependencies);
+            if (scan.isUniform && applyConstant(material, static_cast<MaterialSlot>(s), scan)) {
+                isCollapsed[texture] = true;
+                texture = INVALID_TEXTURE;
+                ++stats.bindingCount;
+            }
+        }
+    }
+
+    // A texture collapsed in one slot may still be sampled through another.
+    std::vector<bool> isReferenced(table.texturePaths.size(), false);
+    for (const Material &material : table.materials) {
+        for (TextureId texture : material.textures) {
+            if (texture != INVALID_TEXTURE && texture < isReferenced.size()) {
+                isReferenced[texture] = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < scans.size(); ++i) {
+        if (isCollapsed[i] && !isReferenced[i]) {
+            ++stats.textureCount;
+            stats.bytes += scans[i].bytes;
+        }
+    }
+
+    RemoveUnreferencedTextures(table);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ResourceManager/ResourceType.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Cook
+{
+    struct ConstantTextureStats
+    {
+        size_t textureCount{0};     // textures no material references anymore
+        uint64_t bytes{0};          // their decoded size
+        size_t bindingCount{0};     // material slots emptied
+    };
+
+    // Replaces textures holding a single value with the material constant
+    // they stand for: albedo scales baseColor and opacity, roughness and
+    // metallic set the scalars of the same name, a mask scales opacity and a
+    // flat normal map is dropped as it changes nothing. The slot is emptied,
+    // so the renderer neither loads nor binds the texture.
+    //
+    // Every texture scanned is added to dependencies; ones that cannot be
+    // read are left in place for the later steps to report.
+    void CollapseConstantTextures(Resources::CPU::MaterialTable &table, std::vector<std::string> &dependencies,
+                                  ConstantTextureStats &stats);
+}
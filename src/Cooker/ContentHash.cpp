@@ -0,0 +1,108 @@
+#include "ContentHash.hpp"
+
+#include <cstring>
+
+using namespace Cook;
+
+namespace
+{
+    constexpr uint64_t PRIME1 = 0x9e3779b185ebca87ull;
+    constexpr uint64_t PRIME2 = 0xc2b2ae3d27d4eb4full;
+    constexpr uint64_t PRIME3 = 0x165667b19e3779f9ull;
+    constexpr uint64_t PRIME4 = 0x85ebca77c2b2ae63ull;
+    constexpr uint64_t PRIME5 = 0x27d4eb2f165667c5ull;
+
+    inline uint64_t rotl(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t read64(const uint8_t *bytes)
+    {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t round(uint64_t lane, uint64_t input)
+    {
+        return rotl(lane + input * PRIME2, 31) * PRIME1;
+    }
+
+    inline uint64_t avalanche(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= PRIME2;
+        value ^= value >> 29;
+        value *= PRIME3;
+        value ^= value >> 32;
+        return value;
+    }
+}
+
+// Four independent xxHash64-style lanes over 32-byte blocks, folded into two
+// differently mixed 64-bit halves.
+Hash128 Cook::HashBytes(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t lanes[4] = {seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1};
+
+    size_t remaining = size;
+    while (remaining >= 32) {
+        lanes[0] = round(lanes[0], read64(bytes));
+        lanes[1] = round(lanes[1], read64(bytes + 8));
+        lanes[2] = round(lanes[2], read64(bytes + 16));
+        lanes[3] = round(lanes[3], read64(bytes + 24));
+        bytes += 32;
+        remaining -= 32;
+    }
+    if (remaining > 0) {
+        uint8_t tail[32] = {};
+        std::memcpy(tail, bytes, remaining);
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = round(lanes[i], read64(tail + i * 8));
+        }
+    }
+
+    const uint64_t length = static_cast<uint64_t>(size);
+    Hash128 hash;
+    hash.low = avalanche(rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) +
+                         length * PRIME5);
+    hash.high = avalanche((lanes[0] * PRIME3) ^ rotl(lanes[1] * PRIME4, 23) ^ rotl(lanes[2] * PRIME5, 41) ^
+                          rotl(lanes[3] * PRIME1, 53) ^ (length * PRIME4) ^ hash.low);
+    return hash;
+}
+
+std::string Cook::ToHex(const Hash128 &hash)
+{
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string text(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        text[15 - i] = DIGITS[(hash.high >> (i * 4)) & 0xf];
+        text[31 - i] = DIGITS[(hash.low >> (i * 4)) & 0xf];
+    }
+    return text;
+}
+
+bool Cook::FromHex(std::string_view text, Hash128 &hash)
+{
+    if (text.size() != 32) {
+        return false;
+    }
+    uint64_t halves[2] = {0, 0};
+    for (size_t i = 0; i < 32; ++i) {
+        const char c = text[i];
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        halves[i / 16] = (halves[i / 16] << 4) | digit;
+    }
+    hash.high = halves[0];
+    hash.low = halves[1];
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Cook
+{
+    // 128-bit non-cryptographic hash of file contents. Wide enough that two
+    // different assets colliding is not a practical concern, fast enough to
+    // run over every source on each cook.
+    struct Hash128
+    {
+        uint64_t low{0};
+        uint64_t high{0};
+
+        bool operator==(const Hash128 &other) const { return low == other.low && high == other.high; }
+        bool operator!=(const Hash128 &other) const { return !(*this == other); }
+    };
+
+    Hash128 HashBytes(const void *data, size_t size, uint64_t seed = 0);
+
+    inline Hash128 HashBytes(std::string_view bytes, uint64_t seed = 0)
+    {
+        return HashBytes(bytes.data(), bytes.size(), seed);
+    }
+
+    std::string ToHex(const Hash128 &hash);
+    bool FromHex(std::string_view text, Hash128 &hash);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace Cook
+{
+    // Adds path to the files a cooked output was built from, once.
+    inline void AddDependency(std::vector<std::string> &dependencies, const std::string &path)
+    {
+        if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end()) {
+            dependencies.push_back(path);
+        }
+    }
+}
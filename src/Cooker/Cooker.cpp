@@ -0,0 +1,564 @@
+#include "Cooker.hpp"
+#include "OrmPacker.hpp"
+
+#include <ResourceManager/BlockCompressor.hpp>
+#include <ResourceManager/CookedMesh.hpp>
+#include <ResourceManager/CookedTexture.hpp>
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/MaterialCompiler.hpp>
+#include <ResourceManager/MeshSimplifier.hpp>
+#include <ResourceManager/Meshlets.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/ObjParser.hpp>
+#include <ResourceManager/Parallel.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+#include <ResourceManager/TiledTexture.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <system_error>
+#include <unordered_set>
+
+using namespace Cook;
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct CookStep
+    {
+        const char *sourceExtension;
+        const char *outputExtension;
+        bool (*cook)(CookJob &job);
+        AssetKind kind;
+    };
+
+    // Meshes read their material libraries for the material names only.
+    // Libraries are cooked on their own and read the textures for constant
+    // folding, so editing a texture never re-cooks a mesh.
+    const CookStep COOK_STEPS[] = {
+        {".obj", ".cmesh", &CookMesh, AssetKind::Mesh},
+        {".mtl", ".cmat", &CookMaterials, AssetKind::MaterialLibrary},
+        {".tga", ".ctex", &CookTexture, AssetKind::Texture},
+    };
+
+    // Duplicate textures: the canonical source writes the output they share.
+    bool shareOutput(CookJob &) { return true; }
+
+    const CookStep SHARED_TEXTURE_STEP = {".tga", ".ctex", &shareOutput, AssetKind::Texture};
+
+    // Replaces the texture step when CookOptions::virtualTextures is set.
+    const CookStep VIRTUAL_TEXTURE_STEP = {".tga", ".cvt", &CookVirtualTexture, AssetKind::Texture};
+
+    // Packed textures the material step asks for, not found in the source tree.
+    const CookStep ORM_TEXTURE_STEP = {".tga", ".ctex", &CookOrmTexture, AssetKind::Texture};
+    const CookStep ORM_VIRTUAL_TEXTURE_STEP = {".tga", ".cvt", &CookOrmVirtualTexture, AssetKind::Texture};
+
+    const CookStep *findStep(const fs::path &path)
+    {
+        const std::string extension = path.extension().string();
+        for (const CookStep &step : COOK_STEPS) {
+            if (Text::EqualsNoCase(extension, step.sourceExtension)) {
+                return &step;
+            }
+        }
+        return nullptr;
+    }
+
+    // Builds the mip chain of image and block compresses every level in the
+    // format its role asks for, read from the name of the path.
+    bool buildTextureLevels(const Image &image, std::string_view role, TextureLevels &texture)
+    {
+        // Jobs already run in parallel, so each one keeps to a single thread here too.
+        MipOptions mipOptions = MipOptionsForTexture(role);
+        mipOptions.threadCount = 1;
+        MipChain chain;
+        if (!GenerateMips(image, mipOptions, chain)) {
+            return false;
+        }
+        chain.levels.resize(std::min<size_t>(chain.levels.size(), MAX_TEXTURE_MIPS));
+
+        Bc::CompressOptions compressOptions;
+        compressOptions.format = Bc::FormatForTexture(role, image.format);
+        compressOptions.threadCount = 1;
+
+        texture.format = TextureFormatOf(compressOptions.format);
+        texture.srgb = mipOptions.srgb;
+        texture.width = image.width;
+        texture.height = image.height;
+        const Hash128 fingerprint = FingerprintImage(image, role);
+        texture.contentHash[0] = fingerprint.low;
+        texture.contentHash[1] = fingerprint.high;
+        texture.levels.resize(chain.levels.size());
+        for (size_t level = 0; level < chain.levels.size(); ++level) {
+            if (!Bc::Compress(chain.levels[level], compressOptions, texture.levels[level])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendBytes(std::string &buffer, const void *data, size_t size)
+    {
+        buffer.append(static_cast<const char *>(data), size);
+    }
+
+    bool isTexture(const std::string &path)
+    {
+        const CookStep *step = findStep(fs::path{path});
+        return step != nullptr && step->kind == AssetKind::Texture;
+    }
+
+    // Where the cooked counterpart of source sits relative to the cooked
+    // counterpart of from; the cooked tree mirrors the source one.
+    std::string cookedRelative(const std::string &source, std::string_view from, const char *extension)
+    {
+        fs::path relative = fs::path{source}.lexically_relative(fs::path{std::string(DirectoryOf(from))});
+        relative.replace_extension(extension);
+        return relative.generic_string();
+    }
+}
+
+bool Cook::CookMesh(CookJob &job)
+{
+    const VertexLayout layout = job.quantizeVertices ? VertexLayouts::QuantizedTangent::Describe()
+                                                     : VertexLayouts::DepthAndShadingTangent::Describe();
+    Obj::LoadOptions options;
+    options.layout = &layout;
+    options.dependencies = &job.dependencies;
+    // Jobs already run in parallel, one parser thread each keeps the machine busy without oversubscribing it.
+    options.threadCount = 1;
+    options.optimize = true;
+    options.tangents = true;
+
+    SponzaShape sponza;
+    if (!Obj::LoadFile(job.source.c_str(), sponza, options)) {
+        return false;
+    }
+    GenerateLods(sponza, LodOptions{}, options.threadCount);
+    BuildMeshlets(sponza, options.threadCount);
+
+    // The only dependencies are the material libraries, each cooked into a .cmat of its own.
+    std::vector<std::string> libraries;
+    for (const std::string &library : job.dependencies) {
+        libraries.push_back(cookedRelative(library, job.source, COOK_STEPS[1].outputExtension));
+    }
+    return WriteCookedMesh(job.output.c_str(), sponza, libraries);
+}
+
+bool Cook::CookMaterials(CookJob &job)
+{
+    MaterialCompiler compiler;
+    if (!compiler.CompileFile(job.source.c_str())) {
+        return false;
+    }
+    MaterialTable materials = compiler.Release();
+    if (job.textureAliases != nullptr) {
+        ApplyTextureAliases(materials, *job.textureAliases, job.dependencies);
+    }
+    // Constant maps go first so only textures that stay get packed.
+    CollapseConstantTextures(materials, job.dependencies, job.constantTextures);
+    const char *extension = job.virtualTextures ? VIRTUAL_TEXTURE_STEP.outputExtension
+                                                : ORM_TEXTURE_STEP.outputExtension;
+    PackOrmTextures(materials, std::string(DirectoryOf(job.output)), extension, job.ormTextures, job.dependencies);
+
+    // Point every texture at the file the runtime loads: packed ones already
+    // name their output, sources move into the cooked tree.
+    for (std::string &path : materials.texturePaths) {
+        const bool isPacked = std::any_of(job.ormTextures.begin(), job.ormTextures.end(),
+                                          [&](const OrmTexture &texture) { return texture.output == path; });
+        if (isPacked) {
+            path = fs::path{path}.lexically_relative(fs::path{std::string(DirectoryOf(job.output))}).generic_string();
+        } else {
+            path = cookedRelative(path, job.source, extension);
+        }
+    }
+    return WriteCookedMaterials(job.output.c_str(), materials);
+}
+
+bool Cook::CookTexture(CookJob &job)
+{
+    Image image;
+    TextureLevels texture;
+    return Tga::LoadFile(job.source.c_str(), image) && buildTextureLevels(image, job.source, texture) &&
+           WriteCookedTexture(job.output.c_str(), texture);
+}
+
+bool Cook::CookVirtualTexture(CookJob &job)
+{
+    Image image;
+    TextureLevels texture;
+    return Tga::LoadFile(job.source.c_str(), image) && buildTextureLevels(image, job.source, texture) &&
+           WriteTiledTexture(job.output.c_str(), texture);
+}
+
+bool Cook::CookOrmTexture(CookJob &job)
+{
+    // Both maps, so the graph links the packed texture to each.
+    job.dependencies = {job.orm.roughness, job.orm.metallic};
+    Image image;
+    TextureLevels texture;
+    return LoadOrmImage(job.orm, image) && buildTextureLevels(image, job.output, texture) &&
+           WriteCookedTexture(job.output.c_str(), texture);
+}
+
+bool Cook::CookOrmVirtualTexture(CookJob &job)
+{
+    // Both maps, so the graph links the packed texture to each.
+    job.dependencies = {job.orm.roughness, job.orm.metallic};
+    Image image;
+    TextureLevels texture;
+    return LoadOrmImage(job.orm, image) && buildTextureLevels(image, job.output, texture) &&
+           WriteTiledTexture(job.output.c_str(), texture);
+}
+
+Cooker::Cooker(const CookOptions &options)
+    : m_options{options}
+{
+}
+
+bool Cooker::Run(CookReport &report)
+{
+    report = CookReport{};
+    const std::string manifestPath = NormalizePath(m_options.outputRoot, "manifest.txt");
+    m_manifest.Load(manifestPath.c_str());
+
+    struct Source
+    {
+        CookJob job;
+        const CookStep *step;
+    };
+    std::vector<Source> sources;
+
+    std::error_code error;
+    const fs::path root{m_options.sourceRoot};
+    for (fs::recursive_directory_iterator it{root, error}, end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error)) {
+            continue;
+        }
+        const CookStep *step = findStep(it->path());
+        if (step == nullptr) {
+            continue;
+        }
+        if (m_options.virtualTextures && step->kind == AssetKind::Texture) {
+            step = &VIRTUAL_TEXTURE_STEP;
+        }
+        fs::path relative = it->path().lexically_relative(root);
+        relative.replace_extension(step->outputExtension);
+
+        Source source;
+        source.job.source = NormalizePath("", it->path().generic_string());
+        source.job.name = source.job.source;
+        source.job.output = NormalizePath(m_options.outputRoot, relative.generic_string());
+        source.step = step;
+        sources.push_back(std::move(source));
+    }
+    if (error) {
+        report.failures.push_back(m_options.sourceRoot + ": " + error.message());
+        return false;
+    }
+    report.sourceCount = sources.size();
+
+    const unsigned threadCount = ResolveThreads(m_options.threadCount);
+
+    // Textures that decode to the same pixels and whose names ask for the
+    // same cook settings are cooked once, from the first source by path;
+    // the others share its output and materials are pointed at it, so the
+    // runtime loads it once too.
+    std::vector<size_t> textures;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i].step->kind == AssetKind::Texture) {
+            textures.push_back(i);
+        }
+    }
+    std::vector<Hash128> fingerprints(sources.size());
+    ParallelFor(textures.size(), threadCount, [&](size_t i) {
+        fingerprints[textures[i]] = fingerprint(sources[textures[i]].job.source, report);
+    });
+    std::sort(textures.begin(), textures.end(), [&](size_t a, size_t b) {
+        const Hash128 &left = fingerprints[a];
+        const Hash128 &right = fingerprints[b];
+        if (left != right) {
+            return left.high != right.high ? left.high < right.high : left.low < right.low;
+        }
+        return sources[a].job.source < sources[b].job.source;
+    });
+
+    TextureAliases aliases;
+    std::vector<size_t> duplicates;
+    for (size_t i = 1, canonical = textures.empty() ? 0 : textures[0]; i < textures.size(); ++i) {
+        const size_t texture = textures[i];
+        if (fingerprints[texture] != fingerprints[canonical] || fingerprints[texture] == Hash128{}) {
+            canonical = texture;
+            continue;
+        }
+        aliases[Text::ToLower(sources[texture].job.source)] = sources[canonical].job.source;
+        sources[texture].job.output = sources[canonical].job.output;
+        sources[texture].step = &SHARED_TEXTURE_STEP;
+        duplicates.push_back(texture);
+    }
+    for (Source &source : sources) {
+        const bool isLibrary = source.step->kind == AssetKind::MaterialLibrary;
+        source.job.textureAliases = isLibrary ? &aliases : nullptr;
+        source.job.quantizeVertices = m_options.quantizeVertices && source.step->kind == AssetKind::Mesh;
+        source.job.virtualTextures = m_options.virtualTextures && isLibrary;
+    }
+
+    ParallelFor(sources.size(), threadCount, [&](size_t i) {
+        cook(sources[i].job, sources[i].step->cook, report);
+    });
+
+    // Libraries sharing an output directory may ask for the same ORM texture,
+    // it is cooked once. Up to date libraries ask through the manifest.
+    std::map<std::string, OrmTexture> ormTextures;
+    for (const Source &source : sources) {
+        for (const OrmTexture &texture : source.job.ormTextures) {
+            const auto inserted = ormTextures.emplace(texture.output, texture);
+            const OrmTexture &known = inserted.first->second;
+            if (!inserted.second && (known.roughness != texture.roughness || known.metallic != texture.metallic)) {
+                report.failures.push_back(texture.output + ": packed from different maps by two material libraries");
+            }
+        }
+    }
+    std::vector<Source> packed;
+    packed.reserve(ormTextures.size());
+    for (auto &[output, texture] : ormTextures) {
+        Source source;
+        source.job.name = output;
+        source.job.source = texture.roughness;
+        source.job.output = output;
+        source.job.orm = std::move(texture);
+        source.step = m_options.virtualTextures ? &ORM_VIRTUAL_TEXTURE_STEP : &ORM_TEXTURE_STEP;
+        packed.push_back(std::move(source));
+    }
+    report.ormTextureCount = packed.size();
+    ParallelFor(packed.size(), threadCount, [&](size_t i) {
+        cook(packed[i].job, packed[i].step->cook, report);
+    });
+
+    report.duplicateTextureCount = duplicates.size();
+    for (size_t duplicate : duplicates) {
+        const uintmax_t size = fs::file_size(sources[duplicate].job.output, error);
+        report.duplicateBytes += error ? 0 : size;
+    }
+    error.clear();
+
+    // Forget sources that went away, their outputs are left for a clean to remove.
+    std::unordered_set<std::string> present;
+    for (const Source &source : sources) {
+        present.insert(source.job.name);
+    }
+    for (const Source &source : packed) {
+        present.insert(source.job.name);
+    }
+    std::vector<std::string> removed;
+    for (const auto &entry : m_manifest.Cooks()) {
+        if (present.count(entry.first) == 0) {
+            removed.push_back(entry.first);
+        }
+    }
+    for (const std::string &source : removed) {
+        m_manifest.RemoveCook(source);
+    }
+    m_manifest.DropUntouchedFiles();
+
+    if (m_manifest.IsDirty()) {
+        fs::create_directories(m_options.outputRoot, error);
+        if (!m_manifest.Save(manifestPath.c_str())) {
+            report.failures.push_back(manifestPath + ": cannot write manifest");
+        }
+    }
+    return report.failures.empty();
+}
+
+bool Cooker::cook(CookJob &job, bool (*step)(CookJob &), CookReport &report)
+{
+    Hash128 sourceHash;
+    if (!hashFile(job.source, sourceHash, report)) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        report.failures.push_back(job.name + ": cannot read " + job.source);
+        return false;
+    }
+
+    std::error_code error;
+    if (!m_options.force) {
+        std::vector<std::string> dependencies;
+        std::vector<OrmTexture> ormTextures;
+        Hash128 previousKey;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            const Manifest::CookRecord *record = m_manifest.FindCook(job.name);
+            if (record != nullptr && record->output == job.output) {
+                dependencies = record->dependencies;
+                ormTextures = record->ormTextures;
+                previousKey = record->key;
+            }
+        }
+        if (previousKey != Hash128{} && cookKey(job, sourceHash, dependencies, report) == previousKey &&
+            fs::exists(job.output, error)) {
+            job.ormTextures = std::move(ormTextures);
+            std::lock_guard<std::mutex> lock{m_mutex};
+            ++report.upToDateCount;
+            return true;
+        }
+    }
+
+    fs::create_directories(fs::path{job.output}.parent_path(), error);
+    job.dependencies.clear();
+    job.ormTextures.clear();
+    job.constantTextures = ConstantTextureStats{};
+    const bool cooked = step(job);
+
+    Manifest::CookRecord record;
+    if (cooked) {
+        record.output = job.output;
+        record.key = cookKey(job, sourceHash, job.dependencies, report);
+        record.dependencies = job.dependencies;
+        record.ormTextures = job.ormTextures;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!cooked) {
+        m_manifest.RemoveCook(job.name);
+        report.failures.push_back(job.name + ": cook failed");
+        return false;
+    }
+    m_manifest.SetCook(job.name, std::move(record));
+    ++report.cookedCount;
+    report.constantTextures.textureCount += job.constantTextures.textureCount;
+    report.constantTextures.bytes += job.constantTextures.bytes;
+    report.constantTextures.bindingCount += job.constantTextures.bindingCount;
+    return true;
+}
+
+// Content hash of a file, read from the manifest while its size and time match.
+bool Cooker::hashFile(const std::string &path, Hash128 &hash, CookReport &report)
+{
+    std::error_code error;
+    Manifest::FileRecord record;
+    record.size = fs::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    record.modified = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    if (error) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        const Manifest::FileRecord *known = m_manifest.FindFile(path);
+        if (known != nullptr && known->size == record.size && known->modified == record.modified) {
+            hash = known->hash;
+            m_manifest.SetFile(path, *known);
+            return true;
+        }
+    }
+
+    MappedFile file;
+    if (!file.Open(path.c_str())) {
+        return false;
+    }
+    record.hash = HashBytes(file.View());
+    hash = record.hash;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_manifest.SetFile(path, record);
+    ++report.hashedCount;
+    report.hashedBytes += record.size;
+    return true;
+}
+
+// Pixel and settings fingerprint of a texture source, decoded only when the
+// manifest has none for the current file content.
+Hash128 Cooker::fingerprint(const std::string &path, CookReport &report)
+{
+    Hash128 file;
+    if (!hashFile(path, file, report)) {
+        return Hash128{};
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (const Hash128 *pixels = m_manifest.FindFingerprint(path, file)) {
+            return *pixels;
+        }
+    }
+
+    Image image;
+    if (!Tga::LoadFile(path.c_str(), image)) {
+        return Hash128{};
+    }
+    const Hash128 pixels = FingerprintImage(image, path);
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_manifest.SetFingerprint(path, {file, pixels});
+    return pixels;
+}
+
+Hash128 Cooker::cookKey(const CookJob &job, const Hash128 &source, const std::vector<std::string> &dependencies,
+                        CookReport &report)
+{
+    std::string key;
+    appendBytes(key, &COOKER_VERSION, sizeof(COOKER_VERSION));
+    appendBytes(key, &source, sizeof(source));
+    // Options that change the output of a step without changing its output path.
+    key.push_back(job.quantizeVertices ? 'q' : '-');
+    key.push_back(job.virtualTextures ? 'v' : '-');
+    for (const std::string &dependency : dependencies) {
+        // A missing dependency is part of the key too, so creating it later
+        // triggers a cook. Textures count by their pixels, so saving one again
+        // with other header fields or compression changes nothing.
+        Hash128 hash;
+        if (isTexture(dependency)) {
+            hash = fingerprint(dependency, report);
+        } else if (!hashFile(dependency, hash, report)) {
+            hash = Hash128{};
+        }
+        key.append(dependency);
+        key.push_back('\0');
+        appendBytes(key, &hash, sizeof(hash));
+    }
+    return HashBytes(key);
+}
+
+void Cooker::BuildGraph(DependencyGraph &graph) const
+{
+    using NodeId = DependencyGraph::NodeId;
+    graph.Clear();
+
+    auto addLibrary = [&graph](const std::string &path) {
+        if (graph.Find(path) == DependencyGraph::INVALID_NODE) {
+            MaterialCompiler materials;
+            materials.CompileFile(path.c_str());
+            AddMaterialLibrary(graph, path, materials.Table());
+        }
+        return graph.Find(path);
+    };
+
+    std::vector<NodeId> dependencies;
+    for (const auto &[source, record] : m_manifest.Cooks()) {
+        // ORM textures are the only records named by their output.
+        const CookStep *step = findStep(fs::path{source});
+        const AssetKind kind = step != nullptr ? step->kind
+                                               : (source == record.output ? AssetKind::Texture : AssetKind::Mesh);
+        // A library's textures hang off the materials sampling them, not off
+        // the library, or every texture would reach the meshes using it.
+        if (kind == AssetKind::MaterialLibrary) {
+            addLibrary(source);
+            continue;
+        }
+        const NodeId node = graph.AddNode(source, kind);
+        dependencies.clear();
+        for (const std::string &dependency : record.dependencies) {
+            const CookStep *dependencyStep = findStep(fs::path{dependency});
+            if (dependencyStep != nullptr && dependencyStep->kind == AssetKind::MaterialLibrary) {
+                dependencies.push_back(addLibrary(dependency));
+            } else {
+                dependencies.push_back(graph.AddNode(dependency, AssetKind::Texture));
+            }
+        }
+        graph.SetDependencies(node, dependencies);
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "ConstantTextures.hpp"
+#include "ContentHash.hpp"
+#include "Manifest.hpp"
+#include "OrmPacker.hpp"
+#include "TextureDedup.hpp"
+
+#include <ResourceManager/DependencyGraph.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Cook
+{
+    // Part of every cook key. Bump it whenever a cooked format or a cook step
+    // changes, so the next run rebuilds everything it produced.
+    constexpr uint32_t COOKER_VERSION = 14;
+
+    struct CookOptions
+    {
+        std::string sourceRoot{"assets"};
+        std::string outputRoot{"cooked"};
+        unsigned threadCount{0};    // 0 picks the hardware concurrency
+        bool force{false};          // ignore the manifest and cook everything
+        bool virtualTextures{false};    // cook textures into tiled .cvt files instead of .ctex
+        bool quantizeVertices{false};   // cook meshes with VertexLayouts::Quantized
+    };
+
+    struct CookReport
+    {
+        size_t sourceCount{0};
+        size_t cookedCount{0};
+        size_t upToDateCount{0};
+        size_t ormTextureCount{0};  // packed textures, counted as cooked or up to date like sources
+        size_t hashedCount{0};      // files read because their size or time changed
+        uint64_t hashedBytes{0};
+        ConstantTextureStats constantTextures;  // summed over the sources cooked this run
+        size_t duplicateTextureCount{0};        // sources sharing another one's cooked texture
+        uint64_t duplicateBytes{0};             // cooked bytes they would have taken
+        std::vector<std::string> failures;
+    };
+
+    // One source to cook. Cook steps add every other file they read to
+    // dependencies, so a change to any of them triggers a re-cook. Texture
+    // dependencies count by their pixels, see FingerprintImage, other files
+    // by their bytes.
+    struct CookJob
+    {
+        // The job's record in the manifest: its source, or its output for ORM
+        // textures, whose roughness map may feed several of them.
+        std::string name;
+        std::string source;
+        std::string output;
+        std::vector<std::string> dependencies;
+        ConstantTextureStats constantTextures;
+        // Set by the cooker for material jobs, so materials name canonical textures only.
+        const TextureAliases *textureAliases{nullptr};
+        // Set by the cooker for mesh jobs from CookOptions::quantizeVertices.
+        bool quantizeVertices{false};
+        // Set by the cooker for material jobs from CookOptions::virtualTextures,
+        // the textures they name get the extension of the texture step.
+        bool virtualTextures{false};
+        // Filled by CookMaterials with the ORM textures its materials now reference.
+        std::vector<OrmTexture> ormTextures;
+        // Set by the cooker for ORM texture jobs, source is its roughness map.
+        OrmTexture orm;
+    };
+
+    // Geometry only: the .cmesh names its materials and the .cmat of every
+    // library they come from, so only the .obj and its .mtl files are read.
+    bool CookMesh(CookJob &job);
+    // Resolves a .mtl against the pixels of its textures into a .cmat: aliases
+    // for duplicates, constant textures folded, ORM pairs packed.
+    bool CookMaterials(CookJob &job);
+    // Decodes a TGA, builds its mip chain and block compresses every level
+    // in the format its role asks for, see Bc::FormatForTexture.
+    bool CookTexture(CookJob &job);
+    // Same levels as CookTexture, cut into virtual texture tiles, see WriteTiledTexture.
+    bool CookVirtualTexture(CookJob &job);
+    // CookTexture and CookVirtualTexture for job.orm: the two maps packed
+    // into one image first, the output name picks the format.
+    bool CookOrmTexture(CookJob &job);
+    bool CookOrmVirtualTexture(CookJob &job);
+
+    // Walks the source tree and cooks every file some cook step understands,
+    // skipping those whose key matches the manifest of the previous run. The
+    // ORM textures the material libraries ask for are cooked after them, once each.
+    class Cooker
+    {
+    public:
+        explicit Cooker(const CookOptions &options);
+
+        bool Run(CookReport &report);
+
+        // Rebuilds graph from the last Run: every cooked source, the material
+        // libraries it read, their materials and the textures those sample.
+        // Meshes reach textures only through a library, so a texture change
+        // affects the materials sampling it and not the meshes.
+        void BuildGraph(Resources::CPU::DependencyGraph &graph) const;
+
+        const CookOptions &Options() const { return m_options; }
+
+    private:
+        bool cook(CookJob &job, bool (*step)(CookJob &), CookReport &report);
+        bool hashFile(const std::string &path, Hash128 &hash, CookReport &report);
+        Hash128 fingerprint(const std::string &path, CookReport &report);
+        Hash128 cookKey(const CookJob &job, const Hash128 &source, const std::vector<std::string> &dependencies, CookReport &report);
+
+        CookOptions m_options;
+        Manifest m_manifest;
+        std::mutex m_mutex;
+    };
+}
@@ -0,0 +1,145 @@
+#include "Cooker.hpp"
+
+#include <ResourceManager/FileWatcher.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    const char *KIND_NAMES[] = {"mesh", "material library", "material", "texture"};
+
+    void printUsage()
+    {
+        std::printf("usage: chelson-cook [--force] [--jobs N] [--watch] [--virtual] [--quantize] [source dir] [output dir]\n");
+        std::printf("  cooks every asset under source dir (assets) into output dir (cooked)\n");
+        std::printf("  --watch keeps running and re-cooks what a changed file affects\n");
+        std::printf("  --virtual cooks textures into tiled .cvt files for virtual texturing\n");
+        std::printf("  --quantize cooks meshes with 16-bit positions in their bounds\n");
+    }
+
+    void printReport(const Cook::CookReport &report, double ms)
+    {
+        for (const std::string &failure : report.failures) {
+            std::printf("error: %s\n", failure.c_str());
+        }
+        std::printf("%zu sources, %zu ORM textures: %zu cooked, %zu up to date, %zu failed; hashed %zu files (%.1f MB) "
+                    "in %.1f ms\n", report.sourceCount, report.ormTextureCount, report.cookedCount, report.upToDateCount,
+                    report.failures.size(), report.hashedCount, report.hashedBytes / (1024.0 * 1024.0), ms);
+        const Cook::ConstantTextureStats &constants = report.constantTextures;
+        if (constants.bindingCount > 0) {
+            std::printf("constant textures: %zu folded into materials (%.1f MB decoded), %zu texture bindings dropped\n",
+                        constants.textureCount, constants.bytes / (1024.0 * 1024.0), constants.bindingCount);
+        }
+        if (report.duplicateTextureCount > 0) {
+            std::printf("duplicate textures: %zu share another source's cooked texture (%.1f MB saved)\n",
+                        report.duplicateTextureCount, report.duplicateBytes / (1024.0 * 1024.0));
+        }
+    }
+
+    void printAffected(const DependencyGraph &graph, const std::string &path)
+    {
+        const DependencyGraph::NodeId node = graph.Find(path);
+        if (node == DependencyGraph::INVALID_NODE) {
+            std::printf("%s: changed, nothing depends on it\n", path.c_str());
+            return;
+        }
+        std::vector<DependencyGraph::NodeId> affected;
+        graph.CollectAffected(node, affected);
+        std::printf("%s: %zu affected\n", path.c_str(), affected.size());
+        for (DependencyGraph::NodeId id : affected) {
+            std::printf("  %-16s %s\n", KIND_NAMES[static_cast<size_t>(graph.Kind(id))], graph.Name(id).c_str());
+        }
+    }
+
+    // Waits for changes, lets a burst of writes settle, then re-cooks. The
+    // manifest makes the cook itself touch only what the changes affect.
+    int watch(Cook::Cooker &cooker)
+    {
+        FileWatcher watcher;
+        if (!watcher.Watch(cooker.Options().sourceRoot)) {
+            std::printf("error: cannot watch %s\n", cooker.Options().sourceRoot.c_str());
+            return 1;
+        }
+        DependencyGraph graph;
+        cooker.BuildGraph(graph);
+        std::printf("watching %s, %zu assets in the dependency graph\n", cooker.Options().sourceRoot.c_str(),
+                    graph.NodeCount());
+        std::fflush(stdout);
+
+        constexpr std::chrono::milliseconds SETTLE_TIME{20};
+        std::vector<FileWatcher::Event> events;
+        for (;;) {
+            watcher.Wait(std::chrono::milliseconds{1000});
+            events.clear();
+            if (watcher.Poll(events) == 0) {
+                continue;
+            }
+            do {
+                std::this_thread::sleep_for(SETTLE_TIME);
+            } while (watcher.Poll(events) > 0);
+
+            for (const FileWatcher::Event &event : events) {
+                printAffected(graph, event.path);
+            }
+            Cook::CookReport report;
+            const auto cookStart = std::chrono::steady_clock::now();
+            cooker.Run(report);
+            const auto cookEnd = std::chrono::steady_clock::now();
+            cooker.BuildGraph(graph);
+            printReport(report, std::chrono::duration<double, std::milli>(cookEnd - cookStart).count());
+            std::printf("reload latency %.1f ms from the first change\n",
+                        std::chrono::duration<double, std::milli>(cookEnd - events.front().time).count());
+            std::fflush(stdout);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Cook::CookOptions options;
+    int positional = 0;
+    bool isWatching = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--force") == 0) {
+            options.force = true;
+        } else if (std::strcmp(argv[i], "--watch") == 0) {
+            isWatching = true;
+        } else if (std::strcmp(argv[i], "--virtual") == 0) {
+            options.virtualTextures = true;
+        } else if (std::strcmp(argv[i], "--quantize") == 0) {
+            options.quantizeVertices = true;
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            options.threadCount = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 1;
+        } else if (positional == 0) {
+            options.sourceRoot = argv[i];
+            ++positional;
+        } else if (positional == 1) {
+            options.outputRoot = argv[i];
+            ++positional;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Cook::Cooker cooker{options};
+    Cook::CookReport report;
+    const bool succeeded = cooker.Run(report);
+    auto stop = std::chrono::steady_clock::now();
+
+    printReport(report, std::chrono::duration<double, std::milli>(stop - start).count());
+    if (isWatching) {
+        return watch(cooker);
+    }
+    return succeeded ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "Manifest.hpp"
+
+#include <ResourceManager/MappedFile.hpp>
+#include <ResourceManager/TextScan.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+using namespace Cook;
+using namespace Resources::CPU;
+
+// One record per line, tab separated since paths may contain spaces:
+//   file <path> <size> <modified> <hash>
+//   cook <source> <output> <key> <dependency>...
+//   orm <source> <output> <roughness> <metallic>, after the cook line of its material library
+//   pixels <source> <file hash> <pixel hash>, FingerprintImage of the source for its role
+namespace
+{
+    constexpr std::string_view MANIFEST_HEADER = "chelson-cook-manifest 2";
+
+    std::vector<std::string_view> splitFields(const char *cursor, const char *end)
+    {
+        std::vector<std::string_view> fields;
+        const char *begin = cursor;
+        for (; cursor <= end; ++cursor) {
+            if (cursor == end || *cursor == '\t') {
+                fields.emplace_back(begin, cursor - begin);
+                begin = cursor + 1;
+            }
+        }
+        return fields;
+    }
+
+    // Times are full 64-bit ticks, past what Text::ParseInt keeps for OBJ indices.
+    template<typename T>
+    bool parseInteger(std::string_view text, T &value)
+    {
+        const char *end = text.data() + text.size();
+        const std::from_chars_result result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc{} && result.ptr == end;
+    }
+
+    template<typename Map>
+    std::vector<typename Map::const_pointer> sorted(const Map &map)
+    {
+        std::vector<typename Map::const_pointer> entries;
+        entries.reserve(map.size());
+        for (const auto &entry : map) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](auto a, auto b) { return a->first < b->first; });
+        return entries;
+    }
+}
+
+// A missing or malformed manifest only costs a full cook, so Load never fails hard.
+bool Manifest::Load(const char *path)
+{
+    m_files.clear();
+    m_cooks.clear();
+    m_fingerprints.clear();
+    m_touchedFiles.clear();
+    m_isDirty = false;
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    bool isFirstLine = true;
+    bool isValid = true;
+    Text::ForEachLine(file.View(), [&](const char *cursor, const char *end) {
+        if (end > cursor && end[-1] == '\r') {
+            --end;
+        }
+        if (isFirstLine) {
+            isFirstLine = false;
+            isValid = std::string_view(cursor, end - cursor) == MANIFEST_HEADER;
+            return isValid;
+        }
+
+        const std::vector<std::string_view> fields = splitFields(cursor, end);
+        if (fields[0] == "file" && fields.size() == 5) {
+            FileRecord record;
+            if (parseInteger(fields[2], record.size) && parseInteger(fields[3], record.modified) &&
+                FromHex(fields[4], record.hash)) {
+                m_files[std::string(fields[1])] = record;
+            }
+        } else if (fields[0] == "cook" && fields.size() >= 4) {
+            CookRecord record;
+            record.output = fields[2];
+            if (FromHex(fields[3], record.key)) {
+                record.dependencies.assign(fields.begin() + 4, fields.end());
+                m_cooks[std::string(fields[1])] = std::move(record);
+            }
+        } else if (fields[0] == "orm" && fields.size() == 5) {
+            auto cook = m_cooks.find(std::string(fields[1]));
+            if (cook != m_cooks.end()) {
+                cook->second.ormTextures.push_back(
+                    {std::string(fields[2]), std::string(fields[3]), std::string(fields[4])});
+            }
+        } else if (fields[0] == "pixels" && fields.size() == 4) {
+            FingerprintRecord record;
+            if (FromHex(fields[2], record.file) && FromHex(fields[3], record.pixels)) {
+                m_fingerprints[std::string(fields[1])] = record;
+            }
+        }
+        return true;
+    });
+
+    if (!isValid || isFirstLine) {
+        m_files.clear();
+        m_cooks.clear();
+        m_fingerprints.clear();
+        return false;
+    }
+    return true;
+}
+
+bool Manifest::Save(const char *path) const
+{
+    const std::string temporary = std::string(path) + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::fprintf(file, "%.*s\n", static_cast<int>(MANIFEST_HEADER.size()), MANIFEST_HEADER.data());
+    for (const auto *entry : sorted(m_files)) {
+        const FileRecord &record = entry->second;
+        std::fprintf(file, "file\t%s\t%llu\t%lld\t%s\n", entry->first.c_str(),
+                     static_cast<unsigned long long>(record.size), static_cast<long long>(record.modified),
+                     ToHex(record.hash).c_str());
+    }
+    for (const auto *entry : sorted(m_cooks)) {
+        const CookRecord &record = entry->second;
+        std::fprintf(file, "cook\t%s\t%s\t%s", entry->first.c_str(), record.output.c_str(), ToHex(record.key).c_str());
+        for (const std::string &dependency : record.dependencies) {
+            std::fprintf(file, "\t%s", dependency.c_str());
+        }
+        std::fputc('\n', file);
+        for (const OrmTexture &texture : record.ormTextures) {
+            std::fprintf(file, "orm\t%s\t%s\t%s\t%s\n", entry->first.c_str(), texture.output.c_str(),
+                         texture.roughness.c_str(), texture.metallic.c_str());
+        }
+    }
+    for (const auto *entry : sorted(m_fingerprints)) {
+        std::fprintf(file, "pixels\t%s\t%s\t%s\n", entry->first.c_str(), ToHex(entry->second.file).c_str(),
+                     ToHex(entry->second.pixels).c_str());
+    }
+
+    if (std::fclose(file) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return MoveFileOver(temporary.c_str(), path);
+}
+
+const Manifest::FileRecord *Manifest::FindFile(const std::string &path) const
+{
+    auto found = m_files.find(path);
+    return found != m_files.end() ? &found->second : nullptr;
+}
+
+void Manifest::SetFile(const std::string &path, const FileRecord &record)
+{
+    m_touchedFiles.insert(path);
+    auto inserted = m_files.emplace(path, record);
+    FileRecord &stored = inserted.first->second;
+    if (inserted.second || stored.size != record.size || stored.modified != record.modified || stored.hash != record.hash) {
+        stored = record;
+        m_isDirty = true;
+    }
+}
+
+const Manifest::CookRecord *Manifest::FindCook(const std::string &source) const
+{
+    auto found = m_cooks.find(source);
+    return found != m_cooks.end() ? &found->second : nullptr;
+}
+
+void Manifest::SetCook(const std::string &source, CookRecord record)
+{
+    m_cooks[source] = std::move(record);
+    m_isDirty = true;
+}
+
+void Manifest::RemoveCook(const std::string &source)
+{
+    m_isDirty |= m_cooks.erase(source) > 0;
+}
+
+const Hash128 *Manifest::FindFingerprint(const std::string &source, const Hash128 &file) const
+{
+    auto found = m_fingerprints.find(source);
+    return found != m_fingerprints.end() && found->second.file == file ? &found->second.pixels : nullptr;
+}
+
+void Manifest::SetFingerprint(const std::string &source, const FingerprintRecord &record)
+{
+    FingerprintRecord &stored = m_fingerprints[source];
+    if (stored.file != record.file || stored.pixels != record.pixels) {
+        stored = record;
+        m_isDirty = true;
+    }
+}
+
+void Manifest::DropUntouchedFiles()
+{
+    for (auto it = m_files.begin(); it != m_files.end();) {
+        if (m_touchedFiles.count(it->first) == 0) {
+            it = m_files.erase(it);
+            m_isDirty = true;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_fingerprints.begin(); it != m_fingerprints.end();) {
+        if (m_files.count(it->first) == 0) {
+            it = m_fingerprints.erase(it);
+            m_isDirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
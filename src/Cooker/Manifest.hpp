@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ContentHash.hpp"
+#include "OrmPacker.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Cook
+{
+    // What the previous cook saw and produced, stored as text next to the outputs.
+    //
+    // File records cache content hashes by size and modification time, so an
+    // unchanged tree is checked without reading a single source. Cook records
+    // keep the key every output was built from: the cooker version plus the
+    // hashes of the source and of every file the cook read along the way.
+    class Manifest
+    {
+    public:
+        struct FileRecord
+        {
+            uint64_t size{0};
+            int64_t modified{0};
+            Hash128 hash;
+        };
+
+        struct CookRecord
+        {
+            std::string output;
+            Hash128 key;
+            std::vector<std::string> dependencies;
+            // ORM textures a material cook asked for, so they are still built
+            // while the library itself is up to date.
+            std::vector<OrmTexture> ormTextures;
+        };
+
+        bool Load(const char *path);
+        bool Save(const char *path) const;
+
+        const FileRecord *FindFile(const std::string &path) const;
+        void SetFile(const std::string &path, const FileRecord &record);
+
+        // Decoded pixel fingerprint of a texture source, valid while the file
+        // still has the content hash it was taken from.
+        struct FingerprintRecord
+        {
+            Hash128 file;
+            Hash128 pixels;
+        };
+
+        const CookRecord *FindCook(const std::string &source) const;
+        void SetCook(const std::string &source, CookRecord record);
+        void RemoveCook(const std::string &source);
+
+        const Hash128 *FindFingerprint(const std::string &source, const Hash128 &file) const;
+        void SetFingerprint(const std::string &source, const FingerprintRecord &record);
+
+        // File records not set since Load belong to files that are gone, and
+        // so do the fingerprints taken from them.
+        void DropUntouchedFiles();
+
+        const std::unordered_map<std::string, CookRecord> &Cooks() const { return m_cooks; }
+        bool IsDirty() const { return m_isDirty; }
+
+    private:
+        std::unordered_map<std::string, FileRecord> m_files;
+        std::unordered_map<std::string, CookRecord> m_cooks;
+        std::unordered_map<std::string, FingerprintRecord> m_fingerprints;
+        std::unordered_set<std::string> m_touchedFiles;
+        bool m_isDirty{false};
+    };
+}
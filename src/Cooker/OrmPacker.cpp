@@ -0,0 +1,70 @@
+#include "OrmPacker.hpp"
+#include "CookUtil.hpp"
+
+#include <ResourceManager/ChannelPacker.hpp>
+#include <ResourceManager/MaterialCompiler.hpp>
+#include <ResourceManager/TextScan.hpp>
+#include <ResourceManager/TgaDecoder.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <system_error>
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+void Cook::PackOrmTextures(MaterialTable &table, const std::string &outputDirectory, const char *extension,
+                           std::vector<OrmTexture> &textures, std::vector<std::string> &dependencies)
+{
+    std::map<std::pair<TextureId, TextureId>, TextureId> packed;
+    for (Material &material : table.materials) {
+        const TextureId roughnessId = material.Texture(MaterialSlot::Roughness);
+        const TextureId metallicId = material.Texture(MaterialSlot::Metallic);
+        if (roughnessId == INVALID_TEXTURE || metallicId == INVALID_TEXTURE) {
+            continue;
+        }
+
+        const auto key = std::make_pair(roughnessId, metallicId);
+        auto found = packed.find(key);
+        if (found == packed.end()) {
+            OrmTexture texture;
+            texture.roughness = table.texturePaths[roughnessId];
+            texture.metallic = table.texturePaths[metallicId];
+            AddDependency(dependencies, texture.roughness);
+            AddDependency(dependencies, texture.metallic);
+
+            TextureId id = INVALID_TEXTURE;
+            std::error_code error;
+            if (fs::is_regular_file(texture.roughness, error) && fs::is_regular_file(texture.metallic, error)) {
+                const std::string name = std::string(Text::StemOf(texture.roughness)) + "_" +
+                                         std::string(Text::StemOf(texture.metallic)) + "_orm" + extension;
+                texture.output = NormalizePath(outputDirectory, "orm/" + name);
+                id = static_cast<TextureId>(table.texturePaths.size());
+                table.texturePaths.push_back(texture.output);
+                textures.push_back(std::move(texture));
+            }
+            found = packed.emplace(key, id).first;
+        }
+
+        if (found->second != INVALID_TEXTURE) {
+            material.Texture(MaterialSlot::Orm) = found->second;
+            material.Texture(MaterialSlot::Roughness) = INVALID_TEXTURE;
+            material.Texture(MaterialSlot::Metallic) = INVALID_TEXTURE;
+        }
+    }
+
+    RemoveUnreferencedTextures(table);
+}
+
+bool Cook::LoadOrmImage(const OrmTexture &texture, Image &orm)
+{
+    Image roughness;
+    Image metallic;
+    if (!Tga::LoadFile(texture.roughness.c_str(), roughness) || !Tga::LoadFile(texture.metallic.c_str(), metallic)) {
+        return false;
+    }
+    PackOrm(roughness, metallic, orm);
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <ResourceManager/ResourceType.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Cook
+{
+    // A packed ORM texture a material library needs: the cooked output its
+    // materials reference and the two maps it is built from.
+    struct OrmTexture
+    {
+        std::string output;
+        std::string roughness;
+        std::string metallic;
+    };
+
+    // Points every material that has both a roughness and a metallic map
+    // (map_Ns and map_Ka in sponza_pbr.mtl) at one ORM texture: occlusion in
+    // R (white, the set has no AO maps), roughness in G, metallic in B.
+    //
+    // Nothing is decoded here. The textures to build are appended to
+    // textures, and the cooker cooks each of them once, after the libraries,
+    // like any other texture; see Cooker::Run. Materials sharing a pair
+    // share the texture. Packed materials reference it through
+    // MaterialSlot::Orm and drop the two single channel slots; textures
+    // nothing references anymore are removed from the table. Outputs go to
+    // outputDirectory/orm with the given extension, .ctex or .cvt. A pair
+    // with a missing map is left unpacked, both paths go to dependencies.
+    void PackOrmTextures(Resources::CPU::MaterialTable &table, const std::string &outputDirectory,
+                         const char *extension, std::vector<OrmTexture> &textures,
+                         std::vector<std::string> &dependencies);
+
+    // Decodes both maps of texture and packs them into one RGBA8 image.
+    bool LoadOrmImage(const OrmTexture &texture, Resources::CPU::Image &orm);
+}
@@ -0,0 +1,70 @@
+#include "TextureDedup.hpp"
+#include "CookUtil.hpp"
+
+#include <ResourceManager/BlockCompressor.hpp>
+#include <ResourceManager/MaterialCompiler.hpp>
+#include <ResourceManager/MipGenerator.hpp>
+#include <ResourceManager/TextScan.hpp>
+
+#include <algorithm>
+
+using namespace Cook;
+using namespace Resources::CPU;
+
+namespace
+{
+    // Everything buildTextureLevels derives from the role, hashed into the seed.
+    struct TextureSettings
+    {
+        uint32_t filter;
+        uint32_t srgb;
+        uint32_t preserveAlphaCoverage;
+        float alphaCutoff;
+        uint32_t blockFormat;
+    };
+}
+
+Hash128 Cook::FingerprintImage(const Image &image, std::string_view role)
+{
+    const MipOptions mipOptions = MipOptionsForTexture(role);
+    const TextureSettings settings{static_cast<uint32_t>(mipOptions.filter), mipOptions.srgb ? 1u : 0u,
+                                   mipOptions.preserveAlphaCoverage ? 1u : 0u,
+                                   mipOptions.preserveAlphaCoverage ? mipOptions.alphaCutoff : 0.0f,
+                                   static_cast<uint32_t>(Bc::FormatForTexture(role, image.format))};
+
+    // TGA sizes are 16 bits each, so the seed keeps them and the format apart.
+    const uint64_t seed = ((uint64_t(image.width) << 32) | (uint64_t(image.height) << 8) | uint64_t(image.format)) ^
+                          HashBytes(&settings, sizeof(settings)).low;
+    const size_t size = std::min(image.pixels.Size, image.RowPitch() * image.height);
+    return HashBytes(image.pixels.Data.get(), size, seed);
+}
+
+void Cook::ApplyTextureAliases(MaterialTable &table, const TextureAliases &aliases,
+                               std::vector<std::string> &dependencies)
+{
+    if (aliases.empty()) {
+        return;
+    }
+
+    std::unordered_map<std::string, TextureId> ids;
+    std::vector<TextureId> remap(table.texturePaths.size(), INVALID_TEXTURE);
+    for (size_t i = 0; i < table.texturePaths.size(); ++i) {
+        std::string &path = table.texturePaths[i];
+        auto alias = aliases.find(Text::ToLower(path));
+        if (alias != aliases.end()) {
+            AddDependency(dependencies, path);
+            AddDependency(dependencies, alias->second);
+            path = alias->second;
+        }
+        // The first id naming a file keeps it, later ones become references to it.
+        remap[i] = ids.emplace(Text::ToLower(path), static_cast<TextureId>(i)).first->second;
+    }
+    for (Material &material : table.materials) {
+        for (TextureId &texture : material.textures) {
+            if (texture != INVALID_TEXTURE && texture < remap.size()) {
+                texture = remap[texture];
+            }
+        }
+    }
+    RemoveUnreferencedTextures(table);
+}
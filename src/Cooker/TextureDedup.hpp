@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ContentHash.hpp"
+
+#include <ResourceManager/ResourceType.hpp>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Cook
+{
+    // Hash of the decoded image: size, format and every texel, seeded with
+    // the cook settings the name of role picks for it (sRGB, alpha coverage,
+    // mip filter, block format). Sources that differ only in how they are
+    // stored (RLE, row order, header fields) get the same fingerprint, unlike
+    // with the file hash; the same pixels cooked for different roles do not.
+    Hash128 FingerprintImage(const Resources::CPU::Image &image, std::string_view role);
+
+    // Source paths of textures whose pixels another source already has, case
+    // folded, mapped to that source. Only the canonical source is cooked.
+    using TextureAliases = std::unordered_map<std::string, std::string>;
+
+    // Points material textures at their canonical source and merges the ids
+    // that now name the same file. Every path replaced and its canonical
+    // source are added to dependencies: when either changes, the pair may
+    // stop being duplicates.
+    void ApplyTextureAliases(Resources::CPU::MaterialTable &table, const TextureAliases &aliases,
+                             std::vector<std::string> &dependencies);
+}
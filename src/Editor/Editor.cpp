@@ -1,8 +1,19 @@
 #include "Editor.hpp"
 
+#include <ResourceManager/MaterialCompiler.hpp>
+#include <ResourceManager/TextScan.hpp>
+
+#include <algorithm>
 #include <utility>
 #include <iostream>
 
+using namespace Resources::CPU;
+
+namespace
+{
+    const char *SPONZA_MESH = "cooked/sponza/sponza.cmesh";
+}
+
 Editor::Editor()
 {
 
@@ -18,6 +29,14 @@ bool Editor::Init(Systems systems)
     m_systems = std::move(systems);
     m_systems.dx12->CreateSwapChain();
 
+    // chelson-cook --watch rewrites cooked files as their sources change.
+    m_cookedWatcher.Watch("cooked");
+    m_sponza = m_resources.LoadMesh(SPONZA_MESH, LoadPriority::VisibleNow, [this](LoadState state) {
+        std::cout << "Sponza " << (state == LoadState::Ready ? "loaded" : "failed to load") << std::endl;
+        if (state == LoadState::Ready) {
+            loadMaterialLibraries();
+        }
+    });
 
     return true;
 }
@@ -29,9 +48,95 @@ bool Editor::Finish()
 
 void Editor::Update()
 {
+    m_cookedChanges.clear();
+    m_cookedWatcher.Poll(m_cookedChanges);
+    for (FileWatcher::Event &change : m_cookedChanges) {
+        // Already waiting: the reload still to come picks this change up too.
+        const bool isPending = std::any_of(m_pendingReloads.begin(), m_pendingReloads.end(),
+            [&change](const FileWatcher::Event &pending) { return pending.path == change.path; });
+        if (!isPending) {
+            m_pendingReloads.push_back(std::move(change));
+        }
+    }
+    m_pendingReloads.erase(std::remove_if(m_pendingReloads.begin(), m_pendingReloads.end(),
+        [this](const FileWatcher::Event &change) { return reloadChanged(change); }), m_pendingReloads.end());
+    m_resources.DispatchCompletions();
     std::cout << "Editor::Update" << std::endl;
 }
 
+// Materials come from the .cmat of every library the mesh lists, next to it in the cooked tree.
+void Editor::loadMaterialLibraries()
+{
+    const CookedMesh *mesh = m_resources.Get(m_sponza);
+    if (mesh == nullptr) {
+        return;
+    }
+    for (uint32_t i = 0; i < mesh->MaterialLibraryCount(); ++i) {
+        std::string path = NormalizePath(DirectoryOf(SPONZA_MESH), mesh->MaterialLibrary(i));
+        if (m_materials.count(path) != 0) {
+            continue;
+        }
+        m_materials[path] = m_resources.LoadMaterials(path, LoadPriority::VisibleNow, [this, path](LoadState state) {
+            if (state == LoadState::Ready) {
+                loadTextures(path);
+            }
+        });
+    }
+}
+
+// Loads the textures of a library not loaded yet, e.g. an ORM texture a re-cook added.
+void Editor::loadTextures(const std::string &libraryPath)
+{
+    const CookedMaterials *materials = m_resources.Get(m_materials[libraryPath]);
+    if (materials == nullptr) {
+        return;
+    }
+    for (TextureId texture = 0; texture < materials->TextureCount(); ++texture) {
+        std::string path = NormalizePath(DirectoryOf(libraryPath), materials->TexturePath(texture));
+        // Virtual textures (.cvt) stream tiles on their own, see VirtualTexture.
+        if (!Text::EndsWithNoCase(path, ".ctex") || m_textures.count(path) != 0) {
+            continue;
+        }
+        m_textures[path] = m_resources.LoadTexture(path, LoadPriority::Prefetch);
+    }
+}
+
+// Reloads the one resource a cooked file backs. False while that resource is
+// still loading, the change then waits in m_pendingReloads.
+bool Editor::reloadChanged(const FileWatcher::Event &change)
+{
+    if (change.path == SPONZA_MESH) {
+        return reload(m_sponza, change, [this]() { loadMaterialLibraries(); });
+    }
+    auto materials = m_materials.find(change.path);
+    if (materials != m_materials.end()) {
+        return reload(materials->second, change, [this, path = change.path]() { loadTextures(path); });
+    }
+    auto texture = m_textures.find(change.path);
+    if (texture != m_textures.end()) {
+        return reload(texture->second, change, {});
+    }
+    return true;
+}
+
+template<typename T>
+bool Editor::reload(Handle<T> handle, const FileWatcher::Event &change, std::function<void()> onReady)
+{
+    const auto changedAt = change.time;
+    const bool isQueued = m_resources.Reload(handle, LoadPriority::VisibleNow,
+        [path = change.path, changedAt, onReady = std::move(onReady)](LoadState state) {
+            const auto latency = std::chrono::duration<double, std::milli>(FileWatcher::Clock::now() - changedAt);
+            std::cout << path << " reload " << (state == LoadState::Ready ? "done" : "failed")
+                      << " in " << latency.count() << " ms" << std::endl;
+            if (state == LoadState::Ready && onReady) {
+                onReady();
+            }
+        });
+    // Reload turns a load in flight away; one that was cancelled or released is never coming back.
+    const LoadState state = m_resources.State(handle);
+    return isQueued || state == LoadState::Invalid || state == LoadState::Cancelled;
+}
+
 void Editor::WindowSizeChanged()
 {
     int width, height;
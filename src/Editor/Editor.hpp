@@ -1,6 +1,13 @@
 #pragma once
 
 #include <Common/IApplication.hpp>
+#include <ResourceManager/FileWatcher.hpp>
+#include <ResourceManager/ResourceManager.hpp>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class Editor final: public IApplication
 {
@@ -16,6 +23,22 @@ public:
 private:
     bool createSwapChain();
 
+    void loadMaterialLibraries();
+    void loadTextures(const std::string &libraryPath);
+    bool reloadChanged(const Resources::CPU::FileWatcher::Event &change);
+    template<typename T>
+    bool reload(Resources::CPU::Handle<T> handle, const Resources::CPU::FileWatcher::Event &change,
+                std::function<void()> onReady);
+
 private:
     Systems m_systems;
+    Resources::CPU::ResourceManager m_resources;
+    Resources::CPU::MeshHandle m_sponza;
+    // Keyed by cooked path, as the watcher reports changes.
+    std::unordered_map<std::string, Resources::CPU::MaterialsHandle> m_materials;
+    std::unordered_map<std::string, Resources::CPU::TextureHandle> m_textures;
+    Resources::CPU::FileWatcher m_cookedWatcher;
+    std::vector<Resources::CPU::FileWatcher::Event> m_cookedChanges;
+    // Changes whose resource was still loading, retried every Update until the load is done.
+    std::vector<Resources::CPU::FileWatcher::Event> m_pendingReloads;
 };
\ No newline at end of file
@@ -0,0 +1,754 @@
+#include "BlockCompressor.hpp"
+#include "Parallel.hpp"
+#include "TextScan.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+using namespace Resources::CPU::Bc;
+
+namespace
+{
+    constexpr uint32_t BLOCK_TEXELS = 16;
+    constexpr float FLOAT_MAX = std::numeric_limits<float>::max();
+    const uint32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // 4x4 texels as floats, CHANNELS per texel.
+    template<uint32_t CHANNELS>
+    struct Block
+    {
+        float texels[BLOCK_TEXELS][CHANNELS];
+    };
+
+    template<uint32_t CHANNELS>
+    void loadBlock(const Image &image, uint32_t blockX, uint32_t blockY, Block<CHANNELS> &block)
+    {
+        const uint32_t bytesPerPixel = BytesPerPixel(image.format);
+        const uint8_t *pixels = image.pixels.Data.get();
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            const uint32_t x = std::min(blockX * 4 + (i & 3), image.width - 1);
+            const uint32_t y = std::min(blockY * 4 + (i >> 2), image.height - 1);
+            const uint8_t *texel = pixels + (size_t(y) * image.width + x) * bytesPerPixel;
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                block.texels[i][c] = c < bytesPerPixel ? texel[c] : (c == 3 ? 255.0f : 0.0f);
+            }
+        }
+    }
+
+    template<uint32_t CHANNELS>
+    float squaredDistance(const float *a, const float *b)
+    {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            sum += (a[c] - b[c]) * (a[c] - b[c]);
+        }
+        return sum;
+    }
+
+    // Principal axis by power iteration on the covariance, returns the two
+    // texel projections furthest apart along it as starting endpoints.
+    template<uint32_t CHANNELS>
+    void principalEndpoints(const Block<CHANNELS> &block, float (&low)[CHANNELS], float (&high)[CHANNELS])
+    {
+        float mean[CHANNELS]{};
+        for (const auto &texel : block.texels) {
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                mean[c] += texel[c] / BLOCK_TEXELS;
+            }
+        }
+        float covariance[CHANNELS][CHANNELS]{};
+        for (const auto &texel : block.texels) {
+            for (uint32_t a = 0; a < CHANNELS; ++a) {
+                for (uint32_t b = 0; b < CHANNELS; ++b) {
+                    covariance[a][b] += (texel[a] - mean[a]) * (texel[b] - mean[b]);
+                }
+            }
+        }
+
+        float axis[CHANNELS];
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            axis[c] = 1.0f;
+        }
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[CHANNELS]{};
+            float length = 0.0f;
+            for (uint32_t a = 0; a < CHANNELS; ++a) {
+                for (uint32_t b = 0; b < CHANNELS; ++b) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length == 0.0f) {
+                break;
+            }
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float minimum = FLOAT_MAX;
+        float maximum = -FLOAT_MAX;
+        for (const auto &texel : block.texels) {
+            float projection = 0.0f;
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                projection += (texel[c] - mean[c]) * axis[c];
+            }
+            minimum = std::min(minimum, projection);
+            maximum = std::max(maximum, projection);
+        }
+        float axisLength = 0.0f;
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            axisLength += axis[c] * axis[c];
+        }
+        axisLength = axisLength > 0.0f ? axisLength : 1.0f;
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            low[c] = std::clamp(mean[c] + axis[c] * minimum / axisLength, 0.0f, 255.0f);
+            high[c] = std::clamp(mean[c] + axis[c] * maximum / axisLength, 0.0f, 255.0f);
+        }
+    }
+
+    // Endpoints minimizing the squared error for fixed interpolation weights
+    // (weight of the high endpoint per texel). False when the weights are
+    // all the same and the system is singular.
+    template<uint32_t CHANNELS>
+    bool leastSquares(const Block<CHANNELS> &block, const float *weights, float (&low)[CHANNELS],
+                      float (&high)[CHANNELS])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[CHANNELS]{};
+        float bx[CHANNELS]{};
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            const float b = weights[i];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                ax[c] += a * block.texels[i][c];
+                bx[c] += b * block.texels[i][c];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) {
+            return false;
+        }
+        for (uint32_t c = 0; c < CHANNELS; ++c) {
+            low[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+            high[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    template<uint32_t CHANNELS, uint32_t ENTRIES>
+    float assignIndices(const Block<CHANNELS> &block, const float (&palette)[ENTRIES][CHANNELS], uint8_t *indices)
+    {
+        float error = 0.0f;
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            float best = FLOAT_MAX;
+            for (uint32_t e = 0; e < ENTRIES; ++e) {
+                const float distance = squaredDistance<CHANNELS>(block.texels[i], palette[e]);
+                if (distance < best) {
+                    best = distance;
+                    indices[i] = static_cast<uint8_t>(e);
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    int iterationsFor(Quality quality)
+    {
+        return quality == Quality::Fast ? 0 : quality == Quality::Normal ? 2 : 6;
+    }
+
+    uint16_t packRgb565(const float (&color)[3])
+    {
+        const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void unpackRgb565(uint16_t packed, float (&color)[3])
+    {
+        const uint32_t r = (packed >> 11) & 31;
+        const uint32_t g = (packed >> 5) & 63;
+        const uint32_t b = packed & 31;
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    // Four color mode palette in the order the indices use.
+    void bc1Palette(uint16_t color0, uint16_t color1, float (&palette)[4][3])
+    {
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (uint32_t c = 0; c < 3; ++c) {
+            palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+            palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+        }
+    }
+
+    // Orders the endpoints for four color mode and returns the error.
+    float evaluateBc1(const Block<3> &block, uint16_t &color0, uint16_t &color1, uint8_t *indices)
+    {
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+        if (color0 == color1) {
+            float color[3];
+            unpackRgb565(color0, color);
+            float error = 0.0f;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                indices[i] = 0;
+                error += squaredDistance<3>(block.texels[i], color);
+            }
+            return error;
+        }
+        float palette[4][3];
+        bc1Palette(color0, color1, palette);
+        return assignIndices(block, palette, indices);
+    }
+
+    void encodeBc1(const Block<3> &block, Quality quality, uint8_t *output)
+    {
+        const float WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float low[3], high[3];
+        principalEndpoints(block, low, high);
+
+        uint16_t best0 = packRgb565(high);
+        uint16_t best1 = packRgb565(low);
+        uint8_t bestIndices[BLOCK_TEXELS];
+        float bestError = evaluateBc1(block, best0, best1, bestIndices);
+
+        for (int iteration = 0; iteration < iterationsFor(quality); ++iteration) {
+            float weights[BLOCK_TEXELS];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                weights[i] = WEIGHTS[bestIndices[i]];
+            }
+            float first[3], second[3];
+            if (!leastSquares(block, weights, first, second)) {
+                break;
+            }
+            uint16_t color0 = packRgb565(first);
+            uint16_t color1 = packRgb565(second);
+            uint8_t indices[BLOCK_TEXELS];
+            const float error = evaluateBc1(block, color0, color1, indices);
+            if (error >= bestError) {
+                break;
+            }
+            bestError = error;
+            best0 = color0;
+            best1 = color1;
+            std::memcpy(bestIndices, indices, BLOCK_TEXELS);
+        }
+
+        // Walk each 565 channel of each endpoint one step at a time while it helps.
+        if (quality == Quality::High) {
+            const uint16_t FIELDS[3][2] = {{11, 31}, {5, 63}, {0, 31}};
+            for (bool improved = true; improved;) {
+                improved = false;
+                for (int endpoint = 0; endpoint < 2; ++endpoint) {
+                    for (const auto &field : FIELDS) {
+                        for (int delta : {-1, 1}) {
+                            uint16_t color0 = best0;
+                            uint16_t color1 = best1;
+                            uint16_t &color = endpoint == 0 ? color0 : color1;
+                            const int value = ((color >> field[0]) & field[1]) + delta;
+                            if (value < 0 || value > field[1]) {
+                                continue;
+                            }
+                            color = static_cast<uint16_t>((color & ~(field[1] << field[0])) | (value << field[0]));
+                            uint8_t indices[BLOCK_TEXELS];
+                            const float error = evaluateBc1(block, color0, color1, indices);
+                            if (error < bestError) {
+                                bestError = error;
+                                best0 = color0;
+                                best1 = color1;
+                                std::memcpy(bestIndices, indices, BLOCK_TEXELS);
+                                improved = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            bits |= uint32_t(bestIndices[i]) << (i * 2);
+        }
+        std::memcpy(output, &best0, 2);
+        std::memcpy(output + 2, &best1, 2);
+        std::memcpy(output + 4, &bits, 4);
+    }
+
+    void bc4Palette(uint32_t endpoint0, uint32_t endpoint1, float (&palette)[8][1])
+    {
+        palette[0][0] = static_cast<float>(endpoint0);
+        palette[1][0] = static_cast<float>(endpoint1);
+        if (endpoint0 > endpoint1) {
+            for (uint32_t i = 1; i < 7; ++i) {
+                palette[i + 1][0] = static_cast<float>(((7 - i) * endpoint0 + i * endpoint1 + 3) / 7);
+            }
+        } else {
+            for (uint32_t i = 1; i < 5; ++i) {
+                palette[i + 1][0] = static_cast<float>(((5 - i) * endpoint0 + i * endpoint1 + 2) / 5);
+            }
+            palette[6][0] = 0.0f;
+            palette[7][0] = 255.0f;
+        }
+    }
+
+    float evaluateBc4(const Block<1> &block, uint32_t endpoint0, uint32_t endpoint1, uint8_t *indices)
+    {
+        float palette[8][1];
+        bc4Palette(endpoint0, endpoint1, palette);
+        return assignIndices(block, palette, indices);
+    }
+
+    void encodeBc4(const Block<1> &block, Quality quality, uint8_t *output)
+    {
+        float minimum = 255.0f;
+        float maximum = 0.0f;
+        float innerMinimum = 255.0f;
+        float innerMaximum = 0.0f;
+        for (const auto &texel : block.texels) {
+            minimum = std::min(minimum, texel[0]);
+            maximum = std::max(maximum, texel[0]);
+            if (texel[0] > 0.0f && texel[0] < 255.0f) {
+                innerMinimum = std::min(innerMinimum, texel[0]);
+                innerMaximum = std::max(innerMaximum, texel[0]);
+            }
+        }
+
+        uint32_t best0 = static_cast<uint32_t>(maximum);
+        uint32_t best1 = static_cast<uint32_t>(minimum);
+        uint8_t bestIndices[BLOCK_TEXELS];
+        float bestError = evaluateBc4(block, best0, best1, bestIndices);
+        auto consider = [&](int endpoint0, int endpoint1) {
+            if (endpoint0 < 0 || endpoint0 > 255 || endpoint1 < 0 || endpoint1 > 255) {
+                return;
+            }
+            uint8_t indices[BLOCK_TEXELS];
+            const float error = evaluateBc4(block, endpoint0, endpoint1, indices);
+            if (error < bestError) {
+                bestError = error;
+                best0 = endpoint0;
+                best1 = endpoint1;
+                std::memcpy(bestIndices, indices, BLOCK_TEXELS);
+            }
+        };
+
+        const float WEIGHTS[8] = {0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7};
+        for (int iteration = 0; iteration < iterationsFor(quality) && best0 > best1; ++iteration) {
+            float weights[BLOCK_TEXELS];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                weights[i] = WEIGHTS[bestIndices[i]];
+            }
+            float first[1], second[1];
+            if (!leastSquares(block, weights, first, second)) {
+                break;
+            }
+            const float previous = bestError;
+            consider(static_cast<int>(first[0] + 0.5f), static_cast<int>(second[0] + 0.5f));
+            if (bestError >= previous) {
+                break;
+            }
+        }
+
+        if (quality == Quality::High) {
+            // Six value mode keeps exact 0 and 255 for blocks that mix them with other values.
+            if (innerMinimum <= innerMaximum) {
+                consider(static_cast<int>(innerMinimum), static_cast<int>(innerMaximum));
+            }
+            const int center0 = static_cast<int>(best0);
+            const int center1 = static_cast<int>(best1);
+            for (int delta0 = -2; delta0 <= 2; ++delta0) {
+                for (int delta1 = -2; delta1 <= 2; ++delta1) {
+                    if (center0 + delta0 > center1 + delta1) {
+                        consider(center0 + delta0, center1 + delta1);
+                    }
+                }
+            }
+        }
+
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            bits |= uint64_t(bestIndices[i]) << (i * 3);
+        }
+        output[0] = static_cast<uint8_t>(best0);
+        output[1] = static_cast<uint8_t>(best1);
+        for (uint32_t i = 0; i < 6; ++i) {
+            output[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    struct Bc7Endpoints
+    {
+        uint32_t values[2][4];  // 7-bit
+        uint32_t pBits[2];
+    };
+
+    // Quantizes one endpoint to 7 bits per channel plus its shared p-bit.
+    void quantizeBc7(const float (&endpoint)[4], uint32_t pBit, uint32_t (&values)[4])
+    {
+        for (uint32_t c = 0; c < 4; ++c) {
+            values[c] = static_cast<uint32_t>(std::clamp((endpoint[c] - pBit) / 2.0f + 0.5f, 0.0f, 127.0f));
+        }
+    }
+
+    void bc7Palette(const Bc7Endpoints &endpoints, float (&palette)[16][4])
+    {
+        for (uint32_t c = 0; c < 4; ++c) {
+            const uint32_t low = (endpoints.values[0][c] << 1) | endpoints.pBits[0];
+            const uint32_t high = (endpoints.values[1][c] << 1) | endpoints.pBits[1];
+            for (uint32_t i = 0; i < 16; ++i) {
+                palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * low + BC7_WEIGHTS[i] * high + 32) >> 6);
+            }
+        }
+    }
+
+    float evaluateBc7(const Block<4> &block, const Bc7Endpoints &endpoints, uint8_t *indices)
+    {
+        float palette[16][4];
+        bc7Palette(endpoints, palette);
+        return assignIndices(block, palette, indices);
+    }
+
+    // Tries the p-bits: each endpoint on its own, or all four pairs for High.
+    float fitBc7(const Block<4> &block, const float (&low)[4], const float (&high)[4], Quality quality,
+                 Bc7Endpoints &endpoints, uint8_t *indices)
+    {
+        if (quality != Quality::High) {
+            for (uint32_t e = 0; e < 2; ++e) {
+                const float(&endpoint)[4] = e == 0 ? low : high;
+                float bestError = FLOAT_MAX;
+                for (uint32_t pBit = 0; pBit < 2; ++pBit) {
+                    uint32_t values[4];
+                    quantizeBc7(endpoint, pBit, values);
+                    float error = 0.0f;
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        const float value = static_cast<float>((values[c] << 1) | pBit);
+                        error += (value - endpoint[c]) * (value - endpoint[c]);
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        endpoints.pBits[e] = pBit;
+                        std::memcpy(endpoints.values[e], values, sizeof(values));
+                    }
+                }
+            }
+            return evaluateBc7(block, endpoints, indices);
+        }
+
+        float bestError = FLOAT_MAX;
+        for (uint32_t pBits = 0; pBits < 4; ++pBits) {
+            Bc7Endpoints candidate;
+            candidate.pBits[0] = pBits & 1;
+            candidate.pBits[1] = pBits >> 1;
+            quantizeBc7(low, candidate.pBits[0], candidate.values[0]);
+            quantizeBc7(high, candidate.pBits[1], candidate.values[1]);
+            uint8_t candidateIndices[BLOCK_TEXELS];
+            const float error = evaluateBc7(block, candidate, candidateIndices);
+            if (error < bestError) {
+                bestError = error;
+                endpoints = candidate;
+                std::memcpy(indices, candidateIndices, BLOCK_TEXELS);
+            }
+        }
+        return bestError;
+    }
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t *output)
+            : m_output{output}
+        {
+            std::memset(m_output, 0, 16);
+        }
+
+        void Write(uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; ++i, ++m_position) {
+                m_output[m_position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (m_position & 7));
+            }
+        }
+
+    private:
+        uint8_t *m_output;
+        uint32_t m_position{0};
+    };
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const uint8_t *input)
+            : m_input{input}
+        {
+        }
+
+        uint32_t Read(uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; ++i, ++m_position) {
+                value |= uint32_t((m_input[m_position >> 3] >> (m_position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t *m_input;
+        uint32_t m_position{0};
+    };
+
+    void encodeBc7(const Block<4> &block, Quality quality, uint8_t *output)
+    {
+        float low[4], high[4];
+        principalEndpoints(block, low, high);
+
+        Bc7Endpoints best;
+        uint8_t bestIndices[BLOCK_TEXELS];
+        float bestError = fitBc7(block, low, high, quality, best, bestIndices);
+        for (int iteration = 0; iteration < iterationsFor(quality); ++iteration) {
+            float weights[BLOCK_TEXELS];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                weights[i] = BC7_WEIGHTS[bestIndices[i]] / 64.0f;
+            }
+            if (!leastSquares(block, weights, low, high)) {
+                break;
+            }
+            Bc7Endpoints endpoints;
+            uint8_t indices[BLOCK_TEXELS];
+            const float error = fitBc7(block, low, high, quality, endpoints, indices);
+            if (error >= bestError) {
+                break;
+            }
+            bestError = error;
+            best = endpoints;
+            std::memcpy(bestIndices, indices, BLOCK_TEXELS);
+        }
+
+        // The first index drops its top bit, so it has to be in the lower half.
+        if (bestIndices[0] >= 8) {
+            std::swap(best.values[0], best.values[1]);
+            std::swap(best.pBits[0], best.pBits[1]);
+            for (uint8_t &index : bestIndices) {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        BitWriter writer{output};
+        writer.Write(1u << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c) {
+            writer.Write(best.values[0][c], 7);
+            writer.Write(best.values[1][c], 7);
+        }
+        writer.Write(best.pBits[0], 1);
+        writer.Write(best.pBits[1], 1);
+        writer.Write(bestIndices[0], 3);
+        for (uint32_t i = 1; i < BLOCK_TEXELS; ++i) {
+            writer.Write(bestIndices[i], 4);
+        }
+    }
+
+    void decodeBc1(const uint8_t *input, uint8_t (&texels)[BLOCK_TEXELS][4])
+    {
+        uint16_t color0, color1;
+        uint32_t bits;
+        std::memcpy(&color0, input, 2);
+        std::memcpy(&color1, input + 2, 2);
+        std::memcpy(&bits, input + 4, 4);
+        float palette[4][3];
+        bc1Palette(color0, color1, palette);
+        float alpha[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+        if (color0 <= color1) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+                palette[3][c] = 0.0f;
+            }
+            alpha[3] = 0.0f;
+        }
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            const uint32_t index = (bits >> (i * 2)) & 3;
+            for (uint32_t c = 0; c < 3; ++c) {
+                texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+            }
+            texels[i][3] = static_cast<uint8_t>(alpha[index]);
+        }
+    }
+
+    void decodeBc4(const uint8_t *input, uint8_t *values, uint32_t stride)
+    {
+        float palette[8][1];
+        bc4Palette(input[0], input[1], palette);
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; ++i) {
+            bits |= uint64_t(input[2 + i]) << (i * 8);
+        }
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            values[i * stride] = static_cast<uint8_t>(palette[(bits >> (i * 3)) & 7][0]);
+        }
+    }
+
+    bool decodeBc7(const uint8_t *input, uint8_t (&texels)[BLOCK_TEXELS][4])
+    {
+        BitReader reader{input};
+        if (reader.Read(7) != (1u << 6)) {
+            return false;
+        }
+        Bc7Endpoints endpoints;
+        for (uint32_t c = 0; c < 4; ++c) {
+            endpoints.values[0][c] = reader.Read(7);
+            endpoints.values[1][c] = reader.Read(7);
+        }
+        endpoints.pBits[0] = reader.Read(1);
+        endpoints.pBits[1] = reader.Read(1);
+        float palette[16][4];
+        bc7Palette(endpoints, palette);
+        for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+            const uint32_t index = reader.Read(i == 0 ? 3 : 4);
+            for (uint32_t c = 0; c < 4; ++c) {
+                texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+            }
+        }
+        return true;
+    }
+}
+
+uint32_t Resources::CPU::Bc::BlockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t Resources::CPU::Bc::CompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+{
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+const char *Resources::CPU::Bc::FormatName(BlockFormat format)
+{
+    switch (format) {
+    case BlockFormat::BC1: return "BC1";
+    case BlockFormat::BC4: return "BC4";
+    case BlockFormat::BC5: return "BC5";
+    case BlockFormat::BC7: return "BC7";
+    }
+    return "unknown";
+}
+
+BlockFormat Resources::CPU::Bc::FormatForTexture(std::string_view path, PixelFormat pixels, bool fastColor)
+{
+    const std::string_view name = Text::StemOf(path);
+    auto endsWith = [name](std::string_view suffix) { return Text::EndsWithNoCase(name, suffix); };
+
+    if (endsWith("_normal") || endsWith("_ddn")) {
+        return BlockFormat::BC5;
+    }
+    if (pixels == PixelFormat::R8 || endsWith("_roughness") || endsWith("_metallic") ||
+        endsWith("_mask")) {
+        return BlockFormat::BC4;
+    }
+    return fastColor ? BlockFormat::BC1 : BlockFormat::BC7;
+}
+
+bool Resources::CPU::Bc::Compress(const Image &image, const CompressOptions &options, RawData &blocks)
+{
+    if (image.width == 0 || image.height == 0 || image.pixels.Size != image.RowPitch() * image.height) {
+        return false;
+    }
+
+    const uint32_t blocksX = (image.width + 3) / 4;
+    const uint32_t blocksY = (image.height + 3) / 4;
+    const uint32_t blockBytes = BlockBytes(options.format);
+    blocks.Allocate(CompressedSize(options.format, image.width, image.height));
+
+    ParallelFor(blocksY, ResolveThreads(options.threadCount), [&](size_t blockY) {
+        uint8_t *output = blocks.Data.get() + blockY * blocksX * blockBytes;
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX, output += blockBytes) {
+            switch (options.format) {
+            case BlockFormat::BC1: {
+                Block<3> block;
+                loadBlock(image, blockX, static_cast<uint32_t>(blockY), block);
+                encodeBc1(block, options.quality, output);
+                break;
+            }
+            case BlockFormat::BC4: {
+                Block<1> block;
+                loadBlock(image, blockX, static_cast<uint32_t>(blockY), block);
+                encodeBc4(block, options.quality, output);
+                break;
+            }
+            case BlockFormat::BC5: {
+                Block<2> block;
+                loadBlock(image, blockX, static_cast<uint32_t>(blockY), block);
+                Block<1> channel;
+                for (uint32_t c = 0; c < 2; ++c) {
+                    for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                        channel.texels[i][0] = block.texels[i][c];
+                    }
+                    encodeBc4(channel, options.quality, output + c * 8);
+                }
+                break;
+            }
+            case BlockFormat::BC7: {
+                Block<4> block;
+                loadBlock(image, blockX, static_cast<uint32_t>(blockY), block);
+                encodeBc7(block, options.quality, output);
+                break;
+            }
+            }
+        }
+    });
+    return true;
+}
+
+bool Resources::CPU::Bc::Decompress(BlockFormat format, const uint8_t *blocks, uint32_t width, uint32_t height,
+                                    Image &image)
+{
+    image.width = width;
+    image.height = height;
+    image.format = format == BlockFormat::BC4 ? PixelFormat::R8 : PixelFormat::RGBA8;
+    image.pixels.Allocate(image.RowPitch() * height);
+
+    const uint32_t bytesPerPixel = BytesPerPixel(image.format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX, blocks += BlockBytes(format)) {
+            uint8_t texels[BLOCK_TEXELS][4]{};
+            switch (format) {
+            case BlockFormat::BC1: decodeBc1(blocks, texels); break;
+            case BlockFormat::BC4: decodeBc4(blocks, &texels[0][0], 4); break;
+            case BlockFormat::BC5:
+                decodeBc4(blocks, &texels[0][0], 4);
+                decodeBc4(blocks + 8, &texels[0][1], 4);
+                for (auto &texel : texels) {
+                    texel[3] = 255;
+                }
+                break;
+            case BlockFormat::BC7:
+                if (!decodeBc7(blocks, texels)) {
+                    return false;
+                }
+                break;
+            }
+            for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+                const uint32_t x = blockX * 4 + (i & 3);
+                const uint32_t y = blockY * 4 + (i >> 2);
+                if (x < width && y < height) {
+                    std::memcpy(image.pixels.Data.get() + (size_t(y) * width + x) * bytesPerPixel, texels[i],
+                                bytesPerPixel);
+                }
+            }
+        }
+    }
+    return true;
+}
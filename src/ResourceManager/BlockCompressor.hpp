@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+// CPU encoders for the block compressed formats the renderer samples from.
+// Every format works on 4x4 texel blocks; blocks on the right and bottom
+// edges of sizes that are not a multiple of four repeat their last texel.
+namespace Resources::CPU::Bc
+{
+    enum class BlockFormat : uint32_t
+    {
+        BC1,  // RGB, 4 bpp, fast path for color
+        BC4,  // one channel, 4 bpp: roughness, metallic, masks
+        BC5,  // two channels, 8 bpp: tangent space normal XY
+        BC7   // RGBA, 8 bpp, color (mode 6 only, see Compress)
+    };
+
+    // Trades encode time against quality. Fast takes the principal axis
+    // extremes as endpoints, Normal refits them by least squares, High also
+    // searches the neighbouring quantized endpoints.
+    enum class Quality : uint32_t
+    {
+        Fast,
+        Normal,
+        High
+    };
+
+    struct CompressOptions
+    {
+        BlockFormat format{BlockFormat::BC7};
+        Quality quality{Quality::Normal};
+        // Block rows are spread over this many threads, 0 picks the hardware concurrency.
+        unsigned threadCount{0};
+    };
+
+    uint32_t BlockBytes(BlockFormat format);
+    size_t CompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+    const char *FormatName(BlockFormat format);
+
+    // Format by texture role: *_normal is BC5, roughness, metallic, masks and
+    // any R8 image are BC4, everything else is color and goes to BC7, or to
+    // BC1 when fastColor is set.
+    BlockFormat FormatForTexture(std::string_view path, PixelFormat pixels, bool fastColor = false);
+
+    // BC4 reads the first channel, BC5 the first two. BC7 always emits mode 6
+    // (one subset, 7-bit RGBA endpoints with p-bits, 4-bit indices).
+    bool Compress(const Image &image, const CompressOptions &options, RawData &blocks);
+
+    // Expands blocks back into an image: BC4 to R8, the others to RGBA8 with
+    // B = 0 and A = 255 for BC5. Only BC7 mode 6 blocks are understood.
+    bool Decompress(BlockFormat format, const uint8_t *blocks, uint32_t width, uint32_t height, Image &image);
+}
@@ -0,0 +1,46 @@
+#include "ChannelPacker.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Byte offset of the nearest source texel for every destination column.
+    std::vector<size_t> columnOffsets(const Image &image, uint32_t width)
+    {
+        std::vector<size_t> offsets(width);
+        const size_t stride = BytesPerPixel(image.format);
+        for (uint32_t x = 0; x < width; ++x) {
+            offsets[x] = size_t(x) * image.width / width * stride;
+        }
+        return offsets;
+    }
+}
+
+void Resources::CPU::PackOrm(const Image &roughness, const Image &metallic, Image &orm)
+{
+    orm.width = std::max(roughness.width, metallic.width);
+    orm.height = std::max(roughness.height, metallic.height);
+    orm.format = PixelFormat::RGBA8;
+    orm.pixels.Allocate(orm.RowPitch() * orm.height);
+
+    // The divisions of the nearest texel lookup only depend on the column or
+    // the row, so they are done once per column and row, not per texel.
+    const std::vector<size_t> roughnessColumns = columnOffsets(roughness, orm.width);
+    const std::vector<size_t> metallicColumns = columnOffsets(metallic, orm.width);
+    uint8_t *texel = orm.pixels.Data.get();
+    for (uint32_t y = 0; y < orm.height; ++y) {
+        const uint8_t *roughnessRow =
+            roughness.pixels.Data.get() + size_t(y) * roughness.height / orm.height * roughness.RowPitch();
+        const uint8_t *metallicRow =
+            metallic.pixels.Data.get() + size_t(y) * metallic.height / orm.height * metallic.RowPitch();
+        for (uint32_t x = 0; x < orm.width; ++x, texel += 4) {
+            texel[0] = 255;
+            texel[1] = roughnessRow[roughnessColumns[x]];
+            texel[2] = metallicRow[metallicColumns[x]];
+            texel[3] = 255;
+        }
+    }
+}
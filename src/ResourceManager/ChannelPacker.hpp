@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+namespace Resources::CPU
+{
+    // Builds an RGBA8 ORM texture: occlusion in R (white), roughness in G
+    // and metallic in B from the first channel of each map, alpha 255. The
+    // result has the larger of the two sizes; the smaller map is sampled by
+    // nearest texel, so a small constant map stretches over a full size one.
+    void PackOrm(const Image &roughness, const Image &metallic, Image &orm);
+}
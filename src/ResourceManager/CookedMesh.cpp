@@ -0,0 +1,496 @@
+#include "CookedMesh.hpp"
+
+#include "MappedFile.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // .cmesh and .cmat alike: a header with a section table, then the sections.
+    template<typename HeaderType, typename SectionKind>
+    class SectionWriter
+    {
+    public:
+        SectionWriter() { m_bytes.resize(sizeof(HeaderType)); }
+
+        HeaderType &Header() { return *reinterpret_cast<HeaderType *>(m_bytes.data()); }
+
+        // Starts the section on the next aligned offset and returns where its data goes.
+        uint8_t *Begin(SectionKind kind, size_t size)
+        {
+            const size_t offset = (m_bytes.size() + COOKED_SECTION_ALIGNMENT - 1) & ~(COOKED_SECTION_ALIGNMENT - 1);
+            m_bytes.resize(offset + size);
+            CookedSection &section = Header().sections[static_cast<size_t>(kind)];
+            section.offset = offset;
+            section.size = size;
+            return m_bytes.data() + offset;
+        }
+
+        template<typename T>
+        T *Begin(SectionKind kind, size_t count)
+        {
+            return reinterpret_cast<T *>(Begin(kind, count * sizeof(T)));
+        }
+
+        const std::vector<uint8_t> &Bytes() const { return m_bytes; }
+
+    private:
+        std::vector<uint8_t> m_bytes;
+    };
+
+    CookedString addString(std::string &strings, std::string_view value)
+    {
+        CookedString result;
+        result.offset = static_cast<uint32_t>(strings.size());
+        result.length = static_cast<uint32_t>(value.size());
+        strings.append(value);
+        return result;
+    }
+
+    template<typename SectionKind, typename Writer>
+    void writeStrings(Writer &writer, SectionKind kind, const std::vector<std::string> &values, size_t count,
+                      std::string &strings)
+    {
+        CookedString *out = writer.template Begin<CookedString>(kind, count);
+        for (size_t i = 0; i < count; ++i) {
+            const CookedString value = addString(strings, i < values.size() ? std::string_view(values[i]) : std::string_view());
+            std::memcpy(&out[i], &value, sizeof(CookedString));
+        }
+    }
+
+    // Section offsets and sizes must lie in the file and stay aligned.
+    bool sectionsFit(const CookedSection *sections, size_t count, uint64_t fileSize)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const CookedSection &section = sections[i];
+            if (section.size == 0) {
+                continue;
+            }
+            if (section.offset % COOKED_SECTION_ALIGNMENT != 0 || section.offset > fileSize ||
+                section.size > fileSize - section.offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool Resources::CPU::WriteCookedMesh(const char *path, const SponzaShape &sponza,
+                                     const std::vector<std::string> &materialLibraries)
+{
+    if (sponza.shapes.empty()) {
+        return false;
+    }
+
+    VertexLayout layout = sponza.shapes.front().layout;
+    uint64_t vertexCount = 0;
+    uint64_t indexCount = 0;
+    uint64_t lodIndexCount = 0;
+    uint64_t meshletCount = 0;
+    uint64_t meshletVertexCount = 0;
+    uint64_t meshletTriangleCount = 0;
+    for (const SponzaShape::Shape &shape : sponza.shapes) {
+        if (shape.layout.streamCount == 0 || std::memcmp(&shape.layout, &layout, sizeof(VertexLayout)) != 0 ||
+            shape.meshletBounds.size() != shape.meshlets.size() || shape.lods.size() >= MAX_MESH_LODS) {
+            return false;
+        }
+        vertexCount += shape.vertexCount;
+        indexCount += shape.indicies.size();
+        for (const MeshLod &lod : shape.lods) {
+            lodIndexCount += lod.indices.size();
+        }
+        meshletCount += shape.meshlets.size();
+        meshletVertexCount += shape.meshletVertices.size();
+        meshletTriangleCount += shape.meshletTriangles.size();
+    }
+    if (vertexCount > UINT32_MAX || indexCount + lodIndexCount > UINT32_MAX || meshletVertexCount > UINT32_MAX ||
+        meshletTriangleCount > UINT32_MAX) {
+        return false;
+    }
+
+    const MaterialTable &materials = sponza.materials;
+    const uint32_t submeshCount = static_cast<uint32_t>(sponza.shapes.size());
+    const uint32_t materialCount = static_cast<uint32_t>(materials.materials.size());
+    const uint32_t libraryCount = static_cast<uint32_t>(materialLibraries.size());
+
+    SectionWriter<CookedMeshHeader, MeshSection> writer;
+    std::memcpy(writer.Begin(MeshSection::Layout, sizeof(VertexLayout)), &layout, sizeof(VertexLayout));
+
+    std::string strings;
+    CookedSubmesh *submeshes = writer.Begin<CookedSubmesh>(MeshSection::Submeshes, submeshCount);
+    uint32_t firstVertex = 0;
+    uint32_t firstIndex = 0;
+    uint32_t firstLodIndex = static_cast<uint32_t>(indexCount);
+    uint32_t firstMeshlet = 0;
+    for (uint32_t i = 0; i < submeshCount; ++i) {
+        const SponzaShape::Shape &shape = sponza.shapes[i];
+        CookedSubmesh submesh;
+        submesh.firstVertex = firstVertex;
+        submesh.vertexCount = shape.vertexCount;
+        submesh.firstIndex = firstIndex;
+        submesh.indexCount = static_cast<uint32_t>(shape.indicies.size());
+        submesh.material = shape.material;
+        submesh.name = addString(strings, shape.name);
+        submesh.firstMeshlet = firstMeshlet;
+        submesh.meshletCount = static_cast<uint32_t>(shape.meshlets.size());
+        submesh.quantization = shape.quantization;
+        submesh.lodCount = static_cast<uint32_t>(shape.lods.size()) + 1;
+        submesh.lods[0] = CookedLod{submesh.firstIndex, submesh.indexCount, 0.0f};
+        for (size_t l = 0; l < shape.lods.size(); ++l) {
+            const uint32_t count = static_cast<uint32_t>(shape.lods[l].indices.size());
+            submesh.lods[l + 1] = CookedLod{firstLodIndex, count, shape.lods[l].error};
+            firstLodIndex += count;
+        }
+        std::memcpy(&submeshes[i], &submesh, sizeof(CookedSubmesh));
+        firstVertex += submesh.vertexCount;
+        firstIndex += submesh.indexCount;
+        firstMeshlet += submesh.meshletCount;
+    }
+
+    Bounds bounds;
+    Bounds *submeshBounds = writer.Begin<Bounds>(MeshSection::Bounds, submeshCount);
+    for (uint32_t i = 0; i < submeshCount; ++i) {
+        std::memcpy(&submeshBounds[i], &sponza.shapes[i].bounds, sizeof(Bounds));
+        bounds.Extend(sponza.shapes[i].bounds);
+    }
+
+    uint8_t *indices = writer.Begin(MeshSection::Indices, (indexCount + lodIndexCount) * sizeof(uint32_t));
+    for (const SponzaShape::Shape &shape : sponza.shapes) {
+        const size_t bytes = shape.indicies.size() * sizeof(uint32_t);
+        std::memcpy(indices, shape.indicies.data(), bytes);
+        indices += bytes;
+    }
+    for (const SponzaShape::Shape &shape : sponza.shapes) {
+        for (const MeshLod &lod : shape.lods) {
+            const size_t bytes = lod.indices.size() * sizeof(uint32_t);
+            std::memcpy(indices, lod.indices.data(), bytes);
+            indices += bytes;
+        }
+    }
+
+    writeStrings(writer, MeshSection::MaterialNames, materials.materialNames, materialCount, strings);
+    writeStrings(writer, MeshSection::MaterialLibraries, materialLibraries, libraryCount, strings);
+    std::memcpy(writer.Begin(MeshSection::Strings, strings.size()), strings.data(), strings.size());
+
+    for (uint32_t s = 0; s < layout.streamCount; ++s) {
+        uint8_t *stream = writer.Begin(static_cast<MeshSection>(static_cast<uint32_t>(MeshSection::Stream0) + s),
+                                       vertexCount * layout.strides[s]);
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            std::memcpy(stream, shape.streams[s].data(), shape.streams[s].size());
+            stream += shape.streams[s].size();
+        }
+    }
+
+    if (meshletCount > 0) {
+        Meshlet *meshlets = writer.Begin<Meshlet>(MeshSection::Meshlets, meshletCount);
+        uint32_t meshletVertex = 0;
+        uint32_t meshletTriangle = 0;
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            // Shape meshlets count from the shape's own lists, cooked ones from the shared lists.
+            for (Meshlet meshlet : shape.meshlets) {
+                meshlet.firstVertex += meshletVertex;
+                meshlet.firstTriangle += meshletTriangle;
+                std::memcpy(meshlets++, &meshlet, sizeof(Meshlet));
+            }
+            meshletVertex += static_cast<uint32_t>(shape.meshletVertices.size());
+            meshletTriangle += static_cast<uint32_t>(shape.meshletTriangles.size());
+        }
+
+        // Begin may move the buffer, each section is filled before the next one starts.
+        uint8_t *meshletBounds = writer.Begin(MeshSection::MeshletBounds, meshletCount * sizeof(MeshletBounds));
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            std::memcpy(meshletBounds, shape.meshletBounds.data(), shape.meshletBounds.size() * sizeof(MeshletBounds));
+            meshletBounds += shape.meshletBounds.size() * sizeof(MeshletBounds);
+        }
+        uint8_t *vertices = writer.Begin(MeshSection::MeshletVertices, meshletVertexCount * sizeof(uint32_t));
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            std::memcpy(vertices, shape.meshletVertices.data(), shape.meshletVertices.size() * sizeof(uint32_t));
+            vertices += shape.meshletVertices.size() * sizeof(uint32_t);
+        }
+        uint8_t *triangles = writer.Begin(MeshSection::MeshletTriangles, meshletTriangleCount * sizeof(uint32_t));
+        for (const SponzaShape::Shape &shape : sponza.shapes) {
+            std::memcpy(triangles, shape.meshletTriangles.data(), shape.meshletTriangles.size() * sizeof(uint32_t));
+            triangles += shape.meshletTriangles.size() * sizeof(uint32_t);
+        }
+    }
+
+    // Section offsets are already in place, fill in the rest.
+    CookedMeshHeader &header = writer.Header();
+    header.magic = COOKED_MESH_MAGIC;
+    header.version = COOKED_MESH_VERSION;
+    header.sectionCount = static_cast<uint32_t>(MESH_SECTION_COUNT);
+    header.fileSize = writer.Bytes().size();
+    header.submeshCount = submeshCount;
+    header.vertexCount = static_cast<uint32_t>(vertexCount);
+    header.indexCount = static_cast<uint32_t>(indexCount + lodIndexCount);
+    header.materialCount = materialCount;
+    header.libraryCount = libraryCount;
+    header.bounds = bounds;
+    return WriteFileAtomic(path, writer.Bytes().data(), writer.Bytes().size());
+}
+
+bool CookedMesh::Open(const char *path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.Size() < sizeof(CookedMeshHeader)) {
+        m_file.Close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const CookedMeshHeader *>(m_file.Data());
+    if (!validate()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CookedMesh::Close()
+{
+    m_header = nullptr;
+    m_file.Close();
+}
+
+const uint8_t *CookedMesh::Stream(uint32_t stream) const
+{
+    if (stream >= Layout().streamCount) {
+        return nullptr;
+    }
+    return section<uint8_t>(static_cast<MeshSection>(static_cast<uint32_t>(MeshSection::Stream0) + stream));
+}
+
+uint32_t CookedMesh::SelectLod(uint32_t submesh, float distance, float projectionScale, float maxPixelError) const
+{
+    const CookedSubmesh &value = Submesh(submesh);
+    uint32_t lod = 0;
+    // Errors grow with the level, so the first one too coarse ends the search.
+    while (lod + 1 < value.lodCount && value.lods[lod + 1].error * projectionScale <= maxPixelError * distance) {
+        ++lod;
+    }
+    return lod;
+}
+
+std::string_view CookedMesh::MaterialName(uint32_t index) const
+{
+    return string(section<CookedString>(MeshSection::MaterialNames)[index]);
+}
+
+std::string_view CookedMesh::MaterialLibrary(uint32_t index) const
+{
+    if (index >= m_header->libraryCount) {
+        return {};
+    }
+    return string(section<CookedString>(MeshSection::MaterialLibraries)[index]);
+}
+
+std::string_view CookedMesh::string(const CookedString &value) const
+{
+    return {section<char>(MeshSection::Strings) + value.offset, value.length};
+}
+
+// Checks everything the accessors rely on, but not the index values themselves
+// or the meshlet lists: walking them would touch every page the mapping is
+// meant to leave alone. The meshlet table itself is small enough to check.
+bool CookedMesh::validate() const
+{
+    const CookedMeshHeader &header = *m_header;
+    if (header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION ||
+        header.fileSize != m_file.Size() || header.sectionCount != MESH_SECTION_COUNT ||
+        !sectionsFit(header.sections, MESH_SECTION_COUNT, header.fileSize)) {
+        return false;
+    }
+
+    auto sizeIs = [&](MeshSection kind, uint64_t expected) {
+        return header.sections[static_cast<size_t>(kind)].size == expected;
+    };
+    if (!sizeIs(MeshSection::Layout, sizeof(VertexLayout)) ||
+        !sizeIs(MeshSection::Submeshes, uint64_t(header.submeshCount) * sizeof(CookedSubmesh)) ||
+        !sizeIs(MeshSection::Bounds, uint64_t(header.submeshCount) * sizeof(Bounds)) ||
+        !sizeIs(MeshSection::Indices, uint64_t(header.indexCount) * sizeof(uint32_t)) ||
+        !sizeIs(MeshSection::MaterialNames, uint64_t(header.materialCount) * sizeof(CookedString)) ||
+        !sizeIs(MeshSection::MaterialLibraries, uint64_t(header.libraryCount) * sizeof(CookedString))) {
+        return false;
+    }
+
+    const VertexLayout &layout = Layout();
+    if (layout.streamCount == 0 || layout.streamCount > MAX_VERTEX_STREAMS || layout.elementCount > MAX_VERTEX_ELEMENTS) {
+        return false;
+    }
+    for (uint32_t s = 0; s < MAX_VERTEX_STREAMS; ++s) {
+        const uint64_t expected = s < layout.streamCount ? uint64_t(header.vertexCount) * layout.strides[s] : 0;
+        if (!sizeIs(static_cast<MeshSection>(static_cast<uint32_t>(MeshSection::Stream0) + s), expected)) {
+            return false;
+        }
+    }
+
+    const uint32_t meshletCount = MeshletCount();
+    if (!sizeIs(MeshSection::Meshlets, uint64_t(meshletCount) * sizeof(Meshlet)) ||
+        !sizeIs(MeshSection::MeshletBounds, uint64_t(meshletCount) * sizeof(MeshletBounds)) ||
+        header.sections[static_cast<size_t>(MeshSection::MeshletVertices)].size % sizeof(uint32_t) != 0 ||
+        header.sections[static_cast<size_t>(MeshSection::MeshletTriangles)].size % sizeof(uint32_t) != 0) {
+        return false;
+    }
+    const uint32_t meshletVertexCount = count<uint32_t>(MeshSection::MeshletVertices);
+    const uint32_t meshletTriangleCount = count<uint32_t>(MeshSection::MeshletTriangles);
+    for (uint32_t i = 0; i < meshletCount; ++i) {
+        const Meshlet &meshlet = Meshlets()[i];
+        if (meshlet.vertexCount > MAX_MESHLET_VERTICES || meshlet.triangleCount > MAX_MESHLET_TRIANGLES ||
+            uint64_t(meshlet.firstVertex) + meshlet.vertexCount > meshletVertexCount ||
+            uint64_t(meshlet.firstTriangle) + meshlet.triangleCount > meshletTriangleCount) {
+            return false;
+        }
+    }
+
+    const uint64_t stringBytes = header.sections[static_cast<size_t>(MeshSection::Strings)].size;
+    auto stringFits = [&](const CookedString &value) {
+        return uint64_t(value.offset) + value.length <= stringBytes;
+    };
+    for (uint32_t i = 0; i < header.submeshCount; ++i) {
+        const CookedSubmesh &submesh = Submesh(i);
+        if (uint64_t(submesh.firstVertex) + submesh.vertexCount > header.vertexCount ||
+            uint64_t(submesh.firstIndex) + submesh.indexCount > header.indexCount ||
+            (submesh.material != INVALID_MATERIAL && submesh.material >= header.materialCount) ||
+            uint64_t(submesh.firstMeshlet) + submesh.meshletCount > meshletCount ||
+            submesh.lodCount == 0 || submesh.lodCount > MAX_MESH_LODS ||
+            submesh.lods[0].firstIndex != submesh.firstIndex || submesh.lods[0].indexCount != submesh.indexCount ||
+            !stringFits(submesh.name)) {
+            return false;
+        }
+        for (uint32_t l = 1; l < submesh.lodCount; ++l) {
+            if (uint64_t(submesh.lods[l].firstIndex) + submesh.lods[l].indexCount > header.indexCount) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < header.materialCount; ++i) {
+        if (!stringFits(section<CookedString>(MeshSection::MaterialNames)[i])) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.libraryCount; ++i) {
+        if (!stringFits(section<CookedString>(MeshSection::MaterialLibraries)[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Resources::CPU::WriteCookedMaterials(const char *path, const MaterialTable &materials)
+{
+    const uint32_t materialCount = static_cast<uint32_t>(materials.materials.size());
+    const uint32_t textureCount = static_cast<uint32_t>(materials.texturePaths.size());
+
+    SectionWriter<CookedMaterialsHeader, MaterialSection> writer;
+    if (materialCount > 0) {
+        std::memcpy(writer.Begin(MaterialSection::Materials, materialCount * sizeof(Material)),
+                    materials.materials.data(), materialCount * sizeof(Material));
+    }
+    std::string strings;
+    writeStrings(writer, MaterialSection::MaterialNames, materials.materialNames, materialCount, strings);
+    writeStrings(writer, MaterialSection::TexturePaths, materials.texturePaths, textureCount, strings);
+    std::memcpy(writer.Begin(MaterialSection::Strings, strings.size()), strings.data(), strings.size());
+
+    CookedMaterialsHeader &header = writer.Header();
+    header.magic = COOKED_MATERIALS_MAGIC;
+    header.version = COOKED_MATERIALS_VERSION;
+    header.sectionCount = static_cast<uint32_t>(MATERIAL_SECTION_COUNT);
+    header.fileSize = writer.Bytes().size();
+    header.materialCount = materialCount;
+    header.textureCount = textureCount;
+    return WriteFileAtomic(path, writer.Bytes().data(), writer.Bytes().size());
+}
+
+bool CookedMaterials::Open(const char *path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.Size() < sizeof(CookedMaterialsHeader)) {
+        m_file.Close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const CookedMaterialsHeader *>(m_file.Data());
+    if (!validate()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CookedMaterials::Close()
+{
+    m_header = nullptr;
+    m_file.Close();
+}
+
+std::string_view CookedMaterials::MaterialName(uint32_t index) const
+{
+    return string(section<CookedString>(MaterialSection::MaterialNames)[index]);
+}
+
+uint32_t CookedMaterials::FindMaterial(std::string_view name) const
+{
+    for (uint32_t i = 0; i < m_header->materialCount; ++i) {
+        if (MaterialName(i) == name) {
+            return i;
+        }
+    }
+    return INVALID_MATERIAL;
+}
+
+std::string_view CookedMaterials::TexturePath(TextureId texture) const
+{
+    if (texture >= m_header->textureCount) {
+        return {};
+    }
+    return string(section<CookedString>(MaterialSection::TexturePaths)[texture]);
+}
+
+std::string_view CookedMaterials::string(const CookedString &value) const
+{
+    return {section<char>(MaterialSection::Strings) + value.offset, value.length};
+}
+
+// Small enough to check all of it, texture ids included.
+bool CookedMaterials::validate() const
+{
+    const CookedMaterialsHeader &header = *m_header;
+    if (header.magic != COOKED_MATERIALS_MAGIC || header.version != COOKED_MATERIALS_VERSION ||
+        header.fileSize != m_file.Size() || header.sectionCount != MATERIAL_SECTION_COUNT ||
+        !sectionsFit(header.sections, MATERIAL_SECTION_COUNT, header.fileSize)) {
+        return false;
+    }
+
+    auto sizeIs = [&](MaterialSection kind, uint64_t expected) {
+        return header.sections[static_cast<size_t>(kind)].size == expected;
+    };
+    if (!sizeIs(MaterialSection::Materials, uint64_t(header.materialCount) * sizeof(Material)) ||
+        !sizeIs(MaterialSection::MaterialNames, uint64_t(header.materialCount) * sizeof(CookedString)) ||
+        !sizeIs(MaterialSection::TexturePaths, uint64_t(header.textureCount) * sizeof(CookedString))) {
+        return false;
+    }
+
+    const uint64_t stringBytes = header.sections[static_cast<size_t>(MaterialSection::Strings)].size;
+    auto stringFits = [&](const CookedString &value) {
+        return uint64_t(value.offset) + value.length <= stringBytes;
+    };
+    for (uint32_t i = 0; i < header.materialCount; ++i) {
+        if (!stringFits(section<CookedString>(MaterialSection::MaterialNames)[i])) {
+            return false;
+        }
+        for (TextureId texture : GetMaterial(i).textures) {
+            if (texture != INVALID_TEXTURE && texture >= header.textureCount) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < header.textureCount; ++i) {
+        if (!stringFits(section<CookedString>(MaterialSection::TexturePaths)[i])) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // .cmesh is the cooked form of a SponzaShape. It is written once by the
+    // cooker and loaded by mapping the file: every section starts on a 64-byte
+    // boundary, so the structures below are used in place without parsing or
+    // copying. All values are little-endian.
+    //
+    //   header | layout | submeshes | bounds | indices | material names
+    //          | material libraries | strings | stream 0..3
+    //          | meshlets | meshlet bounds | meshlet vertices | meshlet triangles
+    //
+    // The meshlet sections are empty for meshes cooked without meshlets. The
+    // indices of every submesh's coarser levels follow all full detail ones,
+    // so drawing the full meshes still reads one contiguous range.
+    //
+    // Submeshes name their material only. The materials themselves live in
+    // the .cmat files of the libraries listed, see CookedMaterials, so a
+    // texture edit re-cooks those and leaves the mesh alone.
+    constexpr uint32_t COOKED_MESH_MAGIC = 0x48534d43u; // "CMSH"
+    constexpr uint32_t COOKED_MESH_VERSION = 7;
+    constexpr uint64_t COOKED_SECTION_ALIGNMENT = 64;
+
+    enum class MeshSection : uint32_t
+    {
+        Layout,         // VertexLayout shared by all submeshes
+        Submeshes,      // CookedSubmesh[submeshCount]
+        Bounds,         // Bounds[submeshCount]
+        Indices,        // uint32_t[indexCount], relative to the submesh firstVertex, all levels
+        MaterialNames,      // CookedString[materialCount]
+        MaterialLibraries,  // CookedString[libraryCount], .cmat paths relative to the .cmesh
+        Strings,            // char blob the CookedStrings point into
+        Stream0,        // vertexCount * layout.strides[n] bytes each
+        Stream1,
+        Stream2,
+        Stream3,
+        Meshlets,           // Meshlet[], offsets into the two lists below
+        MeshletBounds,      // MeshletBounds[], one per meshlet
+        MeshletVertices,    // uint32_t[], relative to the submesh firstVertex
+        MeshletTriangles,   // uint32_t[], three 8-bit meshlet vertex indices each
+        Count
+    };
+
+    constexpr size_t MESH_SECTION_COUNT = static_cast<size_t>(MeshSection::Count);
+
+    struct CookedString
+    {
+        uint32_t offset{0};
+        uint32_t length{0};
+    };
+
+    struct CookedSection
+    {
+        uint64_t offset{0};
+        uint64_t size{0};
+    };
+
+    // One level of detail: a range of the index section over the submesh's
+    // vertices, and how far it strays from the full surface in mesh units.
+    struct CookedLod
+    {
+        uint32_t firstIndex{0};
+        uint32_t indexCount{0};
+        float error{0.0f};
+    };
+
+    struct CookedSubmesh
+    {
+        uint32_t firstVertex{0};
+        uint32_t vertexCount{0};
+        uint32_t firstIndex{0};
+        uint32_t indexCount{0};
+        uint32_t material{INVALID_MATERIAL};
+        CookedString name;
+        uint32_t firstMeshlet{0};
+        uint32_t meshletCount{0};
+        // lods[0] is firstIndex and indexCount again, with error 0.
+        uint32_t lodCount{1};
+        CookedLod lods[MAX_MESH_LODS];
+        // Decodes the submesh's positions when the layout is quantized,
+        // see IsQuantized; the identity otherwise.
+        VertexQuantization quantization;
+    };
+
+    struct CookedMeshHeader
+    {
+        uint32_t magic{COOKED_MESH_MAGIC};
+        uint32_t version{COOKED_MESH_VERSION};
+        uint64_t fileSize{0};
+        uint32_t submeshCount{0};
+        uint32_t vertexCount{0};
+        uint32_t indexCount{0};
+        uint32_t materialCount{0};
+        uint32_t libraryCount{0};
+        uint32_t sectionCount{static_cast<uint32_t>(MESH_SECTION_COUNT)};
+        Bounds bounds;
+        uint32_t reserved[4]{};     // keeps the sections on COOKED_SECTION_ALIGNMENT
+        CookedSection sections[MESH_SECTION_COUNT];
+    };
+
+    static_assert(sizeof(CookedMeshHeader) % COOKED_SECTION_ALIGNMENT == 0, "header must keep sections aligned");
+    static_assert(std::is_trivially_copyable_v<VertexLayout> && std::is_trivially_copyable_v<Material> &&
+                      std::is_trivially_copyable_v<Meshlet> && std::is_trivially_copyable_v<MeshletBounds>,
+                  "cooked sections are used in place");
+
+    // Writes all shapes into one .cmesh. Every shape must already be encoded
+    // into streams with the same layout, see Obj::LoadOptions::layout.
+    // Meshlets and levels of detail are written when the shapes have them,
+    // see BuildMeshlets and GenerateLods. Of the materials only the names go
+    // in; materialLibraries are the .cmat files holding them.
+    bool WriteCookedMesh(const char *path, const SponzaShape &sponza,
+                         const std::vector<std::string> &materialLibraries = {});
+
+    // A mapped .cmesh. Open validates the header and the section table only;
+    // the pointers returned below point straight into the mapping and stay
+    // valid until Close.
+    class CookedMesh
+    {
+    public:
+        bool Open(const char *path);
+        void Close();
+        bool IsOpen() const { return m_header != nullptr; }
+
+        const CookedMeshHeader &Header() const { return *m_header; }
+        const VertexLayout &Layout() const { return *section<VertexLayout>(MeshSection::Layout); }
+
+        uint32_t SubmeshCount() const { return m_header->submeshCount; }
+        const CookedSubmesh &Submesh(uint32_t index) const { return section<CookedSubmesh>(MeshSection::Submeshes)[index]; }
+        const Bounds &SubmeshBounds(uint32_t index) const { return section<Bounds>(MeshSection::Bounds)[index]; }
+        std::string_view SubmeshName(uint32_t index) const { return string(Submesh(index).name); }
+
+        const uint32_t *Indices() const { return section<uint32_t>(MeshSection::Indices); }
+
+        // Coarsest level of the submesh whose error, projected from distance
+        // with projectionScale pixels per unit at distance 1 (viewport height
+        // over 2 tan(fov / 2)), stays within maxPixelError pixels.
+        uint32_t SelectLod(uint32_t submesh, float distance, float projectionScale, float maxPixelError) const;
+
+        const uint8_t *Stream(uint32_t stream) const;
+
+        uint32_t MeshletCount() const { return count<Meshlet>(MeshSection::Meshlets); }
+        const Meshlet *Meshlets() const { return section<Meshlet>(MeshSection::Meshlets); }
+        const MeshletBounds *GetMeshletBounds() const { return section<MeshletBounds>(MeshSection::MeshletBounds); }
+        const uint32_t *MeshletVertices() const { return section<uint32_t>(MeshSection::MeshletVertices); }
+        const uint32_t *MeshletTriangles() const { return section<uint32_t>(MeshSection::MeshletTriangles); }
+
+        uint32_t MaterialCount() const { return m_header->materialCount; }
+        std::string_view MaterialName(uint32_t index) const;
+        // Relative to the .cmesh, look names up with CookedMaterials::FindMaterial.
+        uint32_t MaterialLibraryCount() const { return m_header->libraryCount; }
+        std::string_view MaterialLibrary(uint32_t index) const;
+
+        // Whole mapping, for checksums and uploads.
+        std::string_view View() const { return m_file.View(); }
+
+    private:
+        bool validate() const;
+        std::string_view string(const CookedString &value) const;
+
+        template<typename T>
+        const T *section(MeshSection kind) const
+        {
+            return reinterpret_cast<const T *>(m_file.Data() + m_header->sections[static_cast<size_t>(kind)].offset);
+        }
+
+        template<typename T>
+        uint32_t count(MeshSection kind) const
+        {
+            return static_cast<uint32_t>(m_header->sections[static_cast<size_t>(kind)].size / sizeof(T));
+        }
+
+        MappedFile m_file;
+        const CookedMeshHeader *m_header{nullptr};
+    };
+
+    // .cmat is the cooked form of one material library: what its .mtl says
+    // with constant textures folded in, duplicate textures merged and ORM
+    // pairs packed. It is cooked from the library and the pixels of its
+    // textures, apart from the meshes using it. Laid out like a .cmesh:
+    //
+    //   header | materials | material names | texture paths | strings
+    //
+    // Texture paths name the cooked .ctex or .cvt files, relative to the .cmat.
+    constexpr uint32_t COOKED_MATERIALS_MAGIC = 0x54414d43u; // "CMAT"
+    constexpr uint32_t COOKED_MATERIALS_VERSION = 1;
+
+    enum class MaterialSection : uint32_t
+    {
+        Materials,      // Material[materialCount]
+        MaterialNames,  // CookedString[materialCount]
+        TexturePaths,   // CookedString[textureCount]
+        Strings,        // char blob the CookedStrings point into
+        Count
+    };
+
+    constexpr size_t MATERIAL_SECTION_COUNT = static_cast<size_t>(MaterialSection::Count);
+
+    struct CookedMaterialsHeader
+    {
+        uint32_t magic{COOKED_MATERIALS_MAGIC};
+        uint32_t version{COOKED_MATERIALS_VERSION};
+        uint64_t fileSize{0};
+        uint32_t materialCount{0};
+        uint32_t textureCount{0};
+        uint32_t sectionCount{static_cast<uint32_t>(MATERIAL_SECTION_COUNT)};
+        uint32_t reserved[9]{};     // keeps the sections on COOKED_SECTION_ALIGNMENT
+        CookedSection sections[MATERIAL_SECTION_COUNT];
+    };
+
+    static_assert(sizeof(CookedMaterialsHeader) % COOKED_SECTION_ALIGNMENT == 0, "header must keep sections aligned");
+
+    // Texture paths are written as they are in the table.
+    bool WriteCookedMaterials(const char *path, const MaterialTable &materials);
+
+    // A mapped .cmat, validated on Open like CookedMesh.
+    class CookedMaterials
+    {
+    public:
+        bool Open(const char *path);
+        void Close();
+        bool IsOpen() const { return m_header != nullptr; }
+
+        uint32_t MaterialCount() const { return m_header->materialCount; }
+        const Material &GetMaterial(uint32_t index) const { return section<Material>(MaterialSection::Materials)[index]; }
+        std::string_view MaterialName(uint32_t index) const;
+        uint32_t FindMaterial(std::string_view name) const;
+
+        uint32_t TextureCount() const { return m_header->textureCount; }
+        std::string_view TexturePath(TextureId texture) const;
+
+        std::string_view View() const { return m_file.View(); }
+
+    private:
+        bool validate() const;
+        std::string_view string(const CookedString &value) const;
+
+        template<typename T>
+        const T *section(MaterialSection kind) const
+        {
+            return reinterpret_cast<const T *>(m_file.Data() + m_header->sections[static_cast<size_t>(kind)].offset);
+        }
+
+        MappedFile m_file;
+        const CookedMaterialsHeader *m_header{nullptr};
+    };
+}
@@ -0,0 +1,195 @@
+#include "CookedTexture.hpp"
+
+#include "MappedFile.hpp"
+#include "MipGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    const char *FORMAT_NAMES[] = {"R8", "RGBA8", "BC1", "BC4", "BC5", "BC7"};
+    static_assert(std::size(FORMAT_NAMES) == static_cast<size_t>(TextureFormat::Count), "one name per format");
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+    uint32_t levelSize(uint32_t size, uint32_t level) { return std::max(1u, size >> level); }
+
+    uint32_t blockBytes(TextureFormat format)
+    {
+        switch (format) {
+        case TextureFormat::BC1:
+        case TextureFormat::BC4: return 8;
+        case TextureFormat::BC5:
+        case TextureFormat::BC7: return 16;
+        default: return 0;
+        }
+    }
+
+    CookedMip describeMip(TextureFormat format, uint32_t width, uint32_t height)
+    {
+        CookedMip mip;
+        mip.width = width;
+        mip.height = height;
+        mip.rowPitch = static_cast<uint32_t>(alignUp(TextureRowBytes(format, width), TEXTURE_PITCH_ALIGNMENT));
+        mip.rowCount = TextureRowCount(format, height);
+        mip.size = uint64_t(mip.rowPitch) * mip.rowCount;
+        return mip;
+    }
+}
+
+TextureFormat Resources::CPU::TextureFormatOf(PixelFormat format)
+{
+    return format == PixelFormat::R8 ? TextureFormat::R8 : TextureFormat::RGBA8;
+}
+
+TextureFormat Resources::CPU::TextureFormatOf(Bc::BlockFormat format)
+{
+    switch (format) {
+    case Bc::BlockFormat::BC1: return TextureFormat::BC1;
+    case Bc::BlockFormat::BC4: return TextureFormat::BC4;
+    case Bc::BlockFormat::BC5: return TextureFormat::BC5;
+    case Bc::BlockFormat::BC7: return TextureFormat::BC7;
+    }
+    return TextureFormat::BC7;
+}
+
+const char *Resources::CPU::TextureFormatName(TextureFormat format)
+{
+    return format < TextureFormat::Count ? FORMAT_NAMES[static_cast<size_t>(format)] : "unknown";
+}
+
+bool Resources::CPU::IsBlockCompressed(TextureFormat format)
+{
+    return blockBytes(format) > 0;
+}
+
+uint32_t Resources::CPU::TextureRowBytes(TextureFormat format, uint32_t width)
+{
+    switch (format) {
+    case TextureFormat::R8: return width;
+    case TextureFormat::RGBA8: return width * 4;
+    default: return (width + 3) / 4 * blockBytes(format);
+    }
+}
+
+uint32_t Resources::CPU::TextureRowCount(TextureFormat format, uint32_t height)
+{
+    return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+bool Resources::CPU::WriteCookedTexture(const char *path, const TextureLevels &texture)
+{
+    const uint32_t mipCount = static_cast<uint32_t>(texture.levels.size());
+    if (texture.width == 0 || texture.height == 0 || texture.format >= TextureFormat::Count || mipCount == 0 ||
+        mipCount > std::min(MAX_TEXTURE_MIPS, MipLevelCount(texture.width, texture.height))) {
+        return false;
+    }
+
+    CookedTextureHeader header;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipCount = mipCount;
+    header.format = texture.format;
+    header.srgb = texture.srgb ? 1 : 0;
+    header.contentHash[0] = texture.contentHash[0];
+    header.contentHash[1] = texture.contentHash[1];
+
+    // Smallest level first, each on the next placement boundary.
+    uint64_t offset = sizeof(CookedTextureHeader);
+    for (uint32_t level = mipCount; level-- > 0;) {
+        CookedMip &mip = header.mips[level];
+        mip = describeMip(texture.format, levelSize(texture.width, level), levelSize(texture.height, level));
+        const uint64_t rowBytes = TextureRowBytes(texture.format, mip.width);
+        if (texture.levels[level].Size != rowBytes * mip.rowCount) {
+            return false;
+        }
+        mip.offset = alignUp(offset, TEXTURE_PLACEMENT_ALIGNMENT);
+        offset = mip.offset + mip.size;
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> bytes(offset, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    for (uint32_t level = 0; level < mipCount; ++level) {
+        const CookedMip &mip = header.mips[level];
+        const size_t rowBytes = TextureRowBytes(texture.format, mip.width);
+        const uint8_t *source = texture.levels[level].Data.get();
+        uint8_t *destination = bytes.data() + mip.offset;
+        for (uint32_t row = 0; row < mip.rowCount; ++row) {
+            std::memcpy(destination + size_t(row) * mip.rowPitch, source + row * rowBytes, rowBytes);
+        }
+    }
+    return WriteFileAtomic(path, bytes.data(), bytes.size());
+}
+
+bool CookedTexture::Open(const char *path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.Size() < sizeof(CookedTextureHeader)) {
+        m_file.Close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const CookedTextureHeader *>(m_file.Data());
+    if (!validate()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CookedTexture::Close()
+{
+    m_header = nullptr;
+    m_file.Close();
+}
+
+const uint8_t *CookedTexture::MipData(uint32_t level) const
+{
+    if (level >= m_header->mipCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uint8_t *>(m_file.Data() + m_header->mips[level].offset);
+}
+
+std::string_view CookedTexture::MipRange(uint32_t firstLevel, uint32_t lastLevel) const
+{
+    if (firstLevel > lastLevel || lastLevel >= m_header->mipCount) {
+        return {};
+    }
+    const CookedMip &first = m_header->mips[firstLevel];
+    const uint64_t begin = m_header->mips[lastLevel].offset;
+    return m_file.View().substr(begin, first.offset + first.size - begin);
+}
+
+bool CookedTexture::validate() const
+{
+    const CookedTextureHeader &header = *m_header;
+    if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION ||
+        header.fileSize != m_file.Size() || header.format >= TextureFormat::Count || header.width == 0 ||
+        header.height == 0 || header.mipCount == 0 ||
+        header.mipCount > std::min(MAX_TEXTURE_MIPS, MipLevelCount(header.width, header.height))) {
+        return false;
+    }
+
+    // Levels must be where the writer puts them: aligned, in the file, and
+    // each one after the next smaller one.
+    uint64_t end = sizeof(CookedTextureHeader);
+    for (uint32_t level = header.mipCount; level-- > 0;) {
+        const CookedMip &mip = header.mips[level];
+        const CookedMip expected = describeMip(header.format, levelSize(header.width, level),
+                                               levelSize(header.height, level));
+        if (mip.width != expected.width || mip.height != expected.height || mip.rowPitch != expected.rowPitch ||
+            mip.rowCount != expected.rowCount || mip.size != expected.size ||
+            mip.offset % TEXTURE_PLACEMENT_ALIGNMENT != 0 || mip.offset < end || mip.offset > header.fileSize ||
+            mip.size > header.fileSize - mip.offset) {
+            return false;
+        }
+        end = mip.offset + mip.size;
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "BlockCompressor.hpp"
+#include "MappedFile.hpp"
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // .ctex is the cooked form of a texture: a fixed header followed by the
+    // mip chain, smallest level first. Every level starts on a 512-byte
+    // boundary and its rows are 256 bytes apart, the D3D12 placement and
+    // pitch rules for texture data in an upload buffer. A level, or a run of
+    // neighbouring levels, is therefore one contiguous range of the mapped
+    // file that can be copied into upload memory as is. Smallest first means
+    // a streamer reading the file front to back has something to show after
+    // the first few kilobytes. All values are little-endian.
+    //
+    //   header | mip n-1 | ... | mip 1 | mip 0
+    constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x58455443u; // "CTEX"
+    constexpr uint32_t COOKED_TEXTURE_VERSION = 2;
+    constexpr uint64_t TEXTURE_PLACEMENT_ALIGNMENT = 512;  // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+    constexpr uint32_t TEXTURE_PITCH_ALIGNMENT = 256;      // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    constexpr uint32_t MAX_TEXTURE_MIPS = 16;
+
+    enum class TextureFormat : uint32_t
+    {
+        R8,
+        RGBA8,
+        BC1,
+        BC4,
+        BC5,
+        BC7,
+        Count
+    };
+
+    TextureFormat TextureFormatOf(PixelFormat format);
+    TextureFormat TextureFormatOf(Bc::BlockFormat format);
+    const char *TextureFormatName(TextureFormat format);
+    bool IsBlockCompressed(TextureFormat format);
+
+    // Bytes of one row of texels (of 4x4 blocks for BC formats) without padding.
+    uint32_t TextureRowBytes(TextureFormat format, uint32_t width);
+    // Rows of texels, or of blocks for BC formats.
+    uint32_t TextureRowCount(TextureFormat format, uint32_t height);
+
+    struct CookedMip
+    {
+        uint64_t offset{0};     // from the start of the file
+        uint64_t size{0};       // rowPitch * rowCount
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t rowPitch{0};   // TextureRowBytes rounded up to TEXTURE_PITCH_ALIGNMENT
+        uint32_t rowCount{0};
+    };
+
+    struct CookedTextureHeader
+    {
+        uint32_t magic{COOKED_TEXTURE_MAGIC};
+        uint32_t version{COOKED_TEXTURE_VERSION};
+        uint64_t fileSize{0};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t mipCount{0};
+        TextureFormat format{TextureFormat::RGBA8};
+        uint32_t srgb{0};       // 1 when the color channels are sRGB encoded
+        uint32_t reserved[3]{};
+        // Fingerprint of the decoded source pixels, 0 when unknown. Equal
+        // for sources that decode to the same image, so the runtime can load
+        // such textures once whatever file they came from.
+        uint64_t contentHash[2]{0, 0};
+        CookedMip mips[MAX_TEXTURE_MIPS];   // indexed by level, 0 is the full size
+    };
+
+    static_assert(sizeof(CookedTextureHeader) % 64 == 0, "mip table must stay aligned");
+
+    // Level data to write, tightly packed rows, level 0 first. Level n is
+    // max(1, width >> n) by max(1, height >> n) texels.
+    struct TextureLevels
+    {
+        TextureFormat format{TextureFormat::RGBA8};
+        bool srgb{false};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint64_t contentHash[2]{0, 0};
+        std::vector<RawData> levels;
+    };
+
+    bool WriteCookedTexture(const char *path, const TextureLevels &texture);
+
+    // A mapped .ctex. Open validates the header and the mip table only, no
+    // texel data is read; the pages of a level are faulted in when it is
+    // first touched, so streaming a few levels costs only their size.
+    class CookedTexture
+    {
+    public:
+        bool Open(const char *path);
+        void Close();
+        bool IsOpen() const { return m_header != nullptr; }
+
+        const CookedTextureHeader &Header() const { return *m_header; }
+        uint32_t Width() const { return m_header->width; }
+        uint32_t Height() const { return m_header->height; }
+        uint32_t MipCount() const { return m_header->mipCount; }
+        TextureFormat Format() const { return m_header->format; }
+        bool IsSrgb() const { return m_header->srgb != 0; }
+
+        const CookedMip &Mip(uint32_t level) const { return m_header->mips[level]; }
+        const uint8_t *MipData(uint32_t level) const;
+
+        // Bytes of levels [firstLevel, lastLevel], lastLevel being the
+        // smaller one and thus the start of the range. Level l sits at
+        // Mip(l).offset - Mip(lastLevel).offset inside it, a multiple of
+        // TEXTURE_PLACEMENT_ALIGNMENT.
+        std::string_view MipRange(uint32_t firstLevel, uint32_t lastLevel) const;
+
+        // Whole mapping, for checksums and uploads.
+        std::string_view View() const { return m_file.View(); }
+
+    private:
+        bool validate() const;
+
+        MappedFile m_file;
+        const CookedTextureHeader *m_header{nullptr};
+    };
+}
@@ -0,0 +1,64 @@
+#include "CpuFeatures.hpp"
+
+#include <atomic>
+
+#if CHELSON_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace
+{
+    SimdLevel detect()
+    {
+#if CHELSON_X86 && defined(_MSC_VER)
+        int registers[4];
+        __cpuid(registers, 0);
+        const int highest = registers[0];
+        __cpuid(registers, 1);
+        const bool ssse3 = (registers[2] & (1 << 9)) != 0;
+        const bool osxsave = (registers[2] & (1 << 27)) != 0;
+        const bool avx = (registers[2] & (1 << 28)) != 0;
+        const bool f16c = (registers[2] & (1 << 29)) != 0;
+        bool avx2 = false;
+        if (highest >= 7 && osxsave && avx && f16c && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(registers, 7, 0);
+            avx2 = (registers[1] & (1 << 5)) != 0;
+        }
+        return avx2 ? SimdLevel::Avx2 : ssse3 ? SimdLevel::Ssse3 : SimdLevel::Scalar;
+#elif CHELSON_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+            return SimdLevel::Avx2;
+        }
+        return __builtin_cpu_supports("ssse3") ? SimdLevel::Ssse3 : SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    const SimdLevel DETECTED_LEVEL = detect();
+    std::atomic<SimdLevel> g_limit{SimdLevel::Avx2};
+}
+
+SimdLevel Resources::CPU::ActiveSimdLevel()
+{
+    const SimdLevel limit = g_limit.load(std::memory_order_relaxed);
+    return limit < DETECTED_LEVEL ? limit : DETECTED_LEVEL;
+}
+
+void Resources::CPU::LimitSimdLevel(SimdLevel level)
+{
+    g_limit.store(level, std::memory_order_relaxed);
+}
+
+const char *Resources::CPU::SimdLevelName(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::Ssse3: return "ssse3";
+    case SimdLevel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Kernels for newer instruction sets are compiled per function with these
+// attributes and picked at runtime, so the build needs no /arch or -m flags.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CHELSON_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CHELSON_TARGET_SSSE3
+#define CHELSON_TARGET_AVX2
+#define CHELSON_TARGET_F16C
+#else
+#define CHELSON_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CHELSON_TARGET_AVX2 __attribute__((target("avx2")))
+#define CHELSON_TARGET_F16C __attribute__((target("avx2,f16c")))
+#endif
+#else
+#define CHELSON_X86 0
+#endif
+
+namespace Resources::CPU
+{
+    enum class SimdLevel : uint8_t
+    {
+        Scalar,
+        Ssse3,
+        Avx2        // with F16C, which every AVX2 CPU has
+    };
+
+    // Best level the CPU supports, lowered by LimitSimdLevel.
+    SimdLevel ActiveSimdLevel();
+
+    // Caps the kernels picked from now on, for benchmarks and for checking
+    // every path against the scalar one.
+    void LimitSimdLevel(SimdLevel level);
+
+    const char *SimdLevelName(SimdLevel level);
+}
@@ -0,0 +1,107 @@
+#include "DependencyGraph.hpp"
+
+#include <algorithm>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    std::string foldCase(std::string_view name)
+    {
+        std::string key{name};
+        for (char &c : key) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        return key;
+    }
+}
+
+DependencyGraph::NodeId DependencyGraph::AddNode(std::string_view name, AssetKind kind)
+{
+    auto inserted = m_ids.emplace(foldCase(name), static_cast<NodeId>(m_nodes.size()));
+    if (inserted.second) {
+        Node node;
+        node.name = name;
+        node.kind = kind;
+        m_nodes.push_back(std::move(node));
+    }
+    return inserted.first->second;
+}
+
+DependencyGraph::NodeId DependencyGraph::Find(std::string_view name) const
+{
+    auto found = m_ids.find(foldCase(name));
+    return found != m_ids.end() ? found->second : INVALID_NODE;
+}
+
+void DependencyGraph::SetDependencies(NodeId node, const std::vector<NodeId> &dependencies)
+{
+    for (NodeId old : m_nodes[node].dependencies) {
+        std::vector<NodeId> &dependents = m_nodes[old].dependents;
+        dependents.erase(std::remove(dependents.begin(), dependents.end(), node), dependents.end());
+    }
+
+    std::vector<NodeId> unique = dependencies;
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+    for (NodeId dependency : unique) {
+        m_nodes[dependency].dependents.push_back(node);
+    }
+    m_nodes[node].dependencies = std::move(unique);
+}
+
+// Reverse post-order of a depth-first walk over the dependents is a
+// topological order of the affected subgraph.
+void DependencyGraph::CollectAffected(NodeId node, std::vector<NodeId> &affected) const
+{
+    std::vector<uint8_t> visited(m_nodes.size(), 0);
+    std::vector<NodeId> postOrder;
+    std::vector<std::pair<NodeId, size_t>> stack{{node, 0}};
+    visited[node] = 1;
+    while (!stack.empty()) {
+        auto &[current, next] = stack.back();
+        const std::vector<NodeId> &dependents = m_nodes[current].dependents;
+        if (next < dependents.size()) {
+            const NodeId dependent = dependents[next++];
+            if (!visited[dependent]) {
+                visited[dependent] = 1;
+                stack.emplace_back(dependent, 0);
+            }
+            continue;
+        }
+        postOrder.push_back(current);
+        stack.pop_back();
+    }
+    affected.insert(affected.end(), postOrder.rbegin(), postOrder.rend());
+}
+
+void DependencyGraph::Clear()
+{
+    m_nodes.clear();
+    m_ids.clear();
+}
+
+void Resources::CPU::AddMaterialLibrary(DependencyGraph &graph, std::string_view libraryPath,
+                                        const MaterialTable &materials)
+{
+    using NodeId = DependencyGraph::NodeId;
+    const NodeId library = graph.AddNode(libraryPath, AssetKind::MaterialLibrary);
+
+    std::vector<NodeId> materialDependencies;
+    for (size_t i = 0; i < materials.materials.size(); ++i) {
+        std::string name{libraryPath};
+        name += '#';
+        name += i < materials.materialNames.size() ? materials.materialNames[i] : std::string();
+        const NodeId material = graph.AddNode(name, AssetKind::Material);
+
+        materialDependencies.assign(1, library);
+        for (TextureId texture : materials.materials[i].textures) {
+            if (texture != INVALID_TEXTURE && texture < materials.texturePaths.size()) {
+                materialDependencies.push_back(graph.AddNode(materials.texturePaths[texture], AssetKind::Texture));
+            }
+        }
+        graph.SetDependencies(material, materialDependencies);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Resources::CPU
+{
+    enum class AssetKind : uint8_t
+    {
+        Mesh,
+        MaterialLibrary,
+        Material,       // named "<library>#<material>"
+        Texture,
+        Count
+    };
+
+    // Who reads what. A mesh reads its material libraries, a material reads the
+    // library it is defined in and the textures it samples. Walking the edges
+    // backwards from a changed file gives exactly the assets to rebuild: a
+    // texture touches only the materials sampling it, a library its meshes and
+    // materials.
+    //
+    // Names are paths as the importers normalize them. Lookups ignore case
+    // because the .mtl files disagree with the texture file names on it.
+    class DependencyGraph
+    {
+    public:
+        using NodeId = uint32_t;
+        static constexpr NodeId INVALID_NODE = 0xffffffffu;
+
+        // Returns the existing node when the name is already known.
+        NodeId AddNode(std::string_view name, AssetKind kind);
+        NodeId Find(std::string_view name) const;
+
+        // Replaces everything node depends on.
+        void SetDependencies(NodeId node, const std::vector<NodeId> &dependencies);
+
+        // Appends node and everything depending on it, directly or not, each
+        // one after all of its affected dependencies.
+        void CollectAffected(NodeId node, std::vector<NodeId> &affected) const;
+
+        const std::string &Name(NodeId node) const { return m_nodes[node].name; }
+        AssetKind Kind(NodeId node) const { return m_nodes[node].kind; }
+        const std::vector<NodeId> &Dependencies(NodeId node) const { return m_nodes[node].dependencies; }
+        const std::vector<NodeId> &Dependents(NodeId node) const { return m_nodes[node].dependents; }
+        size_t NodeCount() const { return m_nodes.size(); }
+
+        void Clear();
+
+    private:
+        struct Node
+        {
+            std::string name;
+            AssetKind kind{AssetKind::Mesh};
+            std::vector<NodeId> dependencies;
+            std::vector<NodeId> dependents;
+        };
+
+        std::vector<Node> m_nodes;
+        std::unordered_map<std::string, NodeId> m_ids;
+    };
+
+    // Adds the library, one node per material and the textures the materials sample.
+    void AddMaterialLibrary(DependencyGraph &graph, std::string_view libraryPath, const MaterialTable &materials);
+}
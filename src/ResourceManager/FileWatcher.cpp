@@ -0,0 +1,233 @@
+#include "FileWatcher.hpp"
+#include "MaterialCompiler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    void appendUnique(std::vector<FileWatcher::Event> &events, size_t first, std::string path,
+                      FileWatcher::Clock::time_point time)
+    {
+        for (size_t i = first; i < events.size(); ++i) {
+            if (events[i].path == path) {
+                return;
+            }
+        }
+        events.push_back({std::move(path), time});
+    }
+}
+
+#if defined(__linux__)
+
+FileWatcher::FileWatcher()
+    : m_fd{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool FileWatcher::Watch(const std::string &directory)
+{
+    std::error_code error;
+    if (m_fd < 0 || !fs::is_directory(directory, error)) {
+        return false;
+    }
+    addDirectory(NormalizePath("", directory));
+    for (fs::recursive_directory_iterator it{directory, error}, end; !error && it != end; it.increment(error)) {
+        if (it->is_directory(error)) {
+            addDirectory(NormalizePath("", it->path().generic_string()));
+        }
+    }
+    return !error;
+}
+
+void FileWatcher::addDirectory(const std::string &directory)
+{
+    constexpr uint32_t MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    const int wd = ::inotify_add_watch(m_fd, directory.c_str(), MASK);
+    if (wd >= 0) {
+        m_directories[wd] = directory;
+    }
+}
+
+size_t FileWatcher::Poll(std::vector<Event> &events)
+{
+    const size_t first = events.size();
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t length = m_fd >= 0 ? ::read(m_fd, buffer, sizeof(buffer)) : -1;
+        if (length <= 0) {
+            break;
+        }
+        const Clock::time_point now = Clock::now();
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto directory = m_directories.find(event->wd);
+            if (directory == m_directories.end() || event->len == 0) {
+                continue;
+            }
+            std::string path = NormalizePath(directory->second, event->name);
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addDirectory(path);
+                }
+                continue;
+            }
+            // A new file shows up again with IN_CLOSE_WRITE once its content is there.
+            if (event->mask & IN_CREATE) {
+                continue;
+            }
+            appendUnique(events, first, std::move(path), now);
+        }
+    }
+    return events.size() - first;
+}
+
+void FileWatcher::Wait(std::chrono::milliseconds timeout)
+{
+    if (m_fd < 0) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    pollfd descriptor{m_fd, POLLIN, 0};
+    ::poll(&descriptor, 1, static_cast<int>(timeout.count()));
+}
+
+#else
+
+namespace
+{
+    void scan(const std::string &root, std::unordered_map<std::string, int64_t> &times)
+    {
+        std::error_code error;
+        for (fs::recursive_directory_iterator it{root, error}, end; !error && it != end; it.increment(error)) {
+            if (it->is_regular_file(error)) {
+                const int64_t time = static_cast<int64_t>(it->last_write_time(error).time_since_epoch().count());
+                times[NormalizePath("", it->path().generic_string())] = time;
+            }
+        }
+    }
+}
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool FileWatcher::Watch(const std::string &directory)
+{
+    std::error_code error;
+    if (!fs::is_directory(directory, error)) {
+        return false;
+    }
+    addDirectory(NormalizePath("", directory));
+    return true;
+}
+
+void FileWatcher::addDirectory(const std::string &directory)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_added.push_back(directory);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread{[this]() { run(); }};
+        }
+    }
+    m_wake.notify_all();
+}
+
+// Rescans every root each POLL_INTERVAL and queues what differs from the
+// scan before. A new root's first scan is its baseline, it reports nothing.
+void FileWatcher::run()
+{
+    std::vector<std::string> roots;
+    std::unordered_map<std::string, int64_t> times;
+    std::vector<Event> found;
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (!m_stop) {
+        std::vector<std::string> added = std::move(m_added);
+        m_added.clear();
+        lock.unlock();
+
+        for (std::string &root : added) {
+            scan(root, times);
+            roots.push_back(std::move(root));
+        }
+        std::unordered_map<std::string, int64_t> current;
+        for (const std::string &root : roots) {
+            scan(root, current);
+        }
+        const Clock::time_point now = Clock::now();
+        found.clear();
+        for (const auto &[path, time] : current) {
+            auto known = times.find(path);
+            if (known == times.end() || known->second != time) {
+                found.push_back({path, now});
+            }
+        }
+        for (const auto &[path, time] : times) {
+            if (current.count(path) == 0) {
+                found.push_back({path, now});
+            }
+        }
+        times = std::move(current);
+
+        lock.lock();
+        if (!found.empty()) {
+            for (Event &event : found) {
+                appendUnique(m_pending, 0, std::move(event.path), event.time);
+            }
+            m_changed.notify_all();
+        }
+        m_wake.wait_for(lock, POLL_INTERVAL, [this]() { return m_stop || !m_added.empty(); });
+    }
+}
+
+size_t FileWatcher::Poll(std::vector<Event> &events)
+{
+    const size_t first = events.size();
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (Event &event : m_pending) {
+        appendUnique(events, first, std::move(event.path), event.time);
+    }
+    m_pending.clear();
+    return events.size() - first;
+}
+
+void FileWatcher::Wait(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_changed.wait_for(lock, timeout, [this]() { return m_stop || !m_pending.empty(); });
+}
+
+#endif
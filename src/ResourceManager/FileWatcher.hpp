@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // Reports files written, created, moved or deleted under watched directories.
+    // Uses inotify on Linux. Elsewhere it falls back to comparing modification
+    // times every POLL_INTERVAL, which is enough for editing assets. The scans
+    // run on a thread of the watcher's own, so Poll stays cheap enough to call
+    // every frame.
+    class FileWatcher
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Event
+        {
+            std::string path;
+            Clock::time_point time;
+        };
+
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        // Watches directory and everything below it, including directories created later.
+        bool Watch(const std::string &directory);
+
+        // Appends what changed since the last call without blocking. A file
+        // written several times in between is reported once.
+        size_t Poll(std::vector<Event> &events);
+
+        // Blocks until a change may be pending or timeout passes.
+        void Wait(std::chrono::milliseconds timeout);
+
+    private:
+        void addDirectory(const std::string &directory);
+
+#if defined(__linux__)
+        int m_fd{-1};
+        std::unordered_map<int, std::string> m_directories;
+#else
+        static constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+        void run();
+
+        // Guarded by m_mutex; the modification times belong to the scan thread.
+        std::vector<std::string> m_added;
+        std::vector<Event> m_pending;
+        bool m_stop{false};
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_changed;
+        std::thread m_thread;
+#endif
+    };
+}
@@ -0,0 +1,137 @@
+#include "ImageStats.hpp"
+
+#include "CpuFeatures.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if CHELSON_X86
+#include <immintrin.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Bytes scanned between two checks of the early out.
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    constexpr size_t LANE_COUNT = 32;
+
+    // Folds size bytes into per lane minima and maxima, byte i going to lane
+    // i % 32. Pixels are 1 or 4 bytes and divide 32, so every lane holds a
+    // single channel as long as each call starts at a multiple of 32.
+    using RangeKernel = void (*)(const uint8_t *bytes, size_t size, uint8_t *minimum, uint8_t *maximum);
+
+    void rangeScalar(const uint8_t *bytes, size_t size, uint8_t *minimum, uint8_t *maximum)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            const size_t lane = i % LANE_COUNT;
+            minimum[lane] = std::min(minimum[lane], bytes[i]);
+            maximum[lane] = std::max(maximum[lane], bytes[i]);
+        }
+    }
+
+#if CHELSON_X86
+    CHELSON_TARGET_SSSE3 void rangeSse(const uint8_t *bytes, size_t size, uint8_t *minimum, uint8_t *maximum)
+    {
+        __m128i minimumLow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(minimum));
+        __m128i minimumHigh = _mm_loadu_si128(reinterpret_cast<const __m128i *>(minimum + 16));
+        __m128i maximumLow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maximum));
+        __m128i maximumHigh = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maximum + 16));
+        size_t i = 0;
+        for (; i + LANE_COUNT <= size; i += LANE_COUNT) {
+            const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i + 16));
+            minimumLow = _mm_min_epu8(minimumLow, low);
+            minimumHigh = _mm_min_epu8(minimumHigh, high);
+            maximumLow = _mm_max_epu8(maximumLow, low);
+            maximumHigh = _mm_max_epu8(maximumHigh, high);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(minimum), minimumLow);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(minimum + 16), minimumHigh);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(maximum), maximumLow);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(maximum + 16), maximumHigh);
+        rangeScalar(bytes + i, size - i, minimum, maximum);
+    }
+
+    // Two registers per bound so consecutive loads do not wait on each other.
+    CHELSON_TARGET_AVX2 void rangeAvx2(const uint8_t *bytes, size_t size, uint8_t *minimum, uint8_t *maximum)
+    {
+        __m256i minimumA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(minimum));
+        __m256i maximumA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(maximum));
+        __m256i minimumB = minimumA;
+        __m256i maximumB = maximumA;
+        size_t i = 0;
+        for (; i + 2 * LANE_COUNT <= size; i += 2 * LANE_COUNT) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i + LANE_COUNT));
+            minimumA = _mm256_min_epu8(minimumA, a);
+            maximumA = _mm256_max_epu8(maximumA, a);
+            minimumB = _mm256_min_epu8(minimumB, b);
+            maximumB = _mm256_max_epu8(maximumB, b);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(minimum), _mm256_min_epu8(minimumA, minimumB));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(maximum), _mm256_max_epu8(maximumA, maximumB));
+        rangeScalar(bytes + i, size - i, minimum, maximum);
+    }
+#endif
+
+    RangeKernel pickKernel()
+    {
+        switch (ActiveSimdLevel()) {
+#if CHELSON_X86
+        case SimdLevel::Avx2: return &rangeAvx2;
+        case SimdLevel::Ssse3: return &rangeSse;
+#endif
+        default: return &rangeScalar;
+        }
+    }
+
+    void foldLanes(const uint8_t *minimum, const uint8_t *maximum, ChannelRange &range)
+    {
+        for (uint32_t c = 0; c < range.channelCount; ++c) {
+            range.minimum[c] = 255;
+            range.maximum[c] = 0;
+        }
+        for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+            const size_t c = lane % range.channelCount;
+            range.minimum[c] = std::min(range.minimum[c], minimum[lane]);
+            range.maximum[c] = std::max(range.maximum[c], maximum[lane]);
+        }
+    }
+}
+
+uint8_t ChannelRange::Spread() const
+{
+    uint8_t spread = 0;
+    for (uint32_t c = 0; c < channelCount; ++c) {
+        spread = std::max<uint8_t>(spread, maximum[c] - minimum[c]);
+    }
+    return spread;
+}
+
+ChannelRange Resources::CPU::MeasureChannelRange(const Image &image, uint8_t stopAboveSpread)
+{
+    ChannelRange range;
+    range.channelCount = BytesPerPixel(image.format);
+    const size_t size = std::min(image.pixels.Size, image.RowPitch() * image.height);
+    if (size == 0 || image.pixels.Data == nullptr) {
+        return range;
+    }
+
+    alignas(32) uint8_t minimum[LANE_COUNT];
+    alignas(32) uint8_t maximum[LANE_COUNT];
+    std::memset(minimum, 255, sizeof(minimum));
+    std::memset(maximum, 0, sizeof(maximum));
+
+    const RangeKernel kernel = pickKernel();
+    const uint8_t *bytes = image.pixels.Data.get();
+    for (size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+        kernel(bytes + offset, std::min(CHUNK_SIZE, size - offset), minimum, maximum);
+        foldLanes(minimum, maximum, range);
+        if (range.Spread() > stopAboveSpread) {
+            break;
+        }
+    }
+    return range;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstdint>
+
+namespace Resources::CPU
+{
+    // Smallest and largest value of every channel of an image. Channels the
+    // format does not have stay at 0.
+    struct ChannelRange
+    {
+        uint8_t minimum[4]{0, 0, 0, 0};
+        uint8_t maximum[4]{0, 0, 0, 0};
+        uint32_t channelCount{0};
+
+        uint8_t Spread() const;
+        bool IsUniform(uint8_t tolerance = 0) const { return Spread() <= tolerance; }
+    };
+
+    // One min/max pass over the pixels. The scan stops early once some
+    // channel spreads further than stopAboveSpread, which is all a uniformity
+    // test needs: the range is then only known to be at least that wide.
+    ChannelRange MeasureChannelRange(const Image &image, uint8_t stopAboveSpread = 255);
+}
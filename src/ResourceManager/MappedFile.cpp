@@ -0,0 +1,189 @@
+#include "MappedFile.hpp"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Resources::CPU;
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other) {
+        Close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_isEmpty = std::exchange(other.m_isEmpty, false);
+#if defined(_WIN32)
+        m_file = std::exchange(other.m_file, nullptr);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+bool Resources::CPU::WriteFileAtomic(const char *path, const void *data, size_t size)
+{
+    const std::string temporary = std::string(path) + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(data, 1, size, file) == size;
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return MoveFileOver(temporary.c_str(), path);
+}
+
+#if defined(_WIN32)
+
+bool Resources::CPU::MoveFileOver(const char *temporary, const char *path)
+{
+    // rename fails on Windows when path exists, MoveFileEx replaces it in place.
+    if (!::MoveFileExA(temporary, path, MOVEFILE_REPLACE_EXISTING)) {
+        ::DeleteFileA(temporary);
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Open(const char *path)
+{
+    Close();
+
+    HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!::GetFileSizeEx(file, &size)) {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    // CreateFileMapping refuses zero-sized files, treat them as an empty view.
+    if (size.QuadPart == 0) {
+        ::CloseHandle(file);
+        m_isEmpty = true;
+        return true;
+    }
+
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    void *view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const char *>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr) {
+        ::UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        ::CloseHandle(m_mapping);
+    }
+    if (m_file != nullptr) {
+        ::CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_isEmpty = false;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+
+#else
+
+bool Resources::CPU::MoveFileOver(const char *temporary, const char *path)
+{
+    // rename replaces an existing path atomically, removing it first would
+    // leave a moment without any file.
+    if (std::rename(temporary, path) != 0) {
+        std::remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Open(const char *path)
+{
+    Close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        ::close(fd);
+        m_isEmpty = true;
+        return true;
+    }
+
+    void *view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char *>(view);
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr) {
+        ::munmap(const_cast<char *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_isEmpty = false;
+}
+
+#endif
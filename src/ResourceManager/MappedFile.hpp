@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace Resources::CPU
+{
+    // Read-only view of a whole file mapped into the address space.
+    // The mapping lives as long as the object, so anything pointing into
+    // View() must not outlive it.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        bool Open(const char *path);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr || m_isEmpty; }
+        const char *Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+        std::string_view View() const { return {m_data, m_size}; }
+
+    private:
+        const char *m_data{nullptr};
+        size_t m_size{0};
+        bool m_isEmpty{false};
+#if defined(_WIN32)
+        void *m_file{nullptr};
+        void *m_mapping{nullptr};
+#endif
+    };
+
+    // Moves the file at temporary over path in one step, so a reader opens
+    // either the old file or the new one, never a half written one. The
+    // temporary is removed when the move fails.
+    bool MoveFileOver(const char *temporary, const char *path);
+
+    // Writes size bytes to path + ".tmp" and moves that over path.
+    bool WriteFileAtomic(const char *path, const void *data, size_t size);
+}
@@ -0,0 +1,272 @@
+#include "MaterialCompiler.hpp"
+#include "MappedFile.hpp"
+#include "TextScan.hpp"
+
+#include <utility>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    struct SlotKeyword
+    {
+        const char *keyword;
+        MaterialSlot slot;
+    };
+
+    // sponza_pbr.mtl keeps roughness in map_Ns and metallic in map_Ka.
+    const SlotKeyword SLOT_KEYWORDS[] = {
+        {"map_Kd", MaterialSlot::Albedo},
+        {"map_Ns", MaterialSlot::Roughness},
+        {"map_Pr", MaterialSlot::Roughness},
+        {"map_Ka", MaterialSlot::Metallic},
+        {"map_Pm", MaterialSlot::Metallic},
+        {"map_bump", MaterialSlot::Normal},
+        {"bump", MaterialSlot::Normal},
+        {"norm", MaterialSlot::Normal},
+        {"map_d", MaterialSlot::Mask},
+    };
+
+    bool parseColor(const char *cursor, const char *end, float *color)
+    {
+        for (int i = 0; i < 3; ++i) {
+            Text::SkipBlanks(cursor, end);
+            if (!Text::ParseFloat(cursor, end, color[i])) {
+                // A single value means grey.
+                if (i == 1) {
+                    color[1] = color[2] = color[0];
+                    return true;
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseScalar(const char *cursor, const char *end, float &value)
+    {
+        Text::SkipBlanks(cursor, end);
+        return Text::ParseFloat(cursor, end, value);
+    }
+
+    // Texture statements may carry options ("-bm 0.5 file.tga"); the file
+    // name is always the last token.
+    std::string_view textureReference(const char *cursor, const char *end)
+    {
+        std::string_view rest = Text::RestOfLine(cursor, end);
+        if (rest.empty() || rest[0] != '-') {
+            return rest;
+        }
+        size_t split = rest.find_last_of(" \t");
+        return split == std::string_view::npos ? std::string_view{} : rest.substr(split + 1);
+    }
+
+    char foldCase(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool isAbsolute(std::string_view path)
+    {
+        return (!path.empty() && (path[0] == '/' || path[0] == '\\'))
+            || (path.size() > 1 && path[1] == ':');
+    }
+}
+
+std::string_view Resources::CPU::DirectoryOf(std::string_view path)
+{
+    size_t split = path.find_last_of("/\\");
+    return split == std::string_view::npos ? std::string_view{} : path.substr(0, split + 1);
+}
+
+std::string Resources::CPU::NormalizePath(std::string_view directory, std::string_view path)
+{
+    std::string joined;
+    joined.reserve(directory.size() + path.size() + 1);
+    if (!isAbsolute(path)) {
+        joined.append(directory);
+        if (!joined.empty() && joined.back() != '/' && joined.back() != '\\') {
+            joined.push_back('/');
+        }
+    }
+    joined.append(path);
+
+    std::string normalized;
+    normalized.reserve(joined.size());
+    size_t begin = 0;
+    if (!joined.empty() && (joined[0] == '/' || joined[0] == '\\')) {
+        normalized.push_back('/');
+        begin = 1;
+    }
+    // Segments that cannot be folded away (leading "..") stay in place.
+    size_t keptRoot = normalized.size();
+
+    while (begin <= joined.size()) {
+        size_t end = joined.find_first_of("/\\", begin);
+        if (end == std::string::npos) {
+            end = joined.size();
+        }
+        std::string_view segment{joined.data() + begin, end - begin};
+        begin = end + 1;
+
+        if (segment.empty() || segment == ".") {
+            continue;
+        }
+        if (segment == ".." && normalized.size() > keptRoot) {
+            size_t parent = normalized.find_last_of('/', normalized.size() - 2);
+            normalized.resize(parent == std::string::npos ? 0 : parent + 1);
+            if (normalized.size() < keptRoot) {
+                normalized.resize(keptRoot);
+            }
+            continue;
+        }
+
+        normalized.append(segment);
+        normalized.push_back('/');
+        if (segment == "..") {
+            keptRoot = normalized.size();
+        }
+    }
+    if (!normalized.empty() && normalized.back() == '/' && normalized.size() > 1) {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+bool MaterialCompiler::CompileFile(const char *path)
+{
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    return Compile(file.View(), DirectoryOf(path));
+}
+
+bool MaterialCompiler::Compile(std::string_view text, std::string_view directory)
+{
+    m_skipMaterial = false;
+    return Text::ForEachLine(text, [this, directory](const char *cursor, const char *end) {
+        return compileLine(cursor, end, directory);
+    });
+}
+
+MaterialTable MaterialCompiler::Release()
+{
+    m_textureIds.clear();
+    return std::exchange(m_table, MaterialTable{});
+}
+
+bool MaterialCompiler::compileLine(const char *cursor, const char *end, std::string_view directory)
+{
+    std::string_view keyword = Text::NextToken(cursor, end);
+    if (keyword.empty() || keyword[0] == '#') {
+        return true;
+    }
+
+    if (keyword == "newmtl") {
+        std::string_view name = Text::RestOfLine(cursor, end);
+        if (name.empty()) {
+            name = "none";
+        }
+        // The first library to define a name wins, like a linker would.
+        m_skipMaterial = m_table.FindMaterial(name) != INVALID_MATERIAL;
+        if (!m_skipMaterial) {
+            m_table.materials.emplace_back();
+            m_table.materialNames.emplace_back(name);
+        }
+        return true;
+    }
+
+    Material *material = current();
+    if (material == nullptr) {
+        return true;
+    }
+
+    // Malformed values are skipped rather than failing the whole library.
+    if (keyword == "Kd") {
+        parseColor(cursor, end, material->baseColor);
+    } else if (keyword == "Ke") {
+        parseColor(cursor, end, material->emissive);
+    } else if (keyword == "Ns") {
+        parseScalar(cursor, end, material->specularExponent);
+    } else if (keyword == "Ni") {
+        parseScalar(cursor, end, material->ior);
+    } else if (keyword == "d") {
+        parseScalar(cursor, end, material->opacity);
+    } else if (keyword == "Pr") {
+        parseScalar(cursor, end, material->roughness);
+    } else if (keyword == "Pm") {
+        parseScalar(cursor, end, material->metallic);
+    } else if (keyword == "illum") {
+        int64_t illum = 0;
+        Text::SkipBlanks(cursor, end);
+        if (Text::ParseInt(cursor, end, illum) && illum >= 0) {
+            material->illum = static_cast<uint32_t>(illum);
+        }
+    } else {
+        for (const SlotKeyword &entry : SLOT_KEYWORDS) {
+            // Exporters are sloppy with case (map_NS, map_Bump).
+            if (Text::EqualsNoCase(keyword, entry.keyword)) {
+                std::string_view reference = textureReference(cursor, end);
+                if (!reference.empty()) {
+                    material->Texture(entry.slot) = internTexture(directory, reference);
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+TextureId MaterialCompiler::internTexture(std::string_view directory, std::string_view reference)
+{
+    std::string path = NormalizePath(directory, reference);
+    std::string key = path;
+    for (char &c : key) {
+        c = foldCase(c);
+    }
+
+    auto found = m_textureIds.find(key);
+    if (found != m_textureIds.end()) {
+        return found->second;
+    }
+
+    const TextureId id = static_cast<TextureId>(m_table.texturePaths.size());
+    m_table.texturePaths.push_back(std::move(path));
+    m_textureIds.emplace(std::move(key), id);
+    return id;
+}
+
+Material *MaterialCompiler::current()
+{
+    if (m_skipMaterial || m_table.materials.empty()) {
+        return nullptr;
+    }
+    return &m_table.materials.back();
+}
+
+void Resources::CPU::RemoveUnreferencedTextures(MaterialTable &table)
+{
+    std::vector<TextureId> remap(table.texturePaths.size(), INVALID_TEXTURE);
+    for (const Material &material : table.materials) {
+        for (TextureId texture : material.textures) {
+            if (texture != INVALID_TEXTURE && texture < remap.size()) {
+                remap[texture] = 0;
+            }
+        }
+    }
+
+    std::vector<std::string> kept;
+    for (size_t i = 0; i < remap.size(); ++i) {
+        if (remap[i] != INVALID_TEXTURE) {
+            remap[i] = static_cast<TextureId>(kept.size());
+            kept.push_back(std::move(table.texturePaths[i]));
+        }
+    }
+    table.texturePaths = std::move(kept);
+    for (Material &material : table.materials) {
+        for (TextureId &texture : material.textures) {
+            texture = texture != INVALID_TEXTURE && texture < remap.size() ? remap[texture] : INVALID_TEXTURE;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Resources::CPU
+{
+    // Turns .mtl files into a MaterialTable.
+    //
+    // Texture references are normalized (forward slashes, relative to the .mtl,
+    // "." and ".." folded) and interned, so a texture shared by many materials
+    // or listed under several keywords (map_bump and bump) gets a single id.
+    // Interning ignores case since the assets are authored on Windows.
+    class MaterialCompiler
+    {
+    public:
+        bool CompileFile(const char *path);
+        bool Compile(std::string_view text, std::string_view directory);
+
+        const MaterialTable &Table() const { return m_table; }
+        MaterialTable Release();
+
+    private:
+        bool compileLine(const char *cursor, const char *end, std::string_view directory);
+        TextureId internTexture(std::string_view directory, std::string_view reference);
+        Material *current();
+
+        MaterialTable m_table;
+        std::unordered_map<std::string, TextureId> m_textureIds;
+        bool m_skipMaterial{false};
+    };
+
+    // Joins a texture reference onto directory and folds it into canonical form.
+    std::string NormalizePath(std::string_view directory, std::string_view path);
+
+    // Directory part of a path, including the trailing separator.
+    std::string_view DirectoryOf(std::string_view path);
+
+    // Drops texture paths no material slot points at and renumbers the rest
+    // in order, for cook steps that take textures out of materials.
+    void RemoveUnreferencedTextures(MaterialTable &table);
+}
@@ -0,0 +1,401 @@
+#include "MeshOptimizer.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // FIFO cache kept as one time stamp per vertex: a vertex is cached while
+    // fewer than size misses happened since its own. Reset is a jump of the
+    // clock, no clearing.
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t vertexCount, uint32_t size)
+            : m_stamps(vertexCount, 0)
+            , m_size{size}
+            , m_time{size + 1}
+        {
+        }
+
+        // Returns 1 when vertex had to be transformed.
+        uint32_t Access(uint32_t vertex)
+        {
+            if (m_time - m_stamps[vertex] <= m_size) {
+                return 0;
+            }
+            m_stamps[vertex] = m_time++;
+            return 1;
+        }
+
+        uint32_t AccessTriangle(const unsigned int *triangle)
+        {
+            return Access(triangle[0]) + Access(triangle[1]) + Access(triangle[2]);
+        }
+
+        void Reset() { m_time += m_size + 1; }
+
+    private:
+        std::vector<uint32_t> m_stamps;
+        uint32_t m_size;
+        uint32_t m_time;
+    };
+
+    // Triangles around every vertex, as offsets into one flat array.
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;      // vertexCount + 1
+        std::vector<uint32_t> triangles;
+
+        Adjacency(const unsigned int *indices, size_t indexCount, size_t vertexCount)
+            : offsets(vertexCount + 1, 0)
+            , triangles(indexCount)
+        {
+            for (size_t i = 0; i < indexCount; ++i) {
+                ++offsets[indices[i] + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v) {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) {
+                triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    constexpr uint32_t NO_VERTEX = 0xffffffffu;
+
+    template<typename T>
+    void permute(std::vector<T> &values, const uint32_t *remap, size_t vertexCount, size_t usedCount, size_t width)
+    {
+        if (values.size() < vertexCount * width) {
+            return;
+        }
+        std::vector<T> permuted(usedCount * width);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (remap[v] != NO_VERTEX) {
+                std::memcpy(&permuted[remap[v] * width], &values[v * width], width * sizeof(T));
+            }
+        }
+        values = std::move(permuted);
+    }
+}
+
+VertexCacheStats Resources::CPU::AnalyzeVertexCache(const unsigned int *indices, size_t indexCount,
+                                                    size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) {
+        return stats;
+    }
+    FifoCache cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        misses += cache.Access(indices[i]);
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+    return stats;
+}
+
+void Resources::CPU::OptimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                                         size_t vertexCount, uint32_t cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    const Adjacency adjacency(indices, indexCount, vertexCount);
+    std::vector<uint32_t> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint32_t> stamps(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+
+    const uint32_t k = cacheSize;
+    uint32_t time = k + 1;
+    uint32_t cursor = 0;
+    uint32_t fan = 0;
+    size_t written = 0;
+
+    // Vertex to continue from once the candidates of the last fan are used
+    // up: the most recently touched one still live, else the next live one
+    // in input order.
+    auto skipDeadEnd = [&]() {
+        while (!deadEnds.empty()) {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; ++cursor) {
+            if (live[cursor] > 0) {
+                return cursor;
+            }
+        }
+        return NO_VERTEX;
+    };
+
+    while (fan != NO_VERTEX) {
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; ++a) {
+            const uint32_t triangle = adjacency.triangles[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = 1;
+            for (uint32_t c = 0; c < 3; ++c) {
+                const uint32_t vertex = indices[triangle * 3 + c];
+                destination[written++] = vertex;
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - stamps[vertex] > k) {
+                    stamps[vertex] = time++;
+                }
+            }
+        }
+
+        // Prefer the candidate that entered the cache earliest and will
+        // still be in it after its remaining triangles are emitted.
+        uint32_t next = NO_VERTEX;
+        int64_t best = -1;
+        for (uint32_t vertex : candidates) {
+            if (live[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - stamps[vertex] + 2 * live[vertex] <= k) {
+                priority = time - stamps[vertex];
+            }
+            if (priority > best) {
+                best = priority;
+                next = vertex;
+            }
+        }
+        fan = next != NO_VERTEX ? next : skipDeadEnd();
+    }
+}
+
+size_t Resources::CPU::OptimizeOverdraw(unsigned int *indices, size_t indexCount, const float *positions,
+                                        size_t vertexCount, float threshold, uint32_t cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0;
+    }
+
+    // Hard boundaries: triangles the cache knows none of the corners of.
+    std::vector<uint32_t> hard{0};
+    FifoCache cache(vertexCount, cacheSize);
+    cache.AccessTriangle(indices);
+    for (size_t t = 1; t < triangleCount; ++t) {
+        if (cache.AccessTriangle(indices + t * 3) == 3) {
+            hard.push_back(static_cast<uint32_t>(t));
+        }
+    }
+    hard.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: restart a cluster as soon as its efficiency is close
+    // enough to that of the whole hard cluster it is cut from.
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        const uint32_t begin = hard[h];
+        const uint32_t end = hard[h + 1];
+
+        cache.Reset();
+        uint32_t misses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            misses += cache.AccessTriangle(indices + size_t(t) * 3);
+        }
+        const float target = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+        cache.Reset();
+        clusters.push_back(begin);
+        uint32_t start = begin;
+        misses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            misses += cache.AccessTriangle(indices + size_t(t) * 3);
+            if (t + 1 < end && static_cast<float>(misses) <= target * static_cast<float>(t + 1 - start)) {
+                cache.Reset();
+                clusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+            }
+        }
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+    const size_t clusterCount = clusters.size() - 1;
+
+    // Area weighted centroid and summed normal of every cluster, and of the mesh.
+    std::vector<float> keys(clusterCount);
+    std::vector<float> centroids(clusterCount * 3, 0.0f);
+    std::vector<float> normals(clusterCount * 3, 0.0f);
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float area = 0.0f;
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const float *p0 = positions + size_t(indices[size_t(t) * 3 + 0]) * 3;
+            const float *p1 = positions + size_t(indices[size_t(t) * 3 + 1]) * 3;
+            const float *p2 = positions + size_t(indices[size_t(t) * 3 + 2]) * 3;
+            const float a[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float b[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float n[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+            const float weight = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int i = 0; i < 3; ++i) {
+                centroids[c * 3 + i] += weight * (p0[i] + p1[i] + p2[i]) / 3.0f;
+                normals[c * 3 + i] += n[i];
+            }
+            area += weight;
+        }
+        for (int i = 0; i < 3; ++i) {
+            meshCentroid[i] += centroids[c * 3 + i];
+            centroids[c * 3 + i] = area > 0.0f ? centroids[c * 3 + i] / area : 0.0f;
+        }
+        meshArea += area;
+    }
+    for (float &value : meshCentroid) {
+        value = meshArea > 0.0f ? value / meshArea : 0.0f;
+    }
+
+    for (size_t c = 0; c < clusterCount; ++c) {
+        const float *n = &normals[c * 3];
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float dot = 0.0f;
+        for (int i = 0; i < 3; ++i) {
+            dot += (centroids[c * 3 + i] - meshCentroid[i]) * n[i];
+        }
+        keys[c] = length > 0.0f ? dot / length : 0.0f;
+    }
+
+    // Outward facing clusters far from the centre occlude the rest, draw them first.
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        order[c] = static_cast<uint32_t>(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (uint32_t c : order) {
+        sorted.insert(sorted.end(), indices + size_t(clusters[c]) * 3, indices + size_t(clusters[c + 1]) * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices);
+    return clusterCount;
+}
+
+size_t Resources::CPU::VertexFetchRemap(uint32_t *remap, const unsigned int *indices, size_t indexCount,
+                                        size_t vertexCount)
+{
+    std::fill(remap, remap + vertexCount, NO_VERTEX);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (remap[indices[i]] == NO_VERTEX) {
+            remap[indices[i]] = next++;
+        }
+    }
+    return next;
+}
+
+bool Resources::CPU::ShapePositions(const SponzaShape::Shape &shape, std::vector<float> &positions)
+{
+    if (shape.layout.streamCount == 0) {
+        if (shape.positions.size() < size_t(shape.vertexCount) * 3) {
+            return false;
+        }
+        positions.assign(shape.positions.begin(), shape.positions.begin() + size_t(shape.vertexCount) * 3);
+        return true;
+    }
+
+    const uint8_t *streams[MAX_VERTEX_STREAMS];
+    for (uint32_t s = 0; s < shape.layout.streamCount; ++s) {
+        if (shape.streams[s].size() < size_t(shape.vertexCount) * shape.layout.strides[s]) {
+            return false;
+        }
+        streams[s] = shape.streams[s].data();
+    }
+    positions.resize(size_t(shape.vertexCount) * 3);
+    for (uint32_t v = 0; v < shape.vertexCount; ++v) {
+        float value[4];
+        if (!DecodeAttribute(shape.layout, streams, v, VertexAttribute::Position, value, shape.quantization)) {
+            positions.clear();
+            return false;
+        }
+        std::copy(value, value + 3, &positions[size_t(v) * 3]);
+    }
+    return true;
+}
+
+void Resources::CPU::OptimizeShape(SponzaShape::Shape &shape, MeshOptimizeStats *stats)
+{
+    const size_t indexCount = shape.indicies.size() - shape.indicies.size() % 3;
+    const size_t vertexCount = shape.vertexCount;
+    if (stats != nullptr) {
+        *stats = MeshOptimizeStats{};
+        stats->name = shape.name;
+        stats->triangleCount = indexCount / 3;
+        stats->vertexCount = vertexCount;
+        stats->before = AnalyzeVertexCache(shape.indicies.data(), indexCount, vertexCount);
+    }
+    if (indexCount == 0 || vertexCount == 0) {
+        if (stats != nullptr) {
+            stats->after = stats->before;
+        }
+        return;
+    }
+
+    std::vector<unsigned int> indices(shape.indicies.size());
+    OptimizeVertexCache(indices.data(), shape.indicies.data(), indexCount, vertexCount);
+    std::copy(shape.indicies.begin() + indexCount, shape.indicies.end(), indices.begin() + indexCount);
+
+    std::vector<float> positions;
+    size_t clusterCount = 0;
+    if (ShapePositions(shape, positions)) {
+        clusterCount = OptimizeOverdraw(indices.data(), indexCount, positions.data(), vertexCount);
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    const size_t usedCount = VertexFetchRemap(remap.data(), indices.data(), indexCount, vertexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        indices[i] = remap[indices[i]];
+    }
+    shape.indicies = std::move(indices);
+
+    if (shape.layout.streamCount == 0) {
+        permute(shape.positions, remap.data(), vertexCount, usedCount, 3);
+        permute(shape.normals, remap.data(), vertexCount, usedCount, 3);
+        permute(shape.texcoords, remap.data(), vertexCount, usedCount, 2);
+        permute(shape.tangents, remap.data(), vertexCount, usedCount, 4);
+    } else {
+        for (uint32_t s = 0; s < shape.layout.streamCount; ++s) {
+            permute(shape.streams[s], remap.data(), vertexCount, usedCount, shape.layout.strides[s]);
+        }
+    }
+    shape.vertexCount = static_cast<uint32_t>(usedCount);
+
+    if (stats != nullptr) {
+        stats->clusterCount = clusterCount;
+        stats->after = AnalyzeVertexCache(shape.indicies.data(), indexCount, usedCount);
+    }
+}
+
+void Resources::CPU::OptimizeShapes(SponzaShape &sponza, unsigned threadCount, std::vector<MeshOptimizeStats> *stats)
+{
+    if (stats != nullptr) {
+        stats->assign(sponza.shapes.size(), MeshOptimizeStats{});
+    }
+    ParallelFor(sponza.shapes.size(), ResolveThreads(threadCount), [&sponza, stats](size_t i) {
+        OptimizeShape(sponza.shapes[i], stats != nullptr ? &(*stats)[i] : nullptr);
+    });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Index and vertex reordering for the GPU: triangles in post-transform cache
+// order (Tipsify, Sander et al. 2007), clusters of them sorted outside in to
+// cut overdraw, then vertices renumbered in the order the indices first use
+// them so vertex fetch walks the buffers front to back.
+namespace Resources::CPU
+{
+    // FIFO entries the cache statistics and the optimizer assume; small enough
+    // to hold on any GPU in use.
+    constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+    struct VertexCacheStats
+    {
+        float acmr{0.0f};   // vertex shader runs per triangle, 0.5 at best, 3 at worst
+        float atvr{0.0f};   // vertex shader runs per vertex, 1 at best
+    };
+
+    // Replays indices through a FIFO cache of cacheSize entries.
+    VertexCacheStats AnalyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount,
+                                        uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Writes the triangles of indices to destination in Tipsify order. The
+    // two may not overlap. Winding is kept.
+    void OptimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                             size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Splits cache ordered indices into clusters, at triangles that miss the
+    // cache on every corner and wherever the cache efficiency so far is
+    // within threshold of the cluster's, then sorts the clusters so those
+    // facing away from the mesh centre draw first. Returns the cluster count.
+    size_t OptimizeOverdraw(unsigned int *indices, size_t indexCount, const float *positions, size_t vertexCount,
+                            float threshold = 1.05f, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // remap[old] = new for every vertex, numbered by first use in indices;
+    // unused vertices get ~0u. Returns the number of used vertices.
+    size_t VertexFetchRemap(uint32_t *remap, const unsigned int *indices, size_t indexCount, size_t vertexCount);
+
+    struct MeshOptimizeStats
+    {
+        std::string name;
+        size_t triangleCount{0};
+        size_t vertexCount{0};
+        size_t clusterCount{0};
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    // Positions of a shape as float xyz, from the float arrays or decoded
+    // from its streams. False when the shape has none.
+    bool ShapePositions(const SponzaShape::Shape &shape, std::vector<float> &positions);
+
+    // Runs all three passes over one shape, float arrays or encoded streams.
+    // Shapes without positions skip the overdraw pass.
+    void OptimizeShape(SponzaShape::Shape &shape, MeshOptimizeStats *stats = nullptr);
+
+    // One shape per thread, threadCount 0 picks the hardware concurrency.
+    // stats, if given, gets one entry per shape in shape order.
+    void OptimizeShapes(SponzaShape &sponza, unsigned threadCount = 0,
+                        std::vector<MeshOptimizeStats> *stats = nullptr);
+}
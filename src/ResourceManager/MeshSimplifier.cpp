@@ -0,0 +1,567 @@
+#include "MeshSimplifier.hpp"
+
+#include "MeshOptimizer.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint32_t NONE = 0xffffffffu;
+
+    // Open edges are weighted this much above the triangles next to them, so
+    // seams and unlocked borders keep their shape while they shorten.
+    constexpr double EDGE_WEIGHT = 10.0;
+
+    enum Kind : uint8_t
+    {
+        MANIFOLD,   // all edges shared by two triangles
+        BORDER,     // on one open border, one edge in and one out
+        SEAM,       // one of two welded vertices along a seam
+        LOCKED,     // everything else, never moves
+        KIND_COUNT
+    };
+
+    // CAN_COLLAPSE[from][to]: border and seam vertices stay on their line.
+    constexpr bool CAN_COLLAPSE[KIND_COUNT][KIND_COUNT] = {
+        {true, true, true, true},
+        {false, true, false, false},
+        {false, false, true, false},
+        {false, false, false, false},
+    };
+
+    // w * (n.p + d)^2 summed over planes, kept as the symmetric matrix, the
+    // vector and the constant of the expanded form, plus the summed weight.
+    struct Quadric
+    {
+        double a00{0}, a11{0}, a22{0}, a10{0}, a20{0}, a21{0};
+        double b0{0}, b1{0}, b2{0};
+        double c{0};
+        double w{0};
+
+        void Add(const Quadric &other)
+        {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a10 += other.a10; a20 += other.a20; a21 += other.a21;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            w += other.w;
+        }
+
+        void AddPlane(const double *n, double d, double weight)
+        {
+            a00 += weight * n[0] * n[0]; a11 += weight * n[1] * n[1]; a22 += weight * n[2] * n[2];
+            a10 += weight * n[1] * n[0]; a20 += weight * n[2] * n[0]; a21 += weight * n[2] * n[1];
+            b0 += weight * n[0] * d; b1 += weight * n[1] * d; b2 += weight * n[2] * d;
+            c += weight * d * d;
+            w += weight;
+        }
+
+        // Mean squared distance of p to the planes.
+        double Error(const float *p) const
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            const double rx = a00 * x + a10 * y + a20 * z;
+            const double ry = a10 * x + a11 * y + a21 * z;
+            const double rz = a20 * x + a21 * y + a22 * z;
+            const double r = rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return w > 0.0 ? std::fabs(r) / w : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    struct PositionKey
+    {
+        uint32_t bits[3];
+        bool operator==(const PositionKey &other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const PositionKey &key) const
+        {
+            return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+        }
+    };
+
+    // Triangles around every entry of ids, as offsets into one flat array.
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        void Build(const unsigned int *indices, size_t indexCount, const uint32_t *ids, size_t idCount)
+        {
+            offsets.assign(idCount + 1, 0);
+            triangles.resize(indexCount);
+            for (size_t i = 0; i < indexCount; ++i) {
+                ++offsets[ids[indices[i]] + 1];
+            }
+            for (size_t v = 0; v < idCount; ++v) {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) {
+                triangles[cursor[ids[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+
+    void cross(const double *a, const double *b, double *out)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    double dot(const double *a, const double *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    void triangleNormal(const float *p0, const float *p1, const float *p2, double *normal)
+    {
+        const double e0[3] = {double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2]};
+        const double e1[3] = {double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2]};
+        cross(e0, e1, normal);
+    }
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const float *positions, size_t vertexCount, const SimplifyOptions &options)
+            : m_positions{positions}
+            , m_vertexCount{vertexCount}
+            , m_options{options}
+        {
+        }
+
+        size_t Run(unsigned int *indices, size_t indexCount, size_t targetIndexCount, double errorLimit,
+                   double &error)
+        {
+            indexCount = dropDegenerate(indices, indexCount);
+            buildRemap();
+            classify(indices, indexCount);
+            buildQuadrics(indices, indexCount);
+
+            std::vector<uint32_t> collapseRemap(m_vertexCount);
+            std::vector<uint8_t> locked(m_vertexCount);
+            std::vector<Collapse> collapses;
+            const double limit = errorLimit * errorLimit;
+            double largest = 0.0;
+
+            while (indexCount > targetIndexCount) {
+                m_adjacency.Build(indices, indexCount, m_remap.data(), m_vertexCount);
+                pickCollapses(indices, indexCount, collapses);
+                std::sort(collapses.begin(), collapses.end(),
+                          [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+                for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                    collapseRemap[v] = v;
+                }
+                std::fill(locked.begin(), locked.end(), 0);
+
+                const size_t goal = (indexCount - targetIndexCount) / 3;
+                size_t removed = 0;
+                size_t performed = 0;
+                for (const Collapse &collapse : collapses) {
+                    if (collapse.error > limit || removed >= goal) {
+                        break;
+                    }
+                    const uint32_t r0 = m_remap[collapse.from];
+                    const uint32_t r1 = m_remap[collapse.to];
+                    if (locked[r0] || locked[r1]) {
+                        continue;
+                    }
+
+                    // The twin of a seam vertex goes to the twin of the target on its side of the seam.
+                    uint32_t twin = NONE, twinTarget = NONE;
+                    if (m_kind[collapse.from] == SEAM) {
+                        twin = m_wedge[collapse.from];
+                        twinTarget = m_loop[collapse.from] == collapse.to ? m_loopBack[twin] : m_loop[twin];
+                        if (twinTarget == NONE || m_remap[twinTarget] != r1) {
+                            continue;
+                        }
+                    }
+                    if (flips(indices, r0, r1, m_positions + size_t(collapse.to) * 3)) {
+                        continue;
+                    }
+
+                    collapseRemap[collapse.from] = collapse.to;
+                    if (twin != NONE) {
+                        collapseRemap[twin] = twinTarget;
+                    }
+                    m_quadrics[r1].Add(m_quadrics[r0]);
+                    // Lock the one-ring: later collapses this pass then only see triangles this one left alone.
+                    for (uint32_t a = m_adjacency.offsets[r0]; a < m_adjacency.offsets[r0 + 1]; ++a) {
+                        const unsigned int *triangle = indices + size_t(m_adjacency.triangles[a]) * 3;
+                        locked[m_remap[triangle[0]]] = locked[m_remap[triangle[1]]] = locked[m_remap[triangle[2]]] = 1;
+                    }
+                    largest = std::max(largest, collapse.error);
+                    removed += m_kind[collapse.from] == BORDER ? 1 : 2;
+                    ++performed;
+                }
+                if (performed == 0) {
+                    break;
+                }
+
+                size_t written = 0;
+                for (size_t i = 0; i < indexCount; i += 3) {
+                    const unsigned int a = collapseRemap[indices[i]];
+                    const unsigned int b = collapseRemap[indices[i + 1]];
+                    const unsigned int c = collapseRemap[indices[i + 2]];
+                    if (a != b && a != c && b != c) {
+                        indices[written++] = a;
+                        indices[written++] = b;
+                        indices[written++] = c;
+                    }
+                }
+                indexCount = written;
+                remapLoops(m_loop, collapseRemap);
+                remapLoops(m_loopBack, collapseRemap);
+            }
+
+            error = std::sqrt(largest);
+            return indexCount;
+        }
+
+    private:
+        const float *position(uint32_t vertex) const { return m_positions + size_t(vertex) * 3; }
+
+        static size_t dropDegenerate(unsigned int *indices, size_t indexCount)
+        {
+            size_t written = 0;
+            for (size_t i = 0; i + 2 < indexCount; i += 3) {
+                const unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (a != b && a != c && b != c) {
+                    indices[written++] = a;
+                    indices[written++] = b;
+                    indices[written++] = c;
+                }
+            }
+            return written;
+        }
+
+        // m_remap: first vertex at the same position; m_wedge: ring of all
+        // vertices at one position.
+        void buildRemap()
+        {
+            m_remap.resize(m_vertexCount);
+            m_wedge.resize(m_vertexCount);
+            std::unordered_map<PositionKey, uint32_t, PositionHash> first;
+            first.reserve(m_vertexCount);
+            for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                PositionKey key;
+                std::memcpy(key.bits, position(v), sizeof(key.bits));
+                const uint32_t canonical = first.emplace(key, v).first->second;
+                m_remap[v] = canonical;
+                m_wedge[v] = v;
+                if (canonical != v) {
+                    m_wedge[v] = m_wedge[canonical];
+                    m_wedge[canonical] = v;
+                }
+            }
+        }
+
+        void classify(const unsigned int *indices, size_t indexCount)
+        {
+            // Outgoing edges per vertex, to find the edges nobody walks back.
+            Adjacency corners;
+            std::vector<uint32_t> identity(m_vertexCount);
+            for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                identity[v] = v;
+            }
+            corners.Build(indices, indexCount, identity.data(), m_vertexCount);
+            auto hasEdge = [&](uint32_t a, uint32_t b) {
+                for (uint32_t i = corners.offsets[a]; i < corners.offsets[a + 1]; ++i) {
+                    const unsigned int *triangle = indices + size_t(corners.triangles[i]) * 3;
+                    for (uint32_t c = 0; c < 3; ++c) {
+                        if (triangle[c] == a && triangle[(c + 1) % 3] == b) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            };
+
+            // One open edge out and one in per vertex; the vertex itself when there are several.
+            m_loop.assign(m_vertexCount, NONE);
+            m_loopBack.assign(m_vertexCount, NONE);
+            for (size_t i = 0; i < indexCount; i += 3) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    const uint32_t a = indices[i + c];
+                    const uint32_t b = indices[i + (c + 1) % 3];
+                    if (!hasEdge(b, a)) {
+                        m_loop[a] = m_loop[a] == NONE ? b : a;
+                        m_loopBack[b] = m_loopBack[b] == NONE ? a : b;
+                    }
+                }
+            }
+            auto isSingle = [](uint32_t open, uint32_t vertex) { return open != NONE && open != vertex; };
+
+            m_kind.assign(m_vertexCount, LOCKED);
+            for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                if (m_remap[v] != v) {
+                    continue;
+                }
+                const uint32_t w = m_wedge[v];
+                Kind kind = LOCKED;
+                if (w == v) {
+                    if (m_loop[v] == NONE && m_loopBack[v] == NONE) {
+                        kind = MANIFOLD;
+                    } else if (isSingle(m_loop[v], v) && isSingle(m_loopBack[v], v)) {
+                        kind = m_options.lockBorders ? LOCKED : BORDER;
+                    }
+                } else if (m_wedge[w] == v) {
+                    // Two vertices at one position: a seam when each side's open edges run back along the other.
+                    if (isSingle(m_loop[v], v) && isSingle(m_loopBack[v], v) && isSingle(m_loop[w], w) &&
+                        isSingle(m_loopBack[w], w) && m_remap[m_loop[v]] == m_remap[m_loopBack[w]] &&
+                        m_remap[m_loopBack[v]] == m_remap[m_loop[w]]) {
+                        kind = SEAM;
+                    }
+                }
+                m_kind[v] = kind;
+            }
+            for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                m_kind[v] = m_kind[m_remap[v]];
+            }
+        }
+
+        // Planes of the triangles around every position, and the planes
+        // standing on the open edges so they resist being bent or shortened.
+        void buildQuadrics(const unsigned int *indices, size_t indexCount)
+        {
+            m_quadrics.assign(m_vertexCount, Quadric{});
+            for (size_t i = 0; i < indexCount; i += 3) {
+                const float *p[3] = {position(indices[i]), position(indices[i + 1]), position(indices[i + 2])};
+                double normal[3];
+                triangleNormal(p[0], p[1], p[2], normal);
+                const double length = std::sqrt(dot(normal, normal));
+                if (length <= 0.0) {
+                    continue;
+                }
+                for (double &value : normal) {
+                    value /= length;
+                }
+                const double p0[3] = {p[0][0], p[0][1], p[0][2]};
+                const double d = -dot(normal, p0);
+                for (uint32_t c = 0; c < 3; ++c) {
+                    m_quadrics[m_remap[indices[i + c]]].AddPlane(normal, d, length * 0.5);
+                }
+
+                for (uint32_t c = 0; c < 3; ++c) {
+                    const uint32_t a = indices[i + c];
+                    const uint32_t b = indices[i + (c + 1) % 3];
+                    if (m_loop[a] != b) {
+                        continue;
+                    }
+                    const double edge[3] = {double(p[(c + 1) % 3][0]) - p[c][0], double(p[(c + 1) % 3][1]) - p[c][1],
+                                            double(p[(c + 1) % 3][2]) - p[c][2]};
+                    double side[3];
+                    cross(edge, normal, side);
+                    const double sideLength = std::sqrt(dot(side, side));
+                    if (sideLength <= 0.0) {
+                        continue;
+                    }
+                    for (double &value : side) {
+                        value /= sideLength;
+                    }
+                    const double start[3] = {p[c][0], p[c][1], p[c][2]};
+                    const double weight = dot(edge, edge) * EDGE_WEIGHT;
+                    m_quadrics[m_remap[a]].AddPlane(side, -dot(side, start), weight);
+                    m_quadrics[m_remap[b]].AddPlane(side, -dot(side, start), weight);
+                }
+            }
+        }
+
+        void pickCollapses(const unsigned int *indices, size_t indexCount, std::vector<Collapse> &collapses) const
+        {
+            collapses.clear();
+            for (size_t i = 0; i < indexCount; i += 3) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    const uint32_t i0 = indices[i + c];
+                    const uint32_t i1 = indices[i + (c + 1) % 3];
+                    const Kind k0 = m_kind[i0];
+                    const Kind k1 = m_kind[i1];
+                    if (m_remap[i0] == m_remap[i1]) {
+                        continue;
+                    }
+                    // Interior edges show up from both sides, take them once.
+                    if (k0 == MANIFOLD && k1 == MANIFOLD && i0 > i1) {
+                        continue;
+                    }
+                    // Along a border or seam only the edge that continues it, in either direction.
+                    if (k0 == k1 && (k0 == BORDER || k0 == SEAM) && m_loop[i0] != i1) {
+                        continue;
+                    }
+
+                    Quadric quadric = m_quadrics[m_remap[i0]];
+                    quadric.Add(m_quadrics[m_remap[i1]]);
+                    Collapse best{NONE, NONE, 0.0};
+                    if (CAN_COLLAPSE[k0][k1]) {
+                        best = Collapse{i0, i1, quadric.Error(position(i1))};
+                    }
+                    if (CAN_COLLAPSE[k1][k0]) {
+                        const double error = quadric.Error(position(i0));
+                        if (best.from == NONE || error < best.error) {
+                            best = Collapse{i1, i0, error};
+                        }
+                    }
+                    if (best.from != NONE) {
+                        collapses.push_back(best);
+                    }
+                }
+            }
+        }
+
+        // True when moving position r0 onto target turns a triangle that
+        // stays over, or flattens it to nothing.
+        bool flips(const unsigned int *indices, uint32_t r0, uint32_t r1, const float *target) const
+        {
+            for (uint32_t a = m_adjacency.offsets[r0]; a < m_adjacency.offsets[r0 + 1]; ++a) {
+                const unsigned int *triangle = indices + size_t(m_adjacency.triangles[a]) * 3;
+                const uint32_t ids[3] = {m_remap[triangle[0]], m_remap[triangle[1]], m_remap[triangle[2]]};
+                if (ids[0] == r1 || ids[1] == r1 || ids[2] == r1) {
+                    continue;   // collapses away
+                }
+                const float *before[3] = {position(triangle[0]), position(triangle[1]), position(triangle[2])};
+                const float *after[3] = {ids[0] == r0 ? target : before[0], ids[1] == r0 ? target : before[1],
+                                         ids[2] == r0 ? target : before[2]};
+                double n0[3], n1[3];
+                triangleNormal(before[0], before[1], before[2], n0);
+                triangleNormal(after[0], after[1], after[2], n1);
+                const double scale = std::sqrt(dot(n0, n0) * dot(n1, n1));
+                if (dot(n0, n0) > 0.0 && (dot(n1, n1) <= 0.0 || dot(n0, n1) < 1e-2 * scale)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Follows collapsed vertices so open edge links keep pointing at survivors.
+        void remapLoops(std::vector<uint32_t> &loop, const std::vector<uint32_t> &collapseRemap) const
+        {
+            for (uint32_t v = 0; v < m_vertexCount; ++v) {
+                const uint32_t next = loop[v];
+                if (next == NONE || next == v) {
+                    continue;
+                }
+                const uint32_t target = collapseRemap[next];
+                if (target == v) {
+                    loop[v] = loop[next] != NONE && loop[next] != next ? collapseRemap[loop[next]] : NONE;
+                } else {
+                    loop[v] = target;
+                }
+            }
+        }
+
+        const float *m_positions;
+        size_t m_vertexCount;
+        SimplifyOptions m_options;
+        std::vector<uint32_t> m_remap;
+        std::vector<uint32_t> m_wedge;
+        std::vector<uint32_t> m_loop;       // open edge leaving the vertex
+        std::vector<uint32_t> m_loopBack;   // open edge arriving at the vertex
+        std::vector<Kind> m_kind;
+        std::vector<Quadric> m_quadrics;    // per position, at its first vertex
+        Adjacency m_adjacency;              // per position, rebuilt every pass
+    };
+}
+
+size_t Resources::CPU::SimplifyMesh(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                                    const float *positions, size_t vertexCount, size_t targetIndexCount,
+                                    const SimplifyOptions &options, float *error)
+{
+    indexCount -= indexCount % 3;
+    if (destination != indices) {
+        std::copy(indices, indices + indexCount, destination);
+    }
+    if (error != nullptr) {
+        *error = 0.0f;
+    }
+    if (indexCount == 0 || vertexCount == 0) {
+        return indexCount;
+    }
+
+    Bounds bounds;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        bounds.Extend(positions + v * 3);
+    }
+    const double extent[3] = {double(bounds.max[0]) - bounds.min[0], double(bounds.max[1]) - bounds.min[1],
+                              double(bounds.max[2]) - bounds.min[2]};
+    const double diagonal = std::sqrt(dot(extent, extent));
+
+    double largest = 0.0;
+    Simplifier simplifier(positions, vertexCount, options);
+    const size_t count = simplifier.Run(destination, indexCount, targetIndexCount, options.maxError * diagonal, largest);
+    if (error != nullptr) {
+        *error = static_cast<float>(largest);
+    }
+    return count;
+}
+
+void Resources::CPU::GenerateLods(SponzaShape::Shape &shape, const LodOptions &options, LodStats *stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+    shape.lods.clear();
+    if (stats != nullptr) {
+        *stats = LodStats{};
+        stats->name = shape.name;
+        stats->triangleCounts.push_back(shape.indicies.size() / 3);
+        stats->errors.push_back(0.0f);
+    }
+
+    std::vector<float> positions;
+    const size_t indexCount = shape.indicies.size() - shape.indicies.size() % 3;
+    if (indexCount > 0 && ShapePositions(shape, positions)) {
+        const uint32_t levels = std::min(options.levelCount, MAX_MESH_LODS - 1);
+        std::vector<unsigned int> simplified(indexCount);
+        size_t previous = indexCount;
+        double target = static_cast<double>(indexCount / 3);
+        for (uint32_t level = 0; level < levels; ++level) {
+            target *= options.reduction;
+            float error = 0.0f;
+            const size_t count = SimplifyMesh(simplified.data(), shape.indicies.data(), indexCount, positions.data(),
+                                              shape.vertexCount, static_cast<size_t>(target) * 3, options.simplify,
+                                              &error);
+            if (count == 0 || count > options.minReduction * previous) {
+                break;
+            }
+            MeshLod lod;
+            lod.indices.resize(count);
+            OptimizeVertexCache(lod.indices.data(), simplified.data(), count, shape.vertexCount);
+            lod.error = error;
+            shape.lods.push_back(std::move(lod));
+            previous = count;
+            if (stats != nullptr) {
+                stats->triangleCounts.push_back(count / 3);
+                stats->errors.push_back(error);
+            }
+        }
+    }
+
+    if (stats != nullptr) {
+        stats->milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void Resources::CPU::GenerateLods(SponzaShape &sponza, const LodOptions &options, unsigned threadCount,
+                                  std::vector<LodStats> *stats)
+{
+    if (stats != nullptr) {
+        stats->assign(sponza.shapes.size(), LodStats{});
+    }
+    ParallelFor(sponza.shapes.size(), ResolveThreads(threadCount), [&](size_t i) {
+        GenerateLods(sponza.shapes[i], options, stats != nullptr ? &(*stats)[i] : nullptr);
+    });
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Quadric error metric edge collapse (Garland and Heckbert 1997) over an
+// index buffer, in the style of meshoptimizer's simplifier: vertices only
+// ever collapse onto a neighbour, so every level of detail indexes the
+// vertex buffer of the full mesh and needs no vertex data of its own.
+//
+// Vertices are classified once from the full mesh. Those on a UV or normal
+// seam, two welded vertices at one position with their open edges paired up,
+// collapse only along the seam and take their twin with them, so both sides
+// stay stitched. Open borders are where a shape meets the next material and
+// are locked unless asked otherwise; anything stranger is locked too.
+namespace Resources::CPU
+{
+    struct SimplifyOptions
+    {
+        // Largest distance a collapse may move the surface, as a share of
+        // the diagonal of the mesh bounds.
+        float maxError{0.01f};
+        // Keeps open borders exactly in place: shapes are one material each,
+        // so their borders are the material borders the next shape meets.
+        bool lockBorders{true};
+    };
+
+    // Writes at most indexCount simplified indices to destination, which may
+    // be indices itself, and returns how many. Stops at targetIndexCount or
+    // when the next collapse would exceed the error limit. error, if given,
+    // gets the largest distance the surface moved, in mesh units.
+    size_t SimplifyMesh(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                        const float *positions, size_t vertexCount, size_t targetIndexCount,
+                        const SimplifyOptions &options = {}, float *error = nullptr);
+
+    struct LodOptions
+    {
+        // Levels after the full one, each aiming at reduction times the
+        // triangles of the one before, at most MAX_MESH_LODS - 1.
+        uint32_t levelCount{3};
+        float reduction{0.5f};
+        // A level that keeps more than this share of the level before is
+        // not worth its memory and ends the chain.
+        float minReduction{0.9f};
+        SimplifyOptions simplify{0.02f, true};
+    };
+
+    struct LodStats
+    {
+        std::string name;
+        std::vector<size_t> triangleCounts;     // full detail first
+        std::vector<float> errors;              // mesh units, 0 for full detail
+        double milliseconds{0.0};
+    };
+
+    // Fills shape.lods from the full detail indices, every level simplified
+    // from the full mesh so its error is measured against it, then put in
+    // post-transform cache order.
+    void GenerateLods(SponzaShape::Shape &shape, const LodOptions &options = {}, LodStats *stats = nullptr);
+
+    // One shape per thread, threadCount 0 picks the hardware concurrency.
+    // stats, if given, gets one entry per shape in shape order.
+    void GenerateLods(SponzaShape &sponza, const LodOptions &options = {}, unsigned threadCount = 0,
+                      std::vector<LodStats> *stats = nullptr);
+}
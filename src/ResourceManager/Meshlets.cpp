@@ -0,0 +1,281 @@
+#include "Meshlets.hpp"
+
+#include "MeshOptimizer.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint32_t NO_LOCAL = 0xffffffffu;
+
+    inline float dot(const float *a, const float *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    inline float distance(const float *a, const float *b)
+    {
+        const float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+        return std::sqrt(dot(d, d));
+    }
+
+    inline void normalize(float *v)
+    {
+        const float length = std::sqrt(dot(v, v));
+        if (length > 0.0f) {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    inline void cross(const float *a, const float *b, float *out)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // Ritter's sphere: start from the most distant pair of axis extremes and
+    // grow to take in every point outside.
+    void boundingSphere(const float *positions, const uint32_t *vertices, uint32_t count, MeshletBounds &bounds)
+    {
+        uint32_t extremes[6] = {vertices[0], vertices[0], vertices[0], vertices[0], vertices[0], vertices[0]};
+        for (uint32_t i = 1; i < count; ++i) {
+            const float *p = positions + size_t(vertices[i]) * 3;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (p[axis] < positions[size_t(extremes[axis * 2]) * 3 + axis]) {
+                    extremes[axis * 2] = vertices[i];
+                }
+                if (p[axis] > positions[size_t(extremes[axis * 2 + 1]) * 3 + axis]) {
+                    extremes[axis * 2 + 1] = vertices[i];
+                }
+            }
+        }
+
+        int widest = 0;
+        float widestDistance = -1.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float d = distance(positions + size_t(extremes[axis * 2]) * 3,
+                                     positions + size_t(extremes[axis * 2 + 1]) * 3);
+            if (d > widestDistance) {
+                widestDistance = d;
+                widest = axis;
+            }
+        }
+        const float *a = positions + size_t(extremes[widest * 2]) * 3;
+        const float *b = positions + size_t(extremes[widest * 2 + 1]) * 3;
+        float center[3] = {(a[0] + b[0]) * 0.5f, (a[1] + b[1]) * 0.5f, (a[2] + b[2]) * 0.5f};
+        float radius = widestDistance * 0.5f;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const float *p = positions + size_t(vertices[i]) * 3;
+            const float d = distance(p, center);
+            if (d > radius) {
+                const float grown = (radius + d) * 0.5f;
+                const float shift = (grown - radius) / d;
+                for (int axis = 0; axis < 3; ++axis) {
+                    center[axis] += (p[axis] - center[axis]) * shift;
+                }
+                radius = grown;
+            }
+        }
+
+        std::copy(center, center + 3, bounds.center);
+        // Rounding in the growth steps can leave a point a hair outside.
+        bounds.radius = radius * (1.0f + 1e-5f) + 1e-7f;
+    }
+
+    // Cone around the mean normal that holds every triangle normal; left at
+    // cutoff 1 when the triangles face more than a hemisphere apart.
+    void normalCone(const float *positions, const uint32_t *vertices, const uint32_t *triangles, uint32_t count,
+                    MeshletBounds &bounds)
+    {
+        std::vector<float> normals;
+        normals.reserve(size_t(count) * 3);
+        float axis[3] = {0.0f, 0.0f, 0.0f};
+        for (uint32_t t = 0; t < count; ++t) {
+            const uint32_t packed = triangles[t];
+            const float *p0 = positions + size_t(vertices[packed & 0xff]) * 3;
+            const float *p1 = positions + size_t(vertices[(packed >> 8) & 0xff]) * 3;
+            const float *p2 = positions + size_t(vertices[(packed >> 16) & 0xff]) * 3;
+            const float e0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float normal[3];
+            cross(e0, e1, normal);
+            if (dot(normal, normal) <= 0.0f) {
+                continue;   // degenerate, faces nowhere
+            }
+            normalize(normal);
+            normals.insert(normals.end(), normal, normal + 3);
+            for (int i = 0; i < 3; ++i) {
+                axis[i] += normal[i];
+            }
+        }
+
+        bounds.cutoff = 1.0f;
+        if (normals.empty() || dot(axis, axis) <= 0.0f) {
+            return;
+        }
+        normalize(axis);
+        float minimum = 1.0f;
+        for (size_t n = 0; n < normals.size(); n += 3) {
+            minimum = std::min(minimum, dot(axis, &normals[n]));
+        }
+        std::copy(axis, axis + 3, bounds.axis);
+        if (minimum > 0.0f) {
+            bounds.cutoff = std::sqrt(std::max(0.0f, 1.0f - minimum * minimum));
+        }
+    }
+}
+
+void Resources::CPU::BuildMeshlets(SponzaShape::Shape &shape)
+{
+    shape.meshlets.clear();
+    shape.meshletBounds.clear();
+    shape.meshletVertices.clear();
+    shape.meshletTriangles.clear();
+
+    std::vector<float> positions;
+    const size_t triangleCount = shape.indicies.size() / 3;
+    if (triangleCount == 0 || !ShapePositions(shape, positions)) {
+        return;
+    }
+
+    std::vector<uint32_t> local(shape.vertexCount, NO_LOCAL);
+    Meshlet meshlet;
+
+    auto finish = [&]() {
+        if (meshlet.triangleCount == 0) {
+            return;
+        }
+        const uint32_t *vertices = shape.meshletVertices.data() + meshlet.firstVertex;
+        MeshletBounds bounds;
+        boundingSphere(positions.data(), vertices, meshlet.vertexCount, bounds);
+        normalCone(positions.data(), vertices, shape.meshletTriangles.data() + meshlet.firstTriangle,
+                   meshlet.triangleCount, bounds);
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v) {
+            local[vertices[v]] = NO_LOCAL;
+        }
+        shape.meshlets.push_back(meshlet);
+        shape.meshletBounds.push_back(bounds);
+
+        meshlet = Meshlet{};
+        meshlet.firstVertex = static_cast<uint32_t>(shape.meshletVertices.size());
+        meshlet.firstTriangle = static_cast<uint32_t>(shape.meshletTriangles.size());
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const unsigned int *triangle = &shape.indicies[t * 3];
+        uint32_t added = 0;
+        for (uint32_t c = 0; c < 3; ++c) {
+            const bool repeated = (c > 0 && triangle[c] == triangle[0]) || (c > 1 && triangle[c] == triangle[1]);
+            added += local[triangle[c]] == NO_LOCAL && !repeated ? 1 : 0;
+        }
+        if (meshlet.vertexCount + added > MAX_MESHLET_VERTICES || meshlet.triangleCount == MAX_MESHLET_TRIANGLES) {
+            finish();
+        }
+
+        uint32_t packed = 0;
+        for (uint32_t c = 0; c < 3; ++c) {
+            uint32_t &index = local[triangle[c]];
+            if (index == NO_LOCAL) {
+                index = meshlet.vertexCount++;
+                shape.meshletVertices.push_back(triangle[c]);
+            }
+            packed |= index << (c * 8);
+        }
+        shape.meshletTriangles.push_back(packed);
+        ++meshlet.triangleCount;
+    }
+    finish();
+}
+
+void Resources::CPU::BuildMeshlets(SponzaShape &sponza, unsigned threadCount)
+{
+    ParallelFor(sponza.shapes.size(), ResolveThreads(threadCount), [&sponza](size_t i) {
+        BuildMeshlets(sponza.shapes[i]);
+    });
+}
+
+CullView Resources::CPU::MakeCullView(const float *eye, const float *forward, const float *up, float verticalFov,
+                                      float aspect, float nearZ, float farZ)
+{
+    float f[3] = {forward[0], forward[1], forward[2]};
+    normalize(f);
+    float r[3];
+    cross(f, up, r);
+    normalize(r);
+    float u[3];
+    cross(r, f, u);
+
+    const float halfY = verticalFov * 0.5f;
+    const float halfX = std::atan(std::tan(halfY) * aspect);
+    const float sinY = std::sin(halfY), cosY = std::cos(halfY);
+    const float sinX = std::sin(halfX), cosX = std::cos(halfX);
+
+    CullView view;
+    std::copy(eye, eye + 3, view.eye);
+    auto setPlane = [&view, eye](int plane, const float *normal, float w) {
+        std::copy(normal, normal + 3, view.planes[plane]);
+        view.planes[plane][3] = w - dot(normal, eye);
+    };
+
+    // Side planes pass through the eye; a point straight ahead is inside all four.
+    const float left[3] = {f[0] * sinX + r[0] * cosX, f[1] * sinX + r[1] * cosX, f[2] * sinX + r[2] * cosX};
+    const float right[3] = {f[0] * sinX - r[0] * cosX, f[1] * sinX - r[1] * cosX, f[2] * sinX - r[2] * cosX};
+    const float bottom[3] = {f[0] * sinY + u[0] * cosY, f[1] * sinY + u[1] * cosY, f[2] * sinY + u[2] * cosY};
+    const float top[3] = {f[0] * sinY - u[0] * cosY, f[1] * sinY - u[1] * cosY, f[2] * sinY - u[2] * cosY};
+    const float back[3] = {-f[0], -f[1], -f[2]};
+    setPlane(0, left, 0.0f);
+    setPlane(1, right, 0.0f);
+    setPlane(2, bottom, 0.0f);
+    setPlane(3, top, 0.0f);
+    setPlane(4, f, -nearZ);
+    setPlane(5, back, farZ);
+    return view;
+}
+
+bool Resources::CPU::IsVisible(const CullView &view, const Bounds &bounds)
+{
+    if (bounds.IsEmpty()) {
+        return false;
+    }
+    // Only the corner furthest along each plane normal has to be inside.
+    for (const float *plane : view.planes) {
+        float distance = plane[3];
+        for (int i = 0; i < 3; ++i) {
+            distance += plane[i] * (plane[i] >= 0.0f ? bounds.max[i] : bounds.min[i]);
+        }
+        if (distance < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Resources::CPU::IsVisible(const CullView &view, const MeshletBounds &bounds)
+{
+    for (const float *plane : view.planes) {
+        if (dot(plane, bounds.center) + plane[3] < -bounds.radius) {
+            return false;
+        }
+    }
+    const float toCenter[3] = {bounds.center[0] - view.eye[0], bounds.center[1] - view.eye[1],
+                               bounds.center[2] - view.eye[2]};
+    const float length = std::sqrt(dot(toCenter, toCenter));
+    return dot(toCenter, bounds.axis) < bounds.cutoff * length + bounds.radius * (1.0f + bounds.cutoff);
+}
+
+size_t Resources::CPU::CullMeshlets(const CullView &view, const MeshletBounds *bounds, size_t count, uint32_t *visible)
+{
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (IsVisible(view, bounds[i])) {
+            visible[visibleCount++] = static_cast<uint32_t>(i);
+        }
+    }
+    return visibleCount;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Meshlets for cluster culling: each shape is cut into runs of consecutive
+// triangles that fit the vertex and triangle limits, so the cache ordered
+// indices of the mesh optimizer give compact, mostly flat clusters. Every
+// meshlet carries a bounding sphere and a normal cone; the CPU culling below
+// uses the same tests a culling compute shader would.
+namespace Resources::CPU
+{
+    // Fills the meshlet arrays of the shape from its indices and positions.
+    // Leaves them empty when the shape has no positions.
+    void BuildMeshlets(SponzaShape::Shape &shape);
+
+    // One shape per thread, threadCount 0 picks the hardware concurrency.
+    void BuildMeshlets(SponzaShape &sponza, unsigned threadCount = 0);
+
+    // Six inward facing planes, xyz normal and w distance, and the eye they
+    // were made from. A point p is inside when dot(xyz, p) + w >= 0 for all.
+    struct CullView
+    {
+        float planes[6][4]{};
+        float eye[3]{0.0f, 0.0f, 0.0f};
+    };
+
+    // Perspective view looking along forward; verticalFov is in radians and
+    // aspect is width over height.
+    CullView MakeCullView(const float *eye, const float *forward, const float *up, float verticalFov, float aspect,
+                          float nearZ, float farZ);
+
+    bool IsVisible(const CullView &view, const Bounds &bounds);
+    // Sphere against the frustum, then the normal cone against the eye.
+    bool IsVisible(const CullView &view, const MeshletBounds &bounds);
+
+    // Writes the numbers of the meshlets that pass to visible, returns how many.
+    size_t CullMeshlets(const CullView &view, const MeshletBounds *bounds, size_t count, uint32_t *visible);
+}
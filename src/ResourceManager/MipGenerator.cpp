@@ -0,0 +1,416 @@
+#include "MipGenerator.hpp"
+
+#include "CpuFeatures.hpp"
+#include "Parallel.hpp"
+#include "TextScan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#if CHELSON_X86
+#include <immintrin.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr float KAISER_WIDTH = 3.0f;  // lobes on each side, in destination texels
+    constexpr float KAISER_ALPHA = 4.0f;
+    constexpr uint32_t ROWS_PER_BAND = 16;
+    constexpr uint32_t COVERAGE_STEPS = 12;
+
+    // One level in float. Filtering happens here so every level is made from
+    // full precision data, not from the 8-bit result of the level above.
+    struct Plane
+    {
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t channels{0};
+        std::vector<float> texels;
+
+        float *Row(uint32_t y) { return texels.data() + size_t(y) * width * channels; }
+        const float *Row(uint32_t y) const { return texels.data() + size_t(y) * width * channels; }
+    };
+
+    // Separable filter weights: output i reads source indices
+    // indices[offsets[i] .. offsets[i + 1]), already clamped to the edge.
+    struct Taps
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    using VerticalKernel = void (*)(const float *const *rows, const float *weights, uint32_t count, float *out, size_t n);
+    using HorizontalKernel = void (*)(const float *in, const Taps &taps, uint32_t width, float *out);
+
+    float srgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    struct SrgbTables
+    {
+        static constexpr size_t ENCODE_SIZE = 65536;
+
+        float decode[256];
+        uint8_t encode[ENCODE_SIZE];
+
+        SrgbTables()
+        {
+            for (int i = 0; i < 256; ++i) {
+                decode[i] = srgbToLinear(i / 255.0f);
+            }
+            // Fine enough that every one of the 256 sRGB codes is reachable,
+            // including the dark end where the curve is steepest.
+            for (size_t i = 0; i < ENCODE_SIZE; ++i) {
+                encode[i] = static_cast<uint8_t>(linearToSrgb(i / float(ENCODE_SIZE - 1)) * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const SrgbTables &srgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12) {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    double kaiser(double x)
+    {
+        const double t = x / KAISER_WIDTH;
+        if (std::abs(t) >= 1.0) {
+            return 0.0;
+        }
+        const double sinc = x == 0.0 ? 1.0 : std::sin(3.14159265358979323846 * x) / (3.14159265358979323846 * x);
+        return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / besselI0(KAISER_ALPHA);
+    }
+
+    Taps buildTaps(uint32_t sourceSize, uint32_t targetSize, MipFilter filter)
+    {
+        Taps taps;
+        taps.offsets.reserve(targetSize + 1);
+        taps.offsets.push_back(0);
+        const double scale = double(sourceSize) / targetSize;
+        const double radius = filter == MipFilter::Box ? scale * 0.5 : KAISER_WIDTH * scale;
+        for (uint32_t i = 0; i < targetSize; ++i) {
+            const double center = (i + 0.5) * scale;
+            const int64_t first = static_cast<int64_t>(std::floor(center - radius));
+            const int64_t last = static_cast<int64_t>(std::ceil(center + radius));
+            const size_t begin = taps.weights.size();
+            double total = 0.0;
+            for (int64_t s = first; s < last; ++s) {
+                double weight;
+                if (filter == MipFilter::Box) {
+                    weight = std::min<double>(s + 1, center + radius) - std::max<double>(s, center - radius);
+                } else {
+                    weight = kaiser((s + 0.5 - center) / scale);
+                }
+                if (weight == 0.0) {
+                    continue;
+                }
+                taps.indices.push_back(static_cast<uint32_t>(std::clamp<int64_t>(s, 0, sourceSize - 1)));
+                taps.weights.push_back(static_cast<float>(weight));
+                total += weight;
+            }
+            for (size_t k = begin; k < taps.weights.size(); ++k) {
+                taps.weights[k] = static_cast<float>(taps.weights[k] / total);
+            }
+            taps.offsets.push_back(static_cast<uint32_t>(taps.weights.size()));
+        }
+        return taps;
+    }
+
+    // All kernels accumulate in tap order with separate multiply and add, so
+    // every SIMD level produces the same bits as the scalar one.
+    void verticalScalar(const float *const *rows, const float *weights, uint32_t count, float *out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            float sum = rows[0][i] * weights[0];
+            for (uint32_t k = 1; k < count; ++k) {
+                sum += rows[k][i] * weights[k];
+            }
+            out[i] = sum;
+        }
+    }
+
+    template<uint32_t CHANNELS>
+    void horizontalScalar(const float *in, const Taps &taps, uint32_t width, float *out)
+    {
+        for (uint32_t x = 0; x < width; ++x, out += CHANNELS) {
+            const uint32_t first = taps.offsets[x];
+            const uint32_t last = taps.offsets[x + 1];
+            for (uint32_t c = 0; c < CHANNELS; ++c) {
+                float sum = in[taps.indices[first] * CHANNELS + c] * taps.weights[first];
+                for (uint32_t k = first + 1; k < last; ++k) {
+                    sum += in[taps.indices[k] * CHANNELS + c] * taps.weights[k];
+                }
+                out[c] = sum;
+            }
+        }
+    }
+
+#if CHELSON_X86
+    CHELSON_TARGET_AVX2 void verticalAvx2(const float *const *rows, const float *weights, uint32_t count, float *out,
+                                          size_t n)
+    {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 sum = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), _mm256_set1_ps(weights[0]));
+            for (uint32_t k = 1; k < count; ++k) {
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k])));
+            }
+            _mm256_storeu_ps(out + i, sum);
+        }
+        for (; i < n; ++i) {
+            float sum = rows[0][i] * weights[0];
+            for (uint32_t k = 1; k < count; ++k) {
+                sum += rows[k][i] * weights[k];
+            }
+            out[i] = sum;
+        }
+    }
+
+    // An RGBA texel is exactly one register, so taps are gathered texel-wise.
+    CHELSON_TARGET_SSSE3 void horizontalRgbaSse(const float *in, const Taps &taps, uint32_t width, float *out)
+    {
+        for (uint32_t x = 0; x < width; ++x, out += 4) {
+            const uint32_t first = taps.offsets[x];
+            const uint32_t last = taps.offsets[x + 1];
+            __m128 sum = _mm_mul_ps(_mm_loadu_ps(in + taps.indices[first] * 4), _mm_set1_ps(taps.weights[first]));
+            for (uint32_t k = first + 1; k < last; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in + taps.indices[k] * 4), _mm_set1_ps(taps.weights[k])));
+            }
+            _mm_storeu_ps(out, sum);
+        }
+    }
+#endif
+
+    VerticalKernel pickVertical()
+    {
+#if CHELSON_X86
+        if (ActiveSimdLevel() >= SimdLevel::Avx2) {
+            return &verticalAvx2;
+        }
+#endif
+        return &verticalScalar;
+    }
+
+    HorizontalKernel pickHorizontal(uint32_t channels)
+    {
+        if (channels == 1) {
+            return &horizontalScalar<1>;
+        }
+#if CHELSON_X86
+        if (ActiveSimdLevel() >= SimdLevel::Ssse3) {
+            return &horizontalRgbaSse;
+        }
+#endif
+        return &horizontalScalar<4>;
+    }
+
+    uint8_t toUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    void toPlane(const Image &image, bool srgb, Plane &plane)
+    {
+        plane.width = image.width;
+        plane.height = image.height;
+        plane.channels = BytesPerPixel(image.format);
+        plane.texels.resize(size_t(plane.width) * plane.height * plane.channels);
+        const float *decode = srgbTables().decode;
+        const uint8_t *bytes = image.pixels.Data.get();
+        for (size_t i = 0; i < plane.texels.size(); ++i) {
+            const bool isColor = srgb && plane.channels == 4 && i % 4 != 3;
+            plane.texels[i] = isColor ? decode[bytes[i]] : bytes[i] * (1.0f / 255.0f);
+        }
+    }
+
+    void toImage(const Plane &plane, bool srgb, uint32_t alphaChannel, float alphaScale, Image &image)
+    {
+        image.width = plane.width;
+        image.height = plane.height;
+        image.format = plane.channels == 1 ? PixelFormat::R8 : PixelFormat::RGBA8;
+        image.pixels.Allocate(plane.texels.size());
+        const uint8_t *encode = srgbTables().encode;
+        uint8_t *bytes = image.pixels.Data.get();
+        for (size_t i = 0; i < plane.texels.size(); ++i) {
+            const uint32_t channel = static_cast<uint32_t>(i % plane.channels);
+            float value = plane.texels[i];
+            if (channel == alphaChannel) {
+                value *= alphaScale;
+            }
+            const bool isColor = srgb && plane.channels == 4 && channel != 3;
+            if (isColor) {
+                value = std::clamp(value, 0.0f, 1.0f) * (SrgbTables::ENCODE_SIZE - 1) + 0.5f;
+                bytes[i] = encode[static_cast<size_t>(value)];
+            } else {
+                bytes[i] = toUnorm(value);
+            }
+        }
+    }
+
+    // Share of texels passing the alpha test once scaled and stored as 8 bits,
+    // which is what the shader will compare against the cutoff.
+    float coverage(const Plane &plane, uint32_t channel, float scale, float cutoff)
+    {
+        size_t passing = 0;
+        const size_t count = size_t(plane.width) * plane.height;
+        for (size_t i = 0; i < count; ++i) {
+            passing += toUnorm(plane.texels[i * plane.channels + channel] * scale) > cutoff * 255.0f ? 1 : 0;
+        }
+        return count > 0 ? float(passing) / count : 0.0f;
+    }
+
+    // Finds the alpha scale that makes the level pass the cutoff as often as
+    // the top level does: search the threshold with the same coverage, the
+    // scale maps it onto the cutoff.
+    float coverageScale(const Plane &plane, uint32_t channel, float cutoff, float target)
+    {
+        float low = 0.0f;
+        float high = 1.0f;
+        for (uint32_t step = 0; step < COVERAGE_STEPS; ++step) {
+            const float middle = 0.5f * (low + high);
+            if (coverage(plane, channel, cutoff / middle, cutoff) > target) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        // Coverage moves in steps, take whichever side of the last one is closer.
+        const float lowScale = low > 0.0f ? cutoff / low : 1.0f;
+        const float highScale = cutoff / high;
+        const float lowError = std::abs(coverage(plane, channel, lowScale, cutoff) - target);
+        const float highError = std::abs(coverage(plane, channel, highScale, cutoff) - target);
+        return lowError < highError ? lowScale : highScale;
+    }
+
+    void downsample(const Plane &source, const Taps &horizontal, const Taps &vertical, unsigned threadCount,
+                    Plane &target)
+    {
+        const VerticalKernel verticalKernel = pickVertical();
+        const HorizontalKernel horizontalKernel = pickHorizontal(source.channels);
+        const size_t rowSize = size_t(source.width) * source.channels;
+        const uint32_t bands = (target.height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+
+        ParallelFor(bands, threadCount, [&](size_t band) {
+            // Vertical pass first: it runs over whole rows and halves the rows
+            // the gathering horizontal pass has to touch.
+            std::vector<float> scratch(rowSize);
+            std::vector<const float *> rows;
+            const uint32_t end = std::min<uint32_t>(target.height, static_cast<uint32_t>(band + 1) * ROWS_PER_BAND);
+            for (uint32_t y = static_cast<uint32_t>(band) * ROWS_PER_BAND; y < end; ++y) {
+                const uint32_t first = vertical.offsets[y];
+                const uint32_t count = vertical.offsets[y + 1] - first;
+                rows.clear();
+                for (uint32_t k = 0; k < count; ++k) {
+                    rows.push_back(source.Row(vertical.indices[first + k]));
+                }
+                verticalKernel(rows.data(), vertical.weights.data() + first, count, scratch.data(), rowSize);
+                horizontalKernel(scratch.data(), horizontal, target.width, target.Row(y));
+            }
+        });
+    }
+}
+
+MipOptions Resources::CPU::MipOptionsForTexture(std::string_view path)
+{
+    const std::string_view name = Text::StemOf(path);
+    auto endsWith = [name](std::string_view suffix) { return Text::EndsWithNoCase(name, suffix); };
+
+    MipOptions options;
+    options.srgb = endsWith("_diffuse") || endsWith("_albedo") || endsWith("_basecolor");
+    options.preserveAlphaCoverage = endsWith("_mask");
+    return options;
+}
+
+uint32_t Resources::CPU::MipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+bool Resources::CPU::GenerateMips(const Image &source, const MipOptions &options, MipChain &chain)
+{
+    if (source.width == 0 || source.height == 0 || source.pixels.Size != source.RowPitch() * source.height) {
+        return false;
+    }
+
+    const uint32_t levelCount = MipLevelCount(source.width, source.height);
+    chain.levels.resize(levelCount);
+    Image &top = chain.levels[0];
+    top.width = source.width;
+    top.height = source.height;
+    top.format = source.format;
+    top.pixels.Allocate(source.pixels.Size);
+    std::memcpy(top.pixels.Data.get(), source.pixels.Data.get(), source.pixels.Size);
+
+    const unsigned threadCount = ResolveThreads(options.threadCount);
+    Plane current;
+    Plane next;
+    toPlane(source, options.srgb, current);
+    const uint32_t alphaChannel = options.preserveAlphaCoverage ? current.channels - 1 : UINT32_MAX;
+    const float targetCoverage = options.preserveAlphaCoverage ? coverage(current, alphaChannel, 1.0f, options.alphaCutoff) : 0.0f;
+
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        next.width = std::max(1u, current.width >> 1);
+        next.height = std::max(1u, current.height >> 1);
+        next.channels = current.channels;
+        next.texels.resize(size_t(next.width) * next.height * next.channels);
+        const Taps horizontal = buildTaps(current.width, next.width, options.filter);
+        const Taps vertical = buildTaps(current.height, next.height, options.filter);
+        downsample(current, horizontal, vertical, threadCount, next);
+
+        const float alphaScale = options.preserveAlphaCoverage
+                                     ? coverageScale(next, alphaChannel, options.alphaCutoff, targetCoverage)
+                                     : 1.0f;
+        toImage(next, options.srgb, alphaChannel, alphaScale, chain.levels[level]);
+        std::swap(current, next);
+    }
+    return true;
+}
+
+bool Resources::CPU::GenerateMips(const std::vector<const Image *> &sources, const std::vector<MipOptions> &options,
+                                  std::vector<MipChain> &chains, unsigned threadCount)
+{
+    if (options.size() != sources.size()) {
+        return false;
+    }
+    chains.resize(sources.size());
+    std::atomic<bool> succeeded{true};
+    ParallelFor(sources.size(), ResolveThreads(threadCount), [&](size_t i) {
+        MipOptions single = options[i];
+        single.threadCount = 1;
+        if (!GenerateMips(*sources[i], single, chains[i])) {
+            succeeded = false;
+        }
+    });
+    return succeeded;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace Resources::CPU
+{
+    enum class MipFilter : uint32_t
+    {
+        Box,    // area average, exact for power of two sizes
+        Kaiser  // Kaiser windowed sinc, sharper at distance
+    };
+
+    struct MipOptions
+    {
+        MipFilter filter{MipFilter::Box};
+        // Color channels are stored as sRGB and filtered in linear space. Alpha
+        // (and R8 images) are always treated as linear data.
+        bool srgb{false};
+        // Rescales alpha per level so the share of texels passing the alpha
+        // test stays what it is in the top level; keeps masked foliage from
+        // thinning out in the distance. Uses channel 0 of R8 images.
+        bool preserveAlphaCoverage{false};
+        float alphaCutoff{0.5f};
+        // Threads splitting the rows of each level, 0 picks the hardware concurrency.
+        unsigned threadCount{0};
+    };
+
+    // levels[0] is a copy of the source, each further level halves both
+    // sizes (rounding down, never below 1) until 1x1.
+    struct MipChain
+    {
+        std::vector<Image> levels;
+    };
+
+    // Picks the options the texture set expects from the file name:
+    // *_diffuse / *_albedo / *_basecolor are sRGB, *_mask keeps alpha coverage.
+    MipOptions MipOptionsForTexture(std::string_view path);
+
+    bool GenerateMips(const Image &source, const MipOptions &options, MipChain &chain);
+
+    // Generates chains for many textures, one texture per thread; the inner
+    // row split is disabled so the machine is not oversubscribed.
+    bool GenerateMips(const std::vector<const Image *> &sources, const std::vector<MipOptions> &options,
+                      std::vector<MipChain> &chains, unsigned threadCount = 0);
+
+    uint32_t MipLevelCount(uint32_t width, uint32_t height);
+}
@@ -0,0 +1,643 @@
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+#include "MaterialCompiler.hpp"
+#include "MeshOptimizer.hpp"
+#include "Parallel.hpp"
+#include "ResourceManager.hpp"
+#include "TangentSpace.hpp"
+#include "TextScan.hpp"
+#include "Triangulator.hpp"
+#include "VertexWelder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    template<size_t N>
+    inline bool parseFloats(const char *cursor, const char *end, std::vector<float> &out)
+    {
+        float values[N];
+        for (size_t i = 0; i < N; ++i) {
+            Text::SkipBlanks(cursor, end);
+            if (!Text::ParseFloat(cursor, end, values[i])) {
+                return false;
+            }
+        }
+        out.insert(out.end(), values, values + N);
+        return true;
+    }
+
+    constexpr uint8_t RELATIVE_POSITION = 1 << 0;
+    constexpr uint8_t RELATIVE_TEXCOORD = 1 << 1;
+    constexpr uint8_t RELATIVE_NORMAL = 1 << 2;
+
+    // Chunks smaller than this are not worth a thread.
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    // o/g/usemtl/mtllib statement in file order. A chunk cannot know which group
+    // it starts in, so groups are rebuilt from these after all chunks are parsed.
+    struct Statement
+    {
+        enum class Kind { Group, Material, Library };
+
+        Kind kind;
+        std::string_view text;
+        uint32_t face;  // chunk-local face count when the statement was seen
+    };
+
+    // Corner that used negative indices, stored relative to the chunk start.
+    struct RelativeCorner
+    {
+        uint32_t corner;
+        uint8_t attributes;  // RELATIVE_* bits
+    };
+
+    struct Chunk
+    {
+        std::string_view text;
+        Obj::Data data;  // only the attribute, corner and face arrays are used
+        std::vector<Statement> statements;
+        std::vector<RelativeCorner> relativeCorners;
+        bool isValid{true};
+
+        size_t positionBase{0};
+        size_t texcoordBase{0};
+        size_t normalBase{0};
+        size_t cornerBase{0};
+        size_t faceBase{0};
+    };
+
+    class ChunkParser
+    {
+    public:
+        explicit ChunkParser(Chunk &chunk)
+            : m_chunk{chunk}
+            , m_data{chunk.data}
+        {
+        }
+
+        bool Run()
+        {
+            return Text::ForEachLine(m_chunk.text, [this](const char *cursor, const char *end) {
+                return parseLine(cursor, end);
+            });
+        }
+
+    private:
+        bool parseLine(const char *cursor, const char *end)
+        {
+            std::string_view keyword = Text::NextToken(cursor, end);
+            if (keyword.empty() || keyword[0] == '#') {
+                return true;
+            }
+
+            if (keyword == "v") {
+                return parseFloats<3>(cursor, end, m_data.positions);
+            }
+            if (keyword == "vt") {
+                // The third texture coordinate is optional and unused.
+                return parseFloats<2>(cursor, end, m_data.texcoords);
+            }
+            if (keyword == "vn") {
+                return parseFloats<3>(cursor, end, m_data.normals);
+            }
+            if (keyword == "f") {
+                return parseFace(cursor, end);
+            }
+            if (keyword == "o" || keyword == "g") {
+                addStatement(Statement::Kind::Group, Text::RestOfLine(cursor, end));
+                return true;
+            }
+            if (keyword == "usemtl") {
+                addStatement(Statement::Kind::Material, Text::RestOfLine(cursor, end));
+                return true;
+            }
+            if (keyword == "mtllib") {
+                addStatement(Statement::Kind::Library, Text::RestOfLine(cursor, end));
+                return true;
+            }
+            // s, l, p and unknown statements are ignored.
+            return true;
+        }
+
+        bool parseFace(const char *cursor, const char *end)
+        {
+            Obj::Face face;
+            face.firstCorner = static_cast<uint32_t>(m_data.corners.size());
+
+            const size_t positionCount = m_data.positions.size() / 3;
+            const size_t texcoordCount = m_data.texcoords.size() / 2;
+            const size_t normalCount = m_data.normals.size() / 3;
+
+            for (;;) {
+                Text::SkipBlanks(cursor, end);
+                if (cursor == end) {
+                    break;
+                }
+
+                Obj::Corner corner;
+                uint8_t relative = 0;
+                if (!parseIndex(cursor, end, positionCount, RELATIVE_POSITION, corner.position, relative)) {
+                    return false;
+                }
+                if (cursor < end && *cursor == '/') {
+                    ++cursor;
+                    if (cursor < end && *cursor != '/') {
+                        if (!parseIndex(cursor, end, texcoordCount, RELATIVE_TEXCOORD, corner.texcoord, relative)) {
+                            return false;
+                        }
+                    }
+                    if (cursor < end && *cursor == '/') {
+                        ++cursor;
+                        if (!parseIndex(cursor, end, normalCount, RELATIVE_NORMAL, corner.normal, relative)) {
+                            return false;
+                        }
+                    }
+                }
+                if (relative != 0) {
+                    m_chunk.relativeCorners.push_back({static_cast<uint32_t>(m_data.corners.size()), relative});
+                }
+                m_data.corners.push_back(corner);
+                ++face.cornerCount;
+            }
+
+            // Points and lines have no surface, drop them.
+            if (face.cornerCount < 3) {
+                m_data.corners.resize(face.firstCorner);
+                while (!m_chunk.relativeCorners.empty() && m_chunk.relativeCorners.back().corner >= face.firstCorner) {
+                    m_chunk.relativeCorners.pop_back();
+                }
+                return true;
+            }
+
+            m_data.faces.push_back(face);
+            return true;
+        }
+
+        // OBJ indices are 1-based and absolute, negative ones count back from the
+        // current end. Those are kept chunk-relative until the chunk base is known.
+        bool parseIndex(const char *&cursor, const char *end, size_t count, uint8_t relativeBit,
+                        int32_t &index, uint8_t &relative)
+        {
+            int64_t raw = 0;
+            if (!Text::ParseInt(cursor, end, raw) || raw == 0) {
+                return false;
+            }
+            int64_t resolved = raw > 0 ? raw - 1 : static_cast<int64_t>(count) + raw;
+            if (resolved > INT32_MAX || resolved < INT32_MIN) {
+                return false;
+            }
+            if (raw < 0) {
+                relative |= relativeBit;
+            }
+            index = static_cast<int32_t>(resolved);
+            return true;
+        }
+
+        void addStatement(Statement::Kind kind, std::string_view text)
+        {
+            m_chunk.statements.push_back({kind, text, static_cast<uint32_t>(m_data.faces.size())});
+        }
+
+    private:
+        Chunk &m_chunk;
+        Obj::Data &m_data;
+    };
+
+    // Replays o/g/usemtl statements over the merged face list.
+    class GroupBuilder
+    {
+    public:
+        explicit GroupBuilder(Obj::Data &data)
+            : m_data{data}
+        {
+            m_data.groups.push_back(Obj::Group{"unnamed", {}, 0, 0});
+        }
+
+        void BeginGroup(std::string_view name, uint32_t face)
+        {
+            // The material carries over into the new group.
+            const std::string material = currentGroup().material;
+            m_splitCount = 1;
+            beginGroup(name.empty() ? std::string_view{"unnamed"} : name, material, face);
+        }
+
+        void UseMaterial(std::string_view material, uint32_t face)
+        {
+            Obj::Group &group = currentGroup();
+            if (face == group.firstFace) {
+                group.material.assign(material);
+                return;
+            }
+
+            // A material change inside a group starts a new mesh with a numbered name.
+            std::string name = m_baseName;
+            name += '_';
+            name += std::to_string(++m_splitCount);
+            beginGroup(name, material, face);
+        }
+
+        void Finish(uint32_t faceCount)
+        {
+            closeGroup(faceCount);
+        }
+
+    private:
+        void beginGroup(std::string_view name, std::string_view material, uint32_t face)
+        {
+            Obj::Group &group = currentGroup();
+            if (face == group.firstFace) {
+                // Reuse groups that never received a face.
+                group.name.assign(name);
+                group.material.assign(material);
+            } else {
+                Obj::Group next;
+                next.name.assign(name);
+                next.material.assign(material);
+                next.firstFace = face;
+                closeGroup(face);
+                m_data.groups.push_back(std::move(next));
+            }
+
+            if (m_splitCount <= 1) {
+                m_baseName.assign(name);
+            }
+        }
+
+        void closeGroup(uint32_t face)
+        {
+            currentGroup().faceCount = face - currentGroup().firstFace;
+        }
+
+        Obj::Group &currentGroup()
+        {
+            return m_data.groups.back();
+        }
+
+    private:
+        Obj::Data &m_data;
+        std::string m_baseName{"unnamed"};
+        int m_splitCount{1};
+    };
+
+    void splitChunks(std::string_view text, size_t chunkCount, std::vector<Chunk> &chunks)
+    {
+        chunks.resize(chunkCount);
+        size_t begin = 0;
+        for (size_t i = 0; i < chunkCount; ++i) {
+            size_t end = text.size();
+            if (i + 1 < chunkCount) {
+                // Cut right after the first line break past the even split point.
+                end = std::max(begin, text.size() * (i + 1) / chunkCount);
+                size_t lineBreak = text.find('\n', end);
+                end = lineBreak == std::string_view::npos ? text.size() : lineBreak + 1;
+            }
+            chunks[i].text = text.substr(begin, end - begin);
+            begin = end;
+        }
+    }
+
+    inline bool isInRange(int32_t index, size_t count)
+    {
+        return index >= 0 && static_cast<size_t>(index) < count;
+    }
+
+    // Copies one chunk into its slice of the merged arrays, rebasing relative
+    // indices and checking every index against the final attribute counts.
+    bool mergeChunk(const Chunk &chunk, Obj::Data &data)
+    {
+        const Obj::Data &local = chunk.data;
+        std::copy(local.positions.begin(), local.positions.end(), data.positions.begin() + chunk.positionBase * 3);
+        std::copy(local.texcoords.begin(), local.texcoords.end(), data.texcoords.begin() + chunk.texcoordBase * 2);
+        std::copy(local.normals.begin(), local.normals.end(), data.normals.begin() + chunk.normalBase * 3);
+
+        Obj::Corner *corners = data.corners.data() + chunk.cornerBase;
+        std::copy(local.corners.begin(), local.corners.end(), corners);
+        for (const RelativeCorner &relative : chunk.relativeCorners) {
+            Obj::Corner &corner = corners[relative.corner];
+            if (relative.attributes & RELATIVE_POSITION) {
+                corner.position += static_cast<int32_t>(chunk.positionBase);
+            }
+            if (relative.attributes & RELATIVE_TEXCOORD) {
+                corner.texcoord += static_cast<int32_t>(chunk.texcoordBase);
+            }
+            if (relative.attributes & RELATIVE_NORMAL) {
+                corner.normal += static_cast<int32_t>(chunk.normalBase);
+            }
+        }
+
+        const size_t positionCount = data.positions.size() / 3;
+        const size_t texcoordCount = data.texcoords.size() / 2;
+        const size_t normalCount = data.normals.size() / 3;
+        for (size_t i = 0; i < local.corners.size(); ++i) {
+            const Obj::Corner &corner = corners[i];
+            if (!isInRange(corner.position, positionCount)
+                || (corner.texcoord != -1 && !isInRange(corner.texcoord, texcoordCount))
+                || (corner.normal != -1 && !isInRange(corner.normal, normalCount))) {
+                return false;
+            }
+        }
+
+        Obj::Face *faces = data.faces.data() + chunk.faceBase;
+        for (size_t i = 0; i < local.faces.size(); ++i) {
+            faces[i].firstCorner = local.faces[i].firstCorner + static_cast<uint32_t>(chunk.cornerBase);
+            faces[i].cornerCount = local.faces[i].cornerCount;
+        }
+        return true;
+    }
+
+    bool mergeChunks(std::vector<Chunk> &chunks, Obj::Data &data)
+    {
+        size_t positionCount = 0, texcoordCount = 0, normalCount = 0, cornerCount = 0, faceCount = 0;
+        for (Chunk &chunk : chunks) {
+            chunk.positionBase = positionCount;
+            chunk.texcoordBase = texcoordCount;
+            chunk.normalBase = normalCount;
+            chunk.cornerBase = cornerCount;
+            chunk.faceBase = faceCount;
+            positionCount += chunk.data.positions.size() / 3;
+            texcoordCount += chunk.data.texcoords.size() / 2;
+            normalCount += chunk.data.normals.size() / 3;
+            cornerCount += chunk.data.corners.size();
+            faceCount += chunk.data.faces.size();
+        }
+        if (positionCount > INT32_MAX || cornerCount > UINT32_MAX || faceCount > UINT32_MAX) {
+            return false;
+        }
+
+        data.positions.resize(positionCount * 3);
+        data.texcoords.resize(texcoordCount * 2);
+        data.normals.resize(normalCount * 3);
+        data.corners.resize(cornerCount);
+        data.faces.resize(faceCount);
+
+        // One thread per chunk, the chunks were sized for the thread count already.
+        ParallelFor(chunks.size(), static_cast<unsigned>(chunks.size()), [&chunks, &data](size_t i) {
+            chunks[i].isValid = mergeChunk(chunks[i], data);
+        });
+        for (const Chunk &chunk : chunks) {
+            if (!chunk.isValid) {
+                return false;
+            }
+        }
+
+        GroupBuilder groups{data};
+        for (const Chunk &chunk : chunks) {
+            for (const Statement &statement : chunk.statements) {
+                const uint32_t face = static_cast<uint32_t>(chunk.faceBase) + statement.face;
+                switch (statement.kind) {
+                case Statement::Kind::Group:
+                    groups.BeginGroup(statement.text, face);
+                    break;
+                case Statement::Kind::Material:
+                    groups.UseMaterial(statement.text, face);
+                    break;
+                case Statement::Kind::Library:
+                    data.materialLibraries.emplace_back(statement.text);
+                    break;
+                }
+            }
+        }
+        groups.Finish(static_cast<uint32_t>(faceCount));
+        return true;
+    }
+}
+
+void Obj::Data::Clear()
+{
+    positions.clear();
+    texcoords.clear();
+    normals.clear();
+    corners.clear();
+    faces.clear();
+    groups.clear();
+    materialLibraries.clear();
+}
+
+bool Obj::Parse(std::string_view text, Data &data, unsigned threadCount)
+{
+    data.Clear();
+
+    threadCount = ResolveThreads(threadCount);
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, text.size() / MIN_CHUNK_BYTES));
+
+    std::vector<Chunk> chunks;
+    splitChunks(text, chunkCount, chunks);
+
+    ParallelFor(chunks.size(), static_cast<unsigned>(chunks.size()), [&chunks](size_t i) {
+        ChunkParser parser{chunks[i]};
+        chunks[i].isValid = parser.Run();
+    });
+    for (const Chunk &chunk : chunks) {
+        if (!chunk.isValid) {
+            return false;
+        }
+    }
+
+    if (!mergeChunks(chunks, data)) {
+        return false;
+    }
+    return !data.faces.empty() || !data.positions.empty();
+}
+
+bool Obj::BuildShape(const Data &data, const BuildOptions &options, SponzaShape &sponza)
+{
+    bool fits = true;
+    sponza = SponzaShape{};
+    sponza.shapes.reserve(data.groups.size());
+    if (options.stats != nullptr) {
+        options.stats->clear();
+    }
+
+    const VertexLayout *layout = options.layout;
+    size_t vertexBytes = 8 * sizeof(float);
+    if (layout != nullptr) {
+        vertexBytes = 0;
+        for (uint32_t s = 0; s < layout->streamCount; ++s) {
+            vertexBytes += layout->strides[s];
+        }
+    }
+
+    static constexpr float NO_TEXCOORD[2] = {0.0f, 0.0f};
+
+    VertexWelder welder;
+    Triangulator triangulator;
+    std::vector<uint32_t> faceIndices;
+    std::vector<uint32_t> faceTriangles;
+
+    for (const Group &group : data.groups) {
+        if (group.faceCount == 0) {
+            continue;
+        }
+
+        const Face &first = data.faces[group.firstFace];
+        const Face &last = data.faces[group.firstFace + group.faceCount - 1];
+        const size_t cornerCount = last.firstCorner + last.cornerCount - first.firstCorner;
+        const size_t triangleCount = cornerCount - 2 * group.faceCount;
+
+        SponzaShape::Shape shape;
+        shape.name = group.name;
+        shape.material = options.materials != nullptr ? options.materials->FindMaterial(group.material) : INVALID_MATERIAL;
+        if (layout != nullptr) {
+            shape.layout = *layout;
+            for (uint32_t s = 0; s < layout->streamCount; ++s) {
+                shape.streams[s].reserve(cornerCount * layout->strides[s]);
+            }
+            if (IsQuantized(*layout)) {
+                // Vertices are encoded as they are welded, so the bounds have to be known up front.
+                Bounds bounds;
+                for (size_t c = first.firstCorner; c < first.firstCorner + cornerCount; ++c) {
+                    bounds.Extend(&data.positions[data.corners[c].position * 3]);
+                }
+                shape.quantization = QuantizationForBounds(bounds.min, bounds.max);
+            }
+        } else {
+            shape.positions.reserve(cornerCount * 3);
+            shape.normals.reserve(cornerCount * 3);
+            shape.texcoords.reserve(cornerCount * 2);
+        }
+        shape.indicies.resize(triangleCount * 3);
+        welder.Reset(cornerCount);
+
+        unsigned int *index = shape.indicies.data();
+
+        for (uint32_t f = group.firstFace; f < group.firstFace + group.faceCount; ++f) {
+            const Face &face = data.faces[f];
+            const Corner *corners = data.corners.data() + face.firstCorner;
+
+            bool hasNormals = true;
+            for (uint32_t c = 0; c < face.cornerCount; ++c) {
+                hasNormals &= corners[c].normal >= 0;
+            }
+
+            // Same unnormalized face normal objl falls back to.
+            float faceNormal[3] = {0.0f, 0.0f, 0.0f};
+            if (!hasNormals) {
+                const float *p0 = &data.positions[corners[0].position * 3];
+                const float *p1 = &data.positions[corners[1].position * 3];
+                const float *p2 = &data.positions[corners[2].position * 3];
+                const float a[3] = {p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2]};
+                const float b[3] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+                faceNormal[0] = a[1] * b[2] - a[2] * b[1];
+                faceNormal[1] = a[2] * b[0] - a[0] * b[2];
+                faceNormal[2] = a[0] * b[1] - a[1] * b[0];
+            }
+
+            faceIndices.clear();
+            for (uint32_t c = 0; c < face.cornerCount; ++c) {
+                const float *position = &data.positions[corners[c].position * 3];
+                const float *normal = hasNormals ? &data.normals[corners[c].normal * 3] : faceNormal;
+                const float *texcoord = corners[c].texcoord >= 0 ? &data.texcoords[corners[c].texcoord * 2] : NO_TEXCOORD;
+
+                bool isNew = false;
+                const uint32_t vertex = welder.Insert(position, normal, texcoord, isNew);
+                if (isNew) {
+                    shape.bounds.Extend(position);
+                }
+                if (isNew && layout != nullptr) {
+                    uint8_t *streams[MAX_VERTEX_STREAMS];
+                    for (uint32_t s = 0; s < layout->streamCount; ++s) {
+                        shape.streams[s].resize(shape.streams[s].size() + layout->strides[s]);
+                        streams[s] = shape.streams[s].data();
+                    }
+                    VertexAttributes attributes;
+                    attributes.position = position;
+                    attributes.normal = normal;
+                    attributes.texcoord = texcoord;
+                    fits &= EncodeVertex(*layout, attributes, streams, vertex, shape.quantization);
+                } else if (isNew) {
+                    shape.positions.insert(shape.positions.end(), position, position + 3);
+                    shape.normals.insert(shape.normals.end(), normal, normal + 3);
+                    shape.texcoords.insert(shape.texcoords.end(), texcoord, texcoord + 2);
+                }
+                faceIndices.push_back(vertex);
+            }
+
+            if (faceTriangles.size() < (face.cornerCount - 2) * 3) {
+                faceTriangles.resize((face.cornerCount - 2) * 3);
+            }
+            const uint32_t triangles = triangulator.Triangulate(face.cornerCount, [&](uint32_t c) {
+                return &data.positions[corners[c].position * 3];
+            }, faceTriangles.data());
+            for (uint32_t t = 0; t < triangles * 3; ++t) {
+                index[t] = faceIndices[faceTriangles[t]];
+            }
+            index += triangles * 3;
+        }
+
+        shape.vertexCount = static_cast<uint32_t>(welder.UniqueCount());
+        shape.positions.shrink_to_fit();
+        shape.normals.shrink_to_fit();
+        shape.texcoords.shrink_to_fit();
+        for (std::vector<uint8_t> &stream : shape.streams) {
+            stream.shrink_to_fit();
+        }
+
+        if (options.stats != nullptr) {
+            const size_t indexBytes = shape.indicies.size() * sizeof(unsigned int);
+            ShapeStats shapeStats;
+            shapeStats.name = shape.name;
+            shapeStats.cornerCount = cornerCount;
+            shapeStats.vertexCount = welder.UniqueCount();
+            shapeStats.bytesBefore = cornerCount * vertexBytes + indexBytes;
+            shapeStats.bytesAfter = welder.UniqueCount() * vertexBytes + indexBytes;
+            options.stats->push_back(std::move(shapeStats));
+        }
+
+        sponza.shapes.push_back(std::move(shape));
+    }
+    return fits;
+}
+
+bool Obj::LoadFile(const char *path, SponzaShape &sponza, const LoadOptions &options)
+{
+    sponza = SponzaShape{};
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    Data data;
+    if (!Parse(file.View(), data, options.threadCount)) {
+        return false;
+    }
+
+    // A missing material library leaves its shapes without a material, same as objl.
+    MaterialCompiler materials;
+    const std::string_view directory = DirectoryOf(path);
+    for (const std::string &library : data.materialLibraries) {
+        std::string libraryPath = NormalizePath(directory, library);
+        materials.CompileFile(libraryPath.c_str());
+        if (options.dependencies != nullptr) {
+            options.dependencies->push_back(std::move(libraryPath));
+        }
+    }
+
+    BuildOptions buildOptions;
+    buildOptions.materials = &materials.Table();
+    // Tangents need the float arrays, so the shapes are encoded only once they are done.
+    buildOptions.layout = options.tangents ? nullptr : options.layout;
+    if (!BuildShape(data, buildOptions, sponza)) {
+        return false;
+    }
+    if (options.tangents) {
+        GenerateTangents(sponza, options.threadCount);
+    }
+    if (options.optimize) {
+        OptimizeShapes(sponza, options.threadCount);
+    }
+    if (options.tangents && options.layout != nullptr) {
+        for (SponzaShape::Shape &shape : sponza.shapes) {
+            if (!EncodeStreams(shape, *options.layout)) {
+                return false;
+            }
+        }
+    }
+    sponza.materials = materials.Release();
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Wavefront OBJ reader working in place over a mapped file.
+// Lines are tokenized as string_views and numbers are parsed straight from
+// the mapped bytes, so the only heap traffic is the growth of the output arrays.
+namespace Resources::CPU::Obj
+{
+    // One face corner resolved to 0-based attribute indices, -1 when the attribute is absent.
+    struct Corner
+    {
+        int32_t position{-1};
+        int32_t texcoord{-1};
+        int32_t normal{-1};
+    };
+
+    struct Face
+    {
+        uint32_t firstCorner{0};
+        uint32_t cornerCount{0};
+    };
+
+    // Run of consecutive faces sharing the same o/g name and usemtl material.
+    struct Group
+    {
+        std::string name;
+        std::string material;
+        uint32_t firstFace{0};
+        uint32_t faceCount{0};
+    };
+
+    struct Data
+    {
+        std::vector<float> positions;   // xyz
+        std::vector<float> texcoords;   // uv
+        std::vector<float> normals;     // xyz
+        std::vector<Corner> corners;
+        std::vector<Face> faces;
+        std::vector<Group> groups;
+        std::vector<std::string> materialLibraries;
+
+        void Clear();
+    };
+
+    // Vertex counts and vertex/index memory of one shape before and after welding.
+    struct ShapeStats
+    {
+        std::string name;
+        size_t cornerCount{0};
+        size_t vertexCount{0};
+        size_t bytesBefore{0};
+        size_t bytesAfter{0};
+    };
+
+    // Large inputs are split at line boundaries and parsed on up to threadCount
+    // threads (0 picks the hardware concurrency). Chunks are merged in file order,
+    // so the result does not depend on the thread count.
+    bool Parse(std::string_view text, Data &data, unsigned threadCount = 0);
+
+    struct BuildOptions
+    {
+        // Resolves group materials to indices, shapes get INVALID_MATERIAL without it.
+        const MaterialTable *materials{nullptr};
+        // Encodes welded vertices straight into Shape::streams instead of the float arrays.
+        const VertexLayout *layout{nullptr};
+        std::vector<ShapeStats> *stats{nullptr};
+    };
+
+    // Emits one shape per non-empty group. Face corners with identical
+    // position, texcoord and normal are welded into a single indexed vertex.
+    // False when a vertex does not fit options.layout, see EncodeVertex; the
+    // shapes are still built.
+    bool BuildShape(const Data &data, const BuildOptions &options, SponzaShape &sponza);
+
+    struct LoadOptions
+    {
+        unsigned threadCount{0};
+        const VertexLayout *layout{nullptr};
+        // Receives the normalized path of every mtllib the file refers to, found or not.
+        std::vector<std::string> *dependencies{nullptr};
+        // Reorders each shape's triangles and vertices for the GPU caches, see MeshOptimizer.hpp.
+        bool optimize{false};
+        // Generates tangent frames before encoding, see TangentSpace.hpp. Give
+        // a layout with a Tangent attribute to keep them.
+        bool tangents{false};
+    };
+
+    // Parses the OBJ, compiles its mtllib files into SponzaShape::materials and builds the shapes.
+    bool LoadFile(const char *path, SponzaShape &sponza, const LoadOptions &options = {});
+}
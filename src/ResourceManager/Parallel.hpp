@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // Thread count for the parallel stages: threadCount itself, or the
+    // hardware concurrency for 0.
+    inline unsigned ResolveThreads(unsigned threadCount)
+    {
+        return threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Runs fn(i) for every i in [0, count) on up to threadCount threads, the
+    // calling one included. Indices are handed out one at a time, so uneven
+    // work still spreads over all threads.
+    template<typename Fn>
+    void ParallelFor(size_t count, unsigned threadCount, Fn &&fn)
+    {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                fn(i);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const size_t extra = std::min<size_t>(threadCount, count) > 0 ? std::min<size_t>(threadCount, count) - 1 : 0;
+        workers.reserve(extra);
+        for (size_t i = 0; i < extra; ++i) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : workers) {
+            thread.join();
+        }
+    }
+}
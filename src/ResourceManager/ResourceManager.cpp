@@ -1,41 +1,493 @@
 #include "ResourceManager.hpp"
+#include "ObjParser.hpp"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <external/ObjLoader/ObjLoader.h>
+#include <cstring>
 
 using namespace Resources::CPU;
 
-bool Resources::CPU::LoadSponzaShape(SponzaShape &sponza)
+namespace
 {
-    sponza = SponzaShape{};
-    objl::Loader objLoader;
+    // What every shape load does, so LoadShape hands out the same data as
+    // the LoadSponzaShape call it replaces.
+    Obj::LoadOptions shapeOptions(const VertexLayout *layout)
+    {
+        Obj::LoadOptions options;
+        options.layout = layout;
+        options.optimize = true;
+        return options;
+    }
+
+    // The float array a half element converts from in one batch, or null when
+    // the element has to go through EncodeVertex.
+    const std::vector<float> *halfSource(const SponzaShape::Shape &shape, const VertexElement &element, size_t vertexCount)
+    {
+        if (element.format == VertexFormat::Half2 && element.attribute == VertexAttribute::Texcoord &&
+            shape.texcoords.size() == vertexCount * 2) {
+            return &shape.texcoords;
+        }
+        if (element.format == VertexFormat::Half4 && element.attribute == VertexAttribute::Tangent &&
+            shape.tangents.size() == vertexCount * 4) {
+            return &shape.tangents;
+        }
+        return nullptr;
+    }
+
+    // Faults a mapping in on the loader thread, so the first use on the main
+    // thread does not stall on I/O. False when the load got cancelled meanwhile.
+    bool touchPages(std::string_view bytes, const std::atomic<bool> &cancelled)
+    {
+        constexpr size_t TOUCH_STRIDE = 4096;
+        constexpr size_t CANCEL_CHECK_PAGES = 256;
+        volatile uint8_t sink = 0;
+        for (size_t offset = 0, page = 0; offset < bytes.size(); offset += TOUCH_STRIDE, ++page) {
+            if (page % CANCEL_CHECK_PAGES == 0 && cancelled) {
+                return false;
+            }
+            sink = sink + static_cast<uint8_t>(bytes[offset]);
+        }
+        return true;
+    }
+}
+
+bool Resources::CPU::LoadSponzaShape(SponzaShape &sponza, const VertexLayout *layout)
+{
+    return Obj::LoadFile("assets/sponza/sponza.obj", sponza, shapeOptions(layout));
+}
+
+bool Resources::CPU::LoadSponzaMesh(CookedMesh &mesh)
+{
+    return mesh.Open("cooked/sponza/sponza.cmesh");
+}
+
+bool Resources::CPU::EncodeStreams(SponzaShape::Shape &shape, const VertexLayout &layout)
+{
+    const size_t vertexCount = shape.positions.size() / 3;
+    const bool hasNormals = shape.normals.size() == vertexCount * 3;
+    const bool hasTexcoords = shape.texcoords.size() == vertexCount * 2;
+    const bool hasTangents = shape.tangents.size() == vertexCount * 4;
+
+    shape.quantization = VertexQuantization{};
+    if (IsQuantized(layout)) {
+        Bounds bounds;
+        for (size_t v = 0; v < vertexCount; ++v) {
+            bounds.Extend(&shape.positions[v * 3]);
+        }
+        shape.quantization = QuantizationForBounds(bounds.min, bounds.max);
+    }
+
+    uint8_t *streams[MAX_VERTEX_STREAMS];
+    for (uint32_t s = 0; s < MAX_VERTEX_STREAMS; ++s) {
+        shape.streams[s].clear();
+        if (s < layout.streamCount) {
+            shape.streams[s].resize(vertexCount * layout.strides[s]);
+        }
+        streams[s] = shape.streams[s].data();
+    }
+
+    // Half elements convert their whole array with the batch FloatToHalf and
+    // are scattered into the stream; everything else goes vertex by vertex.
+    VertexLayout perVertex = layout;
+    perVertex.elementCount = 0;
+    std::vector<uint16_t> halves;
+    for (uint32_t i = 0; i < layout.elementCount; ++i) {
+        const VertexElement &element = layout.elements[i];
+        const std::vector<float> *values = halfSource(shape, element, vertexCount);
+        if (values == nullptr) {
+            perVertex.elements[perVertex.elementCount++] = element;
+            continue;
+        }
+        halves.resize(values->size());
+        FloatToHalf(values->data(), halves.data(), values->size());
+        const uint32_t size = VertexFormatSize(element.format);
+        const uint32_t stride = layout.strides[element.stream];
+        uint8_t *out = streams[element.stream] + element.offset;
+        for (size_t v = 0; v < vertexCount; ++v) {
+            std::memcpy(out + v * stride, &halves[v * size / sizeof(uint16_t)], size);
+        }
+    }
+
+    bool fits = true;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        VertexAttributes attributes;
+        attributes.position = &shape.positions[v * 3];
+        attributes.normal = hasNormals ? &shape.normals[v * 3] : nullptr;
+        attributes.texcoord = hasTexcoords ? &shape.texcoords[v * 2] : nullptr;
+        attributes.tangent = hasTangents ? &shape.tangents[v * 4] : nullptr;
+        fits &= EncodeVertex(perVertex, attributes, streams, v, shape.quantization);
+    }
+
+    shape.layout = layout;
+    shape.vertexCount = static_cast<uint32_t>(vertexCount);
+    shape.positions = {};
+    shape.normals = {};
+    shape.texcoords = {};
+    shape.tangents = {};
+    return fits;
+}
+
+struct ResourceManager::Entry
+{
+    uint32_t generation{0};
+    uint32_t ticket{0};
+    LoadState state{LoadState::Invalid};
+    LoadPriority priority{LoadPriority::Background};
+    bool isQueued{false};
+    bool isInFlight{false};
+    bool isReleased{false};
+    LoadFn load;                            // kept for Reload
+    LoadCallback callback;
+    LoadState completedState{LoadState::Invalid};
+    std::shared_ptr<void> resource;
+    std::shared_ptr<void> reloaded;         // swapped in by DispatchCompletions
+    std::atomic<bool> cancelled{false};
+};
+
+ResourceManager::ResourceManager(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+    m_workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ResourceManager::~ResourceManager()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_isStopping = true;
+        for (const std::unique_ptr<Entry> &entry : m_entries) {
+            entry->cancelled = true;
+        }
+    }
+    m_wakeup.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
 
-    bool loadout = objLoader.LoadFile("assets/sponza/sponza.obj");
+MeshHandle ResourceManager::LoadMesh(std::string path, LoadPriority priority, LoadCallback callback)
+{
+    MeshHandle handle;
+    handle.slot = enqueue(priority, [path = std::move(path)](const std::atomic<bool> &cancelled) -> std::shared_ptr<void> {
+        auto mesh = std::make_shared<CookedMesh>();
+        if (!mesh->Open(path.c_str()) || !touchPages(mesh->View(), cancelled)) {
+            return nullptr;
+        }
+        return mesh;
+    }, std::move(callback), handle.generation);
+    return handle;
+}
 
-    if (loadout) {
+MaterialsHandle ResourceManager::LoadMaterials(std::string path, LoadPriority priority, LoadCallback callback)
+{
+    MaterialsHandle handle;
+    handle.slot = enqueue(priority, [path = std::move(path)](const std::atomic<bool> &cancelled) -> std::shared_ptr<void> {
+        // A few kilobytes, Open reads all of it to validate.
+        auto materials = std::make_shared<CookedMaterials>();
+        if (cancelled || !materials->Open(path.c_str())) {
+            return nullptr;
+        }
+        return materials;
+    }, std::move(callback), handle.generation);
+    return handle;
+}
 
-        for (int i = 0; i < objLoader.LoadedMeshes.size(); i++) {
-            // Copy one of the loaded meshes to be our current mesh
-            objl::Mesh curMesh = objLoader.LoadedMeshes[i];
-            SponzaShape::Shape curShape;
-            curShape.name = curMesh.MeshName;
-            for (int j = 0; j < curMesh.Vertices.size(); ++j) {
-                curShape.positions.push_back(curMesh.Vertices[j].Position.X);
-                curShape.positions.push_back(curMesh.Vertices[j].Position.Y);
-                curShape.positions.push_back(curMesh.Vertices[j].Position.Z);
+TextureHandle ResourceManager::LoadTexture(std::string path, LoadPriority priority, LoadCallback callback)
+{
+    TextureHandle handle;
+    handle.slot = enqueue(priority, [path = std::move(path)](const std::atomic<bool> &cancelled) -> std::shared_ptr<void> {
+        auto texture = std::make_shared<CookedTexture>();
+        if (!texture->Open(path.c_str()) || !touchPages(texture->View(), cancelled)) {
+            return nullptr;
+        }
+        return texture;
+    }, std::move(callback), handle.generation);
+    return handle;
+}
 
-                curShape.normals.push_back(curMesh.Vertices[j].Normal.X);
-                curShape.normals.push_back(curMesh.Vertices[j].Normal.Y);
-                curShape.normals.push_back(curMesh.Vertices[j].Normal.Z);
+ShapeHandle ResourceManager::LoadShape(std::string path, LoadPriority priority, const VertexLayout *layout,
+                                       LoadCallback callback)
+{
+    const bool hasLayout = layout != nullptr;
+    const VertexLayout layoutCopy = hasLayout ? *layout : VertexLayout{};
+
+    ShapeHandle handle;
+    handle.slot = enqueue(priority, [path = std::move(path), hasLayout, layoutCopy](const std::atomic<bool> &cancelled)
+                                         -> std::shared_ptr<void> {
+        if (cancelled) {
+            return nullptr;
+        }
+        // Loads run side by side on the pool, one parser thread each.
+        Obj::LoadOptions options = shapeOptions(hasLayout ? &layoutCopy : nullptr);
+        options.threadCount = 1;
+        auto shape = std::make_shared<SponzaShape>();
+        if (!Obj::LoadFile(path.c_str(), *shape, options)) {
+            return nullptr;
+        }
+        return shape;
+    }, std::move(callback), handle.generation);
+    return handle;
+}
+
+size_t ResourceManager::DispatchCompletions()
+{
+    std::vector<Ticket> completed;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        completed.swap(m_completed);
+    }
+
+    size_t dispatched = 0;
+    for (const Ticket &ticket : completed) {
+        LoadCallback callback;
+        LoadState state;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            Entry *entry = find(ticket.slot, ticket.generation);
+            if (entry == nullptr) {
+                continue;
+            }
+            if (entry->reloaded != nullptr) {
+                entry->resource = std::move(entry->reloaded);
             }
+            if (!entry->callback) {
+                continue;
+            }
+            callback = std::move(entry->callback);
+            entry->callback = nullptr;
+            state = entry->completedState;
+        }
+        // Outside the lock, callbacks are free to queue or release resources.
+        callback(state);
+        ++dispatched;
+    }
+    return dispatched;
+}
+
+size_t ResourceManager::PendingCount() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_pendingCount;
+}
+
+uint32_t ResourceManager::enqueue(LoadPriority priority, LoadFn load, LoadCallback callback, uint32_t &generation)
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(m_entries.size());
+        m_entries.push_back(std::make_unique<Entry>());
+    }
+
+    Entry &entry = *m_entries[slot];
+    entry.state = LoadState::Queued;
+    entry.priority = priority;
+    entry.isQueued = true;
+    entry.isReleased = false;
+    entry.cancelled = false;
+    entry.load = std::move(load);
+    entry.callback = std::move(callback);
+    ++entry.ticket;
+    generation = entry.generation;
+
+    m_queues[static_cast<size_t>(priority)].push_back({slot, entry.generation, entry.ticket});
+    ++m_pendingCount;
+    lock.unlock();
+    m_wakeup.notify_one();
+    return slot;
+}
+
+ResourceManager::Entry *ResourceManager::find(uint32_t slot, uint32_t generation) const
+{
+    if (slot >= m_entries.size()) {
+        return nullptr;
+    }
+    Entry *entry = m_entries[slot].get();
+    if (entry->generation != generation || entry->state == LoadState::Invalid || entry->isReleased) {
+        return nullptr;
+    }
+    return entry;
+}
 
-            for (int j = 0; j < curMesh.Indices.size(); ++j) {
-                curShape.indicies.push_back(curMesh.Indices[j]);
+void ResourceManager::freeSlot(uint32_t slot)
+{
+    Entry &entry = *m_entries[slot];
+    entry.state = LoadState::Invalid;
+    entry.isQueued = false;
+    entry.isInFlight = false;
+    entry.load = nullptr;
+    entry.callback = nullptr;
+    entry.resource.reset();
+    entry.reloaded.reset();
+    ++entry.generation;
+    m_freeSlots.push_back(slot);
+}
+
+void ResourceManager::workerLoop()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    for (;;) {
+        std::deque<Ticket> *queue = nullptr;
+        m_wakeup.wait(lock, [&]() {
+            for (std::deque<Ticket> &candidate : m_queues) {
+                if (!candidate.empty()) {
+                    queue = &candidate;
+                    return true;
+                }
             }
+            return m_isStopping;
+        });
+        if (m_isStopping) {
+            return;
+        }
+
+        const Ticket ticket = queue->front();
+        queue->pop_front();
+        // Tickets of cancelled, released or re-prioritized loads are left behind in the queues.
+        Entry &entry = *m_entries[ticket.slot];
+        if (entry.generation != ticket.generation || entry.ticket != ticket.ticket || !entry.isQueued) {
+            continue;
+        }
+
+        // A first load goes Queued -> Loading -> Ready. A reload keeps the
+        // entry Ready on the old data while it runs.
+        const bool isReload = entry.state != LoadState::Queued;
+        entry.isQueued = false;
+        entry.isInFlight = true;
+        if (!isReload) {
+            entry.state = LoadState::Loading;
+        }
+        const LoadFn load = entry.load;
+        lock.unlock();
+        std::shared_ptr<void> result = load(entry.cancelled);
+        lock.lock();
+
+        entry.isInFlight = false;
+        --m_pendingCount;
+        if (entry.isReleased) {
+            freeSlot(ticket.slot);
+            continue;
+        }
 
-            sponza.shapes.push_back(curShape);
+        if (entry.cancelled) {
+            entry.completedState = LoadState::Cancelled;
+        } else {
+            entry.completedState = result != nullptr ? LoadState::Ready : LoadState::Failed;
         }
+        entry.cancelled = false;
+
+        if (entry.state == LoadState::Ready) {
+            // Somebody may hold the old data for this frame, swap on the main thread.
+            if (entry.completedState == LoadState::Ready) {
+                entry.reloaded = std::move(result);
+            }
+        } else if (entry.completedState == LoadState::Ready) {
+            entry.resource = std::move(result);
+            entry.state = LoadState::Ready;
+        } else if (!isReload) {
+            entry.state = entry.completedState;
+        }
+        m_completed.push_back(ticket);
     }
+}
+
+LoadState ResourceManager::state(uint32_t slot, uint32_t generation) const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const Entry *entry = find(slot, generation);
+    return entry != nullptr ? entry->state : LoadState::Invalid;
+}
+
+const void *ResourceManager::resource(uint32_t slot, uint32_t generation) const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const Entry *entry = find(slot, generation);
+    return entry != nullptr && entry->state == LoadState::Ready ? entry->resource.get() : nullptr;
+}
 
-    return loadout;
-}
\ No newline at end of file
+void ResourceManager::setPriority(uint32_t slot, uint32_t generation, LoadPriority priority)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        Entry *entry = find(slot, generation);
+        if (entry == nullptr || !entry->isQueued || entry->priority == priority) {
+            return;
+        }
+        entry->priority = priority;
+        ++entry->ticket;
+        m_queues[static_cast<size_t>(priority)].push_back({slot, generation, entry->ticket});
+    }
+    m_wakeup.notify_one();
+}
+
+bool ResourceManager::reload(uint32_t slot, uint32_t generation, LoadPriority priority, LoadCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        Entry *entry = find(slot, generation);
+        if (entry == nullptr || entry->isQueued || entry->isInFlight ||
+            (entry->state != LoadState::Ready && entry->state != LoadState::Failed)) {
+            return false;
+        }
+        entry->priority = priority;
+        entry->isQueued = true;
+        entry->cancelled = false;
+        entry->callback = std::move(callback);
+        ++entry->ticket;
+        m_queues[static_cast<size_t>(priority)].push_back({slot, generation, entry->ticket});
+        ++m_pendingCount;
+    }
+    m_wakeup.notify_one();
+    return true;
+}
+
+bool ResourceManager::cancel(uint32_t slot, uint32_t generation)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    Entry *entry = find(slot, generation);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (entry->isQueued) {
+        entry->isQueued = false;
+        entry->completedState = LoadState::Cancelled;
+        if (entry->state == LoadState::Queued) {
+            entry->state = LoadState::Cancelled;
+        }
+        --m_pendingCount;
+        m_completed.push_back({slot, generation, entry->ticket});
+        return true;
+    }
+    if (entry->isInFlight) {
+        entry->cancelled = true;
+        return true;
+    }
+    return false;
+}
+
+void ResourceManager::release(uint32_t slot, uint32_t generation)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    Entry *entry = find(slot, generation);
+    if (entry == nullptr) {
+        return;
+    }
+    if (entry->isInFlight) {
+        // The worker frees the slot once the load returns.
+        entry->isReleased = true;
+        entry->cancelled = true;
+        entry->callback = nullptr;
+        return;
+    }
+    if (entry->isQueued) {
+        --m_pendingCount;
+    }
+    freeSlot(slot);
+}
@@ -1,8 +1,175 @@
 #pragma once
 
+#include "CookedMesh.hpp"
+#include "CookedTexture.hpp"
 #include "ResourceType.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace Resources::CPU
 {
-    bool LoadSponzaShape(SponzaShape &sponza);
+    enum class LoadPriority : uint8_t
+    {
+        VisibleNow,     // needed by the frame being built
+        Prefetch,       // likely needed soon
+        Background,     // runs only when nothing else waits
+        Count
+    };
+
+    constexpr size_t LOAD_PRIORITY_COUNT = static_cast<size_t>(LoadPriority::Count);
+
+    enum class LoadState : uint8_t
+    {
+        Invalid,        // unknown or released handle
+        Queued,
+        Loading,
+        Ready,
+        Failed,
+        Cancelled
+    };
+
+    // Typed reference to a resource owned by the ResourceManager. A slot is
+    // reused after Release, the generation tells a stale handle apart.
+    template<typename T>
+    struct Handle
+    {
+        uint32_t slot{0xffffffffu};
+        uint32_t generation{0};
+
+        bool IsValid() const { return slot != 0xffffffffu; }
+    };
+
+    using MeshHandle = Handle<CookedMesh>;
+    using MaterialsHandle = Handle<CookedMaterials>;
+    using TextureHandle = Handle<CookedTexture>;
+    using ShapeHandle = Handle<SponzaShape>;
+
+    using LoadCallback = std::function<void(LoadState state)>;
+
+    // Asynchronous loading. Load calls return a handle right away and queue the
+    // work for a pool of loader threads, which always take the highest
+    // priority class first. Callers either poll State() or pass a callback;
+    // callbacks run inside DispatchCompletions, so on the thread that calls it,
+    // normally once per frame on the main thread. Nothing here waits for a load.
+    //
+    // Handles are used from one thread; only the loads run on the pool.
+    class ResourceManager
+    {
+    public:
+        // 0 threads leaves one core for the main thread.
+        explicit ResourceManager(unsigned threadCount = 0);
+        ~ResourceManager();
+
+        ResourceManager(const ResourceManager &) = delete;
+        ResourceManager &operator=(const ResourceManager &) = delete;
+
+        // Maps a cooked .cmesh and faults its pages in, all on a loader thread.
+        MeshHandle LoadMesh(std::string path, LoadPriority priority, LoadCallback callback = {});
+        // Maps the .cmat of a material library, the materials a mesh names.
+        MaterialsHandle LoadMaterials(std::string path, LoadPriority priority, LoadCallback callback = {});
+        // Maps a cooked .ctex and faults its pages in, like LoadMesh.
+        TextureHandle LoadTexture(std::string path, LoadPriority priority, LoadCallback callback = {});
+        // Parses an OBJ with its materials, encoded into layout when one is given.
+        ShapeHandle LoadShape(std::string path, LoadPriority priority, const VertexLayout *layout = nullptr,
+                              LoadCallback callback = {});
+
+        template<typename T>
+        LoadState State(Handle<T> handle) const { return state(handle.slot, handle.generation); }
+
+        // nullptr until the load is Ready.
+        const CookedMesh *Get(MeshHandle handle) const
+        {
+            return static_cast<const CookedMesh *>(resource(handle.slot, handle.generation));
+        }
+        const CookedMaterials *Get(MaterialsHandle handle) const
+        {
+            return static_cast<const CookedMaterials *>(resource(handle.slot, handle.generation));
+        }
+        const CookedTexture *Get(TextureHandle handle) const
+        {
+            return static_cast<const CookedTexture *>(resource(handle.slot, handle.generation));
+        }
+        const SponzaShape *Get(ShapeHandle handle) const
+        {
+            return static_cast<const SponzaShape *>(resource(handle.slot, handle.generation));
+        }
+
+        // Moves a queued load to another priority class, e.g. when it comes into view.
+        template<typename T>
+        void SetPriority(Handle<T> handle, LoadPriority priority) { setPriority(handle.slot, handle.generation, priority); }
+
+        // Loads the resource again, e.g. after its file changed. Get() keeps
+        // returning the old data until DispatchCompletions swaps the new one in,
+        // so pointers taken during a frame stay valid for that frame.
+        template<typename T>
+        bool Reload(Handle<T> handle, LoadPriority priority = LoadPriority::VisibleNow, LoadCallback callback = {})
+        {
+            return reload(handle.slot, handle.generation, priority, std::move(callback));
+        }
+
+        // Drops a load nobody needs anymore. Queued work never runs; a load in
+        // flight stops at its next check and its result is thrown away.
+        template<typename T>
+        bool Cancel(Handle<T> handle) { return cancel(handle.slot, handle.generation); }
+
+        // Frees the resource and invalidates the handle. No callback runs for it afterwards.
+        template<typename T>
+        void Release(Handle<T> handle) { release(handle.slot, handle.generation); }
+
+        // Runs the callbacks of loads that finished since the last call and returns how many ran.
+        size_t DispatchCompletions();
+        // Loads queued or in flight.
+        size_t PendingCount() const;
+
+    private:
+        struct Entry;
+        struct Ticket
+        {
+            uint32_t slot;
+            uint32_t generation;
+            uint32_t ticket;
+        };
+        using LoadFn = std::function<std::shared_ptr<void>(const std::atomic<bool> &cancelled)>;
+
+        uint32_t enqueue(LoadPriority priority, LoadFn load, LoadCallback callback, uint32_t &generation);
+        Entry *find(uint32_t slot, uint32_t generation) const;
+        void freeSlot(uint32_t slot);
+        void workerLoop();
+
+        LoadState state(uint32_t slot, uint32_t generation) const;
+        const void *resource(uint32_t slot, uint32_t generation) const;
+        void setPriority(uint32_t slot, uint32_t generation, LoadPriority priority);
+        bool reload(uint32_t slot, uint32_t generation, LoadPriority priority, LoadCallback callback);
+        bool cancel(uint32_t slot, uint32_t generation);
+        void release(uint32_t slot, uint32_t generation);
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::vector<std::unique_ptr<Entry>> m_entries;
+        std::vector<uint32_t> m_freeSlots;
+        std::deque<Ticket> m_queues[LOAD_PRIORITY_COUNT];
+        std::vector<Ticket> m_completed;
+        size_t m_pendingCount{0};
+        bool m_isStopping{false};
+        std::vector<std::thread> m_workers;
+    };
+
+    // With a layout the shapes come back as encoded vertex streams only.
+    bool LoadSponzaShape(SponzaShape &sponza, const VertexLayout *layout = nullptr);
+
+    // Maps the Sponza mesh written by chelson-cook, no parsing involved.
+    bool LoadSponzaMesh(CookedMesh &mesh);
+
+    // Encodes the float arrays of a shape into its streams and releases them.
+    // False when a vertex does not fit the layout, see EncodeVertex.
+    bool EncodeStreams(SponzaShape::Shape &shape, const VertexLayout &layout);
 }
\ No newline at end of file
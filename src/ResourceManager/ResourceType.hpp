@@ -1,14 +1,179 @@
 #pragma once
 
+#include "VertexLayout.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <new>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace Resources::CPU
 {    
+    // Owned pixel or blob memory. Allocations are 64-byte aligned so SIMD
+    // kernels and uploads can use aligned loads on row starts.
     struct RawData
     {
-        std::unique_ptr<uint8_t[]> Data;
+        static constexpr size_t ALIGNMENT = 64;
+
+        struct AlignedDelete
+        {
+            void operator()(uint8_t *data) const { ::operator delete[](data, std::align_val_t{ALIGNMENT}); }
+        };
+
+        std::unique_ptr<uint8_t[], AlignedDelete> Data;
+        size_t Size{0};
+
+        // Replaces the contents with size uninitialized bytes.
+        void Allocate(size_t size)
+        {
+            Data.reset(size > 0 ? static_cast<uint8_t *>(::operator new[](size, std::align_val_t{ALIGNMENT})) : nullptr);
+            Size = size;
+        }
+    };
+
+    enum class PixelFormat : uint32_t
+    {
+        R8,
+        RGBA8
+    };
+
+    constexpr uint32_t BytesPerPixel(PixelFormat format) { return format == PixelFormat::R8 ? 1u : 4u; }
+
+    // Decoded image, top row first, rows tightly packed.
+    struct Image
+    {
+        uint32_t width{0};
+        uint32_t height{0};
+        PixelFormat format{PixelFormat::RGBA8};
+        RawData pixels;
+
+        size_t RowPitch() const { return size_t(width) * BytesPerPixel(format); }
+    };
+
+    using TextureId = uint32_t;
+    constexpr TextureId INVALID_TEXTURE = 0xffffffffu;
+    constexpr uint32_t INVALID_MATERIAL = 0xffffffffu;
+
+    enum class MaterialSlot : uint32_t
+    {
+        Albedo,
+        Roughness,
+        Metallic,
+        Normal,
+        Mask,
+        Orm,        // occlusion, roughness, metallic in R, G, B; packed by the cooker
+        Count
+    };
+
+    constexpr size_t MATERIAL_SLOT_COUNT = static_cast<size_t>(MaterialSlot::Count);
+
+    // Flat material record. Textures are ids into MaterialTable::texturePaths,
+    // so nothing past import has to look at a string.
+    struct Material
+    {
+        float baseColor[3]{1.0f, 1.0f, 1.0f};
+        float opacity{1.0f};
+        float emissive[3]{0.0f, 0.0f, 0.0f};
+        float specularExponent{0.0f};
+        float ior{1.0f};
+        uint32_t illum{0};
+        // Stand in for the roughness and metallic maps when those slots are empty,
+        // either because the .mtl gave Pr/Pm or because the map was one value.
+        float roughness{1.0f};
+        float metallic{0.0f};
+        TextureId textures[MATERIAL_SLOT_COUNT]{
+            INVALID_TEXTURE, INVALID_TEXTURE, INVALID_TEXTURE, INVALID_TEXTURE, INVALID_TEXTURE, INVALID_TEXTURE
+        };
+
+        TextureId &Texture(MaterialSlot slot) { return textures[static_cast<size_t>(slot)]; }
+        TextureId Texture(MaterialSlot slot) const { return textures[static_cast<size_t>(slot)]; }
+    };
+
+    struct MaterialTable
+    {
+        std::vector<Material> materials;
+
+        // Import-time data: names to resolve usemtl and normalized source paths
+        // of every unique texture, indexed by TextureId.
+        std::vector<std::string> materialNames;
+        std::vector<std::string> texturePaths;
+
+        uint32_t FindMaterial(std::string_view name) const
+        {
+            for (size_t i = 0; i < materialNames.size(); ++i) {
+                if (materialNames[i] == name) {
+                    return static_cast<uint32_t>(i);
+                }
+            }
+            return INVALID_MATERIAL;
+        }
+    };
+
+    // Axis-aligned box, empty (min > max) until the first point is added.
+    struct Bounds
+    {
+        float min[3]{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        float max[3]{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+        void Extend(const float *point)
+        {
+            for (int i = 0; i < 3; ++i) {
+                min[i] = std::min(min[i], point[i]);
+                max[i] = std::max(max[i], point[i]);
+            }
+        }
+
+        void Extend(const Bounds &other)
+        {
+            if (other.IsEmpty()) {
+                return;
+            }
+            Extend(other.min);
+            Extend(other.max);
+        }
+
+        bool IsEmpty() const { return min[0] > max[0]; }
+    };
+
+    // Cluster of up to MAX_MESHLET_VERTICES vertices and MAX_MESHLET_TRIANGLES
+    // triangles, the unit the GPU culls and draws. Sized for mesh shader
+    // groups: 124 triangles keep the primitive indices in 512 bytes.
+    constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+    constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+    struct Meshlet
+    {
+        uint32_t firstVertex{0};    // into the meshlet vertex list
+        uint32_t firstTriangle{0};  // into the meshlet triangle list
+        uint32_t vertexCount{0};
+        uint32_t triangleCount{0};
+    };
+
+    // Bounding sphere and normal cone of a meshlet. Every triangle faces away
+    // from a camera at c when dot(center - c, axis) >= cutoff * |center - c|
+    // + radius * (1 + cutoff); cutoff is the sine of the cone's half angle,
+    // 1 for cones too wide to ever cull.
+    struct MeshletBounds
+    {
+        float center[3]{0.0f, 0.0f, 0.0f};
+        float radius{0.0f};
+        float axis[3]{0.0f, 0.0f, 1.0f};
+        float cutoff{1.0f};
+    };
+
+    // Levels of detail per shape, the full one included.
+    constexpr uint32_t MAX_MESH_LODS = 4;
+
+    // A coarser index list over the vertices of the full detail shape, and
+    // how far its surface strays from the full one, in mesh units.
+    struct MeshLod
+    {
+        std::vector<unsigned int> indices;
+        float error{0.0f};
     };
 
     struct SponzaShape
@@ -17,10 +182,34 @@ namespace Resources::CPU
         {
             std::vector<float> positions;
             std::vector<float> normals;
+            std::vector<float> texcoords;
+            std::vector<float> tangents;    // xyz and the bitangent sign, filled by GenerateTangents
             std::vector<unsigned int> indicies;
             std::string name;
+            uint32_t material{INVALID_MATERIAL};
+            uint32_t vertexCount{0};
+            Bounds bounds;
+
+            // Encoded vertex data when the shape was imported with a VertexLayout.
+            // The float arrays above stay empty in that case.
+            VertexLayout layout;
+            std::vector<uint8_t> streams[MAX_VERTEX_STREAMS];
+            // Decode constants of Unorm16x4 positions, from the shape bounds.
+            VertexQuantization quantization;
+
+            // Filled by BuildMeshlets, empty otherwise. meshletVertices holds
+            // shape vertex numbers, meshletTriangles one triangle each: three
+            // 8-bit indices into the meshlet's vertices, packed low byte first.
+            std::vector<Meshlet> meshlets;
+            std::vector<MeshletBounds> meshletBounds;
+            std::vector<uint32_t> meshletVertices;
+            std::vector<uint32_t> meshletTriangles;
+
+            // Levels 1 and up, filled by GenerateLods; indicies is level 0.
+            std::vector<MeshLod> lods;
         };
 
         std::vector<Shape> shapes;
+        MaterialTable materials;
     };
 };
\ No newline at end of file
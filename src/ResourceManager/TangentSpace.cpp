@@ -0,0 +1,305 @@
+#include "TangentSpace.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint32_t NO_VERTEX = 0xffffffffu;
+    constexpr float SAME_TANGENT_SINE = 1e-4f;
+
+    inline float dot(const float *a, const float *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+    inline void cross(const float *a, const float *b, float *out)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    inline bool normalize(float *v)
+    {
+        const float length = std::sqrt(dot(v, v));
+        if (!(length > 0.0f)) {
+            return false;
+        }
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+        return true;
+    }
+
+    // v without its component along the unit vector n, normalized.
+    inline bool projectOnto(const float *n, const float *v, float *out)
+    {
+        const float along = dot(n, v);
+        out[0] = v[0] - n[0] * along;
+        out[1] = v[1] - n[1] * along;
+        out[2] = v[2] - n[2] * along;
+        return normalize(out);
+    }
+
+    // Some unit vector perpendicular to n, from the axis least aligned with it.
+    void perpendicular(const float *n, float *out)
+    {
+        const float x[3] = {1.0f, 0.0f, 0.0f};
+        const float y[3] = {0.0f, 1.0f, 0.0f};
+        cross(std::fabs(n[0]) < 0.9f ? x : y, n, out);
+        if (!normalize(out)) {
+            std::copy(x, x + 3, out);
+        }
+    }
+
+    // Unit tangent and sign of a vertex with the given normal, nullptr for
+    // none, from its summed directions.
+    void finishTangent(const float *n, const float *sum, bool mirrored, float *tangent)
+    {
+        float normal[3] = {0.0f, 0.0f, 1.0f};
+        if (n != nullptr) {
+            std::copy_n(n, 3, normal);
+        }
+        const bool hasNormal = normalize(normal);
+        // The summed projections already lie in the normal plane, projecting again only removes rounding.
+        if (!(hasNormal ? projectOnto(normal, sum, tangent) : (std::copy_n(sum, 3, tangent), normalize(tangent)))) {
+            perpendicular(normal, tangent);
+        }
+        tangent[3] = mirrored ? -1.0f : 1.0f;
+    }
+
+    // Frames closer than the octahedral tangent encoding can tell apart.
+    bool sameTangent(const float *a, const float *b)
+    {
+        float between[3];
+        cross(a, b, between);
+        return a[3] == b[3] && dot(a, b) > 0.0f && dot(between, between) <= SAME_TANGENT_SINE * SAME_TANGENT_SINE;
+    }
+}
+
+bool Resources::CPU::GenerateTangents(SponzaShape::Shape &shape, TangentStats *stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const size_t vertexCount = shape.vertexCount;
+    if (stats != nullptr) {
+        *stats = TangentStats{};
+        stats->name = shape.name;
+        stats->vertexCount = vertexCount;
+    }
+    if (shape.layout.streamCount != 0 || shape.positions.size() < vertexCount * 3) {
+        return false;
+    }
+
+    const bool hasNormals = shape.normals.size() >= vertexCount * 3;
+    const bool hasTexcoords = shape.texcoords.size() >= vertexCount * 2;
+    const size_t triangleCount = shape.indicies.size() / 3;
+    const size_t cornerCount = triangleCount * 3;
+
+    // Per triangle 1 or -1 by UV orientation, 0 when degenerate; bridges
+    // are triangles without UV area that still span positions, which
+    // MikkTSpace lets join the group of either orientation.
+    std::vector<int8_t> orientations(triangleCount, 0);
+    std::vector<uint8_t> bridges(triangleCount, 0);
+    // Angle weighted direction every corner adds to its group.
+    std::vector<float> contributions(cornerCount * 3, 0.0f);
+    size_t degenerateCount = 0;
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const unsigned int *triangle = &shape.indicies[t * 3];
+        const float *p[3] = {&shape.positions[size_t(triangle[0]) * 3], &shape.positions[size_t(triangle[1]) * 3],
+                             &shape.positions[size_t(triangle[2]) * 3]};
+        const float d1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+        const float d2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+        float faceNormal[3];
+        cross(d1, d2, faceNormal);
+        const bool hasFace = normalize(faceNormal);
+
+        float area = 0.0f;
+        float s[3] = {0.0f, 0.0f, 0.0f};
+        if (hasTexcoords) {
+            const float *uv0 = &shape.texcoords[size_t(triangle[0]) * 2];
+            const float *uv1 = &shape.texcoords[size_t(triangle[1]) * 2];
+            const float *uv2 = &shape.texcoords[size_t(triangle[2]) * 2];
+            const float t21[2] = {uv1[0] - uv0[0], uv1[1] - uv0[1]};
+            const float t31[2] = {uv2[0] - uv0[0], uv2[1] - uv0[1]};
+            area = t21[0] * t31[1] - t21[1] * t31[0];
+            // Direction of increasing u across the triangle, up to the sign of the area.
+            for (int i = 0; i < 3; ++i) {
+                s[i] = (t31[1] * d1[i] - t21[1] * d2[i]) * (area < 0.0f ? -1.0f : 1.0f);
+            }
+        }
+        if (area == 0.0f || !normalize(s)) {
+            ++degenerateCount;
+            bridges[t] = area == 0.0f && hasFace ? 1 : 0;
+            continue;
+        }
+        orientations[t] = area < 0.0f ? -1 : 1;
+
+        for (uint32_t c = 0; c < 3; ++c) {
+            const uint32_t vertex = triangle[c];
+            const float *n = hasNormals ? &shape.normals[size_t(vertex) * 3] : faceNormal;
+            float normal[3] = {n[0], n[1], n[2]};
+            float direction[3];
+            if (!normalize(normal) || !projectOnto(normal, s, direction)) {
+                continue;
+            }
+
+            // Weighted by the angle the triangle spans at this corner, seen along the normal.
+            const float *here = p[c];
+            const float *next = p[(c + 1) % 3];
+            const float *previous = p[(c + 2) % 3];
+            const float toNext[3] = {next[0] - here[0], next[1] - here[1], next[2] - here[2]};
+            const float toPrevious[3] = {previous[0] - here[0], previous[1] - here[1], previous[2] - here[2]};
+            float a[3], b[3];
+            if (!projectOnto(normal, toNext, a) || !projectOnto(normal, toPrevious, b)) {
+                continue;
+            }
+            const float angle = std::acos(std::clamp(dot(a, b), -1.0f, 1.0f));
+            for (int i = 0; i < 3; ++i) {
+                contributions[(t * 3 + c) * 3 + i] = direction[i] * angle;
+            }
+        }
+    }
+
+    // Corners of every vertex, bucketed by vertex.
+    std::vector<uint32_t> firstCorner(vertexCount + 1, 0);
+    for (size_t k = 0; k < cornerCount; ++k) {
+        ++firstCorner[shape.indicies[k] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        firstCorner[v + 1] += firstCorner[v];
+    }
+    std::vector<uint32_t> corners(cornerCount);
+    {
+        std::vector<uint32_t> fill(firstCorner.begin(), firstCorner.end() - 1);
+        for (size_t k = 0; k < cornerCount; ++k) {
+            corners[fill[shape.indicies[k]]++] = static_cast<uint32_t>(k);
+        }
+    }
+
+    // A group is a fan of triangles around one vertex, edge to edge, all
+    // of one orientation. The first group of a vertex keeps it, every
+    // further one gets a copy unless its frame is the same as an earlier
+    // one's, the weld a MikkTSpace caller does on its per-corner output.
+    struct Group
+    {
+        uint32_t vertex;
+        float tangent[4];
+    };
+    std::vector<Group> groups;
+    std::vector<uint32_t> groupOf(cornerCount, NO_VERTEX);
+    std::vector<uint32_t> pending;
+    size_t splitCount = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const uint32_t *begin = corners.data() + firstCorner[v];
+        const uint32_t *end = corners.data() + firstCorner[v + 1];
+        const size_t firstGroup = groups.size();
+        for (const uint32_t *seed = begin; seed != end; ++seed) {
+            const int8_t orientation = orientations[*seed / 3];
+            if (orientation == 0 || groupOf[*seed] != NO_VERTEX) {
+                continue;
+            }
+            const uint32_t group = static_cast<uint32_t>(groups.size());
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+            groupOf[*seed] = group;
+            pending.assign(1, *seed);
+            while (!pending.empty()) {
+                const uint32_t corner = pending.back();
+                pending.pop_back();
+                const float *contribution = &contributions[size_t(corner) * 3];
+                for (int i = 0; i < 3; ++i) {
+                    sum[i] += contribution[i];
+                }
+                const unsigned int *triangle = &shape.indicies[corner / 3 * 3];
+                const unsigned int next = triangle[(corner % 3 + 1) % 3];
+                const unsigned int previous = triangle[(corner % 3 + 2) % 3];
+                for (const uint32_t *other = begin; other != end; ++other) {
+                    const size_t t = *other / 3;
+                    if (groupOf[*other] != NO_VERTEX || (orientations[t] != orientation && !bridges[t])) {
+                        continue;
+                    }
+                    // Neighbours share an edge at this vertex, walked the other way round.
+                    const unsigned int *adjacent = &shape.indicies[t * 3];
+                    if (adjacent[(*other % 3 + 2) % 3] == next || adjacent[(*other % 3 + 1) % 3] == previous) {
+                        groupOf[*other] = group;
+                        pending.push_back(*other);
+                    }
+                }
+            }
+
+            Group value;
+            finishTangent(hasNormals ? &shape.normals[v * 3] : nullptr, sum, orientation < 0, value.tangent);
+            value.vertex = NO_VERTEX;
+            for (size_t other = firstGroup; other < groups.size(); ++other) {
+                if (sameTangent(groups[other].tangent, value.tangent)) {
+                    value.vertex = groups[other].vertex;
+                    break;
+                }
+            }
+            if (value.vertex == NO_VERTEX) {
+                value.vertex = group == firstGroup ? static_cast<uint32_t>(v)
+                                                   : static_cast<uint32_t>(vertexCount + splitCount++);
+            }
+            groups.push_back(value);
+        }
+    }
+
+    const size_t finalCount = vertexCount + splitCount;
+    if (splitCount > 0) {
+        shape.positions.resize(finalCount * 3);
+        if (hasNormals) {
+            shape.normals.resize(finalCount * 3);
+        }
+        if (hasTexcoords) {
+            shape.texcoords.resize(finalCount * 2);
+        }
+        for (size_t k = 0; k < cornerCount; ++k) {
+            if (groupOf[k] == NO_VERTEX) {
+                continue;
+            }
+            unsigned int &index = shape.indicies[k];
+            const uint32_t copy = groups[groupOf[k]].vertex;
+            if (copy != index) {
+                std::copy_n(&shape.positions[size_t(index) * 3], 3, &shape.positions[size_t(copy) * 3]);
+                if (hasNormals) {
+                    std::copy_n(&shape.normals[size_t(index) * 3], 3, &shape.normals[size_t(copy) * 3]);
+                }
+                if (hasTexcoords) {
+                    std::copy_n(&shape.texcoords[size_t(index) * 2], 2, &shape.texcoords[size_t(copy) * 2]);
+                }
+                index = copy;
+            }
+        }
+    }
+
+    // Vertices without any group, only on degenerate triangles or unused, still get a frame.
+    shape.tangents.assign(finalCount * 4, 0.0f);
+    const float none[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t v = 0; v < vertexCount; ++v) {
+        finishTangent(hasNormals ? &shape.normals[v * 3] : nullptr, none, false, &shape.tangents[v * 4]);
+    }
+    for (const Group &group : groups) {
+        std::copy_n(group.tangent, 4, &shape.tangents[size_t(group.vertex) * 4]);
+    }
+    shape.vertexCount = static_cast<uint32_t>(finalCount);
+
+    if (stats != nullptr) {
+        stats->splitCount = splitCount;
+        stats->degenerateCount = degenerateCount;
+        stats->milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+void Resources::CPU::GenerateTangents(SponzaShape &sponza, unsigned threadCount, std::vector<TangentStats> *stats)
+{
+    if (stats != nullptr) {
+        stats->assign(sponza.shapes.size(), TangentStats{});
+    }
+    ParallelFor(sponza.shapes.size(), ResolveThreads(threadCount), [&sponza, stats](size_t i) {
+        GenerateTangents(sponza.shapes[i], stats != nullptr ? &(*stats)[i] : nullptr);
+    });
+}
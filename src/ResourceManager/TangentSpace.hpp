@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Per-vertex tangent frames for normal mapping, computed the way MikkTSpace
+// does so baked normal maps decode as the baker meant them: every triangle
+// contributes its texture-space s direction, projected into the plane of the
+// vertex normal and weighted by the corner angle, summed over a MikkTSpace
+// group, the fan of triangles around the vertex joined edge to edge that
+// share one UV orientation. Triangles without UV area join the first fan
+// that reaches them, as in MikkTSpace, and add nothing to it.
+//
+// A vertex keeps its index for its first group; every further group whose
+// frame differs from the earlier ones by more than the octahedral encoding
+// resolves gets a copy of the vertex. That is where UV mirrors meet, and
+// where a vertex joins fans that touch only at it.
+//
+// Differences from the reference implementation, which the tangents
+// benchmark checks it against per corner:
+//   - vertices are told apart by index, as the importer welded them, not
+//     by comparing positions, normals and texcoords;
+//   - the angular threshold is MikkTSpace's default of 180 degrees, so a
+//     group is never cut into subgroups, and only the unit tangent and the
+//     sign come out, no magnitudes and no separate bitangent;
+//   - corners of degenerate triangles, whose positions collapse or that
+//     span no UV area, take the frame of the vertex's first group, and a
+//     vertex with no group at all gets one perpendicular to its normal
+//     instead of MikkTSpace's fixed (1, 0, 0);
+//   - sums run in float in a different order, so frames match to rounding,
+//     not bit for bit.
+namespace Resources::CPU
+{
+    struct TangentStats
+    {
+        std::string name;
+        size_t vertexCount{0};          // before any split
+        size_t splitCount{0};           // vertices added for further groups, see above
+        size_t degenerateCount{0};      // triangles without texture-space area
+        double milliseconds{0.0};
+    };
+
+    // Fills shape.tangents, four floats a vertex: the unit tangent and the
+    // sign to give cross(normal, tangent) to get the bitangent. Works on the
+    // float arrays only, false for shapes already encoded into streams.
+    // Vertices without any texture-space direction get one perpendicular to
+    // their normal, so the frame is still orthonormal.
+    bool GenerateTangents(SponzaShape::Shape &shape, TangentStats *stats = nullptr);
+
+    // One shape per thread, threadCount 0 picks the hardware concurrency.
+    // stats, if given, gets one entry per shape in shape order.
+    void GenerateTangents(SponzaShape &sponza, unsigned threadCount = 0, std::vector<TangentStats> *stats = nullptr);
+}
@@ -0,0 +1,166 @@
+#include "TextScan.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr float FLOAT_POW10[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+
+    // Longest mantissa that is still exact in a float and can be scaled by
+    // an exact power of ten with a single correctly rounded operation.
+    constexpr int FAST_PATH_MAX_DIGITS = 7;
+    constexpr int FAST_PATH_MAX_EXPONENT = 10;
+}
+
+bool Text::EqualsNoCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        char ca = a[i];
+        char cb = b[i];
+        if (ca >= 'A' && ca <= 'Z') {
+            ca = static_cast<char>(ca - 'A' + 'a');
+        }
+        if (cb >= 'A' && cb <= 'Z') {
+            cb = static_cast<char>(cb - 'A' + 'a');
+        }
+        if (ca != cb) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Text::EndsWithNoCase(std::string_view text, std::string_view suffix)
+{
+    return text.size() >= suffix.size() && EqualsNoCase(text.substr(text.size() - suffix.size()), suffix);
+}
+
+std::string Text::ToLower(std::string_view text)
+{
+    std::string lower{text};
+    for (char &c : lower) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return lower;
+}
+
+std::string_view Text::StemOf(std::string_view path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    const std::string_view name = path.substr(slash == std::string_view::npos ? 0 : slash + 1);
+    return name.substr(0, name.rfind('.'));
+}
+
+bool Text::ParseInt(const char *&cursor, const char *end, int64_t &value)
+{
+    const char *p = cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end || !IsDigit(*p)) {
+        return false;
+    }
+    int64_t result = 0;
+    while (p < end && IsDigit(*p)) {
+        if (result < (int64_t(1) << 40)) {
+            result = result * 10 + (*p - '0');
+        }
+        ++p;
+    }
+    value = negative ? -result : result;
+    cursor = p;
+    return true;
+}
+
+bool Text::ParseFloat(const char *&cursor, const char *end, float &value)
+{
+    const char *p = cursor;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+
+    while (p < end && IsDigit(*p)) {
+        anyDigit = true;
+        if (mantissa != 0 || *p != '0') {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+            } else {
+                ++exponent;
+            }
+            ++digits;
+        }
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && IsDigit(*p)) {
+            anyDigit = true;
+            if (mantissa != 0 || *p != '0') {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    --exponent;
+                }
+                ++digits;
+            } else {
+                --exponent;
+            }
+            ++p;
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *expCursor = p + 1;
+        int64_t expValue = 0;
+        if (ParseInt(expCursor, end, expValue)) {
+            exponent += static_cast<int>(expValue);
+            p = expCursor;
+        }
+    }
+
+    if (mantissa == 0) {
+        value = negative ? -0.0f : 0.0f;
+        cursor = p;
+        return true;
+    }
+
+    if (digits <= FAST_PATH_MAX_DIGITS && exponent >= -FAST_PATH_MAX_EXPONENT && exponent <= FAST_PATH_MAX_EXPONENT) {
+        float result = static_cast<float>(mantissa);
+        result = exponent < 0 ? result / FLOAT_POW10[-exponent] : result * FLOAT_POW10[exponent];
+        value = negative ? -result : result;
+        cursor = p;
+        return true;
+    }
+
+    // Slow path: strtof needs a terminated string, copy the token to the stack.
+    char buffer[128];
+    size_t length = static_cast<size_t>(p - cursor);
+    if (length >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, cursor, length);
+    buffer[length] = '\0';
+    value = std::strtof(buffer, nullptr);
+    cursor = p;
+    return true;
+}
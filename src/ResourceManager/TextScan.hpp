@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// In-place scanning helpers for line based text assets (OBJ, MTL).
+// Scanning works on [cursor, end) ranges of a mapped file and never allocates.
+namespace Resources::CPU::Text
+{
+    inline bool IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    inline bool IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline void SkipBlanks(const char *&cursor, const char *end)
+    {
+        while (cursor < end && IsBlank(*cursor)) {
+            ++cursor;
+        }
+    }
+
+    inline std::string_view NextToken(const char *&cursor, const char *end)
+    {
+        SkipBlanks(cursor, end);
+        const char *begin = cursor;
+        while (cursor < end && !IsBlank(*cursor)) {
+            ++cursor;
+        }
+        return {begin, static_cast<size_t>(cursor - begin)};
+    }
+
+    // Remainder of the line without surrounding blanks, same as objl's tail().
+    inline std::string_view RestOfLine(const char *cursor, const char *end)
+    {
+        SkipBlanks(cursor, end);
+        while (end > cursor && IsBlank(end[-1])) {
+            --end;
+        }
+        return {cursor, static_cast<size_t>(end - cursor)};
+    }
+
+    // Calls fn(line) for every line of text, without the line break.
+    template<typename LineFn>
+    bool ForEachLine(std::string_view text, LineFn &&fn)
+    {
+        const char *cursor = text.data();
+        const char *end = text.data() + text.size();
+        while (cursor < end) {
+            const char *lineEnd = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+            if (lineEnd == nullptr) {
+                lineEnd = end;
+            }
+            if (!fn(cursor, lineEnd)) {
+                return false;
+            }
+            cursor = lineEnd + 1;
+        }
+        return true;
+    }
+
+    bool EqualsNoCase(std::string_view a, std::string_view b);
+    bool EndsWithNoCase(std::string_view text, std::string_view suffix);
+
+    // ASCII lower case copy, the key for paths and names matched regardless of case.
+    std::string ToLower(std::string_view text);
+
+    // File name of path without its directory and last extension.
+    std::string_view StemOf(std::string_view path);
+
+    bool ParseInt(const char *&cursor, const char *end, int64_t &value);
+
+    // Parses a decimal float starting at cursor and advances it past the number.
+    // Short mantissas take an exact float fast path, anything else goes through strtof.
+    bool ParseFloat(const char *&cursor, const char *end, float &value);
+}
@@ -0,0 +1,348 @@
+#include "TextureResidency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint32_t NO_REQUEST = 0xffffffffu;
+
+    // The content hash covers the source pixels. Files cooked from them with
+    // another format or color space are different textures all the same.
+    bool isSameTexture(const CookedTextureHeader &a, const CookedTextureHeader &b)
+    {
+        return a.format == b.format && a.srgb == b.srgb && a.width == b.width && a.height == b.height &&
+               a.mipCount == b.mipCount;
+    }
+}
+
+float Resources::CPU::ProjectedSize(const Bounds &bounds, const CameraView &camera)
+{
+    if (bounds.IsEmpty()) {
+        return 0.0f;
+    }
+    float radiusSquared = 0.0f;
+    float distanceSquared = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        const float half = 0.5f * (bounds.max[i] - bounds.min[i]);
+        const float offset = bounds.min[i] + half - camera.position[i];
+        radiusSquared += half * half;
+        distanceSquared += offset * offset;
+    }
+    if (distanceSquared <= radiusSquared) {
+        return std::numeric_limits<float>::max();
+    }
+    // The sphere subtends asin(r / d) on either side of its center.
+    const float tangent = std::sqrt(radiusSquared / (distanceSquared - radiusSquared));
+    return tangent / std::tan(0.5f * camera.verticalFov) * camera.viewportHeight;
+}
+
+uint32_t Resources::CPU::MipForFootprint(uint32_t width, uint32_t height, uint32_t mipCount, float pixels, float tiling)
+{
+    if (mipCount == 0) {
+        return 0;
+    }
+    const float texels = float(std::max(width, height)) * std::max(tiling, 0.0f);
+    if (pixels <= 0.0f) {
+        return mipCount - 1;
+    }
+    if (texels <= pixels) {
+        return 0;
+    }
+    const float level = std::floor(std::log2(texels / pixels));
+    return static_cast<uint32_t>(std::min(level, float(mipCount - 1)));
+}
+
+TextureResidency::TextureResidency(TextureUploadBackend &backend, const ResidencyOptions &options)
+    : m_backend{backend}
+    , m_options{options}
+{
+}
+
+TextureId TextureResidency::Add(const char *path)
+{
+    Entry entry;
+    if (!entry.file.Open(path)) {
+        return INVALID_TEXTURE;
+    }
+    const CookedTextureHeader &header = entry.file.Header();
+    const auto content = std::make_pair(header.contentHash[0], header.contentHash[1]);
+    if (content.first != 0 || content.second != 0) {
+        auto found = m_byContent.find(content);
+        if (found == m_byContent.end()) {
+            m_byContent.emplace(content, static_cast<TextureId>(m_entries.size()));
+        } else if (isSameTexture(m_entries[found->second].file.Header(), header)) {
+            ++m_stats.sharedCount;
+            m_stats.sharedBytes += header.fileSize;
+            return found->second;
+        }
+    }
+
+    const uint32_t mipCount = entry.file.MipCount();
+    entry.tailMip = mipCount - 1;
+    while (entry.tailMip > 0 && std::max(entry.file.Mip(entry.tailMip - 1).width,
+                                         entry.file.Mip(entry.tailMip - 1).height) <= m_options.tailSize) {
+        --entry.tailMip;
+    }
+    entry.residentMip = mipCount;
+    entry.desiredMip = entry.tailMip;
+    entry.lastUsedFrame = m_frame;
+    m_entries.push_back(std::move(entry));
+    return static_cast<TextureId>(m_entries.size() - 1);
+}
+
+void TextureResidency::RequestFootprint(TextureId texture, const Bounds &bounds, const CameraView &camera, float tiling)
+{
+    if (texture >= m_entries.size()) {
+        return;
+    }
+    const CookedTexture &file = m_entries[texture].file;
+    RequestMip(texture, MipForFootprint(file.Width(), file.Height(), file.MipCount(), ProjectedSize(bounds, camera),
+                                        tiling));
+}
+
+void TextureResidency::RequestMip(TextureId texture, uint32_t level)
+{
+    if (texture < m_entries.size()) {
+        Entry &entry = m_entries[texture];
+        entry.requestedMip = std::min(entry.requestedMip, level);
+    }
+}
+
+void TextureResidency::Update()
+{
+    ++m_frame;
+    retireUploads();
+    applyRequests();
+    issueUploads();
+}
+
+// Counted the way the backend sees them: the mapped range, padding between levels included.
+uint64_t TextureResidency::levelBytes(const Entry &entry, uint32_t first, uint32_t last) const
+{
+    return entry.file.MipRange(first, last).size();
+}
+
+void TextureResidency::retireUploads()
+{
+    for (Entry &entry : m_entries) {
+        if (entry.ticket == 0 || !m_backend.IsComplete(entry.ticket)) {
+            continue;
+        }
+        const uint64_t bytes = levelBytes(entry, entry.uploadFirst, entry.uploadLast);
+        m_stats.inFlightBytes -= bytes;
+        m_stats.residentBytes += bytes;
+        entry.residentMip = entry.uploadFirst;
+        entry.ticket = 0;
+    }
+}
+
+// New wishes replace old ones right away; a texture that nobody asked for
+// this frame keeps its levels and only loses them to the budget.
+void TextureResidency::applyRequests()
+{
+    for (TextureId texture = 0; texture < m_entries.size(); ++texture) {
+        Entry &entry = m_entries[texture];
+        if (entry.requestedMip == NO_REQUEST) {
+            entry.coarserFrames = 0;
+            continue;
+        }
+        entry.desiredMip = std::min(entry.requestedMip, entry.tailMip);
+        entry.requestedMip = NO_REQUEST;
+        entry.lastUsedFrame = m_frame;
+
+        if (entry.desiredMip <= entry.residentMip || entry.ticket != 0) {
+            entry.coarserFrames = 0;
+        } else if (++entry.coarserFrames >= m_options.hysteresisFrames) {
+            m_stats.droppedCount += entry.desiredMip - entry.residentMip;
+            dropLevels(texture, entry.desiredMip);
+            entry.coarserFrames = 0;
+        }
+    }
+}
+
+// Tails first, then the textures used this frame, furthest from what they
+// want first. One step per texture and frame, so the levels of a texture
+// arrive coarse to fine and the budget is spread evenly.
+void TextureResidency::issueUploads()
+{
+    std::vector<TextureId> pending;
+    for (TextureId texture = 0; texture < m_entries.size(); ++texture) {
+        const Entry &entry = m_entries[texture];
+        const bool isWanted = entry.residentMip > entry.tailMip || entry.lastUsedFrame == m_frame;
+        if (entry.ticket == 0 && entry.desiredMip < entry.residentMip && isWanted) {
+            pending.push_back(texture);
+        }
+    }
+    auto priority = [this](TextureId a, TextureId b) {
+        const Entry &left = m_entries[a];
+        const Entry &right = m_entries[b];
+        const bool leftTail = left.residentMip > left.tailMip;
+        const bool rightTail = right.residentMip > right.tailMip;
+        if (leftTail != rightTail) {
+            return leftTail;
+        }
+        const uint32_t leftMissing = left.residentMip - left.desiredMip;
+        const uint32_t rightMissing = right.residentMip - right.desiredMip;
+        return leftMissing != rightMissing ? leftMissing > rightMissing : a < b;
+    };
+    std::sort(pending.begin(), pending.end(), priority);
+
+    uint64_t frameBytes = 0;
+    for (TextureId texture : pending) {
+        Entry &entry = m_entries[texture];
+        const bool isTail = entry.residentMip > entry.tailMip;
+        const uint32_t first = isTail ? entry.tailMip : entry.residentMip - 1;
+        const uint32_t last = isTail ? entry.file.MipCount() - 1 : first;
+        const uint64_t bytes = levelBytes(entry, first, last);
+        if (frameBytes > 0 && frameBytes + bytes > m_options.uploadBytesPerFrame) {
+            break;
+        }
+        if (!isTail && !makeRoom(bytes, texture)) {
+            ++m_stats.deferredCount;
+            continue;
+        }
+
+        const uint64_t ticket = m_backend.Upload(texture, first, last, entry.file.MipRange(first, last));
+        if (ticket == 0) {
+            break;
+        }
+        entry.ticket = ticket;
+        entry.uploadFirst = first;
+        entry.uploadLast = last;
+        frameBytes += bytes;
+        m_stats.inFlightBytes += bytes;
+        m_stats.uploadedBytes += bytes;
+        ++m_stats.uploadCount;
+    }
+}
+
+void TextureResidency::dropLevels(TextureId texture, uint32_t newResidentMip)
+{
+    Entry &entry = m_entries[texture];
+    newResidentMip = std::min(newResidentMip, entry.tailMip);
+    if (newResidentMip <= entry.residentMip) {
+        return;
+    }
+    // Levels past the tail were uploaded one at a time.
+    uint64_t bytes = 0;
+    for (uint32_t level = entry.residentMip; level < newResidentMip; ++level) {
+        bytes += levelBytes(entry, level, level);
+    }
+    m_backend.Evict(texture, entry.residentMip, newResidentMip - 1);
+    entry.residentMip = newResidentMip;
+    m_stats.residentBytes -= bytes;
+    m_stats.evictedBytes += bytes;
+}
+
+// Frees the finest level of the least recently used texture until bytes
+// fit. Textures used this frame only give up levels they hold beyond what
+// they want; the requester and textures with an upload in flight are left alone.
+bool TextureResidency::makeRoom(uint64_t bytes, TextureId requester)
+{
+    while (m_stats.residentBytes + m_stats.inFlightBytes + bytes > m_options.budgetBytes) {
+        TextureId victim = INVALID_TEXTURE;
+        for (TextureId texture = 0; texture < m_entries.size(); ++texture) {
+            const Entry &entry = m_entries[texture];
+            const bool hasSpare = entry.residentMip < entry.tailMip &&
+                                  (entry.lastUsedFrame < m_frame || entry.residentMip < entry.desiredMip);
+            if (texture == requester || entry.ticket != 0 || !hasSpare) {
+                continue;
+            }
+            if (victim == INVALID_TEXTURE || entry.lastUsedFrame < m_entries[victim].lastUsedFrame) {
+                victim = texture;
+            }
+        }
+        if (victim == INVALID_TEXTURE) {
+            return false;
+        }
+        ++m_stats.evictionCount;
+        dropLevels(victim, m_entries[victim].residentMip + 1);
+    }
+    return true;
+}
+
+SimulatedUploadBackend::SimulatedUploadBackend(uint32_t latencyFrames, uint64_t bytesPerFrame)
+    : m_latencyFrames{latencyFrames}
+    , m_bytesPerFrame{bytesPerFrame}
+{
+}
+
+uint64_t SimulatedUploadBackend::Upload(TextureId texture, uint32_t firstLevel, uint32_t lastLevel,
+                                        std::string_view bytes)
+{
+    if (m_frameBytes > 0 && m_frameBytes + bytes.size() > m_bytesPerFrame) {
+        return 0;
+    }
+    const uint32_t levels = ((2u << lastLevel) - 1) & ~((1u << firstLevel) - 1);
+    uint32_t &resident = m_residentLevels[texture];
+    for (const auto &entry : m_copies) {
+        if (entry.second.texture == texture && (entry.second.levels & levels) != 0) {
+            ++m_errorCount;
+        }
+    }
+    if ((resident & levels) != 0) {
+        ++m_errorCount;
+    }
+
+    // Read one byte per page, as the copy into the upload heap would.
+    for (size_t i = 0; i < bytes.size(); i += 4096) {
+        m_checksum += static_cast<uint8_t>(bytes[i]);
+    }
+    std::vector<uint64_t> &sizes = m_levelBytes[texture];
+    sizes.resize(std::max<size_t>(sizes.size(), lastLevel + 1), 0);
+    sizes[firstLevel] += bytes.size();
+
+    m_frameBytes += bytes.size();
+    m_allocatedBytes += bytes.size();
+    m_peakBytes = std::max(m_peakBytes, m_allocatedBytes);
+    const uint64_t ticket = m_nextTicket++;
+    m_copies.emplace(ticket, Copy{texture, levels, m_frame + m_latencyFrames});
+    return ticket;
+}
+
+bool SimulatedUploadBackend::IsComplete(uint64_t ticket)
+{
+    auto found = m_copies.find(ticket);
+    if (found == m_copies.end()) {
+        return true;
+    }
+    if (found->second.completeFrame > m_frame) {
+        return false;
+    }
+    m_residentLevels[found->second.texture] |= found->second.levels;
+    m_copies.erase(found);
+    return true;
+}
+
+void SimulatedUploadBackend::Evict(TextureId texture, uint32_t firstLevel, uint32_t lastLevel)
+{
+    const uint32_t levels = ((2u << lastLevel) - 1) & ~((1u << firstLevel) - 1);
+    uint32_t &resident = m_residentLevels[texture];
+    if ((resident & levels) != levels) {
+        ++m_errorCount;
+    }
+    resident &= ~levels;
+
+    // Uploads are single levels except for tails, which are never evicted.
+    std::vector<uint64_t> &sizes = m_levelBytes[texture];
+    for (uint32_t level = firstLevel; level <= lastLevel && level < sizes.size(); ++level) {
+        m_allocatedBytes -= sizes[level];
+        sizes[level] = 0;
+    }
+}
+
+void SimulatedUploadBackend::AdvanceFrame()
+{
+    ++m_frame;
+    m_frameBytes = 0;
+}
+
+uint32_t SimulatedUploadBackend::ResidentLevels(TextureId texture) const
+{
+    auto found = m_residentLevels.find(texture);
+    return found != m_residentLevels.end() ? found->second : 0;
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "CookedTexture.hpp"
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // Where uploaded mip levels go. The renderer implements it on top of its
+    // upload heap and copy queue; SimulatedUploadBackend stands in for it
+    // when there is no GPU.
+    class TextureUploadBackend
+    {
+    public:
+        virtual ~TextureUploadBackend() = default;
+
+        // Starts copying levels [firstLevel, lastLevel] of texture, laid out as
+        // CookedTexture::MipRange returns them. Returns a ticket for IsComplete,
+        // or 0 when the backend cannot take more work this frame.
+        virtual uint64_t Upload(TextureId texture, uint32_t firstLevel, uint32_t lastLevel, std::string_view bytes) = 0;
+        virtual bool IsComplete(uint64_t ticket) = 0;
+        // Levels [firstLevel, lastLevel] are no longer sampled and can be freed.
+        virtual void Evict(TextureId texture, uint32_t firstLevel, uint32_t lastLevel) = 0;
+    };
+
+    struct ResidencyOptions
+    {
+        // Resident levels plus uploads in flight stay below this. Mip tails
+        // are the exception: a texture always gets its tail, over budget or not.
+        uint64_t budgetBytes{256ull << 20};
+        // Levels this size and smaller are loaded with the texture in one
+        // upload and never evicted, so there is always something to sample.
+        uint32_t tailSize{64};
+        // Frames a texture must want fewer levels before they are dropped;
+        // keeps a camera moving back and forth from streaming the same level.
+        uint32_t hysteresisFrames{30};
+        uint64_t uploadBytesPerFrame{16ull << 20};
+    };
+
+    struct ResidencyStats
+    {
+        uint64_t residentBytes{0};
+        uint64_t inFlightBytes{0};
+        uint64_t uploadedBytes{0};
+        uint64_t evictedBytes{0};
+        size_t uploadCount{0};
+        size_t evictionCount{0};    // levels freed for the budget, least recently used first
+        size_t droppedCount{0};     // levels freed because the texture got small on screen
+        size_t deferredCount{0};    // uploads that did not fit the budget and waited
+        size_t sharedCount{0};      // Add calls answered with a texture already added
+        uint64_t sharedBytes{0};    // file bytes those did not map a second time
+    };
+
+    struct CameraView
+    {
+        float position[3]{0.0f, 0.0f, 0.0f};
+        float verticalFov{1.0f};        // radians
+        float viewportHeight{1080.0f};  // pixels
+    };
+
+    // Screen pixels spanned by the bounding sphere of bounds; effectively
+    // infinite when the camera is inside it.
+    float ProjectedSize(const Bounds &bounds, const CameraView &camera);
+
+    // Finest level worth having for a texture covering pixels screen pixels
+    // and repeating tiling times across them.
+    uint32_t MipForFootprint(uint32_t width, uint32_t height, uint32_t mipCount, float pixels, float tiling = 1.0f);
+
+    // Decides which mip levels of which cooked textures live in GPU memory.
+    // Each frame the renderer reports what it draws with RequestFootprint or
+    // RequestMip, then calls Update once: finished uploads become resident,
+    // levels a texture has not needed for a while are dropped, and missing
+    // levels are uploaded one per texture and frame, finest last. When the
+    // budget is full the levels of the least recently used textures go first.
+    //
+    // Single threaded like the frame loop that drives it; the .ctex files are
+    // mapped, so only the ranges handed to the backend are ever read.
+    class TextureResidency
+    {
+    public:
+        explicit TextureResidency(TextureUploadBackend &backend, const ResidencyOptions &options = {});
+
+        // Maps a .ctex; its tail is uploaded by the next Update. INVALID_TEXTURE
+        // when it does not open. A file with the content hash, format and
+        // color space of one already added gets that texture's id, so scenes
+        // referencing the same image under different names share its levels.
+        TextureId Add(const char *path);
+        size_t TextureCount() const { return m_entries.size(); }
+        const CookedTexture &Texture(TextureId texture) const { return m_entries[texture].file; }
+
+        void RequestFootprint(TextureId texture, const Bounds &bounds, const CameraView &camera, float tiling = 1.0f);
+        void RequestMip(TextureId texture, uint32_t level);
+
+        void Update();
+
+        // Finest level the GPU can sample, MipCount() before the tail arrived.
+        uint32_t ResidentMip(TextureId texture) const { return m_entries[texture].residentMip; }
+        uint32_t DesiredMip(TextureId texture) const { return m_entries[texture].desiredMip; }
+        uint32_t TailMip(TextureId texture) const { return m_entries[texture].tailMip; }
+        bool IsUploading(TextureId texture) const { return m_entries[texture].ticket != 0; }
+
+        void SetBudget(uint64_t bytes) { m_options.budgetBytes = bytes; }
+        const ResidencyOptions &Options() const { return m_options; }
+        const ResidencyStats &Stats() const { return m_stats; }
+        uint64_t Frame() const { return m_frame; }
+
+    private:
+        struct Entry
+        {
+            CookedTexture file;
+            uint32_t tailMip{0};
+            uint32_t residentMip{0};
+            uint32_t desiredMip{0};
+            uint32_t requestedMip{0xffffffffu};  // finest request this frame
+            uint32_t coarserFrames{0};           // consecutive frames desiredMip > residentMip
+            uint64_t lastUsedFrame{0};
+            uint64_t ticket{0};
+            uint32_t uploadFirst{0};
+            uint32_t uploadLast{0};
+        };
+
+        uint64_t levelBytes(const Entry &entry, uint32_t first, uint32_t last) const;
+        void retireUploads();
+        void applyRequests();
+        void issueUploads();
+        void dropLevels(TextureId texture, uint32_t newResidentMip);
+        bool makeRoom(uint64_t bytes, TextureId requester);
+
+        TextureUploadBackend &m_backend;
+        ResidencyOptions m_options;
+        ResidencyStats m_stats;
+        std::vector<Entry> m_entries;
+        std::map<std::pair<uint64_t, uint64_t>, TextureId> m_byContent;
+        uint64_t m_frame{0};
+    };
+
+    // Upload backend without a GPU: copies finish latencyFrames frames after
+    // they were issued and at most bytesPerFrame are accepted per frame. It
+    // keeps its own record of what is resident, to check the manager against.
+    class SimulatedUploadBackend : public TextureUploadBackend
+    {
+    public:
+        explicit SimulatedUploadBackend(uint32_t latencyFrames = 2, uint64_t bytesPerFrame = UINT64_MAX);
+
+        uint64_t Upload(TextureId texture, uint32_t firstLevel, uint32_t lastLevel, std::string_view bytes) override;
+        bool IsComplete(uint64_t ticket) override;
+        void Evict(TextureId texture, uint32_t firstLevel, uint32_t lastLevel) override;
+
+        // Ends the frame: the copy queue moves on by one frame.
+        void AdvanceFrame();
+
+        // Bytes allocated for resident levels and copies in flight.
+        uint64_t AllocatedBytes() const { return m_allocatedBytes; }
+        uint64_t PeakBytes() const { return m_peakBytes; }
+        // Levels of texture the GPU holds, as a bit mask; bit n is level n.
+        uint32_t ResidentLevels(TextureId texture) const;
+        // Upload or eviction calls that did not match the backend's state.
+        size_t ErrorCount() const { return m_errorCount; }
+
+    private:
+        struct Copy
+        {
+            TextureId texture;
+            uint32_t levels;
+            uint64_t completeFrame;
+        };
+
+        uint32_t m_latencyFrames;
+        uint64_t m_bytesPerFrame;
+        uint64_t m_frame{0};
+        uint64_t m_frameBytes{0};
+        uint64_t m_nextTicket{1};
+        uint64_t m_allocatedBytes{0};
+        uint64_t m_peakBytes{0};
+        size_t m_errorCount{0};
+        uint64_t m_checksum{0};
+        std::unordered_map<uint64_t, Copy> m_copies;
+        std::unordered_map<TextureId, uint32_t> m_residentLevels;
+        std::unordered_map<TextureId, std::vector<uint64_t>> m_levelBytes;
+    };
+}
@@ -0,0 +1,304 @@
+#include "TgaDecoder.hpp"
+
+#include "CpuFeatures.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if CHELSON_X86
+#include <immintrin.h>
+#endif
+
+using namespace Resources::CPU;
+using namespace Resources::CPU::Tga;
+
+namespace
+{
+    // Converts count source pixels into count destination pixels. Kernels
+    // never read past the count source pixels, so they can run on RLE raw
+    // packets in the middle of the file as well as on whole rows.
+    using SpanKernel = void (*)(const uint8_t *source, uint8_t *destination, size_t count);
+
+    uint16_t readU16(const uint8_t *bytes) { return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8)); }
+
+    void copyGrey(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        std::memcpy(destination, source, count);
+    }
+
+    void swizzleBgrScalar(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i, source += 3, destination += 4) {
+            destination[0] = source[2];
+            destination[1] = source[1];
+            destination[2] = source[0];
+            destination[3] = 0xff;
+        }
+    }
+
+    void swizzleBgraScalar(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i, source += 4, destination += 4) {
+            destination[0] = source[2];
+            destination[1] = source[1];
+            destination[2] = source[0];
+            destination[3] = source[3];
+        }
+    }
+
+#if CHELSON_X86
+    // Four BGR pixels (12 bytes) to four RGBA pixels, the high lanes become alpha.
+    CHELSON_TARGET_SSSE3 void swizzleBgrSsse3(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+        size_t i = 0;
+        // A load covers 16 source bytes of which 12 are used, keep it inside the span.
+        for (; i + 6 <= count; i += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * 4),
+                             _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+        }
+        swizzleBgrScalar(source + i * 3, destination + i * 4, count - i);
+    }
+
+    CHELSON_TARGET_SSSE3 void swizzleBgraSsse3(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+        }
+        swizzleBgraScalar(source + i * 4, destination + i * 4, count - i);
+    }
+
+    // Eight BGR pixels per step: each 128-bit lane gets four of them, loaded
+    // from offsets 0 and 12, and the in-lane shuffle does the rest.
+    CHELSON_TARGET_AVX2 void swizzleBgrAvx2(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                                 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+        size_t i = 0;
+        // The upper load ends 28 bytes in, i.e. inside the tenth pixel.
+        for (; i + 10 <= count; i += 8) {
+            const uint8_t *pixels = source + i * 3;
+            const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + 12));
+            const __m256i both = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i * 4),
+                                _mm256_or_si256(_mm256_shuffle_epi8(both, shuffle), alpha));
+        }
+        swizzleBgrScalar(source + i * 3, destination + i * 4, count - i);
+    }
+
+    CHELSON_TARGET_AVX2 void swizzleBgraAvx2(const uint8_t *source, uint8_t *destination, size_t count)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i * 4), _mm256_shuffle_epi8(pixels, shuffle));
+        }
+        swizzleBgraScalar(source + i * 4, destination + i * 4, count - i);
+    }
+#endif
+
+    SpanKernel pickKernel(uint32_t bytesPerPixel)
+    {
+        if (bytesPerPixel == 1) {
+            return &copyGrey;
+        }
+        const bool bgr = bytesPerPixel == 3;
+        switch (ActiveSimdLevel()) {
+#if CHELSON_X86
+        case SimdLevel::Avx2: return bgr ? &swizzleBgrAvx2 : &swizzleBgraAvx2;
+        case SimdLevel::Ssse3: return bgr ? &swizzleBgrSsse3 : &swizzleBgraSsse3;
+#endif
+        default: return bgr ? &swizzleBgrScalar : &swizzleBgraScalar;
+        }
+    }
+
+    // Destination row for the n-th row stored in the file.
+    uint8_t *destinationRow(Image &image, bool topDown, uint32_t row)
+    {
+        const uint32_t y = topDown ? row : image.height - 1 - row;
+        return image.pixels.Data.get() + y * image.RowPitch();
+    }
+
+    bool decodeRaw(const uint8_t *source, const uint8_t *end, uint32_t sourceBpp, bool topDown, SpanKernel kernel,
+                   Image &image)
+    {
+        const size_t sourcePitch = size_t(image.width) * sourceBpp;
+        if (size_t(end - source) / sourcePitch < image.height) {
+            return false;
+        }
+        for (uint32_t row = 0; row < image.height; ++row, source += sourcePitch) {
+            kernel(source, destinationRow(image, topDown, row), image.width);
+        }
+        return true;
+    }
+
+    // Packets are allowed to run across row ends, so they are cut into
+    // per-row pieces as they are consumed.
+    bool decodeRle(const uint8_t *source, const uint8_t *end, uint32_t sourceBpp, bool topDown, SpanKernel kernel,
+                   Image &image)
+    {
+        const uint32_t destinationBpp = BytesPerPixel(image.format);
+        uint32_t row = 0;
+        uint32_t x = 0;
+        uint8_t *destination = destinationRow(image, topDown, 0);
+        while (row < image.height) {
+            if (source >= end) {
+                return false;
+            }
+            const uint8_t packet = *source++;
+            uint32_t count = (packet & 0x7fu) + 1;
+            const bool isRun = (packet & 0x80u) != 0;
+            const size_t packetBytes = size_t(isRun ? 1 : count) * sourceBpp;
+            if (size_t(end - source) < packetBytes) {
+                return false;
+            }
+
+            uint8_t value[4];
+            if (isRun) {
+                kernel(source, value, 1);
+            }
+            while (count > 0) {
+                const uint32_t span = std::min(count, image.width - x);
+                uint8_t *target = destination + size_t(x) * destinationBpp;
+                if (!isRun) {
+                    kernel(source, target, span);
+                    source += size_t(span) * sourceBpp;
+                } else if (destinationBpp == 1) {
+                    std::memset(target, value[0], span);
+                } else {
+                    for (uint32_t i = 0; i < span; ++i) {
+                        std::memcpy(target + i * 4, value, 4);
+                    }
+                }
+                count -= span;
+                x += span;
+                if (x == image.width) {
+                    x = 0;
+                    if (++row == image.height) {
+                        // Trailing pixels of the last packet are dropped, like other readers do.
+                        break;
+                    }
+                    destination = destinationRow(image, topDown, row);
+                }
+            }
+            if (isRun) {
+                source += sourceBpp;
+            }
+        }
+        return true;
+    }
+}
+
+size_t Header::DataOffset() const
+{
+    return HEADER_SIZE + idLength + (colorMapType != 0 ? size_t(colorMapLength) * ((colorMapEntrySize + 7) / 8) : 0);
+}
+
+bool Resources::CPU::Tga::ReadHeader(std::string_view bytes, Header &header)
+{
+    if (bytes.size() < HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(bytes.data());
+    header.idLength = data[0];
+    header.colorMapType = data[1];
+    header.imageType = data[2];
+    header.colorMapLength = readU16(data + 5);
+    header.colorMapEntrySize = data[7];
+    header.width = readU16(data + 12);
+    header.height = readU16(data + 14);
+    header.bitsPerPixel = data[16];
+    header.descriptor = data[17];
+
+    const bool isGrey = header.imageType == 3 || header.imageType == 11;
+    const bool isTrueColor = header.imageType == 2 || header.imageType == 10;
+    if (isGrey ? header.bitsPerPixel != 8 : !isTrueColor || (header.bitsPerPixel != 24 && header.bitsPerPixel != 32)) {
+        return false;
+    }
+    // Right-to-left storage does not occur in practice and is not supported.
+    if ((header.descriptor & 0x10) != 0 || header.colorMapType > 1) {
+        return false;
+    }
+    return header.width > 0 && header.height > 0 && header.DataOffset() <= bytes.size();
+}
+
+bool Resources::CPU::Tga::Decode(std::string_view bytes, Image &image)
+{
+    Header header;
+    if (!ReadHeader(bytes, header)) {
+        return false;
+    }
+
+    const uint32_t sourceBpp = header.bitsPerPixel / 8;
+    image.width = header.width;
+    image.height = header.height;
+    image.format = sourceBpp == 1 ? PixelFormat::R8 : PixelFormat::RGBA8;
+    const size_t size = image.RowPitch() * image.height;
+    if (image.pixels.Size != size) {
+        image.pixels.Allocate(size);
+    }
+
+    const uint8_t *source = reinterpret_cast<const uint8_t *>(bytes.data()) + header.DataOffset();
+    const uint8_t *end = reinterpret_cast<const uint8_t *>(bytes.data()) + bytes.size();
+    const SpanKernel kernel = pickKernel(sourceBpp);
+    if (header.IsRle()) {
+        return decodeRle(source, end, sourceBpp, header.IsTopDown(), kernel, image);
+    }
+    return decodeRaw(source, end, sourceBpp, header.IsTopDown(), kernel, image);
+}
+
+bool Resources::CPU::Tga::LoadFile(const char *path, Image &image)
+{
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    return Decode(file.View(), image);
+}
+
+bool Resources::CPU::Tga::WriteFile(const char *path, const Image &image)
+{
+    if (image.width == 0 || image.height == 0 || image.width > 0xffff || image.height > 0xffff ||
+        image.pixels.Size != image.RowPitch() * image.height) {
+        return false;
+    }
+
+    const bool isGrey = image.format == PixelFormat::R8;
+    const uint8_t header[HEADER_SIZE] = {
+        0, 0, static_cast<uint8_t>(isGrey ? 3 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        static_cast<uint8_t>(image.width), static_cast<uint8_t>(image.width >> 8),
+        static_cast<uint8_t>(image.height), static_cast<uint8_t>(image.height >> 8),
+        static_cast<uint8_t>(isGrey ? 8 : 32), static_cast<uint8_t>(isGrey ? 0x20 : 0x28),
+    };
+    std::vector<uint8_t> bytes(HEADER_SIZE + image.pixels.Size);
+    std::memcpy(bytes.data(), header, HEADER_SIZE);
+    // Swapping R and B is its own inverse, the decoder kernel does the job.
+    pickKernel(isGrey ? 1 : 4)(image.pixels.Data.get(), bytes.data() + HEADER_SIZE,
+                               size_t(image.width) * image.height);
+
+    const std::string temporary = std::string(path) + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::remove(path);
+    return std::rename(temporary.c_str(), path) == 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ResourceType.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+// Truevision TGA reader (and a minimal writer) for the texture sets the assets ship with.
+// Pixels are converted straight from the mapped file into the destination
+// rows: there is no intermediate copy of the file or of a decompressed image,
+// and bottom-up files are flipped by the row they are written to.
+namespace Resources::CPU::Tga
+{
+    enum class ImageType : uint8_t
+    {
+        TrueColor = 2,
+        Grey = 3,
+        TrueColorRle = 10,
+        GreyRle = 11
+    };
+
+    struct Header
+    {
+        uint8_t idLength{0};
+        uint8_t colorMapType{0};
+        uint8_t imageType{0};
+        uint16_t colorMapLength{0};
+        uint8_t colorMapEntrySize{0};
+        uint16_t width{0};
+        uint16_t height{0};
+        uint8_t bitsPerPixel{0};
+        uint8_t descriptor{0};
+
+        bool IsRle() const { return imageType == 10 || imageType == 11; }
+        bool IsTopDown() const { return (descriptor & 0x20) != 0; }
+        // Offset of the first pixel packet, past the id field and any color map.
+        size_t DataOffset() const;
+    };
+
+    constexpr size_t HEADER_SIZE = 18;
+
+    // Parses and validates the 18-byte header. Supported are types 2, 3, 10
+    // and 11 with 8-bit grey or 24/32-bit BGR(A) pixels stored left to right.
+    bool ReadHeader(std::string_view bytes, Header &header);
+
+    // Grey images decode to R8, true color ones to RGBA8 with alpha 255 for
+    // 24-bit sources. The pixel memory is reused when it already has the
+    // right size, so decoding a series of equally sized files allocates once.
+    bool Decode(std::string_view bytes, Image &image);
+    bool LoadFile(const char *path, Image &image);
+
+    // Writes an uncompressed top-down file: type 3 for R8, type 2 with 32-bit
+    // BGRA for RGBA8. Goes through a temporary file like the other writers.
+    bool WriteFile(const char *path, const Image &image);
+}
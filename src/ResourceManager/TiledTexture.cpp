@@ -0,0 +1,195 @@
+#include "TiledTexture.hpp"
+
+#include "MappedFile.hpp"
+#include "MipGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+    uint32_t levelSize(uint32_t size, uint32_t level) { return std::max(1u, size >> level); }
+
+    uint32_t tilesFor(uint32_t size) { return (size + VIRTUAL_TILE_CONTENT - 1) / VIRTUAL_TILE_CONTENT; }
+
+    // Tiles start on the first placement boundary after the header.
+    uint64_t firstTileOffset() { return alignUp(sizeof(TiledTextureHeader), TEXTURE_PLACEMENT_ALIGNMENT); }
+
+    // Bytes of one texel, or of one 4x4 block for BC formats.
+    uint32_t unitBytes(TextureFormat format)
+    {
+        return IsBlockCompressed(format) ? TextureRowBytes(format, 4) : TextureRowBytes(format, 1);
+    }
+
+    // Texels, or blocks, along one side of a tile, and of its border.
+    uint32_t tileUnits(TextureFormat format) { return TextureRowCount(format, VIRTUAL_TILE_SIZE); }
+    uint32_t borderUnits(TextureFormat format) { return TextureRowCount(format, VIRTUAL_TILE_BORDER); }
+
+    // Unit number value of a level count units long, wrapped around it.
+    uint32_t wrap(int64_t value, uint32_t count)
+    {
+        const int64_t remainder = value % int64_t(count);
+        return static_cast<uint32_t>(remainder < 0 ? remainder + count : remainder);
+    }
+
+    // Copies the tile at (tileX, tileY) of a tightly packed level with its
+    // border, wrapping reads past the edges around the level.
+    void copyTile(const RawData &level, TextureFormat format, uint32_t width, uint32_t height, uint32_t tileX,
+                  uint32_t tileY, uint8_t *tile)
+    {
+        const uint32_t unit = unitBytes(format);
+        const uint32_t units = tileUnits(format);
+        const uint32_t border = borderUnits(format);
+        const uint32_t content = units - 2 * border;
+        const uint32_t levelColumns = TextureRowBytes(format, width) / unit;
+        const uint32_t levelRows = TextureRowCount(format, height);
+        const size_t levelPitch = size_t(levelColumns) * unit;
+        const uint32_t pitch = TiledRowPitch(format);
+
+        const int64_t firstColumn = int64_t(tileX) * content - border;
+        const int64_t firstRow = int64_t(tileY) * content - border;
+        for (uint32_t row = 0; row < units; ++row) {
+            const uint8_t *source = level.Data.get() + wrap(firstRow + row, levelRows) * levelPitch;
+            uint8_t *destination = tile + size_t(row) * pitch;
+            // Runs of columns up to the right edge of the level, then from its left edge again.
+            for (uint32_t column = 0; column < units;) {
+                const uint32_t sourceColumn = wrap(firstColumn + column, levelColumns);
+                const uint32_t run = std::min(units - column, levelColumns - sourceColumn);
+                std::memcpy(destination + size_t(column) * unit, source + size_t(sourceColumn) * unit,
+                            size_t(run) * unit);
+                column += run;
+            }
+        }
+    }
+}
+
+uint32_t Resources::CPU::TiledRowPitch(TextureFormat format)
+{
+    return static_cast<uint32_t>(alignUp(TextureRowBytes(format, VIRTUAL_TILE_SIZE), TEXTURE_PITCH_ALIGNMENT));
+}
+
+uint32_t Resources::CPU::TiledTileBytes(TextureFormat format)
+{
+    return static_cast<uint32_t>(
+        alignUp(uint64_t(TiledRowPitch(format)) * tileUnits(format), TEXTURE_PLACEMENT_ALIGNMENT));
+}
+
+uint32_t Resources::CPU::TiledMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    while (count < MAX_TEXTURE_MIPS && std::max(levelSize(width, count - 1), levelSize(height, count - 1)) >
+                                           VIRTUAL_TILE_CONTENT) {
+        ++count;
+    }
+    return count;
+}
+
+bool Resources::CPU::WriteTiledTexture(const char *path, const TextureLevels &texture)
+{
+    if (texture.width == 0 || texture.height == 0 || texture.format >= TextureFormat::Count ||
+        texture.levels.empty()) {
+        return false;
+    }
+    const uint32_t mipCount = std::min<uint32_t>(TiledMipCount(texture.width, texture.height),
+                                                 static_cast<uint32_t>(texture.levels.size()));
+
+    TiledTextureHeader header;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipCount = mipCount;
+    header.format = texture.format;
+    header.srgb = texture.srgb ? 1 : 0;
+    header.tileBytes = TiledTileBytes(texture.format);
+    header.contentHash[0] = texture.contentHash[0];
+    header.contentHash[1] = texture.contentHash[1];
+
+    // Coarsest level first, like .ctex.
+    for (uint32_t level = mipCount; level-- > 0;) {
+        TiledMip &mip = header.mips[level];
+        mip.width = levelSize(texture.width, level);
+        mip.height = levelSize(texture.height, level);
+        mip.tilesX = tilesFor(mip.width);
+        mip.tilesY = tilesFor(mip.height);
+        mip.firstTile = header.tileCount;
+        const uint64_t levelBytes =
+            uint64_t(TextureRowBytes(texture.format, mip.width)) * TextureRowCount(texture.format, mip.height);
+        if (texture.levels[level].Size != levelBytes) {
+            return false;
+        }
+        header.tileCount += mip.tilesX * mip.tilesY;
+    }
+    header.fileSize = firstTileOffset() + uint64_t(header.tileCount) * header.tileBytes;
+
+    std::vector<uint8_t> bytes(header.fileSize, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    for (uint32_t level = 0; level < mipCount; ++level) {
+        const TiledMip &mip = header.mips[level];
+        for (uint32_t y = 0; y < mip.tilesY; ++y) {
+            for (uint32_t x = 0; x < mip.tilesX; ++x) {
+                const uint64_t index = mip.firstTile + y * mip.tilesX + x;
+                copyTile(texture.levels[level], texture.format, mip.width, mip.height, x, y,
+                         bytes.data() + firstTileOffset() + index * header.tileBytes);
+            }
+        }
+    }
+    return WriteFileAtomic(path, bytes.data(), bytes.size());
+}
+
+bool TiledTexture::Open(const char *path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.Size() < sizeof(TiledTextureHeader)) {
+        m_file.Close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const TiledTextureHeader *>(m_file.Data());
+    if (!validate()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void TiledTexture::Close()
+{
+    m_header = nullptr;
+    m_file.Close();
+}
+
+std::string_view TiledTexture::Tile(uint32_t index) const
+{
+    if (index >= m_header->tileCount) {
+        return {};
+    }
+    return m_file.View().substr(firstTileOffset() + uint64_t(index) * m_header->tileBytes, m_header->tileBytes);
+}
+
+bool TiledTexture::validate() const
+{
+    const TiledTextureHeader &header = *m_header;
+    if (header.magic != TILED_TEXTURE_MAGIC || header.version != TILED_TEXTURE_VERSION ||
+        header.fileSize != m_file.Size() || header.format >= TextureFormat::Count || header.width == 0 ||
+        header.height == 0 || header.mipCount == 0 || header.mipCount > TiledMipCount(header.width, header.height) ||
+        header.tileSize != VIRTUAL_TILE_SIZE || header.tileBytes != TiledTileBytes(header.format)) {
+        return false;
+    }
+
+    // The tile grids must be the ones the writer lays out, packed coarsest first.
+    uint32_t tileCount = 0;
+    for (uint32_t level = header.mipCount; level-- > 0;) {
+        const TiledMip &mip = header.mips[level];
+        if (mip.width != levelSize(header.width, level) || mip.height != levelSize(header.height, level) ||
+            mip.tilesX != tilesFor(mip.width) || mip.tilesY != tilesFor(mip.height) || mip.firstTile != tileCount) {
+            return false;
+        }
+        tileCount += mip.tilesX * mip.tilesY;
+    }
+    return tileCount == header.tileCount &&
+           header.fileSize == firstTileOffset() + uint64_t(header.tileCount) * header.tileBytes;
+}
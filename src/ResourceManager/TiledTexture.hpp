@@ -0,0 +1,114 @@
+#pragma once
+
+#include "CookedTexture.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace Resources::CPU
+{
+    // .cvt is the cooked form of a virtual texture: the mip chain cut into
+    // square tiles of VIRTUAL_TILE_SIZE texels, stored one after the other
+    // behind a fixed header, coarsest level first and row by row inside a
+    // level. Each tile holds VIRTUAL_TILE_CONTENT texels of its level inside
+    // a border of VIRTUAL_TILE_BORDER texels copied from the neighbouring
+    // tiles, so bilinear and up to 4x anisotropic filtering inside a cache
+    // slot read the same texels as on the whole level. Texel p of a level
+    // lives in tile p / VIRTUAL_TILE_CONTENT at VIRTUAL_TILE_BORDER +
+    // p % VIRTUAL_TILE_CONTENT. Borders and the filler past the right and
+    // bottom edges wrap around the level, as repeat addressing samples it;
+    // clamped textures may see the opposite edge in their outermost texel.
+    // For BC formats the border is one block, and a level whose size is
+    // not a multiple of 4 wraps by whole blocks.
+    //
+    // Every tile has the same size in bytes whatever its position. A tile
+    // is thus one contiguous range of the mapped file that fits any slot of
+    // the physical tile cache, and its rows are TEXTURE_PITCH_ALIGNMENT
+    // apart like .ctex levels so it can be copied into upload memory as is.
+    //
+    // The chain stops at the first level that fits in one tile; everything
+    // coarser would only ever be sampled from that tile anyway.
+    //
+    //   header | mip n-1 tiles | ... | mip 0 tiles
+    constexpr uint32_t TILED_TEXTURE_MAGIC = 0x58545643u;  // "CVTX"
+    constexpr uint32_t TILED_TEXTURE_VERSION = 2;
+    constexpr uint32_t VIRTUAL_TILE_SIZE = 128;     // stored texels per side, border included
+    constexpr uint32_t VIRTUAL_TILE_BORDER = 4;
+    constexpr uint32_t VIRTUAL_TILE_CONTENT = VIRTUAL_TILE_SIZE - 2 * VIRTUAL_TILE_BORDER;
+
+    struct TiledMip
+    {
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t tilesX{0};
+        uint32_t tilesY{0};
+        uint32_t firstTile{0};  // index of the tile at (0, 0)
+        uint32_t reserved{0};
+    };
+
+    struct TiledTextureHeader
+    {
+        uint32_t magic{TILED_TEXTURE_MAGIC};
+        uint32_t version{TILED_TEXTURE_VERSION};
+        uint64_t fileSize{0};
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t mipCount{0};
+        TextureFormat format{TextureFormat::RGBA8};
+        uint32_t srgb{0};
+        uint32_t tileSize{VIRTUAL_TILE_SIZE};   // VIRTUAL_TILE_CONTENT of it per tile are the tile's own
+        uint32_t tileBytes{0};  // TiledRowPitch * rows of one tile, placement aligned
+        uint32_t tileCount{0};
+        uint64_t contentHash[2]{0, 0};      // as in CookedTextureHeader
+        TiledMip mips[MAX_TEXTURE_MIPS];    // indexed by level, 0 is the full size
+    };
+
+    static_assert(sizeof(TiledTextureHeader) % 64 == 0, "mip table must stay aligned");
+
+    // Distance between the texel (or block) rows of a tile.
+    uint32_t TiledRowPitch(TextureFormat format);
+    uint32_t TiledTileBytes(TextureFormat format);
+    // Levels a width x height texture is cut into: down to the first one
+    // that fits the content of a tile.
+    uint32_t TiledMipCount(uint32_t width, uint32_t height);
+
+    // Cuts texture into tiles. Takes TiledMipCount levels, or all of them
+    // when there are fewer; the coarsest level written may then span
+    // several tiles.
+    bool WriteTiledTexture(const char *path, const TextureLevels &texture);
+
+    // A mapped .cvt, validated on Open like CookedTexture; tile data is only
+    // read when a tile is handed out for upload.
+    class TiledTexture
+    {
+    public:
+        bool Open(const char *path);
+        void Close();
+        bool IsOpen() const { return m_header != nullptr; }
+
+        const TiledTextureHeader &Header() const { return *m_header; }
+        uint32_t Width() const { return m_header->width; }
+        uint32_t Height() const { return m_header->height; }
+        uint32_t MipCount() const { return m_header->mipCount; }
+        TextureFormat Format() const { return m_header->format; }
+        bool IsSrgb() const { return m_header->srgb != 0; }
+        uint32_t TileCount() const { return m_header->tileCount; }
+
+        const TiledMip &Mip(uint32_t level) const { return m_header->mips[level]; }
+        uint32_t TileIndex(uint32_t level, uint32_t x, uint32_t y) const
+        {
+            return m_header->mips[level].firstTile + y * m_header->mips[level].tilesX + x;
+        }
+        std::string_view Tile(uint32_t index) const;
+        std::string_view Tile(uint32_t level, uint32_t x, uint32_t y) const { return Tile(TileIndex(level, x, y)); }
+
+        std::string_view View() const { return m_file.View(); }
+
+    private:
+        bool validate() const;
+
+        MappedFile m_file;
+        const TiledTextureHeader *m_header{nullptr};
+    };
+}
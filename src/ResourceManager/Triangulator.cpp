@@ -0,0 +1,98 @@
+#include "Triangulator.hpp"
+
+using namespace Resources::CPU;
+
+namespace
+{
+    inline float cross2(const float *o, const float *a, const float *b)
+    {
+        return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+    }
+
+    // Inclusive on the edges so that a vertex duplicated onto the ear blocks it.
+    inline bool inTriangle(const float *p, const float *a, const float *b, const float *c, float orientation)
+    {
+        return cross2(a, b, p) * orientation >= 0.0f
+            && cross2(b, c, p) * orientation >= 0.0f
+            && cross2(c, a, p) * orientation >= 0.0f;
+    }
+}
+
+uint32_t Triangulator::fan(uint32_t cornerCount, uint32_t *out)
+{
+    for (uint32_t i = 1; i + 1 < cornerCount; ++i) {
+        out[0] = 0;
+        out[1] = i;
+        out[2] = i + 1;
+        out += 3;
+    }
+    return cornerCount - 2;
+}
+
+uint32_t Triangulator::clipProjected(uint32_t cornerCount, uint32_t *out)
+{
+    const float *points = m_points.data();
+
+    float area = 0.0f;
+    for (uint32_t i = 0, j = cornerCount - 1; i < cornerCount; j = i++) {
+        area += points[j * 2] * points[i * 2 + 1] - points[i * 2] * points[j * 2 + 1];
+    }
+    const float orientation = area < 0.0f ? -1.0f : 1.0f;
+
+    m_prev.resize(cornerCount);
+    m_next.resize(cornerCount);
+    for (uint32_t i = 0; i < cornerCount; ++i) {
+        m_prev[i] = i == 0 ? cornerCount - 1 : i - 1;
+        m_next[i] = i + 1 == cornerCount ? 0 : i + 1;
+    }
+
+    uint32_t triangles = 0;
+    uint32_t remaining = cornerCount;
+    uint32_t current = 0;
+    uint32_t sinceLastEar = 0;
+
+    while (remaining > 3) {
+        const uint32_t prev = m_prev[current];
+        const uint32_t next = m_next[current];
+        const float *a = points + prev * 2;
+        const float *b = points + current * 2;
+        const float *c = points + next * 2;
+
+        bool isEar = cross2(a, b, c) * orientation > 0.0f;
+        if (isEar) {
+            for (uint32_t i = m_next[next]; i != prev; i = m_next[i]) {
+                const float *p = points + i * 2;
+                // Only reflex vertices can lie inside a convex ear.
+                const bool isReflex = cross2(points + m_prev[i] * 2, p, points + m_next[i] * 2) * orientation <= 0.0f;
+                if (isReflex && inTriangle(p, a, b, c, orientation)) {
+                    isEar = false;
+                    break;
+                }
+            }
+        }
+
+        // Degenerate or self-intersecting input: once a full loop finds no ear,
+        // cut the current corner anyway so the triangle count stays cornerCount - 2.
+        if (isEar || sinceLastEar >= remaining) {
+            out[0] = prev;
+            out[1] = current;
+            out[2] = next;
+            out += 3;
+            ++triangles;
+
+            m_next[prev] = next;
+            m_prev[next] = prev;
+            --remaining;
+            sinceLastEar = 0;
+            current = next;
+        } else {
+            ++sinceLastEar;
+            current = next;
+        }
+    }
+
+    out[0] = m_prev[current];
+    out[1] = current;
+    out[2] = m_next[current];
+    return triangles + 1;
+}
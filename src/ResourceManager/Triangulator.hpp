@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // Splits a planar polygon into cornerCount - 2 triangles of polygon-local
+    // corner indices, keeping the winding of the input.
+    //
+    // Triangles and convex polygons (which covers nearly every quad) are fanned
+    // without touching memory beyond the output. Only concave polygons are
+    // projected into a scratch buffer owned by the triangulator and ear-clipped,
+    // so a triangulator reused across faces does not allocate after warm-up.
+    class Triangulator
+    {
+    public:
+        // position(i) returns a pointer to the xyz of corner i.
+        // out must hold 3 * (cornerCount - 2) indices. Returns the triangle count.
+        template<typename PositionFn>
+        uint32_t Triangulate(uint32_t cornerCount, PositionFn &&position, uint32_t *out);
+
+        // Always runs the ear clipper. Used by Triangulate for concave input.
+        template<typename PositionFn>
+        uint32_t ClipEars(uint32_t cornerCount, PositionFn &&position, uint32_t *out);
+
+        uint32_t ConcaveCount() const { return m_concaveCount; }
+
+    private:
+        template<typename PositionFn>
+        static void polygonNormal(uint32_t cornerCount, PositionFn &position, float normal[3]);
+
+        template<typename PositionFn>
+        static bool isConvex(uint32_t cornerCount, PositionFn &position, const float normal[3]);
+
+        template<typename PositionFn>
+        uint32_t clipEars(uint32_t cornerCount, PositionFn &position, const float normal[3], uint32_t *out);
+
+        static uint32_t fan(uint32_t cornerCount, uint32_t *out);
+        uint32_t clipProjected(uint32_t cornerCount, uint32_t *out);
+
+        std::vector<float> m_points;      // projected xy per corner
+        std::vector<uint32_t> m_prev;
+        std::vector<uint32_t> m_next;
+        uint32_t m_concaveCount{0};
+    };
+
+    template<typename PositionFn>
+    uint32_t Triangulator::Triangulate(uint32_t cornerCount, PositionFn &&position, uint32_t *out)
+    {
+        if (cornerCount < 3) {
+            return 0;
+        }
+        if (cornerCount == 3) {
+            out[0] = 0;
+            out[1] = 1;
+            out[2] = 2;
+            return 1;
+        }
+
+        float normal[3];
+        polygonNormal(cornerCount, position, normal);
+        if (isConvex(cornerCount, position, normal)) {
+            return fan(cornerCount, out);
+        }
+
+        ++m_concaveCount;
+        return clipEars(cornerCount, position, normal, out);
+    }
+
+    template<typename PositionFn>
+    uint32_t Triangulator::ClipEars(uint32_t cornerCount, PositionFn &&position, uint32_t *out)
+    {
+        if (cornerCount < 3) {
+            return 0;
+        }
+
+        float normal[3];
+        polygonNormal(cornerCount, position, normal);
+        return clipEars(cornerCount, position, normal, out);
+    }
+
+    template<typename PositionFn>
+    uint32_t Triangulator::clipEars(uint32_t cornerCount, PositionFn &position, const float normal[3], uint32_t *out)
+    {
+        // Project onto the plane of the two axes the normal is least aligned with.
+        const float ax = normal[0] < 0.0f ? -normal[0] : normal[0];
+        const float ay = normal[1] < 0.0f ? -normal[1] : normal[1];
+        const float az = normal[2] < 0.0f ? -normal[2] : normal[2];
+        const int axis = (ax >= ay && ax >= az) ? 0 : (ay >= az ? 1 : 2);
+        const int u = axis == 0 ? 1 : 0;
+        const int v = axis == 2 ? 1 : 2;
+
+        m_points.resize(cornerCount * 2);
+        for (uint32_t i = 0; i < cornerCount; ++i) {
+            const float *p = position(i);
+            m_points[i * 2 + 0] = p[u];
+            m_points[i * 2 + 1] = p[v];
+        }
+        return clipProjected(cornerCount, out);
+    }
+
+    // Newell's method, robust for slightly non-planar and concave polygons.
+    template<typename PositionFn>
+    void Triangulator::polygonNormal(uint32_t cornerCount, PositionFn &position, float normal[3])
+    {
+        normal[0] = normal[1] = normal[2] = 0.0f;
+        const float *prev = position(cornerCount - 1);
+        for (uint32_t i = 0; i < cornerCount; ++i) {
+            const float *cur = position(i);
+            normal[0] += (prev[1] - cur[1]) * (prev[2] + cur[2]);
+            normal[1] += (prev[2] - cur[2]) * (prev[0] + cur[0]);
+            normal[2] += (prev[0] - cur[0]) * (prev[1] + cur[1]);
+            prev = cur;
+        }
+    }
+
+    template<typename PositionFn>
+    bool Triangulator::isConvex(uint32_t cornerCount, PositionFn &position, const float normal[3])
+    {
+        const float *a = position(cornerCount - 2);
+        const float *b = position(cornerCount - 1);
+        for (uint32_t i = 0; i < cornerCount; ++i) {
+            const float *c = position(i);
+            const float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const float e1[3] = {c[0] - b[0], c[1] - b[1], c[2] - b[2]};
+            const float turn = (e0[1] * e1[2] - e0[2] * e1[1]) * normal[0]
+                             + (e0[2] * e1[0] - e0[0] * e1[2]) * normal[1]
+                             + (e0[0] * e1[1] - e0[1] * e1[0]) * normal[2];
+            if (turn < 0.0f) {
+                return false;
+            }
+            a = b;
+            b = c;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,385 @@
+#include "VertexLayout.hpp"
+
+#include "CpuFeatures.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if CHELSON_X86
+#include <immintrin.h>
+#endif
+
+using namespace Resources::CPU;
+
+namespace
+{
+    const float ZERO[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    inline float clamp(float value, float low, float high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+
+    inline int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline uint16_t toUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::lround(clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    const float *source(const VertexAttributes &attributes, VertexAttribute attribute)
+    {
+        const float *value = nullptr;
+        switch (attribute) {
+        case VertexAttribute::Position: value = attributes.position; break;
+        case VertexAttribute::Normal: value = attributes.normal; break;
+        case VertexAttribute::Texcoord: value = attributes.texcoord; break;
+        case VertexAttribute::Tangent: value = attributes.tangent; break;
+        case VertexAttribute::Count: break;
+        }
+        return value != nullptr ? value : ZERO;
+    }
+
+    void encodeElement(VertexFormat format, const float *in, uint8_t *out)
+    {
+        switch (format) {
+        case VertexFormat::Float2:
+            std::memcpy(out, in, 2 * sizeof(float));
+            break;
+        case VertexFormat::Float3:
+            std::memcpy(out, in, 3 * sizeof(float));
+            break;
+        case VertexFormat::Float4:
+            std::memcpy(out, in, 4 * sizeof(float));
+            break;
+        case VertexFormat::Half2:
+        case VertexFormat::Half4: {
+            const int count = format == VertexFormat::Half2 ? 2 : 4;
+            uint16_t half[4];
+            for (int i = 0; i < count; ++i) {
+                half[i] = FloatToHalf(in[i]);
+            }
+            std::memcpy(out, half, count * sizeof(uint16_t));
+            break;
+        }
+        case VertexFormat::Unorm16x2: {
+            const uint16_t value[2] = {toUnorm16(in[0]), toUnorm16(in[1])};
+            std::memcpy(out, value, sizeof(value));
+            break;
+        }
+        case VertexFormat::Snorm16x2Oct: {
+            int16_t value[2];
+            EncodeOctahedral(in, value);
+            std::memcpy(out, value, sizeof(value));
+            break;
+        }
+        case VertexFormat::Snorm16x4: {
+            const int16_t value[4] = {toSnorm16(in[0]), toSnorm16(in[1]), toSnorm16(in[2]), toSnorm16(in[3])};
+            std::memcpy(out, value, sizeof(value));
+            break;
+        }
+        case VertexFormat::Unorm16x4: {
+            const uint16_t value[4] = {toUnorm16(in[0]), toUnorm16(in[1]), toUnorm16(in[2]), toUnorm16(in[3])};
+            std::memcpy(out, value, sizeof(value));
+            break;
+        }
+        case VertexFormat::Snorm16x2OctSign: {
+            int16_t value[2];
+            EncodeOctahedral(in, value);
+            // Giving up the lowest bit of x moves the direction by at most 1 / 32767.
+            value[0] = static_cast<int16_t>((value[0] & ~1) | (in[3] < 0.0f ? 1 : 0));
+            std::memcpy(out, value, sizeof(value));
+            break;
+        }
+        }
+    }
+
+    void decodeElement(VertexFormat format, const uint8_t *in, float *out)
+    {
+        switch (format) {
+        case VertexFormat::Float2:
+            std::memcpy(out, in, 2 * sizeof(float));
+            break;
+        case VertexFormat::Float3:
+            std::memcpy(out, in, 3 * sizeof(float));
+            break;
+        case VertexFormat::Float4:
+            std::memcpy(out, in, 4 * sizeof(float));
+            break;
+        case VertexFormat::Half2:
+        case VertexFormat::Half4: {
+            const int count = format == VertexFormat::Half2 ? 2 : 4;
+            uint16_t half[4];
+            std::memcpy(half, in, count * sizeof(uint16_t));
+            for (int i = 0; i < count; ++i) {
+                out[i] = HalfToFloat(half[i]);
+            }
+            break;
+        }
+        case VertexFormat::Unorm16x2: {
+            uint16_t value[2];
+            std::memcpy(value, in, sizeof(value));
+            out[0] = value[0] / 65535.0f;
+            out[1] = value[1] / 65535.0f;
+            break;
+        }
+        case VertexFormat::Snorm16x2Oct: {
+            int16_t value[2];
+            std::memcpy(value, in, sizeof(value));
+            DecodeOctahedral(value, out);
+            break;
+        }
+        case VertexFormat::Snorm16x4: {
+            int16_t value[4];
+            std::memcpy(value, in, sizeof(value));
+            for (int i = 0; i < 4; ++i) {
+                out[i] = std::fmax(value[i] / 32767.0f, -1.0f);
+            }
+            break;
+        }
+        case VertexFormat::Unorm16x4: {
+            uint16_t value[4];
+            std::memcpy(value, in, sizeof(value));
+            for (int i = 0; i < 4; ++i) {
+                out[i] = value[i] / 65535.0f;
+            }
+            break;
+        }
+        case VertexFormat::Snorm16x2OctSign: {
+            int16_t value[2];
+            std::memcpy(value, in, sizeof(value));
+            DecodeOctahedral(value, out);
+            out[3] = (value[0] & 1) != 0 ? -1.0f : 1.0f;
+            break;
+        }
+        }
+    }
+
+    inline bool isQuantizedPosition(const VertexElement &element)
+    {
+        return element.attribute == VertexAttribute::Position && element.format == VertexFormat::Unorm16x4;
+    }
+
+#if CHELSON_X86
+    CHELSON_TARGET_F16C void floatToHalfF16c(const float *values, uint16_t *halves, size_t count)
+    {
+        for (size_t i = 0; i + 8 <= count; i += 8) {
+            const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(halves + i), half);
+        }
+    }
+
+    CHELSON_TARGET_F16C void halfToFloatF16c(const uint16_t *halves, float *values, size_t count)
+    {
+        for (size_t i = 0; i + 8 <= count; i += 8) {
+            const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(halves + i));
+            _mm256_storeu_ps(values + i, _mm256_cvtph_ps(half));
+        }
+    }
+#endif
+}
+
+VertexQuantization Resources::CPU::QuantizationForBounds(const float *min, const float *max)
+{
+    VertexQuantization quantization;
+    for (int i = 0; i < 3; ++i) {
+        quantization.offset[i] = min[i];
+        quantization.scale[i] = max[i] > min[i] ? max[i] - min[i] : 0.0f;
+    }
+    return quantization;
+}
+
+bool Resources::CPU::IsQuantized(const VertexLayout &layout)
+{
+    for (uint32_t i = 0; i < layout.elementCount; ++i) {
+        if (isQuantizedPosition(layout.elements[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Resources::CPU::EncodeVertex(const VertexLayout &layout, const VertexAttributes &attributes,
+                                  uint8_t *const *streams, size_t index, const VertexQuantization &quantization)
+{
+    bool fits = true;
+    for (uint32_t i = 0; i < layout.elementCount; ++i) {
+        const VertexElement &element = layout.elements[i];
+        uint8_t *out = streams[element.stream] + index * layout.strides[element.stream] + element.offset;
+        const float *in = source(attributes, element.attribute);
+        if (isQuantizedPosition(element)) {
+            float normalized[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int c = 0; c < 3; ++c) {
+                normalized[c] = quantization.scale[c] > 0.0f ? (in[c] - quantization.offset[c]) / quantization.scale[c]
+                                                             : 0.0f;
+            }
+            encodeElement(element.format, normalized, out);
+        } else {
+            if (element.format == VertexFormat::Unorm16x2) {
+                fits &= in[0] >= 0.0f && in[0] <= 1.0f && in[1] >= 0.0f && in[1] <= 1.0f;
+            }
+            encodeElement(element.format, in, out);
+        }
+    }
+    return fits;
+}
+
+bool Resources::CPU::DecodeAttribute(const VertexLayout &layout, const uint8_t *const *streams, size_t index,
+                                     VertexAttribute attribute, float *value, const VertexQuantization &quantization)
+{
+    for (uint32_t i = 0; i < layout.elementCount; ++i) {
+        const VertexElement &element = layout.elements[i];
+        if (element.attribute == attribute) {
+            decodeElement(element.format, streams[element.stream] + index * layout.strides[element.stream] + element.offset,
+                          value);
+            if (isQuantizedPosition(element)) {
+                for (int c = 0; c < 3; ++c) {
+                    value[c] = quantization.offset[c] + value[c] * quantization.scale[c];
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void Resources::CPU::FloatToHalf(const float *values, uint16_t *halves, size_t count)
+{
+    size_t done = 0;
+#if CHELSON_X86
+    if (ActiveSimdLevel() >= SimdLevel::Avx2) {
+        done = count & ~size_t(7);
+        floatToHalfF16c(values, halves, done);
+    }
+#endif
+    for (size_t i = done; i < count; ++i) {
+        halves[i] = FloatToHalf(values[i]);
+    }
+}
+
+void Resources::CPU::HalfToFloat(const uint16_t *halves, float *values, size_t count)
+{
+    size_t done = 0;
+#if CHELSON_X86
+    if (ActiveSimdLevel() >= SimdLevel::Avx2) {
+        done = count & ~size_t(7);
+        halfToFloatF16c(halves, values, done);
+    }
+#endif
+    for (size_t i = done; i < count; ++i) {
+        values[i] = HalfToFloat(halves[i]);
+    }
+}
+
+// Round to nearest even, with overflow to infinity and gradual underflow,
+// matching the hardware F16C conversion.
+uint16_t Resources::CPU::FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7fffffffu;
+
+    if (magnitude >= 0x7f800000u) {
+        // Inf stays inf, NaN stays a quiet NaN.
+        return static_cast<uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477ff000u) {
+        // Rounds past the largest half.
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (magnitude < 0x38800000u) {
+        // Subnormal half: shift the implicit-one mantissa into place.
+        if (magnitude < 0x33000000u) {
+            return static_cast<uint16_t>(sign);
+        }
+        const uint32_t exponent = magnitude >> 23;
+        const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        const uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (magnitude - 0x38000000u) >> 13;
+    const uint32_t remainder = magnitude & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float Resources::CPU::HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Renormalize a subnormal half.
+        exponent = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void Resources::CPU::EncodeOctahedral(const float *normal, int16_t *encoded)
+{
+    const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (length <= 0.0f) {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    if (normal[2] < 0.0f) {
+        // Fold the lower hemisphere over the diagonals.
+        const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
+}
+
+void Resources::CPU::DecodeOctahedral(const int16_t *encoded, float *normal)
+{
+    float x = std::fmax(encoded[0] / 32767.0f, -1.0f);
+    float y = std::fmax(encoded[1] / 32767.0f, -1.0f);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) {
+        const float unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    const float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Resources::CPU
+{
+    enum class VertexAttribute : uint8_t
+    {
+        Position,   // float3 source
+        Normal,     // float3 source
+        Texcoord,   // float2 source
+        Tangent,    // float4 source, w is the bitangent sign
+        Count
+    };
+
+    enum class VertexFormat : uint8_t
+    {
+        Float2,
+        Float3,
+        Float4,
+        Half2,
+        Half4,
+        Unorm16x2,      // [0, 1] only, EncodeVertex fails outside, so no tiling texcoords
+        Snorm16x2Oct,   // octahedral unit vector
+        Snorm16x4,
+        Unorm16x4,          // positions: xyz in the mesh bounds, see VertexQuantization, w 0
+        Snorm16x2OctSign,   // octahedral unit vector, lowest bit of x set when w is negative
+    };
+
+    constexpr uint32_t MAX_VERTEX_STREAMS = 4;
+    constexpr uint32_t MAX_VERTEX_ELEMENTS = 8;
+
+    constexpr uint32_t VertexFormatSize(VertexFormat format)
+    {
+        switch (format) {
+        case VertexFormat::Float2: return 8;
+        case VertexFormat::Float3: return 12;
+        case VertexFormat::Float4: return 16;
+        case VertexFormat::Half2: return 4;
+        case VertexFormat::Half4: return 8;
+        case VertexFormat::Unorm16x2: return 4;
+        case VertexFormat::Snorm16x2Oct: return 4;
+        case VertexFormat::Snorm16x4: return 8;
+        case VertexFormat::Unorm16x4: return 8;
+        case VertexFormat::Snorm16x2OctSign: return 4;
+        }
+        return 0;
+    }
+
+    struct VertexElement
+    {
+        VertexAttribute attribute{VertexAttribute::Position};
+        VertexFormat format{VertexFormat::Float3};
+        uint8_t stream{0};
+        uint16_t offset{0};
+    };
+
+    // Runtime description of where every attribute lives. Plain data, so it can
+    // be stored next to the streams and turned into input element descs as is.
+    struct VertexLayout
+    {
+        VertexElement elements[MAX_VERTEX_ELEMENTS]{};
+        uint32_t elementCount{0};
+        uint32_t strides[MAX_VERTEX_STREAMS]{};
+        uint32_t streamCount{0};
+    };
+
+    // Per-mesh decode constants of Unorm16x4 positions: position = offset +
+    // value * scale, with value the [0, 1] the input assembler hands out.
+    // The default maps [0, 1] onto itself.
+    struct VertexQuantization
+    {
+        float offset[3]{0.0f, 0.0f, 0.0f};
+        float scale[3]{1.0f, 1.0f, 1.0f};
+    };
+
+    // Spreads the 16 bits of every axis over [min, max].
+    VertexQuantization QuantizationForBounds(const float *min, const float *max);
+
+    // True when the layout stores positions relative to a VertexQuantization.
+    bool IsQuantized(const VertexLayout &layout);
+
+    // Float attributes of one vertex, nullptr when the mesh does not have them.
+    struct VertexAttributes
+    {
+        const float *position{nullptr};
+        const float *normal{nullptr};
+        const float *texcoord{nullptr};
+        const float *tangent{nullptr};
+    };
+
+    // Encodes vertex number index into every stream of the layout.
+    // Missing attributes are written as zero. False when a value is outside
+    // what its format can hold, a Unorm16x2 texcoord outside [0, 1]; the
+    // vertex is still written, clamped, but the mesh should be rejected.
+    bool EncodeVertex(const VertexLayout &layout, const VertexAttributes &attributes,
+                      uint8_t *const *streams, size_t index, const VertexQuantization &quantization = {});
+
+    // Reads attribute of vertex number index back as floats: up to four, as
+    // many as the encoded format has, three for octahedral normals and four
+    // with the sign in w for signed ones. False when the layout does not
+    // have the attribute.
+    bool DecodeAttribute(const VertexLayout &layout, const uint8_t *const *streams, size_t index,
+                         VertexAttribute attribute, float *value, const VertexQuantization &quantization = {});
+
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+
+    // Whole arrays at once, eight values per instruction with F16C when
+    // ActiveSimdLevel allows it. Results match the scalar ones bit for bit,
+    // NaN payloads aside.
+    void FloatToHalf(const float *values, uint16_t *halves, size_t count);
+    void HalfToFloat(const uint16_t *halves, float *values, size_t count);
+    void EncodeOctahedral(const float *normal, int16_t *encoded);
+    void DecodeOctahedral(const int16_t *encoded, float *normal);
+
+    // Compile-time layout description. Formats and streams are spelled out as
+    // types, strides and offsets are computed by the compiler:
+    //
+    //     using Depth = VertexLayouts::Layout<
+    //         VertexLayouts::Stream<VertexLayouts::Element<VertexAttribute::Position, VertexLayouts::Float3>>>;
+    //     constexpr VertexLayout DEPTH = Depth::Describe();
+    namespace VertexLayouts
+    {
+        template<VertexFormat F>
+        struct Format
+        {
+            static constexpr VertexFormat FORMAT = F;
+            static constexpr uint32_t SIZE = VertexFormatSize(F);
+        };
+
+        using Float2 = Format<VertexFormat::Float2>;
+        using Float3 = Format<VertexFormat::Float3>;
+        using Float4 = Format<VertexFormat::Float4>;
+        using Half2 = Format<VertexFormat::Half2>;
+        using Half4 = Format<VertexFormat::Half4>;
+        using Unorm16x2 = Format<VertexFormat::Unorm16x2>;
+        using Snorm16x2Oct = Format<VertexFormat::Snorm16x2Oct>;
+        using Snorm16x4 = Format<VertexFormat::Snorm16x4>;
+        using Unorm16x4 = Format<VertexFormat::Unorm16x4>;
+        using Snorm16x2OctSign = Format<VertexFormat::Snorm16x2OctSign>;
+
+        template<VertexAttribute A, typename F>
+        struct Element
+        {
+            static constexpr VertexAttribute ATTRIBUTE = A;
+            static constexpr VertexFormat FORMAT = F::FORMAT;
+            static constexpr uint32_t SIZE = F::SIZE;
+        };
+
+        // One vertex buffer with its elements interleaved in declaration order.
+        template<typename... Elements>
+        struct Stream
+        {
+            static constexpr uint32_t ELEMENT_COUNT = sizeof...(Elements);
+            static constexpr uint32_t STRIDE = (0 + ... + Elements::SIZE);
+
+            static constexpr void Describe(VertexLayout &layout, uint8_t stream)
+            {
+                uint16_t offset = 0;
+                ((layout.elements[layout.elementCount++] = VertexElement{Elements::ATTRIBUTE, Elements::FORMAT, stream, offset},
+                  offset = static_cast<uint16_t>(offset + Elements::SIZE)), ...);
+                layout.strides[stream] = STRIDE;
+            }
+        };
+
+        template<typename... Streams>
+        struct Layout
+        {
+            static_assert(sizeof...(Streams) >= 1 && sizeof...(Streams) <= MAX_VERTEX_STREAMS, "too many vertex streams");
+            static_assert((0 + ... + Streams::ELEMENT_COUNT) <= MAX_VERTEX_ELEMENTS, "too many vertex elements");
+            static_assert(((Streams::STRIDE % 4 == 0) && ...), "vertex strides must be 4-byte aligned");
+
+            static constexpr VertexLayout Describe()
+            {
+                VertexLayout layout{};
+                uint8_t stream = 0;
+                (Streams::Describe(layout, stream++), ...);
+                layout.streamCount = sizeof...(Streams);
+                return layout;
+            }
+        };
+
+        // Everything as float in one buffer, the layout SponzaShape used to hand out.
+        using InterleavedFloat = Layout<
+            Stream<Element<VertexAttribute::Position, Float3>,
+                   Element<VertexAttribute::Normal, Float3>,
+                   Element<VertexAttribute::Texcoord, Float2>>>;
+
+        // Full precision positions alone for depth-only passes, packed shading
+        // attributes in a second stream.
+        using DepthAndShading = Layout<
+            Stream<Element<VertexAttribute::Position, Float3>>,
+            Stream<Element<VertexAttribute::Normal, Snorm16x2Oct>,
+                   Element<VertexAttribute::Texcoord, Half2>>>;
+
+        // Same as DepthAndShading with a tangent frame for normal mapping.
+        using DepthAndShadingTangent = Layout<
+            Stream<Element<VertexAttribute::Position, Float3>>,
+            Stream<Element<VertexAttribute::Normal, Snorm16x2Oct>,
+                   Element<VertexAttribute::Tangent, Snorm16x4>,
+                   Element<VertexAttribute::Texcoord, Half2>>>;
+
+        // DepthAndShading at 16 bytes a vertex instead of 20, 8 of them for
+        // depth-only passes: 16-bit positions in the mesh bounds, so every
+        // draw needs its submesh's quantization.
+        using Quantized = Layout<
+            Stream<Element<VertexAttribute::Position, Unorm16x4>>,
+            Stream<Element<VertexAttribute::Normal, Snorm16x2Oct>,
+                   Element<VertexAttribute::Texcoord, Half2>>>;
+
+        // Quantized with an octahedral tangent, 20 bytes instead of 28.
+        using QuantizedTangent = Layout<
+            Stream<Element<VertexAttribute::Position, Unorm16x4>>,
+            Stream<Element<VertexAttribute::Normal, Snorm16x2Oct>,
+                   Element<VertexAttribute::Tangent, Snorm16x2OctSign>,
+                   Element<VertexAttribute::Texcoord, Half2>>>;
+    }
+}
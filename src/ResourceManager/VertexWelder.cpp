@@ -0,0 +1,99 @@
+#include "VertexWelder.hpp"
+
+#include <cstring>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    // Load factor is kept at or below 1/2 so probe sequences stay short.
+    constexpr size_t MIN_CAPACITY = 64;
+
+    inline uint32_t floatBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        // -0.0 and 0.0 weld together.
+        return bits == 0x80000000u ? 0u : bits;
+    }
+
+    inline uint32_t hashKey(const VertexWelder::Key &key)
+    {
+        uint64_t h = 0x9e3779b97f4a7c15ull;
+        for (uint32_t bits : key.bits) {
+            h ^= bits;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 32;
+        }
+        return static_cast<uint32_t>(h);
+    }
+
+    inline size_t capacityFor(size_t count)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+}
+
+void VertexWelder::Reset(size_t expectedVertices)
+{
+    const size_t capacity = capacityFor(expectedVertices);
+    m_slots.assign(capacity, Slot{0, EMPTY_SLOT});
+    m_mask = capacity - 1;
+    m_keys.clear();
+    m_keys.reserve(expectedVertices);
+}
+
+uint32_t VertexWelder::Insert(const float *position, const float *normal, const float *texcoord, bool &isNew)
+{
+    if (m_slots.empty() || (m_keys.size() + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    Key key;
+    key.bits[0] = floatBits(position[0]);
+    key.bits[1] = floatBits(position[1]);
+    key.bits[2] = floatBits(position[2]);
+    key.bits[3] = floatBits(normal[0]);
+    key.bits[4] = floatBits(normal[1]);
+    key.bits[5] = floatBits(normal[2]);
+    key.bits[6] = floatBits(texcoord[0]);
+    key.bits[7] = floatBits(texcoord[1]);
+
+    const uint32_t hash = hashKey(key);
+    size_t slot = hash & m_mask;
+    for (;;) {
+        Slot &entry = m_slots[slot];
+        if (entry.index == EMPTY_SLOT) {
+            entry.hash = hash;
+            entry.index = static_cast<uint32_t>(m_keys.size());
+            m_keys.push_back(key);
+            isNew = true;
+            return entry.index;
+        }
+        if (entry.hash == hash && std::memcmp(&m_keys[entry.index], &key, sizeof(Key)) == 0) {
+            isNew = false;
+            return entry.index;
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+void VertexWelder::grow()
+{
+    const size_t capacity = capacityFor(m_keys.size() + 1);
+    m_slots.assign(capacity, Slot{0, EMPTY_SLOT});
+    m_mask = capacity - 1;
+
+    for (uint32_t index = 0; index < m_keys.size(); ++index) {
+        const uint32_t hash = hashKey(m_keys[index]);
+        size_t slot = hash & m_mask;
+        while (m_slots[slot].index != EMPTY_SLOT) {
+            slot = (slot + 1) & m_mask;
+        }
+        m_slots[slot] = Slot{hash, index};
+    }
+}
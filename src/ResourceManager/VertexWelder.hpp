@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // Welds vertices with bit-identical attributes into one index.
+    // Lookups go through an open-addressing table with linear probing whose
+    // slots keep the hash next to the vertex index, so a probe sequence stays
+    // in one or two cache lines and only a hash hit touches the stored key.
+    class VertexWelder
+    {
+    public:
+        // Position xyz, normal xyz, texcoord uv.
+        static constexpr size_t KEY_FLOATS = 8;
+
+        struct Key
+        {
+            uint32_t bits[KEY_FLOATS];
+        };
+
+        // Clears the table and sizes it for the expected number of inputs.
+        // Storage is kept between calls so one welder can serve many shapes.
+        void Reset(size_t expectedVertices);
+
+        // Returns the welded index for the attributes; isNew tells whether
+        // the caller has to append the vertex to its own arrays.
+        uint32_t Insert(const float *position, const float *normal, const float *texcoord, bool &isNew);
+
+        size_t UniqueCount() const { return m_keys.size(); }
+
+    private:
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t index;  // EMPTY_SLOT when unused
+        };
+
+        static constexpr uint32_t EMPTY_SLOT = 0xffffffffu;
+
+        void grow();
+
+        std::vector<Slot> m_slots;
+        std::vector<Key> m_keys;
+        size_t m_mask{0};
+    };
+}
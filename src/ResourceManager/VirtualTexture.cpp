@@ -0,0 +1,474 @@
+#include "VirtualTexture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Resources::CPU;
+
+namespace
+{
+    constexpr uint16_t UNMAPPED_SLOT = 0xffff;
+
+    // Feedback values sorted by tile with their counts summed, in place.
+    template<typename Request>
+    void mergeRequests(std::vector<Request> &requests)
+    {
+        std::sort(requests.begin(), requests.end(),
+                  [](const Request &a, const Request &b) { return a.tile < b.tile; });
+        size_t count = 0;
+        for (const Request &request : requests) {
+            if (count > 0 && requests[count - 1].tile == request.tile) {
+                requests[count - 1].count += request.count;
+            } else {
+                requests[count++] = request;
+            }
+        }
+        requests.resize(count);
+    }
+}
+
+uint32_t PageTable::AddTexture(const TiledTexture &texture)
+{
+    Texture table;
+    table.levels.resize(texture.MipCount());
+    for (uint32_t level = 0; level < texture.MipCount(); ++level) {
+        Grid &grid = table.levels[level];
+        grid.tilesX = texture.Mip(level).tilesX;
+        grid.tilesY = texture.Mip(level).tilesY;
+        grid.entries.resize(size_t(grid.tilesX) * grid.tilesY);
+    }
+    table.dirtyLevels = (1u << texture.MipCount()) - 1;
+    m_textures.push_back(std::move(table));
+    return static_cast<uint32_t>(m_textures.size() - 1);
+}
+
+const PageEntry &PageTable::Entry(uint32_t texture, uint32_t level, uint32_t x, uint32_t y) const
+{
+    const Grid &grid = m_textures[texture].levels[level];
+    return grid.entries[size_t(y) * grid.tilesX + x];
+}
+
+// Levels halve in texels, not always in tiles: a 257 texel wide level has
+// three tiles and the next one only one. The last tile of a level covers
+// whatever is left of the finer grid.
+void PageTable::Ancestor(uint32_t texture, uint32_t fine, uint32_t x, uint32_t y, uint32_t level,
+                         uint32_t &ancestorX, uint32_t &ancestorY) const
+{
+    const Grid &grid = m_textures[texture].levels[level];
+    const uint32_t shift = level - fine;
+    ancestorX = std::min(x >> shift, grid.tilesX - 1);
+    ancestorY = std::min(y >> shift, grid.tilesY - 1);
+}
+
+void PageTable::covered(const Texture &texture, uint32_t level, uint32_t x, uint32_t y, uint32_t fine, uint32_t &x0,
+                        uint32_t &x1, uint32_t &y0, uint32_t &y1) const
+{
+    const Grid &coarse = texture.levels[level];
+    const Grid &grid = texture.levels[fine];
+    const uint32_t shift = level - fine;
+    x0 = x << shift;
+    y0 = y << shift;
+    x1 = x + 1 == coarse.tilesX ? grid.tilesX : std::min((x + 1) << shift, grid.tilesX);
+    y1 = y + 1 == coarse.tilesY ? grid.tilesY : std::min((y + 1) << shift, grid.tilesY);
+}
+
+void PageTable::Map(uint32_t texture, uint32_t level, uint32_t x, uint32_t y, uint32_t slot)
+{
+    Texture &table = m_textures[texture];
+    const PageEntry mapped{static_cast<uint16_t>(slot), static_cast<uint8_t>(level), 0};
+    for (uint32_t fine = level + 1; fine-- > 0;) {
+        uint32_t x0, x1, y0, y1;
+        covered(table, level, x, y, fine, x0, x1, y0, y1);
+        Grid &grid = table.levels[fine];
+        for (uint32_t row = y0; row < y1; ++row) {
+            for (uint32_t column = x0; column < x1; ++column) {
+                PageEntry &entry = grid.entries[size_t(row) * grid.tilesX + column];
+                if (fine == level || entry.slot == UNMAPPED_SLOT || entry.level > level) {
+                    entry = mapped;
+                }
+            }
+        }
+        table.dirtyLevels |= 1u << fine;
+    }
+}
+
+void PageTable::Unmap(uint32_t texture, uint32_t level, uint32_t x, uint32_t y)
+{
+    Texture &table = m_textures[texture];
+    PageEntry replacement;
+    if (level + 1 < table.levels.size()) {
+        uint32_t parentX, parentY;
+        Ancestor(texture, level, x, y, level + 1, parentX, parentY);
+        replacement = Entry(texture, level + 1, parentX, parentY);
+    }
+    for (uint32_t fine = level + 1; fine-- > 0;) {
+        uint32_t x0, x1, y0, y1;
+        covered(table, level, x, y, fine, x0, x1, y0, y1);
+        Grid &grid = table.levels[fine];
+        for (uint32_t row = y0; row < y1; ++row) {
+            for (uint32_t column = x0; column < x1; ++column) {
+                PageEntry &entry = grid.entries[size_t(row) * grid.tilesX + column];
+                if (entry.slot != UNMAPPED_SLOT && entry.level == level) {
+                    entry = replacement;
+                }
+            }
+        }
+        table.dirtyLevels |= 1u << fine;
+    }
+}
+
+uint32_t PageTable::TakeDirtyLevels(uint32_t texture)
+{
+    const uint32_t levels = m_textures[texture].dirtyLevels;
+    m_textures[texture].dirtyLevels = 0;
+    return levels;
+}
+
+TileCache::TileCache(uint32_t slotCount)
+    : m_slots(slotCount)
+{
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        pushBack(slot);
+    }
+}
+
+uint32_t TileCache::Find(TileKey tile) const
+{
+    auto found = m_slotOf.find(tile);
+    return found != m_slotOf.end() ? found->second : INVALID_SLOT;
+}
+
+void TileCache::Touch(uint32_t slot, uint64_t frame)
+{
+    m_slots[slot].lastUsed = frame;
+    if (!m_slots[slot].locked) {
+        unlink(slot);
+        pushBack(slot);
+    }
+}
+
+uint32_t TileCache::Allocate(TileKey tile, uint64_t frame, TileKey &evicted)
+{
+    const uint32_t slot = m_head;
+    if (slot == INVALID_SLOT || (m_slots[slot].tile != INVALID_TILE && m_slots[slot].lastUsed >= frame)) {
+        return INVALID_SLOT;
+    }
+    Slot &entry = m_slots[slot];
+    evicted = entry.tile;
+    if (evicted != INVALID_TILE) {
+        m_slotOf.erase(evicted);
+    }
+    entry.tile = tile;
+    entry.lastUsed = frame;
+    m_slotOf[tile] = slot;
+    unlink(slot);
+    pushBack(slot);
+    return slot;
+}
+
+void TileCache::Free(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    if (entry.tile != INVALID_TILE) {
+        m_slotOf.erase(entry.tile);
+        entry.tile = INVALID_TILE;
+    }
+    if (entry.locked) {
+        entry.locked = false;
+    } else {
+        unlink(slot);
+    }
+    pushFront(slot);
+}
+
+void TileCache::Lock(uint32_t slot)
+{
+    if (!m_slots[slot].locked) {
+        unlink(slot);
+        m_slots[slot].locked = true;
+    }
+}
+
+void TileCache::Unlock(uint32_t slot, uint64_t frame)
+{
+    if (m_slots[slot].locked) {
+        m_slots[slot].locked = false;
+        m_slots[slot].lastUsed = frame;
+        pushBack(slot);
+    }
+}
+
+void TileCache::unlink(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    (entry.previous != INVALID_SLOT ? m_slots[entry.previous].next : m_head) = entry.next;
+    (entry.next != INVALID_SLOT ? m_slots[entry.next].previous : m_tail) = entry.previous;
+    entry.previous = INVALID_SLOT;
+    entry.next = INVALID_SLOT;
+}
+
+void TileCache::pushBack(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    entry.previous = m_tail;
+    entry.next = INVALID_SLOT;
+    (m_tail != INVALID_SLOT ? m_slots[m_tail].next : m_head) = slot;
+    m_tail = slot;
+}
+
+void TileCache::pushFront(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    entry.previous = INVALID_SLOT;
+    entry.next = m_head;
+    (m_head != INVALID_SLOT ? m_slots[m_head].previous : m_tail) = slot;
+    m_head = slot;
+}
+
+VirtualTextureSystem::VirtualTextureSystem(TileUploadBackend &backend, const VirtualTextureOptions &options)
+    : m_backend{backend}
+    , m_options{options}
+    , m_cache{std::min<uint32_t>(options.cacheSlots, UNMAPPED_SLOT)}
+    , m_isReady(m_cache.SlotCount(), 0)
+{
+}
+
+TextureId VirtualTextureSystem::Add(const char *path)
+{
+    TiledTexture texture;
+    if (m_textures.size() >= MAX_VIRTUAL_TEXTURES || !texture.Open(path) ||
+        texture.Mip(0).tilesX > MAX_VIRTUAL_TILES_PER_SIDE || texture.Mip(0).tilesY > MAX_VIRTUAL_TILES_PER_SIDE) {
+        return INVALID_TEXTURE;
+    }
+    const TextureId id = m_pages.AddTexture(texture);
+    const uint32_t coarsest = texture.MipCount() - 1;
+    for (uint32_t y = 0; y < texture.Mip(coarsest).tilesY; ++y) {
+        for (uint32_t x = 0; x < texture.Mip(coarsest).tilesX; ++x) {
+            m_pinned.push_back(PackTile(id, coarsest, x, y));
+        }
+    }
+    m_textures.push_back(std::move(texture));
+    return id;
+}
+
+void VirtualTextureSystem::AddFeedback(const TileKey *tiles, size_t count)
+{
+    // Neighbouring feedback texels mostly name the same tile; runs are
+    // collapsed here so sorting only sees what differs.
+    for (size_t i = 0; i < count;) {
+        size_t end = i + 1;
+        while (end < count && tiles[end] == tiles[i]) {
+            ++end;
+        }
+        if (tiles[i] != INVALID_TILE) {
+            m_feedback.push_back({tiles[i], static_cast<uint32_t>(end - i)});
+        }
+        i = end;
+    }
+}
+
+void VirtualTextureSystem::Update()
+{
+    ++m_frame;
+    retireUploads();
+    collectRequests();
+    issueUploads();
+    m_feedback.clear();
+}
+
+bool VirtualTextureSystem::IsResident(TileKey tile) const
+{
+    if (!isValid(tile)) {
+        return false;
+    }
+    const uint32_t slot = m_cache.Find(tile);
+    return slot != INVALID_SLOT && m_isReady[slot] != 0;
+}
+
+bool VirtualTextureSystem::isValid(TileKey tile) const
+{
+    const uint32_t texture = TileTexture(tile);
+    if (tile == INVALID_TILE || texture >= m_textures.size() || TileLevel(tile) >= m_pages.MipCount(texture)) {
+        return false;
+    }
+    return TileX(tile) < m_pages.TilesX(texture, TileLevel(tile)) &&
+           TileY(tile) < m_pages.TilesY(texture, TileLevel(tile));
+}
+
+void VirtualTextureSystem::retireUploads()
+{
+    auto retired = std::remove_if(m_uploads.begin(), m_uploads.end(), [this](const Upload &upload) {
+        if (!m_backend.IsComplete(upload.ticket)) {
+            return false;
+        }
+        m_isReady[upload.slot] = 1;
+        m_pages.Map(TileTexture(upload.tile), TileLevel(upload.tile), TileX(upload.tile), TileY(upload.tile),
+                    upload.slot);
+        if (!isPinned(upload.tile)) {
+            m_cache.Unlock(upload.slot, m_frame);
+        }
+        return true;
+    });
+    m_uploads.erase(retired, m_uploads.end());
+}
+
+// Tiles seen this frame are touched, and so is whatever the page table
+// shows in place of a missing one. A missing tile asks for its coarsest
+// missing ancestor instead, and nothing while that one is on its way.
+void VirtualTextureSystem::collectRequests()
+{
+    mergeRequests(m_feedback);
+    m_stats.feedbackCount = 0;
+    m_stats.requestCount = 0;
+    m_stats.missingCount = 0;
+    m_missing.clear();
+    for (const Request &request : m_feedback) {
+        if (!isValid(request.tile)) {
+            continue;
+        }
+        m_stats.feedbackCount += request.count;
+        ++m_stats.requestCount;
+        const uint32_t slot = m_cache.Find(request.tile);
+        if (slot != INVALID_SLOT && m_isReady[slot] != 0) {
+            m_cache.Touch(slot, m_frame);
+            continue;
+        }
+
+        ++m_stats.missingCount;
+        const uint32_t texture = TileTexture(request.tile);
+        const uint32_t level = TileLevel(request.tile);
+        const uint32_t x = TileX(request.tile);
+        const uint32_t y = TileY(request.tile);
+        const PageEntry &shown = m_pages.Entry(texture, level, x, y);
+        if (shown.slot != UNMAPPED_SLOT) {
+            m_cache.Touch(shown.slot, m_frame);
+        }
+        if (slot != INVALID_SLOT) {
+            continue;
+        }
+
+        TileKey wanted = request.tile;
+        for (uint32_t coarser = level + 1; coarser < m_pages.MipCount(texture); ++coarser) {
+            uint32_t parentX, parentY;
+            m_pages.Ancestor(texture, level, x, y, coarser, parentX, parentY);
+            const TileKey parent = PackTile(texture, coarser, parentX, parentY);
+            const uint32_t parentSlot = m_cache.Find(parent);
+            if (parentSlot != INVALID_SLOT) {
+                wanted = m_isReady[parentSlot] != 0 ? wanted : INVALID_TILE;
+                break;
+            }
+            wanted = parent;
+        }
+        if (wanted != INVALID_TILE && !isPinned(wanted)) {
+            m_missing.push_back({wanted, request.count});
+        }
+    }
+
+    mergeRequests(m_missing);
+    std::sort(m_missing.begin(), m_missing.end(), [](const Request &a, const Request &b) {
+        if (TileLevel(a.tile) != TileLevel(b.tile)) {
+            return TileLevel(a.tile) > TileLevel(b.tile);
+        }
+        return a.count != b.count ? a.count > b.count : a.tile < b.tile;
+    });
+}
+
+// Coarsest levels of new textures first, then missing tiles coarse to fine
+// and most seen first, until the frame's uploads or the free slots run out.
+void VirtualTextureSystem::issueUploads()
+{
+    uint32_t issued = 0;
+    auto upload = [this, &issued](TileKey tile) {
+        if (issued >= m_options.uploadsPerFrame) {
+            return false;
+        }
+        TileKey evicted = INVALID_TILE;
+        const uint32_t slot = m_cache.Allocate(tile, m_frame, evicted);
+        if (slot == INVALID_SLOT) {
+            return false;
+        }
+        if (evicted != INVALID_TILE) {
+            m_isReady[slot] = 0;
+            m_pages.Unmap(TileTexture(evicted), TileLevel(evicted), TileX(evicted), TileY(evicted));
+            ++m_stats.evictionCount;
+        }
+        const uint64_t ticket =
+            m_backend.UploadTile(slot, m_textures[TileTexture(tile)].Tile(TileLevel(tile), TileX(tile), TileY(tile)));
+        if (ticket == 0) {
+            m_cache.Free(slot);
+            return false;
+        }
+        m_cache.Lock(slot);
+        m_uploads.push_back({tile, slot, ticket});
+        ++m_stats.uploadCount;
+        ++issued;
+        return true;
+    };
+
+    size_t pinned = 0;
+    while (pinned < m_pinned.size() && upload(m_pinned[pinned])) {
+        ++pinned;
+    }
+    m_pinned.erase(m_pinned.begin(), m_pinned.begin() + pinned);
+
+    size_t missing = 0;
+    while (missing < m_missing.size() && upload(m_missing[missing].tile)) {
+        ++missing;
+    }
+    m_stats.deferredCount = m_missing.size() - missing;
+}
+
+SimulatedTileBackend::SimulatedTileBackend(uint32_t slotCount, uint32_t latencyFrames, uint32_t tilesPerFrame)
+    : m_latencyFrames{latencyFrames}
+    , m_tilesPerFrame{tilesPerFrame}
+    , m_slots(slotCount, 0)
+{
+}
+
+uint64_t SimulatedTileBackend::UploadTile(uint32_t slot, std::string_view bytes)
+{
+    if (m_frameTiles >= m_tilesPerFrame) {
+        return 0;
+    }
+    for (const auto &entry : m_copies) {
+        if (entry.second.slot == slot) {
+            ++m_errorCount;
+        }
+    }
+    ++m_frameTiles;
+    const uint64_t ticket = m_nextTicket++;
+    m_copies.emplace(ticket, Copy{slot, Checksum(bytes), m_frame + m_latencyFrames});
+    return ticket;
+}
+
+bool SimulatedTileBackend::IsComplete(uint64_t ticket)
+{
+    auto found = m_copies.find(ticket);
+    if (found == m_copies.end()) {
+        return true;
+    }
+    if (found->second.completeFrame > m_frame) {
+        return false;
+    }
+    m_slots[found->second.slot] = found->second.checksum;
+    m_copies.erase(found);
+    return true;
+}
+
+void SimulatedTileBackend::AdvanceFrame()
+{
+    ++m_frame;
+    m_frameTiles = 0;
+}
+
+uint64_t SimulatedTileBackend::Checksum(std::string_view bytes)
+{
+    // FNV-1a over 8-byte words; tiles are multiples of 512 bytes.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i + 8 <= bytes.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    return hash;
+}
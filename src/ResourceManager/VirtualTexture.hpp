@@ -0,0 +1,272 @@
+#pragma once
+
+#include "ResourceType.hpp"
+#include "TiledTexture.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Resources::CPU
+{
+    // A tile as the feedback pass writes it, one 32-bit value per feedback
+    // texel: texture in bits 20-31, level in 16-19, y in 8-15, x in 0-7. So
+    // at most MAX_VIRTUAL_TEXTURES textures of up to 256 x 256 tiles.
+    using TileKey = uint32_t;
+    constexpr TileKey INVALID_TILE = 0xffffffffu;
+    constexpr uint32_t MAX_VIRTUAL_TEXTURES = 4095;
+    constexpr uint32_t MAX_VIRTUAL_TILES_PER_SIDE = 256;
+    constexpr uint32_t INVALID_SLOT = 0xffffffffu;
+
+    inline TileKey PackTile(uint32_t texture, uint32_t level, uint32_t x, uint32_t y)
+    {
+        return (texture << 20) | (level << 16) | (y << 8) | x;
+    }
+    inline uint32_t TileTexture(TileKey tile) { return tile >> 20; }
+    inline uint32_t TileLevel(TileKey tile) { return (tile >> 16) & 0xf; }
+    inline uint32_t TileY(TileKey tile) { return (tile >> 8) & 0xff; }
+    inline uint32_t TileX(TileKey tile) { return tile & 0xff; }
+
+    // What the shader finds for a virtual tile: the cache slot to sample and
+    // the level of the tile in it, coarser than asked for while the tile
+    // itself is missing. slot is 0xffff until the texture's coarsest level
+    // arrived.
+    struct PageEntry
+    {
+        uint16_t slot{0xffff};
+        uint8_t level{0};
+        uint8_t reserved{0};
+    };
+
+    // One grid of PageEntry per texture and level, the CPU copy of the page
+    // table texture. Mapping a tile points every entry it covers, on its
+    // level and the finer ones, at it unless a finer tile is mapped there;
+    // unmapping hands those entries back to the tile one level up.
+    class PageTable
+    {
+    public:
+        uint32_t AddTexture(const TiledTexture &texture);
+        size_t TextureCount() const { return m_textures.size(); }
+        uint32_t MipCount(uint32_t texture) const { return static_cast<uint32_t>(m_textures[texture].levels.size()); }
+        uint32_t TilesX(uint32_t texture, uint32_t level) const { return m_textures[texture].levels[level].tilesX; }
+        uint32_t TilesY(uint32_t texture, uint32_t level) const { return m_textures[texture].levels[level].tilesY; }
+
+        const PageEntry &Entry(uint32_t texture, uint32_t level, uint32_t x, uint32_t y) const;
+        // Row-major grid of a level, for the upload of the page table texture.
+        const std::vector<PageEntry> &Level(uint32_t texture, uint32_t level) const
+        {
+            return m_textures[texture].levels[level].entries;
+        }
+        // Tile on level that covers tile (x, y) of the finer level fine.
+        void Ancestor(uint32_t texture, uint32_t fine, uint32_t x, uint32_t y, uint32_t level, uint32_t &ancestorX,
+                      uint32_t &ancestorY) const;
+
+        void Map(uint32_t texture, uint32_t level, uint32_t x, uint32_t y, uint32_t slot);
+        void Unmap(uint32_t texture, uint32_t level, uint32_t x, uint32_t y);
+
+        // Levels of texture changed since the last call, as a bit mask.
+        uint32_t TakeDirtyLevels(uint32_t texture);
+
+    private:
+        struct Grid
+        {
+            uint32_t tilesX{0};
+            uint32_t tilesY{0};
+            std::vector<PageEntry> entries;
+        };
+        struct Texture
+        {
+            std::vector<Grid> levels;
+            uint32_t dirtyLevels{0};
+        };
+
+        // Tiles of level fine under tile (x, y) of level, as [x0, x1) x [y0, y1).
+        void covered(const Texture &texture, uint32_t level, uint32_t x, uint32_t y, uint32_t fine, uint32_t &x0,
+                     uint32_t &x1, uint32_t &y0, uint32_t &y1) const;
+
+        std::vector<Texture> m_textures;
+    };
+
+    // The physical tile cache: a fixed number of equally sized slots in one
+    // GPU texture, recycled least recently used first. Locked slots, tiles
+    // being uploaded and the always resident coarsest levels, are never
+    // recycled; neither is a tile used in the current frame, so a frame that
+    // needs more tiles than there are slots keeps what it has instead of
+    // thrashing.
+    class TileCache
+    {
+    public:
+        explicit TileCache(uint32_t slotCount);
+
+        uint32_t SlotCount() const { return static_cast<uint32_t>(m_slots.size()); }
+        size_t UsedCount() const { return m_slotOf.size(); }
+        uint32_t Find(TileKey tile) const;
+        TileKey Tile(uint32_t slot) const { return m_slots[slot].tile; }
+        bool IsLocked(uint32_t slot) const { return m_slots[slot].locked; }
+
+        void Touch(uint32_t slot, uint64_t frame);
+        // Slot for tile: a free one, else the least recently used one, whose
+        // tile is returned in evicted. INVALID_SLOT when every slot is
+        // locked or in use this frame.
+        uint32_t Allocate(TileKey tile, uint64_t frame, TileKey &evicted);
+        void Free(uint32_t slot);
+        void Lock(uint32_t slot);
+        void Unlock(uint32_t slot, uint64_t frame);
+
+    private:
+        struct Slot
+        {
+            TileKey tile{INVALID_TILE};
+            uint32_t previous{INVALID_SLOT};
+            uint32_t next{INVALID_SLOT};
+            uint64_t lastUsed{0};
+            bool locked{false};
+        };
+
+        void unlink(uint32_t slot);
+        void pushBack(uint32_t slot);
+        void pushFront(uint32_t slot);
+
+        std::vector<Slot> m_slots;
+        uint32_t m_head{INVALID_SLOT};     // least recently used, free slots first
+        uint32_t m_tail{INVALID_SLOT};     // most recently used
+        std::unordered_map<TileKey, uint32_t> m_slotOf;
+    };
+
+    // Where tiles go: the renderer copies them into a slot of its physical
+    // cache texture. SimulatedTileBackend stands in for it without a GPU.
+    class TileUploadBackend
+    {
+    public:
+        virtual ~TileUploadBackend() = default;
+
+        // Starts copying a tile, laid out as TiledTexture::Tile returns it,
+        // into slot. Returns a ticket for IsComplete, or 0 when the backend
+        // cannot take more work this frame.
+        virtual uint64_t UploadTile(uint32_t slot, std::string_view bytes) = 0;
+        virtual bool IsComplete(uint64_t ticket) = 0;
+    };
+
+    struct VirtualTextureOptions
+    {
+        // Slots of the physical cache; every texture keeps its coarsest
+        // level in it for good, the rest is shared least recently used. At
+        // most 65535, page entries address slots in 16 bits.
+        uint32_t cacheSlots{1024};
+        uint32_t uploadsPerFrame{32};
+    };
+
+    struct VirtualTextureStats
+    {
+        size_t feedbackCount{0};    // feedback values read, last frame
+        size_t requestCount{0};     // distinct tiles among them
+        size_t missingCount{0};     // of those, served by a coarser tile
+        size_t deferredCount{0};    // missing tiles left for a later frame
+        size_t uploadCount{0};      // since the start
+        size_t evictionCount{0};
+    };
+
+    // Virtual texturing without the GPU parts: the renderer adds the .cvt
+    // files, hands over the feedback buffer each frame and calls Update,
+    // then uploads the page table levels that changed and samples through
+    // them. Update maps the tiles whose upload finished, then requests the
+    // missing ones coarse to fine, each replacing the least recently used
+    // tile of the cache; a tile whose parent is missing asks for the parent
+    // first, so detail arrives one level per upload without holes.
+    //
+    // Single threaded like the frame loop that drives it.
+    class VirtualTextureSystem
+    {
+    public:
+        explicit VirtualTextureSystem(TileUploadBackend &backend, const VirtualTextureOptions &options = {});
+
+        // Maps a .cvt and queues its coarsest level. INVALID_TEXTURE when it
+        // does not open or does not fit the tile addressing.
+        TextureId Add(const char *path);
+        size_t TextureCount() const { return m_textures.size(); }
+        const TiledTexture &Texture(TextureId texture) const { return m_textures[texture]; }
+
+        // Feedback values of one frame; INVALID_TILE values and tiles that
+        // do not exist are ignored.
+        void AddFeedback(const TileKey *tiles, size_t count);
+        void Update();
+
+        bool IsResident(TileKey tile) const;
+        const PageTable &Pages() const { return m_pages; }
+        PageTable &Pages() { return m_pages; }
+        const TileCache &Cache() const { return m_cache; }
+        const VirtualTextureOptions &Options() const { return m_options; }
+        const VirtualTextureStats &Stats() const { return m_stats; }
+        uint64_t Frame() const { return m_frame; }
+
+    private:
+        struct Upload
+        {
+            TileKey tile;
+            uint32_t slot;
+            uint64_t ticket;
+        };
+        struct Request
+        {
+            TileKey tile;
+            uint32_t count;
+        };
+
+        bool isValid(TileKey tile) const;
+        bool isPinned(TileKey tile) const { return TileLevel(tile) + 1 == m_pages.MipCount(TileTexture(tile)); }
+        void retireUploads();
+        void collectRequests();
+        void issueUploads();
+
+        TileUploadBackend &m_backend;
+        VirtualTextureOptions m_options;
+        VirtualTextureStats m_stats;
+        std::vector<TiledTexture> m_textures;
+        PageTable m_pages;
+        TileCache m_cache;
+        std::vector<uint8_t> m_isReady;     // per slot: the upload into it finished
+        std::vector<Upload> m_uploads;
+        std::vector<Request> m_feedback;   // runs of equal values, with their length
+        std::vector<TileKey> m_pinned;      // coarsest level tiles not uploaded yet
+        std::vector<Request> m_missing;
+        uint64_t m_frame{0};
+    };
+
+    // Upload backend without a GPU: copies finish latencyFrames frames after
+    // they were issued, at most tilesPerFrame per frame. It keeps a checksum
+    // of what each slot holds, to check the page table against.
+    class SimulatedTileBackend : public TileUploadBackend
+    {
+    public:
+        explicit SimulatedTileBackend(uint32_t slotCount, uint32_t latencyFrames = 2,
+                                      uint32_t tilesPerFrame = 0xffffffffu);
+
+        uint64_t UploadTile(uint32_t slot, std::string_view bytes) override;
+        bool IsComplete(uint64_t ticket) override;
+
+        void AdvanceFrame();
+
+        static uint64_t Checksum(std::string_view bytes);
+        uint64_t SlotChecksum(uint32_t slot) const { return m_slots[slot]; }
+        // Uploads into a slot that still had a copy in flight.
+        size_t ErrorCount() const { return m_errorCount; }
+
+    private:
+        struct Copy
+        {
+            uint32_t slot;
+            uint64_t checksum;
+            uint64_t completeFrame;
+        };
+
+        uint32_t m_latencyFrames;
+        uint32_t m_tilesPerFrame;
+        uint32_t m_frameTiles{0};
+        uint64_t m_frame{0};
+        uint64_t m_nextTicket{1};
+        size_t m_errorCount{0};
+        std::vector<uint64_t> m_slots;
+        std::unordered_map<uint64_t, Copy> m_copies;
+    };
+}